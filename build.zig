@@ -1527,7 +1527,10 @@ fn buildCommonInfrastructure(ctx: *const BuildContext, cfg: *const TargetConfig,
             "sample_library/sample_library_lua.cpp",
             "sample_library/sample_library_mdata.cpp",
             "sample_library/server/sample_library_server.cpp",
+            "sample_library/server/sample_memory_pool.cpp",
+            "sample_library/server/sample_io.cpp",
             "sample_library/server/scan_folders.cpp",
+            "search_index.cpp",
             "sentry/sentry.cpp",
             "state/legacy_param_logic.cpp",
             "state/macros.cpp",
@@ -1622,6 +1625,7 @@ fn buildPluginLib(ctx: *const BuildContext, cfg: *const TargetConfig, deps: stru
             "engine/engine.cpp",
             "engine/favourite_items.cpp",
             "engine/package_installation.cpp",
+            "engine/preset_prefetch.cpp",
             "engine/random_variation.cpp",
             "engine/shared_engine_systems.cpp",
             "engine/undo.cpp",
@@ -1687,6 +1691,7 @@ fn buildPluginLib(ctx: *const BuildContext, cfg: *const TargetConfig, deps: stru
             "processing_utils/arpeggiator.cpp",
             "processing_utils/lfo.cpp",
             "processing_utils/midi.cpp",
+            "processing_utils/midi_file.cpp",
             "processing_utils/volume_fade.cpp",
             "processor/layer_processor.cpp",
             "processor/param.cpp",
@@ -2126,6 +2131,7 @@ fn buildStandalone(ctx: *const BuildContext, cfg: *const TargetConfig, deps: str
         .files = &.{
             "src/standalone_wrapper/standalone_wrapper.cpp",
             "src/standalone_wrapper/standalone_device_manager.cpp",
+            "src/standalone_wrapper/offline_render.cpp",
             "src/plugin/plugin/plugin_entry.cpp",
             "src/common_infrastructure/final_binary_type.cpp",
         },
@@ -2816,6 +2822,7 @@ fn buildTests(ctx: *const BuildContext, cfg: *const TargetConfig, deps: struct {
             "src/foundation/container/dynamic_array.cpp",
             "src/foundation/container/function.cpp",
             "src/foundation/container/function_queue.cpp",
+            "src/foundation/container/grouped_hash_table.cpp",
             "src/foundation/container/hash_table.cpp",
             "src/foundation/container/optional.cpp",
             "src/foundation/container/path_pool.cpp",
@@ -2869,7 +2876,11 @@ fn buildBenchmarks(ctx: *const BuildContext, cfg: *const TargetConfig, deps: str
         .files = &.{
             "src/common_infrastructure/final_binary_type.cpp",
             "src/benchmarks/benchmarks_main.cpp",
+            "src/foundation/container/grouped_hash_table.cpp",
+            "src/foundation/container/path_pool.cpp",
             "src/foundation/memory/allocators.cpp",
+            "src/utils/json/json_reader.cpp",
+            "src/utils/thread_extra/thread_pool.cpp",
         },
         .flags = FlagsBuilder.init(ctx, cfg, .{
             .all_warnings = true,
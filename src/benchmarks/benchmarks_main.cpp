@@ -11,7 +11,21 @@
 
 // X-macro list of benchmark registration functions.
 #define BENCHMARK_REGISTER_FUNCTIONS                                                                         \
-    X(RegisterAllocatorBenchmarks) X(RegisterSampleProcessingBenchmarks) X(RegisterLayoutBenchmarks)
+    X(RegisterAllocatorBenchmarks)                                                                           \
+    X(RegisterSampleProcessingBenchmarks)                                                                    \
+    X(RegisterLayoutBenchmarks)                                                                              \
+    X(RegisterStateCodingBenchmarks)                                                                         \
+    X(RegisterThreadPoolBenchmarks)                                                                          \
+    X(RegisterPackageInstallationBenchmarks)                                                                 \
+    X(RegisterChecksumBenchmarks)                                                                            \
+    X(RegisterAudioFileBenchmarks)                                                                           \
+    X(RegisterSampleIoBenchmarks)                                                                            \
+    X(RegisterVoiceBenchmarks)                                                                               \
+    X(RegisterMidiFileBenchmarks)                                                                            \
+    X(RegisterHashTableBenchmarks)                                                                           \
+    X(RegisterPathPoolBenchmarks)                                                                            \
+    X(RegisterPersistentStoreBenchmarks)                                                                     \
+    X(RegisterJsonReaderBenchmarks)
 
 // Declare the registration functions.
 #define X(fn) void fn(benchmarks::Benchmarker&);
@@ -106,3 +106,43 @@ inline void CopySeparateChannelsToInterleaved(f32* __restrict interleaved_dest,
     for (auto const i : Range(num_frames))
         interleaved_dest[1 + (i * 2)] = src_r[i];
 }
+
+// Hann-windowed DFT of a power-of-two sized frame that only computes the bins that are asked for. Each bin is
+// O(size), so this is for analysing audio in tests, not for processing it.
+struct HannWindowedDft {
+    HannWindowedDft(ArenaAllocator& arena, u32 size)
+        : cos_table(arena.AllocateExactSizeUninitialised<f32>(size))
+        , sin_table(arena.AllocateExactSizeUninitialised<f32>(size))
+        , windowed(arena.AllocateExactSizeUninitialised<f32>(size)) {
+        ASSERT(IsPowerOfTwo(size));
+        for (auto const n : Range(size)) {
+            auto const phase = k_tau<f64> * n / size;
+            cos_table[n] = (f32)Cos(phase);
+            sin_table[n] = (f32)Sin(phase);
+        }
+    }
+
+    void SetFrame(Span<f32 const> frame) {
+        ASSERT(frame.size == windowed.size);
+        for (auto const n : Range(windowed.size))
+            windowed[n] = frame[n] * (0.5f - (0.5f * cos_table[n]));
+    }
+
+    // Squared magnitude of the bin, of the frame given to SetFrame.
+    f64 BinPower(u32 bin) const {
+        auto const mask = (u32)windowed.size - 1;
+        f64 re = 0;
+        f64 im = 0;
+        u32 phase = 0;
+        for (auto const n : Range(windowed.size)) {
+            re += (f64)(windowed[n] * cos_table[phase]);
+            im -= (f64)(windowed[n] * sin_table[phase]);
+            phase = (phase + bin) & mask;
+        }
+        return (re * re) + (im * im);
+    }
+
+    Span<f32> cos_table;
+    Span<f32> sin_table;
+    Span<f32> windowed;
+};
@@ -5,97 +5,222 @@
 
 #include "tests/framework.hpp"
 
+#include "common_infrastructure/checksum_crc32_file.hpp"
 #include "common_infrastructure/error_reporting.hpp"
 #include "common_infrastructure/state/state_coding.hpp"
 
 #include "plugin/engine/engine_prefs.hpp"
 
 constexpr auto k_autosave_filename_prefix = "autosave"_ca;
+constexpr auto k_autosave_journal_extension = ".floe-autosave-journal"_ca;
+
+// Sharing DeleteRename lets a trim replace the journal while other processes have it open.
+constexpr FileMode k_journal_write_mode {
+    .capability = FileMode::Capability::ReadWrite,
+    .win32_share = FileMode::Share::ReadWrite | FileMode::Share::DeleteRename,
+    .creation = FileMode::Creation::OpenAlways,
+};
+
+// The journal is a sequence of entries, each a header followed by the zlib-compressed state.
+struct AutosaveJournalEntryHeader {
+    static constexpr u32 k_magic = 0x4a534146; // 'FASJ'
+    u32 magic;
+    u32 compressed_size;
+    u32 uncompressed_size;
+    u32 crc32; // Of the compressed data.
+    s64 time_seconds;
+    u64 state_hash;
+};
+static_assert(sizeof(AutosaveJournalEntryHeader) == 32);
+
+struct ParsedAutosaveJournal {
+    struct Record {
+        AutosaveJournalEntryHeader header;
+        usize offset; // Of the header.
+        Span<u8 const> compressed_data;
+    };
+    DynamicArray<Record> records;
+    usize valid_size; // Bytes up to the end of the last complete entry.
+};
+
+static ParsedAutosaveJournal ParseAutosaveJournal(Span<u8 const> data, ArenaAllocator& arena) {
+    ParsedAutosaveJournal result {.records = {arena}, .valid_size = 0};
+    usize pos = 0;
+    while (pos + sizeof(AutosaveJournalEntryHeader) <= data.size) {
+        AutosaveJournalEntryHeader header;
+        CopyMemory(&header, data.data + pos, sizeof(header));
+        if (header.magic != AutosaveJournalEntryHeader::k_magic) break;
+        auto const data_start = pos + sizeof(header);
+        if (header.compressed_size > data.size - data_start) break;
+        auto const compressed = data.SubSpan(data_start, header.compressed_size);
+        if (Crc32(0, compressed) != header.crc32) break;
+        dyn::Append(result.records, {.header = header, .offset = pos, .compressed_data = compressed});
+        pos = data_start + header.compressed_size;
+        result.valid_size = pos;
+    }
+    return result;
+}
 
-// background thread
-static ErrorCodeOr<void>
-CleanupExcessInstanceAutosaves(AutosaveState& state, FloePaths const& paths, ArenaAllocator& scratch_arena) {
-    ZoneScoped;
-
-    auto const wildcard = fmt::FormatInline<32>("*{}*", InstanceId(state));
-
-    auto const entries = TRY(FindEntriesInFolder(scratch_arena,
-                                                 paths.autosave_path,
-                                                 {
-                                                     .options {
-                                                         .wildcard = wildcard,
-                                                     },
-                                                     .recursive = false,
-                                                     .only_file_type = FileType::File,
-                                                 }));
+ErrorCodeOr<Span<AutosaveJournalEntry>> ReadAutosaveJournal(String path, ArenaAllocator& arena) {
+    auto const data = TRY(ReadEntireFile(path, arena)).ToByteSpan();
+    auto const journal = ParseAutosaveJournal(data, arena);
+
+    DynamicArray<AutosaveJournalEntry> entries {arena};
+    for (auto const& record : journal.records) {
+        auto state_data = arena.AllocateExactSizeUninitialised<u8>(record.header.uncompressed_size);
+        auto size = (mz_ulong)state_data.size;
+        auto const result = mz_uncompress(state_data.data,
+                                          &size,
+                                          record.compressed_data.data,
+                                          (mz_ulong)record.compressed_data.size);
+        if (result != MZ_OK || size != state_data.size) break;
+        dyn::Append(entries,
+                    {
+                        .time_seconds = record.header.time_seconds,
+                        .state_hash = record.header.state_hash,
+                        .state_data = state_data,
+                    });
+    }
+    return entries.ToOwnedSpan();
+}
 
-    auto const max_autosaves_per_instance = state.max_autosaves_per_instance.Load(LoadMemoryOrder::Relaxed);
+ErrorCodeOr<Span<String>>
+ExportAutosaveJournal(String journal_path, String output_folder, ArenaAllocator& arena) {
+    auto const entries = TRY(ReadAutosaveJournal(journal_path, arena));
+    auto const name = path::FilenameWithoutExtension(journal_path);
+
+    DynamicArray<String> result {arena};
+    for (auto const [index, entry] : Enumerate(entries)) {
+        // The entries are exactly what's written to the autosave preset file. Several can be made in the same
+        // second, so the name has the entry number too.
+        auto const t = LocalTimeFromNanosecondsSinceEpoch((s128)entry.time_seconds * 1'000'000'000);
+        auto const filename = fmt::Format(arena,
+                                          "{} {04}-{02}-{02} {02}-{02}-{02} ({})" FLOE_PRESET_FILE_EXTENSION,
+                                          name,
+                                          t.year,
+                                          t.months_since_jan + 1,
+                                          t.day_of_month,
+                                          t.hour,
+                                          t.minute,
+                                          t.second,
+                                          index + 1);
+        auto const path = path::Join(arena, Array {output_folder, (String)filename});
+        TRY(WriteFile(path, entry.state_data));
+        dyn::Append(result, path);
+    }
+    return result.ToOwnedSpan();
+}
 
-    if (entries.size <= max_autosaves_per_instance) return k_success;
+String AutosaveJournalPath(FloePaths const& paths, String instance_id, Allocator& a) {
+    auto const filename =
+        fmt::Format(a, "{} {}{}", k_autosave_filename_prefix, instance_id, k_autosave_journal_extension);
+    return path::Join(a, Array {paths.autosave_path, filename});
+}
 
-    struct EntryWithTime {
-        dir_iterator::Entry const* entry;
-        s128 last_modified_time;
-    };
-    auto entries_with_times = scratch_arena.AllocateExactSizeUninitialised<EntryWithTime>(entries.size);
-    for (auto [i, entry] : Enumerate(entries)) {
-        auto const path = path::Join(scratch_arena, Array {paths.autosave_path, entry.subpath});
-        DEFER { scratch_arena.Free(path.ToByteSpan()); };
-        PLACEMENT_NEW(&entries_with_times[i])
-        EntryWithTime {.entry = &entry, .last_modified_time = TRY(LastModifiedTimeNsSinceEpoch(path))};
-    }
+static String AutosavePresetPath(FloePaths const& paths, String instance_id, Allocator& a) {
+    auto const filename =
+        fmt::Format(a, "{} {}" FLOE_PRESET_FILE_EXTENSION, k_autosave_filename_prefix, instance_id);
+    return path::Join(a, Array {paths.autosave_path, filename});
+}
 
-    Sort(entries_with_times, [](EntryWithTime const& a, EntryWithTime const& b) {
-        return a.last_modified_time < b.last_modified_time;
-    });
+// Write to a temporary file and rename so that a crash never leaves a half-written file behind.
+static ErrorCodeOr<void> WriteFileReplacing(String path, Span<u8 const> data, ArenaAllocator& scratch_arena) {
+    auto const temp_path = fmt::Join(scratch_arena, Array {path, ".tmp"_s});
+    TRY(WriteFile(temp_path, data));
+    TRY(Rename(temp_path, path));
+    return k_success;
+}
 
-    auto const excess_count = entries.size - max_autosaves_per_instance;
-    for (auto i : Range(excess_count)) {
-        auto const path =
-            path::Join(scratch_arena, Array {paths.autosave_path, entries_with_times[i].entry->subpath});
-        DEFER { scratch_arena.Free(path.ToByteSpan()); };
-        auto _ = Delete(path, {.type = DeleteOptions::Type::File, .fail_if_not_exists = false});
+// background thread
+// The file must be locked. If the journal isn't as we left it (it's new to us, or another writer has been at
+// it) we count its entries again, and cut off any partly-written entry so that we append after the last good
+// one.
+static ErrorCodeOr<AutosaveWriter::Journal*>
+SyncJournal(AutosaveWriter& writer, String instance_id, File& file, ArenaAllocator& scratch_arena) {
+    AutosaveWriter::Journal* journal = nullptr;
+    for (auto& j : writer.journals)
+        if (j.instance_id == instance_id) journal = &j;
+    if (!journal) {
+        dyn::Append(writer.journals, {.instance_id = instance_id, .identity = k_nullopt, .size = 0});
+        journal = &Last(writer.journals);
     }
 
-    return k_success;
+    auto const identity = TRY(file.Identity());
+    auto const file_size = TRY(file.FileSize());
+    if (journal->identity == identity && journal->size == file_size) return journal;
+
+    auto const data = TRY(file.ReadWholeFile(scratch_arena)).ToByteSpan();
+    auto const parsed = ParseAutosaveJournal(data, scratch_arena);
+    if (parsed.valid_size != data.size) TRY(file.Truncate(parsed.valid_size));
+    journal->identity = identity;
+    journal->size = parsed.valid_size;
+    journal->num_entries = (u32)parsed.records.size;
+    return journal;
 }
 
 // background thread
-static ErrorCodeOr<void>
-Autosave(AutosaveState& state, StateSnapshot const& snapshot, FloePaths const& paths) {
+static ErrorCodeOr<void> WriteAutosave(AutosaveWriter& writer,
+                                       AutosaveWriter::PendingWrite const& write,
+                                       FloePaths const& paths,
+                                       ArenaAllocator& scratch_arena) {
     ZoneScoped;
-    PathArena arena {PageAllocator::Instance()};
 
-    auto seed = RandomSeed();
-    DynamicArrayBounded<char, 64> filename;
-    {
-        auto const date = LocalTimeNow();
-        fmt::Assign(filename,
-                    "{} {02}-{02}-{02} {} {} {} {} {} ({})" FLOE_PRESET_FILE_EXTENSION,
-                    k_autosave_filename_prefix,
-                    date.hour,
-                    date.minute,
-                    date.second,
-                    date.DayName(),
-                    date.day_of_month,
-                    date.MonthName(),
-                    date.year,
-                    InstanceId(state),
-                    RandomIntInRange<u32>(seed, 1000, 9999));
-    }
+    // Another process might trim the journal while we're waiting for the lock, replacing it.
+    auto const journal_path = AutosaveJournalPath(paths, write.instance_id, scratch_arena);
+    auto file = TRY(OpenFileAndLockExclusive(journal_path, k_journal_write_mode));
+    DEFER { auto _ = file.Unlock(); };
+    auto journal = TRY(SyncJournal(writer, write.instance_id, file, scratch_arena));
 
-    // The directory may have been deleted since Floe started.
-    TRY(CreateDirectory(paths.autosave_path,
-                        {.create_intermediate_directories = false, .fail_if_exists = false}));
+    // The latest state is a normal preset so that recovering from a crash is just a matter of loading it.
+    TRY(WriteFileReplacing(AutosavePresetPath(paths, write.instance_id, scratch_arena),
+                           write.state_data,
+                           scratch_arena));
 
-    // Each autosave file is its own preset with its own identity, so it can be favourited independently.
-    auto snapshot_with_uuid = snapshot;
-    snapshot_with_uuid.extras.preset_uuid = RandomU64(seed);
+    {
+        auto const max_compressed_size = mz_compressBound((mz_ulong)write.state_data.size);
+        auto buffer =
+            scratch_arena.AllocateExactSizeUninitialised<u8>(sizeof(AutosaveJournalEntryHeader) +
+                                                             max_compressed_size);
+        auto compressed_size = (mz_ulong)max_compressed_size;
+        auto const result = mz_compress2(buffer.data + sizeof(AutosaveJournalEntryHeader),
+                                         &compressed_size,
+                                         write.state_data.data,
+                                         (mz_ulong)write.state_data.size,
+                                         MZ_DEFAULT_LEVEL);
+        ASSERT(result == MZ_OK); // The buffer is big enough for anything.
+        auto const compressed = buffer.SubSpan(sizeof(AutosaveJournalEntryHeader), compressed_size);
+
+        AutosaveJournalEntryHeader const header {
+            .magic = AutosaveJournalEntryHeader::k_magic,
+            .compressed_size = (u32)compressed_size,
+            .uncompressed_size = (u32)write.state_data.size,
+            .crc32 = Crc32(0, compressed),
+            .time_seconds = write.time_seconds,
+            .state_hash = write.state_hash,
+        };
+        CopyMemory(buffer.data, &header, sizeof(header));
+
+        // A single write, so that a crash leaves at most one partial entry at the end.
+        auto const entry = buffer.SubSpan(0, sizeof(header) + compressed_size);
+        TRY(file.WriteAt((s64)journal->size, entry));
+        journal->size += entry.size;
+        ++journal->num_entries;
+    }
 
-    auto const path = path::Join(arena, Array {paths.autosave_path, filename});
-    TRY(SavePresetFile(path,
-                       snapshot_with_uuid,
-                       state.write_experimental_params.Load(LoadMemoryOrder::Relaxed)));
+    // Trimming rewrites the file, so we let it grow to twice the limit before doing it. We still hold the
+    // lock on the old file, so no one can append to it while it's being replaced.
+    if (journal->num_entries > write.max_history_entries * 2u) {
+        auto const data = TRY(file.ReadWholeFile(scratch_arena)).ToByteSpan();
+        auto const parsed = ParseAutosaveJournal(data, scratch_arena);
+        auto const num_to_keep = Min<usize>(parsed.records.size, write.max_history_entries);
+        if (!num_to_keep) return k_success;
+        auto const first_kept = parsed.records[parsed.records.size - num_to_keep].offset;
+        TRY(WriteFileReplacing(journal_path,
+                               data.SubSpan(first_kept, parsed.valid_size - first_kept),
+                               scratch_arena));
+        // It's a different file now, so the next write reads it again.
+        journal->identity = k_nullopt;
+    }
 
     return k_success;
 }
@@ -105,8 +230,8 @@ ErrorCodeOr<void> CleanupOldAutosavesIfNeeded(FloePaths const& paths,
                                               ArenaAllocator& scratch_arena,
                                               u16 k_autosave_max_age_days) {
     ZoneScoped;
-    constexpr auto k_wildcard =
-        ConcatArrays("*"_ca, k_autosave_filename_prefix, "*"_ca, FLOE_PRESET_FILE_EXTENSION ""_ca);
+    // Presets and journals, along with temporary files left by a crash.
+    constexpr auto k_wildcard = ConcatArrays("*"_ca, k_autosave_filename_prefix, "*"_ca);
     auto const entries = TRY(FindEntriesInFolder(scratch_arena,
                                                  paths.autosave_path,
                                                  {
@@ -165,6 +290,7 @@ void InitAutosaveState(AutosaveState& state,
     state.last_save_time = TimePoint::Now();
     state.state = AutosaveState::State::Saved;
     state.snapshot = initial_state;
+    state.preset_uuid = RandomU64(random_seed);
     state.autosave_delete_after_days.raw =
         (u16)AutosaveSettingIntValue(AutosaveSetting::AutosaveDeleteAfterDays, prefs);
     state.max_autosaves_per_instance.raw =
@@ -172,7 +298,7 @@ void InitAutosaveState(AutosaveState& state,
 }
 
 // background thread
-void AutosaveToFileIfNeeded(AutosaveState& state, FloePaths const& paths) {
+void SubmitAutosaveIfNeeded(AutosaveState& state, AutosaveWriter& writer) {
     ZoneScoped;
     Optional<StateSnapshot> snapshot {};
     {
@@ -187,32 +313,98 @@ void AutosaveToFileIfNeeded(AutosaveState& state, FloePaths const& paths) {
             case AutosaveState::State::Saved: return;
         }
     }
-    if (snapshot) {
-        TRY_OR(Autosave(state, *snapshot, paths),
-               ReportError(ErrorLevel::Error, HashFnv1a("autosave"), "autosave failed: {}", error););
-        ArenaAllocatorWithInlineStorage<1000> scratch_arena {PageAllocator::Instance()};
-        static bool first_call = true;
-        if (Exchange(first_call, false)) {
-            TRY_OR(
-                CleanupOldAutosavesIfNeeded(paths,
+    if (!snapshot) return;
+
+    ArenaAllocatorWithInlineStorage<4000> scratch_arena {PageAllocator::Instance()};
+    snapshot->extras.preset_uuid = state.preset_uuid;
+    auto const data = TRY_OR(EncodeToMemory(*snapshot,
                                             scratch_arena,
-                                            state.autosave_delete_after_days.Load(LoadMemoryOrder::Relaxed)),
-                {
-                    if (error != FilesystemError::PathDoesNotExist)
-                        ReportError(ErrorLevel::Error,
-                                    HashFnv1a("autosave cleanup"),
-                                    "cleanup old autosaves failed: {}",
-                                    error);
-                });
+                                            StateSource::PresetFile,
+                                            state.write_experimental_params.Load(LoadMemoryOrder::Relaxed)),
+                             {
+                                 ReportError(ErrorLevel::Error,
+                                             HashFnv1a("autosave"),
+                                             "autosave failed: {}",
+                                             error);
+                                 return;
+                             });
+
+    // Changes that cancel each other out, or that don't affect what's saved, don't need a new autosave.
+    auto const hash = Hash(data);
+    if (hash == state.last_submitted_hash) return;
+    state.last_submitted_hash = hash;
+
+    auto const instance_id = InstanceId(state);
+    auto state_data = Malloc::Instance().AllocateExactSizeUninitialised<u8>(data.size);
+    CopyMemory(state_data.data, data.data, data.size);
+
+    writer.mutex.Lock();
+    DEFER { writer.mutex.Unlock(); };
+    AutosaveWriter::PendingWrite const write {
+        .source = &state,
+        .instance_id = instance_id,
+        .state_data = state_data,
+        .state_hash = hash,
+        .time_seconds = (s64)(NanosecondsSinceEpoch() / 1'000'000'000),
+        .max_history_entries = state.max_autosaves_per_instance.Load(LoadMemoryOrder::Relaxed),
+        .delete_after_days = state.autosave_delete_after_days.Load(LoadMemoryOrder::Relaxed),
+    };
+    for (auto& p : writer.pending) {
+        if (p.source == &state) {
+            Malloc::Instance().Free(p.state_data.ToByteSpan());
+            p = write;
+            return;
         }
-        TRY_OR(CleanupExcessInstanceAutosaves(state, paths, scratch_arena), {
+    }
+    dyn::Append(writer.pending, write);
+}
+
+// background thread
+void WritePendingAutosaves(AutosaveWriter& writer, FloePaths const& paths) {
+    ZoneScoped;
+    DynamicArray<AutosaveWriter::PendingWrite> pending {Malloc::Instance()};
+    {
+        writer.mutex.Lock();
+        DEFER { writer.mutex.Unlock(); };
+        if (!writer.pending.size) return;
+        pending = Move(writer.pending);
+    }
+    DEFER {
+        for (auto const& write : pending)
+            Malloc::Instance().Free(write.state_data.ToByteSpan());
+    };
+
+    ArenaAllocatorWithInlineStorage<4000> scratch_arena {PageAllocator::Instance()};
+
+    // The directory may have been deleted since Floe started.
+    TRY_OR(CreateDirectory(paths.autosave_path,
+                           {.create_intermediate_directories = false, .fail_if_exists = false}),
+           {
+               ReportError(ErrorLevel::Error, HashFnv1a("autosave"), "autosave failed: {}", error);
+               return;
+           });
+
+    if (!Exchange(writer.cleaned_up_old_autosaves, true)) {
+        TRY_OR(CleanupOldAutosavesIfNeeded(paths, scratch_arena, pending[0].delete_after_days), {
             if (error != FilesystemError::PathDoesNotExist)
                 ReportError(ErrorLevel::Error,
                             HashFnv1a("autosave cleanup"),
-                            "cleanup excess autosaves failed: {}",
+                            "cleanup old autosaves failed: {}",
                             error);
         });
     }
+
+    for (auto const& write : pending) {
+        scratch_arena.ResetCursorAndConsolidateRegions();
+        TRY_OR(WriteAutosave(writer, write, paths, scratch_arena),
+               ReportError(ErrorLevel::Error, HashFnv1a("autosave"), "autosave failed: {}", error););
+    }
+}
+
+void DeinitAutosaveWriter(AutosaveWriter& writer) {
+    for (auto const& write : writer.pending)
+        Malloc::Instance().Free(write.state_data.ToByteSpan());
+    dyn::Clear(writer.pending);
 }
 
 prefs::Descriptor SettingDescriptor(AutosaveSetting setting) {
@@ -358,7 +550,10 @@ static String TestPresetPath(tests::Tester& tester, String filename) {
 
 TEST_CASE(TestAutosave) {
     AutosaveState state {};
-    auto const paths = CreateFloePaths(tester.arena, true);
+    AutosaveWriter writer {};
+    DEFER { DeinitAutosaveWriter(writer); };
+    auto paths = CreateFloePaths(tester.arena, true);
+    paths.autosave_path = tests::TempFolderUnique(tester);
     prefs::Preferences preferences {};
 
     // We need to load some valid state to test autosave.
@@ -369,18 +564,170 @@ TEST_CASE(TestAutosave) {
     // We don't need check the result since it's time-based and we don't want to wait in a test.
     AutosaveNeeded(state, preferences);
 
-    // main thread
-    snapshot.param_values[0] += 1;
-    QueueAutosave(state, snapshot);
+    auto const journal_path = AutosaveJournalPath(paths, InstanceId(state), tester.arena);
 
-    // background thread
-    AutosaveToFileIfNeeded(state, paths);
+    // The hash of each state that was submitted, in order.
+    DynamicArray<u64> saved_hashes {tester.scratch_arena};
 
-    // do it multiple time to check file rotation
-    for (auto _ : Range(AutosaveSettingIntValue(AutosaveSetting::MaxAutosavesPerInstance, preferences) + 1)) {
+    auto save_with = [&](AutosaveWriter& w) {
         snapshot.param_values[0] += 1;
+        QueueAutosave(state, snapshot); // main thread
+        SubmitAutosaveIfNeeded(state, w); // background thread
+        WritePendingAutosaves(w, paths);
+        dyn::Append(saved_hashes, state.last_submitted_hash);
+    };
+    auto save = [&]() { save_with(writer); };
+
+    // The entry must decompress to exactly what was submitted, and decode as a preset.
+    auto check_entry = [&](AutosaveJournalEntry const& entry, u64 expected_hash) -> ErrorCodeOr<void> {
+        CHECK_EQ(entry.state_hash, expected_hash);
+        CHECK_EQ(Hash(entry.state_data), expected_hash);
+        TRY(DecodeFromMemory(entry.state_data, StateSource::PresetFile));
+        return k_success;
+    };
+
+    SUBCASE("history is recoverable from the journal") {
+        for (auto _ : Range(3))
+            save();
+
+        auto const entries = TRY(ReadAutosaveJournal(journal_path, tester.scratch_arena));
+        REQUIRE_EQ(entries.size, 3uz);
+        for (auto const i : Range(3uz))
+            TRY(check_entry(entries[i], saved_hashes[i]));
+        CHECK(entries[0].time_seconds <= entries[2].time_seconds);
+
+        // The latest state is also a preset file.
+        auto const preset_filename =
+            fmt::Format(tester.scratch_arena, "autosave {}" FLOE_PRESET_FILE_EXTENSION, InstanceId(state));
+        auto const preset_data = TRY(ReadEntireFile(
+            path::Join(tester.scratch_arena, Array {paths.autosave_path, (String)preset_filename}),
+            tester.scratch_arena));
+        CHECK_EQ(Hash(preset_data.ToByteSpan()), Last(saved_hashes));
+    }
+
+    SUBCASE("unchanged state is not written again") {
+        save();
+
+        // Force a save request with the same state.
+        state.state = AutosaveState::State::SaveRequested;
+        SubmitAutosaveIfNeeded(state, writer);
+        WritePendingAutosaves(writer, paths);
+
+        // Changes that cancel out are the same state too.
+        snapshot.param_values[0] += 1;
+        QueueAutosave(state, snapshot);
+        snapshot.param_values[0] -= 1;
         QueueAutosave(state, snapshot);
-        AutosaveToFileIfNeeded(state, paths);
+        SubmitAutosaveIfNeeded(state, writer);
+        WritePendingAutosaves(writer, paths);
+
+        auto const entries = TRY(ReadAutosaveJournal(journal_path, tester.scratch_arena));
+        CHECK_EQ(entries.size, 1uz);
+    }
+
+    SUBCASE("writes are coalesced") {
+        for (auto _ : Range(3)) {
+            snapshot.param_values[0] += 1;
+            QueueAutosave(state, snapshot);
+            SubmitAutosaveIfNeeded(state, writer);
+        }
+        CHECK_EQ(writer.pending.size, 1uz);
+        WritePendingAutosaves(writer, paths);
+
+        auto const entries = TRY(ReadAutosaveJournal(journal_path, tester.scratch_arena));
+        REQUIRE_EQ(entries.size, 1uz);
+        TRY(check_entry(entries[0], state.last_submitted_hash));
+    }
+
+    SUBCASE("instances with the same id don't replace each other's writes") {
+        AutosaveState duplicate {};
+        InitAutosaveState(duplicate, preferences, tester.random_seed, snapshot);
+        SetInstanceId(duplicate, InstanceId(state));
+
+        snapshot.param_values[0] += 1;
+        QueueAutosave(state, snapshot);
+        SubmitAutosaveIfNeeded(state, writer);
+        snapshot.param_values[0] += 1;
+        QueueAutosave(duplicate, snapshot);
+        SubmitAutosaveIfNeeded(duplicate, writer);
+        CHECK_EQ(writer.pending.size, 2uz);
+        WritePendingAutosaves(writer, paths);
+
+        auto const entries = TRY(ReadAutosaveJournal(journal_path, tester.scratch_arena));
+        REQUIRE_EQ(entries.size, 2uz);
+        TRY(check_entry(entries[0], state.last_submitted_hash));
+        TRY(check_entry(entries[1], duplicate.last_submitted_hash));
+    }
+
+    SUBCASE("another writer's entries are kept") {
+        save();
+
+        // As if another process with the same instance id appended to the journal after our last write.
+        {
+            AutosaveWriter other_writer {};
+            DEFER { DeinitAutosaveWriter(other_writer); };
+            save_with(other_writer);
+        }
+        save();
+
+        auto const entries = TRY(ReadAutosaveJournal(journal_path, tester.scratch_arena));
+        REQUIRE_EQ(entries.size, 3uz);
+        for (auto const i : Range(3uz))
+            TRY(check_entry(entries[i], saved_hashes[i]));
+    }
+
+    SUBCASE("history can be exported as presets") {
+        for (auto _ : Range(2))
+            save();
+
+        auto const export_folder = tests::TempFolderUnique(tester);
+        auto const exported = TRY(ExportAutosaveJournal(journal_path, export_folder, tester.scratch_arena));
+        REQUIRE_EQ(exported.size, 2uz);
+        for (auto const i : Range(2uz)) {
+            CHECK(path::Equal(path::Directory(exported[i]).ValueOr({}), export_folder));
+            auto const data = TRY(ReadEntireFile(exported[i], tester.scratch_arena));
+            CHECK_EQ(Hash(data.ToByteSpan()), saved_hashes[i]);
+            TRY(LoadPresetFile(exported[i], tester.scratch_arena));
+        }
+    }
+
+    SUBCASE("recovers from a partly-written entry") {
+        for (auto _ : Range(2))
+            save();
+
+        // As if the process crashed while appending.
+        {
+            auto const complete = TRY(ReadEntireFile(journal_path, tester.scratch_arena));
+            TRY(AppendFile(journal_path, complete.SubSpan(0, complete.size / 3)));
+        }
+
+        auto const entries = TRY(ReadAutosaveJournal(journal_path, tester.scratch_arena));
+        REQUIRE_EQ(entries.size, 2uz);
+        TRY(check_entry(entries[1], saved_hashes[1]));
+
+        // A new process carries on from the last good entry.
+        AutosaveWriter new_writer {};
+        DEFER { DeinitAutosaveWriter(new_writer); };
+        snapshot.param_values[0] += 1;
+        QueueAutosave(state, snapshot);
+        SubmitAutosaveIfNeeded(state, new_writer);
+        WritePendingAutosaves(new_writer, paths);
+
+        auto const entries_after = TRY(ReadAutosaveJournal(journal_path, tester.scratch_arena));
+        REQUIRE_EQ(entries_after.size, 3uz);
+        TRY(check_entry(entries_after[2], state.last_submitted_hash));
+    }
+
+    SUBCASE("journal is trimmed") {
+        constexpr u16 k_max = 3;
+        state.max_autosaves_per_instance.Store(k_max, StoreMemoryOrder::Relaxed);
+        for (auto _ : Range(k_max * 2 + 1))
+            save();
+
+        auto const entries = TRY(ReadAutosaveJournal(journal_path, tester.scratch_arena));
+        REQUIRE(entries.size >= k_max);
+        CHECK(entries.size <= k_max * 2);
+        TRY(check_entry(Last(entries), Last(saved_hashes)));
     }
 
     return k_success;
@@ -3,6 +3,7 @@
 
 #pragma once
 #include "foundation/foundation.hpp"
+#include "os/filesystem.hpp"
 #include "os/misc.hpp"
 
 #include "common_infrastructure/paths.hpp"
@@ -20,6 +21,50 @@ struct AutosaveState {
     Mutex mutex {};
     StateSnapshot snapshot {};
     State state {State::Idle};
+    u64 preset_uuid {}; // The identity of this instance's autosave preset.
+    u64 last_submitted_hash {}; // Background thread only.
+};
+
+// One per process, shared by every instance. Instances submit their encoded state and the writer does the
+// file work for all of them in a single pass. If an instance submits again before the pass, only its newest
+// state is written.
+//
+// For each instance id there's a preset file containing the latest state, and a journal that keeps the
+// history: an append-only file of compressed states. The journal is trimmed to max_autosaves_per_instance
+// entries from time to time. Instances in other processes can have the same id (a DAW project restores it),
+// so the files are only written while holding a lock on the journal.
+struct AutosaveWriter {
+    struct PendingWrite {
+        // Only compared, never dereferenced. Instance ids aren't unique so they can't say whose write it is.
+        AutosaveState const* source;
+        DynamicArrayBounded<char, k_max_instance_id_size> instance_id;
+        Span<u8> state_data; // Encoded preset, allocated with Malloc.
+        u64 state_hash;
+        s64 time_seconds; // Since epoch.
+        u16 max_history_entries;
+        u16 delete_after_days;
+    };
+    // What the journal was like when we last wrote to it. If another writer has changed it since, we read it
+    // again.
+    struct Journal {
+        DynamicArrayBounded<char, k_max_instance_id_size> instance_id;
+        Optional<FileIdentity> identity;
+        u64 size;
+        u32 num_entries;
+    };
+
+    Mutex mutex {};
+    DynamicArray<PendingWrite> pending {Malloc::Instance()};
+
+    // Only used by WritePendingAutosaves.
+    DynamicArray<Journal> journals {Malloc::Instance()};
+    bool cleaned_up_old_autosaves {};
+};
+
+struct AutosaveJournalEntry {
+    s64 time_seconds; // Since epoch.
+    u64 state_hash;
+    Span<u8 const> state_data; // Encoded preset, decode it with DecodeFromMemory.
 };
 
 // Run from main thread
@@ -50,4 +95,20 @@ prefs::Descriptor SettingDescriptor(AutosaveSetting setting);
 void OnPreferenceChanged(AutosaveState& state, prefs::Key const& key, prefs::Value const* value);
 
 // Run from background thread
-void AutosaveToFileIfNeeded(AutosaveState& state, FloePaths const& paths);
+// Encodes the state if a save was queued and hands it to the writer, unless it's the same as the last one.
+void SubmitAutosaveIfNeeded(AutosaveState& state, AutosaveWriter& writer);
+
+// Run from background thread
+void WritePendingAutosaves(AutosaveWriter& writer, FloePaths const& paths);
+void DeinitAutosaveWriter(AutosaveWriter& writer);
+
+String AutosaveJournalPath(FloePaths const& paths, String instance_id, Allocator& a);
+
+// Reads the entries of a journal, oldest first. Entries that were only partly written, for example because
+// the process crashed while appending, are ignored along with anything after them.
+ErrorCodeOr<Span<AutosaveJournalEntry>> ReadAutosaveJournal(String path, ArenaAllocator& arena);
+
+// Writes each entry of the journal into output_folder as a preset file, named after the journal and the time
+// of the entry, so that any of the history can be loaded. Returns the paths of the files, oldest first.
+ErrorCodeOr<Span<String>>
+ExportAutosaveJournal(String journal_path, String output_folder, ArenaAllocator& arena);
@@ -3,13 +3,187 @@
 
 #include "checksum_crc32_file.hpp"
 
+#if defined(__x86_64__)
+#include <smmintrin.h> // SSE4.1
+#include <wmmintrin.h> // PCLMULQDQ
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
 #include "os/filesystem.hpp"
+#include "os/misc.hpp"
 #include "tests/framework.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/thread_extra/thread_pool.hpp"
 
+#include "benchmarks/framework.hpp"
 #include "common_errors.hpp"
 
-static u32 Crc32(Span<u8 const> data) {
-    return CheckedCast<u32>(mz_crc32(MZ_CRC32_INIT, data.data, data.size));
+// CRC32
+// =================================================================================================
+// The zlib/PNG CRC (reflected polynomial 0xEDB88320), the same as miniz. Note that SSE4.2's CRC32 instruction
+// can't be used: it computes CRC32C, which uses a different polynomial.
+
+constexpr u32 k_crc32_polynomial = 0xEDB88320;
+
+struct Crc32Tables {
+    u32 t[16][256];
+};
+
+// Slicing-by-16 tables: t[0] is the classic byte-at-a-time table, t[n] advances a byte through n more zero
+// bytes.
+static constexpr Crc32Tables MakeCrc32Tables() {
+    Crc32Tables result {};
+    for (u32 i = 0; i < 256; ++i) {
+        u32 c = i;
+        for (auto _ : Range(8))
+            c = (c >> 1) ^ (k_crc32_polynomial & (0u - (c & 1)));
+        result.t[0][i] = c;
+    }
+    for (u32 i = 0; i < 256; ++i)
+        for (usize slice = 1; slice < 16; ++slice)
+            result.t[slice][i] = (result.t[slice - 1][i] >> 8) ^ result.t[0][result.t[slice - 1][i] & 0xff];
+    return result;
+}
+
+alignas(64) static constexpr Crc32Tables k_crc32_tables = MakeCrc32Tables();
+
+// crc is the raw (non-inverted) CRC register.
+static u32 Crc32RegisterSlicingBy16(u32 crc, u8 const* data, usize size) {
+    auto const& t = k_crc32_tables.t;
+    auto const load = [](u8 const* p) {
+        u32 v;
+        __builtin_memcpy_inline(&v, p, sizeof(v));
+        return v;
+    };
+    while (size >= 16) {
+        auto const a = load(data) ^ crc;
+        auto const b = load(data + 4);
+        auto const c = load(data + 8);
+        auto const d = load(data + 12);
+        crc = t[15][a & 0xff] ^ t[14][(a >> 8) & 0xff] ^ t[13][(a >> 16) & 0xff] ^ t[12][a >> 24] ^
+              t[11][b & 0xff] ^ t[10][(b >> 8) & 0xff] ^ t[9][(b >> 16) & 0xff] ^ t[8][b >> 24] ^
+              t[7][c & 0xff] ^ t[6][(c >> 8) & 0xff] ^ t[5][(c >> 16) & 0xff] ^ t[4][c >> 24] ^
+              t[3][d & 0xff] ^ t[2][(d >> 8) & 0xff] ^ t[1][(d >> 16) & 0xff] ^ t[0][d >> 24];
+        data += 16;
+        size -= 16;
+    }
+    while (size--)
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xff];
+    return crc;
+}
+
+#if defined(__x86_64__)
+
+#define CRC32_PCLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+
+static ALWAYS_INLINE __m128i Load128(u8 const* p) { return _mm_loadu_si128((__m128i const*)p); }
+
+// Multiplies both halves of x by the matching constant in k and adds (xors) in the next block.
+CRC32_PCLMUL_TARGET static ALWAYS_INLINE __m128i Fold128(__m128i x, __m128i k, __m128i next) {
+    auto const lo = _mm_clmulepi64_si128(x, k, 0x00);
+    auto const hi = _mm_clmulepi64_si128(x, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(hi, lo), next);
+}
+
+// Folds 64 bytes at a time using carry-less multiplication, then Barrett-reduces to 32 bits. This is the
+// method from Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" paper, using
+// the bit-reflected constants for our polynomial given there. size must be at least 64 and a multiple of 16.
+CRC32_PCLMUL_TARGET static u32 Crc32RegisterPclmul(u32 crc, u8 const* data, usize size) {
+    ASSERT_HOT(size >= 64 && size % 16 == 0);
+
+    alignas(16) static constexpr u64 k_k1k2[] = {0x0154442bd4, 0x01c6e41596};
+    alignas(16) static constexpr u64 k_k3k4[] = {0x01751997d0, 0x00ccaa009e};
+    alignas(16) static constexpr u64 k_k5k0[] = {0x0163cd6124, 0x0000000000};
+    alignas(16) static constexpr u64 k_poly[] = {0x01db710641, 0x01f7011641};
+
+    auto x1 = _mm_xor_si128(Load128(data), _mm_cvtsi32_si128((int)crc));
+    auto x2 = Load128(data + 16);
+    auto x3 = Load128(data + 32);
+    auto x4 = Load128(data + 48);
+    data += 64;
+    size -= 64;
+
+    auto k = _mm_load_si128((__m128i const*)k_k1k2);
+    while (size >= 64) {
+        x1 = Fold128(x1, k, Load128(data));
+        x2 = Fold128(x2, k, Load128(data + 16));
+        x3 = Fold128(x3, k, Load128(data + 32));
+        x4 = Fold128(x4, k, Load128(data + 48));
+        data += 64;
+        size -= 64;
+    }
+
+    // Fold the 4 lanes into 1.
+    k = _mm_load_si128((__m128i const*)k_k3k4);
+    x1 = Fold128(x1, k, x2);
+    x1 = Fold128(x1, k, x3);
+    x1 = Fold128(x1, k, x4);
+    while (size >= 16) {
+        x1 = Fold128(x1, k, Load128(data));
+        data += 16;
+        size -= 16;
+    }
+
+    // 128 to 64 bits.
+    auto const mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    k = _mm_loadl_epi64((__m128i const*)k_k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x00), x2);
+
+    // Barrett reduction to 32 bits.
+    k = _mm_load_si128((__m128i const*)k_poly);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask32), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (u32)_mm_extract_epi32(x1, 1);
+}
+
+static bool CpuHasPclmul() {
+    static bool const result = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+    return result;
+}
+
+#endif
+
+u32 Crc32(u32 crc, Span<u8 const> data) {
+    auto p = data.data;
+    auto size = data.size;
+    crc = ~crc;
+
+#if defined(__x86_64__)
+    if (size >= 64 && CpuHasPclmul()) {
+        auto const folded_size = size & ~(usize)15;
+        crc = Crc32RegisterPclmul(crc, p, folded_size);
+        p += folded_size;
+        size -= folded_size;
+    }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    while (size >= 8) {
+        u64 v;
+        __builtin_memcpy_inline(&v, p, sizeof(v));
+        crc = __crc32d(crc, v);
+        p += 8;
+        size -= 8;
+    }
+#endif
+
+    return ~Crc32RegisterSlicingBy16(crc, p, size);
+}
+
+constexpr usize k_file_read_chunk_size = Mb(1);
+
+static ErrorCodeOr<u32> Crc32OfFile(File& file, Span<u8> buffer) {
+    u32 crc = MZ_CRC32_INIT;
+    while (true) {
+        auto const num_read = TRY(file.Read(buffer.data, buffer.size));
+        if (num_read == 0) break;
+        crc = Crc32(crc, buffer.SubSpan(0, num_read));
+    }
+    return crc;
 }
 
 static String SerialiseChecksumsValues(HashTable<String, ChecksumValues> checksum_values,
@@ -92,18 +266,192 @@ ErrorCodeOr<ChecksumTable> ParseChecksumFile(String checksum_file_data, ArenaAll
     return checksum_values;
 }
 
-ErrorCodeOr<u32> ChecksumForFile(String path, ArenaAllocator& scratch_arena) {
-    auto const file_data = TRY(ReadEntireFile(path, scratch_arena)).ToByteSpan();
+// Checksum cache
+// =================================================================================================
+
+constexpr String k_checksum_cache_filename = "checksum_cache.bin"_s;
+constexpr u32 k_checksum_cache_version = 1;
+
+ChecksumCache& SharedChecksumCache() {
+    static ArenaAllocatorWithInlineStorage<1000> path_arena {Malloc::Instance()};
+    static ChecksumCache cache {
+        .file_path = KnownDirectoryWithSubdirectories(path_arena,
+                                                      KnownDirectoryType::UserData,
+                                                      Array {"Floe"_s},
+                                                      k_checksum_cache_filename,
+                                                      {.create = true}),
+    };
+    return cache;
+}
+
+// Record format, all little-endian: u32 path size, path, u32 crc32, u64 file size, s64 modified time,
+// u64 device, u64 inode.
+//
+// Adds the file's entries for paths that the cache doesn't already have: the in-memory entry is always at
+// least as fresh. The file must be locked. If include_entry is given, it filters the file's entries.
+static void ReadChecksumCacheFile(File& file,
+                                  ChecksumCache& cache,
+                                  TrivialFunctionRef<bool(String path)> include_entry = {}) {
+    if (TRY_OR(file.FileSize(), return;) > Mb(64)) return;
+    ArenaAllocator scratch {PageAllocator::Instance()};
+    auto const data = TRY_OR(file.ReadWholeFile(scratch), return;).ToByteSpan();
+
+    auto p = data.data;
+    auto const end = data.data + data.size;
+    auto const read = [&](auto& value) {
+        if ((usize)(end - p) < sizeof(value)) return false;
+        __builtin_memcpy_inline(&value, p, sizeof(value));
+        p += sizeof(value);
+        return true;
+    };
+
+    u32 version;
+    if (!read(version) || version != k_checksum_cache_version) return;
+
+    while (p < end) {
+        u32 path_size;
+        if (!read(path_size) || (usize)(end - p) < path_size) break;
+        String const path {(char const*)p, path_size};
+        p += path_size;
+
+        ChecksumCache::Entry entry;
+        if (!read(entry.crc32) || !read(entry.file_size) || !read(entry.modified_time_ns) ||
+            !read(entry.identity.device) || !read(entry.identity.inode))
+            break;
+        if (cache.entries.Find(path)) continue;
+        if (include_entry && !include_entry(path)) continue;
+        cache.entries.InsertGrowIfNeeded(cache.arena, cache.arena.Clone(path), entry);
+    }
+}
+
+static void LoadChecksumCacheIfNeeded(ChecksumCache& cache) {
+    if (cache.loaded) return;
+    cache.loaded = true;
+    if (!cache.file_path.size) return;
+
+    auto file = TRY_OR(OpenFile(cache.file_path,
+                                {
+                                    .capability = FileMode::Capability::Read,
+                                    .win32_share = FileMode::Share::ReadWrite | FileMode::Share::DeleteRename,
+                                    .creation = FileMode::Creation::OpenExisting,
+                                }),
+                       return;);
+
+    TRY_OR(file.Lock({.type = FileLockOptions::Type::Shared}), return);
+    DEFER { auto _ = file.Unlock(); };
+
+    ReadChecksumCacheFile(file, cache);
+}
+
+void SaveChecksumCacheIfNeeded(ChecksumCache& cache) {
+    cache.mutex.Lock();
+    DEFER { cache.mutex.Unlock(); };
+    if (!cache.dirty || !cache.file_path.size) return;
+    cache.dirty = false;
+
+    // Other processes share the file, so it's only truncated once we hold the lock, and what they've added
+    // since we loaded it is merged in rather than overwritten.
+    auto file = TRY_OR(
+        OpenFile(cache.file_path,
+                 {
+                     .capability = FileMode::Capability::ReadWrite,
+                     .win32_share = FileMode::Share::ReadWrite,
+                     .creation = FileMode::Creation::OpenAlways,
+                     .everyone_read_write = true,
+                 }),
+        {
+            LogError(ModuleName::Package, "Failed to open checksum cache for write: {}", error);
+            return;
+        });
+
+    TRY_OR(file.Lock({.type = FileLockOptions::Type::Exclusive}), return);
+    DEFER { auto _ = file.Unlock(); };
+
+    // Files that no longer exist are skipped, else entries that we've removed would come back.
+    ReadChecksumCacheFile(file, cache, [](String path) { return GetFileType(path).HasValue(); });
+
+    TRY_OR(file.Seek(0, File::SeekOrigin::Start), return);
+    TRY_OR(file.Truncate(0), return);
+
+    BufferedWriter<Kb(16)> buffered {.unbuffered_writer = file.Writer()};
     DEFER {
-        if (file_data.size) scratch_arena.Free(file_data);
+        buffered.FlushReset();
+        auto _ = file.Flush();
     };
-    return Crc32(file_data);
+
+    auto const write = [&](auto const& value) {
+        return buffered.Writer().WriteBytes({(u8 const*)&value, sizeof(value)});
+    };
+
+    TRY_OR(write(k_checksum_cache_version), return);
+    for (auto const& [path, entry, _] : cache.entries) {
+        TRY_OR(write((u32)path.size), return);
+        TRY_OR(buffered.Writer().WriteBytes(path.ToByteSpan()), return);
+        TRY_OR(write(entry.crc32), return);
+        TRY_OR(write(entry.file_size), return);
+        TRY_OR(write(entry.modified_time_ns), return);
+        TRY_OR(write(entry.identity.device), return);
+        TRY_OR(write(entry.identity.inode), return);
+    }
 }
 
-ErrorCodeOr<ChecksumTable>
-ChecksumsForFolder(String folder, ArenaAllocator& arena, ArenaAllocator& scratch_arena) {
-    ChecksumTable checksums {};
+static ErrorCodeOr<u32>
+ChecksumForFileUsingCache(String path, u64 file_size, ChecksumCache* cache, Span<u8> buffer) {
+    auto file = TRY(OpenFile(path, FileMode::Read()));
+    if (!cache) return Crc32OfFile(file, buffer);
+
+    auto const modified_time_ns = (s64)TRY(file.LastModifiedTimeNsSinceEpoch());
+    auto const identity = TRY(file.Identity());
+
+    {
+        cache->mutex.Lock();
+        DEFER { cache->mutex.Unlock(); };
+        LoadChecksumCacheIfNeeded(*cache);
+        if (auto const entry = cache->entries.Find(path)) {
+            if (entry->file_size == file_size && entry->modified_time_ns == modified_time_ns &&
+                entry->identity == identity)
+                return entry->crc32;
+        }
+    }
+
+    auto const crc32 = TRY(Crc32OfFile(file, buffer));
+
+    {
+        cache->mutex.Lock();
+        DEFER { cache->mutex.Unlock(); };
+        ChecksumCache::Entry const entry {
+            .crc32 = crc32,
+            .file_size = file_size,
+            .modified_time_ns = modified_time_ns,
+            .identity = identity,
+        };
+        if (auto const existing = cache->entries.Find(path))
+            *existing = entry;
+        else
+            cache->entries.InsertGrowIfNeeded(cache->arena, cache->arena.Clone(path), entry);
+        cache->dirty = true;
+        ++cache->num_files_read;
+    }
 
+    return crc32;
+}
+
+// Checksums
+// =================================================================================================
+
+ErrorCodeOr<u32> ChecksumForFile(String path, ArenaAllocator& scratch_arena) {
+    auto file = TRY(OpenFile(path, FileMode::Read()));
+    auto const buffer = scratch_arena.AllocateExactSizeUninitialised<u8>(k_file_read_chunk_size);
+    DEFER { scratch_arena.Free(buffer); };
+    return Crc32OfFile(file, buffer);
+}
+
+constexpr u32 k_max_checksum_threads = 8;
+
+ErrorCodeOr<ChecksumTable> ChecksumsForFolder(String folder,
+                                              ArenaAllocator& arena,
+                                              ArenaAllocator& scratch_arena,
+                                              ChecksumCache* cache) {
     auto it = TRY(dir_iterator::RecursiveCreate(scratch_arena,
                                                 folder,
                                                 {
@@ -113,12 +461,17 @@ ChecksumsForFolder(String folder, ArenaAllocator& arena, ArenaAllocator& scratch
                                                 }));
     DEFER { dir_iterator::Destroy(it); };
 
-    ArenaAllocator inner_arena {PageAllocator::Instance()};
+    struct FolderFile {
+        String relative_path;
+        String full_path;
+        u64 file_size;
+        u32 crc32;
+        Optional<ErrorCode> error;
+    };
+    DynamicArray<FolderFile> files {scratch_arena};
 
     while (auto entry = TRY(dir_iterator::Next(it, arena))) {
         if (entry->type == FileType::File) {
-            inner_arena.ResetCursorAndConsolidateRegions();
-
             if (path::IgnorableSystemFile(entry->subpath)) continue;
 
             auto relative_path = entry->subpath;
@@ -129,17 +482,60 @@ ChecksumsForFolder(String folder, ArenaAllocator& arena, ArenaAllocator& scratch
             ASSERT(relative_path.size);
             ASSERT(relative_path[0] != '/');
 
-            auto const file_data =
-                TRY(ReadEntireFile(dir_iterator::FullPath(it, *entry, inner_arena), inner_arena))
-                    .ToByteSpan();
+            dyn::Append(files,
+                        {
+                            .relative_path = relative_path,
+                            .full_path = dir_iterator::FullPath(it, *entry, scratch_arena),
+                            .file_size = entry->file_size,
+                        });
+        }
+    }
+
+    auto const num_threads =
+        Min(k_max_checksum_threads, CachedSystemStats().num_logical_cpus, Max((u32)files.size, 1u));
+    // One read buffer per thread.
+    auto const buffers =
+        scratch_arena.AllocateExactSizeUninitialised<u8>(num_threads * k_file_read_chunk_size);
+    DEFER { scratch_arena.Free(buffers); };
+
+    ParallelFor("checksum", (u32)files.size, num_threads, [&](u32 index, u32 thread_index) {
+        auto& file = files[index];
+        auto const buffer = buffers.SubSpan(thread_index * k_file_read_chunk_size, k_file_read_chunk_size);
+        auto const outcome = ChecksumForFileUsingCache(file.full_path, file.file_size, cache, buffer);
+        if (outcome.HasError())
+            file.error = outcome.Error();
+        else
+            file.crc32 = outcome.Value();
+        return !file.error;
+    });
 
-            checksums.InsertGrowIfNeeded(arena,
-                                         relative_path,
-                                         ChecksumValues {
-                                             .crc32 = Crc32(file_data),
-                                             .file_size = entry->file_size,
-                                         });
+    ChecksumTable checksums {};
+    for (auto const& file : files) {
+        if (file.error) return *file.error;
+        checksums.InsertGrowIfNeeded(arena,
+                                     file.relative_path,
+                                     ChecksumValues {
+                                         .crc32 = file.crc32,
+                                         .file_size = file.file_size,
+                                     });
+    }
+
+    if (cache) {
+        // Forget files in this folder that no longer exist so that the cache doesn't grow forever.
+        {
+            auto seen = Set<String>::Create(scratch_arena, files.size);
+            for (auto const& file : files)
+                seen.InsertWithoutGrowing(file.full_path);
+
+            cache->mutex.Lock();
+            DEFER { cache->mutex.Unlock(); };
+            auto const num_removed = cache->entries.RemoveIf([&](String path, ChecksumCache::Entry const&) {
+                return path.size > it.base_path.size + 1 && StartsWithSpan(path, it.base_path) &&
+                       path::IsDirectorySeparator(path[it.base_path.size]) && !seen.Contains(path);
+            });
+            if (num_removed) cache->dirty = true;
         }
+        SaveChecksumCacheIfNeeded(*cache);
     }
 
     return checksums;
@@ -209,8 +605,10 @@ ErrorCodeOr<bool>
 FileMatchesChecksum(String filepath, ChecksumValues const& checksum, ArenaAllocator& scratch_arena) {
     auto f = TRY(OpenFile(filepath, FileMode::Read()));
     auto const file_size = TRY(f.FileSize());
-    return file_size == checksum.file_size &&
-           Crc32(TRY(f.ReadWholeFile(scratch_arena)).ToByteSpan()) == checksum.crc32;
+    if (file_size != checksum.file_size) return false;
+    auto const buffer = scratch_arena.AllocateExactSizeUninitialised<u8>(k_file_read_chunk_size);
+    DEFER { scratch_arena.Free(buffer); };
+    return TRY(Crc32OfFile(f, buffer)) == checksum.crc32;
 }
 
 TEST_CASE(TestCompareChecksums) {
@@ -355,7 +753,198 @@ abcdef01 5678 /path/to/another/file)raw"_s;
     return k_success;
 }
 
+TEST_CASE(TestCrc32) {
+    auto const miniz_crc32 = [](u32 crc, Span<u8 const> data) {
+        return (u32)mz_crc32(crc, data.data, data.size);
+    };
+
+    CHECK_EQ(Crc32(MZ_CRC32_INIT, "123456789"_s.ToByteSpan()), 0xCBF43926u);
+    CHECK_EQ(Crc32(MZ_CRC32_INIT, {}), 0u);
+
+    auto const data = tester.scratch_arena.AllocateExactSizeUninitialised<u8>(Kb(300));
+    u64 seed = 42;
+    for (auto& b : data)
+        b = (u8)RandomIntInRange<u32>(seed, 0, 255);
+
+    SUBCASE("matches miniz for every size and alignment") {
+        for (auto const offset : Range(17uz))
+            for (auto const size : Range(300uz))
+                REQUIRE_EQ(Crc32(MZ_CRC32_INIT, data.SubSpan(offset, size)),
+                           miniz_crc32(MZ_CRC32_INIT, data.SubSpan(offset, size)));
+        for (auto const size : Array {Kb(64) - 1, Kb(64), Kb(64) + 15, Kb(299)})
+            CHECK_EQ(Crc32(MZ_CRC32_INIT, data.SubSpan(1, size)),
+                     miniz_crc32(MZ_CRC32_INIT, data.SubSpan(1, size)));
+    }
+
+    SUBCASE("can be streamed") {
+        auto const expected = miniz_crc32(MZ_CRC32_INIT, data);
+        for (auto const split : Array {1uz, 63uz, 64uz, 1000uz, Kb(100) + 7}) {
+            auto const first = Crc32(MZ_CRC32_INIT, data.SubSpan(0, split));
+            CHECK_EQ(Crc32(first, data.SubSpan(split)), expected);
+        }
+    }
+
+    return k_success;
+}
+
+TEST_CASE(TestChecksumsForFolder) {
+    auto& a = tester.scratch_arena;
+    auto const folder = tests::TempFolderUnique(tester);
+
+    struct TestFile {
+        String relative_path;
+        usize size;
+    };
+    // One file is bigger than the read chunk so that it is read in several parts.
+    Array const test_files {
+        TestFile {"a.txt"_s, 10},
+        TestFile {"empty"_s, 0},
+        TestFile {"sub/b.bin"_s, k_file_read_chunk_size * 2 + 100},
+        TestFile {"sub/deeper/c"_s, 5000},
+    };
+
+    u64 seed = 1;
+    auto const write_file = [&](String relative_path, usize size) -> ErrorCodeOr<Span<u8 const>> {
+        auto const data = a.AllocateExactSizeUninitialised<u8>(size);
+        for (auto& b : data)
+            b = (u8)RandomIntInRange<u32>(seed, 0, 255);
+        auto const path = path::Join(a, Array {folder, relative_path});
+        TRY(CreateDirectory(*path::Directory(path), {.create_intermediate_directories = true}));
+        TRY(WriteFile(path, data));
+        return data;
+    };
+
+    HashTable<String, ChecksumValues> expected {};
+    for (auto const& f : test_files) {
+        auto const data = TRY(write_file(f.relative_path, f.size));
+        expected.InsertGrowIfNeeded(a,
+                                    f.relative_path,
+                                    {.crc32 = (u32)mz_crc32(MZ_CRC32_INIT, data.data, data.size),
+                                     .file_size = f.size});
+    }
+
+    auto const check_matches_expected = [&](ChecksumTable const& table) {
+        CHECK_EQ(table.size, expected.size);
+        CHECK_EQ(CompareChecksums(expected, table, {}), CompareChecksumsResult::Same);
+    };
+
+    SUBCASE("no cache") { check_matches_expected(TRY(ChecksumsForFolder(folder, a, a))); }
+
+    SUBCASE("unchanged files are not read again") {
+        ChecksumCache cache {};
+        check_matches_expected(TRY(ChecksumsForFolder(folder, a, a, &cache)));
+        CHECK_EQ(cache.num_files_read, (u64)test_files.size);
+
+        check_matches_expected(TRY(ChecksumsForFolder(folder, a, a, &cache)));
+        CHECK_EQ(cache.num_files_read, (u64)test_files.size);
+
+        // Same size but different content and time.
+        auto const path = path::Join(a, Array {folder, "a.txt"_s});
+        auto const original_time = TRY(LastModifiedTimeNsSinceEpoch(path));
+        auto const data = TRY(write_file("a.txt"_s, 10));
+        TRY(SetLastModifiedTimeNsSinceEpoch(path, original_time + 2'000'000'000));
+        expected.Find("a.txt"_s)->crc32 = (u32)mz_crc32(MZ_CRC32_INIT, data.data, data.size);
+
+        check_matches_expected(TRY(ChecksumsForFolder(folder, a, a, &cache)));
+        CHECK_EQ(cache.num_files_read, (u64)test_files.size + 1);
+
+        // Deleted files are forgotten.
+        TRY(Delete(path, {}));
+        expected.Delete("a.txt"_s);
+        check_matches_expected(TRY(ChecksumsForFolder(folder, a, a, &cache)));
+        CHECK(!cache.entries.Find(path));
+        CHECK_EQ(cache.entries.size, test_files.size - 1);
+    }
+
+    SUBCASE("cache is persisted") {
+        auto const cache_path = tests::TempFilename(tester);
+        {
+            ChecksumCache cache {.file_path = cache_path};
+            check_matches_expected(TRY(ChecksumsForFolder(folder, a, a, &cache)));
+            CHECK_EQ(cache.num_files_read, (u64)test_files.size);
+        }
+        {
+            ChecksumCache cache {.file_path = cache_path};
+            check_matches_expected(TRY(ChecksumsForFolder(folder, a, a, &cache)));
+            CHECK_EQ(cache.num_files_read, (u64)0);
+        }
+    }
+
+    SUBCASE("caches sharing a file keep each other's entries") {
+        auto const cache_path = tests::TempFilename(tester);
+        auto const other_folder = tests::TempFolderUnique(tester);
+        TRY(WriteFile(path::Join(a, Array {other_folder, "d.txt"_s}), "other"_s));
+
+        // Both loaded the file before either saved, like two processes running at once.
+        ChecksumCache cache_1 {.file_path = cache_path};
+        ChecksumCache cache_2 {.file_path = cache_path};
+        cache_1.loaded = true;
+        cache_2.loaded = true;
+        check_matches_expected(TRY(ChecksumsForFolder(folder, a, a, &cache_1)));
+        CHECK_EQ(TRY(ChecksumsForFolder(other_folder, a, a, &cache_2)).size, (usize)1);
+
+        ChecksumCache cache {.file_path = cache_path};
+        check_matches_expected(TRY(ChecksumsForFolder(folder, a, a, &cache)));
+        CHECK_EQ(TRY(ChecksumsForFolder(other_folder, a, a, &cache)).size, (usize)1);
+        CHECK_EQ(cache.num_files_read, (u64)0);
+    }
+
+    return k_success;
+}
+
 TEST_REGISTRATION(RegisterChecksumFileTests) {
     REGISTER_TEST(TestChecksumFileParsing);
     REGISTER_TEST(TestCompareChecksums);
+    REGISTER_TEST(TestCrc32);
+    REGISTER_TEST(TestChecksumsForFolder);
+}
+
+BENCHMARK_FN void BenchmarkCrc32(bool use_miniz) {
+    ArenaAllocator arena {PageAllocator::Instance()};
+    auto const data = arena.AllocateExactSizeUninitialised<u8>(Mb(64));
+    for (auto [i, b] : Enumerate(data))
+        b = (u8)(i * 2654435761u >> 24);
+
+    u32 crc = MZ_CRC32_INIT;
+    for (auto _ : Range(16)) {
+        if (use_miniz)
+            crc = (u32)mz_crc32(crc, data.data, data.size);
+        else
+            crc = Crc32(crc, data);
+    }
+    benchmarks::DoNotOptimise(crc);
+}
+
+// A library-sized folder: 64 files of 1 MB.
+BENCHMARK_FN void BenchmarkChecksumsForFolder(bool cached) {
+    ArenaAllocator arena {PageAllocator::Instance()};
+    u64 seed = RandomSeed();
+    auto const folder = TemporaryDirectoryWithinFolder(
+                            KnownDirectory(arena, KnownDirectoryType::Temporary, {.create = true}),
+                            arena,
+                            seed)
+                            .Value();
+    DEFER { auto _ = Delete(folder, {.type = DeleteOptions::Type::DirectoryRecursively}); };
+
+    auto const data = arena.AllocateExactSizeUninitialised<u8>(Mb(1));
+    for (auto const file_index : Range(64u)) {
+        for (auto [i, b] : Enumerate(data))
+            b = (u8)((i * (file_index + 1)) >> 3);
+        auto const filename = fmt::Format(arena, "{}.flac", file_index);
+        auto const path = path::Join(arena, Array {folder, (String)filename});
+        if (WriteFile(path, data).HasError()) Panic("failed to write benchmark file");
+    }
+
+    ChecksumCache cache {};
+    for (auto _ : Range(8)) {
+        auto const table = ChecksumsForFolder(folder, arena, arena, cached ? &cache : nullptr);
+        if (table.HasError()) Panic("failed to checksum benchmark folder");
+    }
+}
+
+BENCHMARK_REGISTRATION(RegisterChecksumBenchmarks) {
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkCrc32(true); }, "Crc32/Miniz");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkCrc32(false); }, "Crc32/Fast");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkChecksumsForFolder(false); }, "ChecksumsForFolder/Uncached");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkChecksumsForFolder(true); }, "ChecksumsForFolder/Cached");
 }
@@ -5,6 +5,8 @@
 #include <miniz.h>
 
 #include "foundation/foundation.hpp"
+#include "os/filesystem.hpp"
+#include "os/threading.hpp"
 
 struct ChecksumValues {
     u32 crc32;
@@ -19,6 +21,39 @@ struct ChecksumLine {
 
 using ChecksumTable = HashTable<String, ChecksumValues>;
 
+// Gives exactly the same result as mz_crc32(crc, data.data, data.size), but is much faster. Uses PCLMULQDQ
+// folding on x86_64 CPUs that have it, the CRC32 instructions on aarch64, and slicing-by-16 otherwise.
+u32 Crc32(u32 crc, Span<u8 const> data);
+
+// Remembers the CRC32 of files that we've already read, so that files that haven't changed are never read
+// again. A file is considered unchanged if its path, size, modified time and identity (inode) all match.
+// Thread-safe.
+struct ChecksumCache {
+    struct Entry {
+        u32 crc32;
+        u64 file_size;
+        s64 modified_time_ns;
+        FileIdentity identity;
+    };
+
+    // Where the cache is persisted. If empty the cache only lives in memory.
+    String const file_path {};
+
+    Mutex mutex {};
+    ArenaAllocator arena {PageAllocator::Instance()};
+    HashTable<String, Entry> entries {}; // Absolute path -> entry.
+    bool loaded {};
+    bool dirty {};
+    u64 num_files_read {}; // Files that were not in the cache and had to be read.
+};
+
+// The cache used for installed libraries, persisted in the user data folder and shared between processes.
+ChecksumCache& SharedChecksumCache();
+
+// Writes the cache to its file_path if anything has changed. Failure to write it is logged but otherwise
+// ignored.
+void SaveChecksumCacheIfNeeded(ChecksumCache& cache);
+
 void AppendChecksumLine(DynamicArray<char>& buffer, ChecksumLine line);
 
 void AppendCommentLine(DynamicArray<char>& buffer, String comment);
@@ -31,8 +66,12 @@ ErrorCodeOr<ChecksumTable> ParseChecksumFile(String checksum_file_data, ArenaAll
 
 ErrorCodeOr<u32> ChecksumForFile(String path, ArenaAllocator& scratch_arena);
 
-ErrorCodeOr<ChecksumTable>
-ChecksumsForFolder(String folder, ArenaAllocator& arena, ArenaAllocator& scratch_arena);
+// Files are read on several threads at once. If a cache is given, unchanged files are not read at all and the
+// cache is saved afterwards.
+ErrorCodeOr<ChecksumTable> ChecksumsForFolder(String folder,
+                                              ArenaAllocator& arena,
+                                              ArenaAllocator& scratch_arena,
+                                              ChecksumCache* cache = nullptr);
 
 enum class CompareChecksumsResult : u8 { Same, Differ, SameButHasExtraFiles };
 
@@ -3991,6 +3991,20 @@ Span<String const> ParameterMenuItems(ParamIndex param_index);
 String ParamMenuText(ParamIndex index, f32 value);
 inline bool ParamToBool(f32 value) { return value != 0; }
 
+// A hash of a set of param values is the XOR of a term per param, so it can be updated in O(1) when one
+// value changes: hash ^= ParamValueHashTerm(i, old) ^ ParamValueHashTerm(i, new).
+inline u64 ParamValueHashTerm(usize param_index, f32 value) {
+    if (value == 0) value = 0; // -0 == 0, so they must hash the same.
+    return Hash(((u64)param_index << 32) | __builtin_bit_cast(u32, value));
+}
+
+inline u64 HashParamValues(Span<f32 const> param_values) {
+    u64 result = 0;
+    for (auto const [i, value] : Enumerate(param_values))
+        result ^= ParamValueHashTerm(i, value);
+    return result;
+}
+
 template <typename Type>
 Type ParamToInt(f32 value) {
     auto const i = (s64)Trunc(value);
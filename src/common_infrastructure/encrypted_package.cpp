@@ -4,7 +4,9 @@
 #include "encrypted_package.hpp"
 
 #include "foundation/zig_std/zig_std.hpp"
+#include "os/threading.hpp"
 #include "tests/framework.hpp"
+#include "utils/thread_extra/thread_pool.hpp"
 
 namespace encrypted_package {
 
@@ -51,40 +53,60 @@ ErrorCodeOr<Header> ReadHeader(Reader& reader) {
 // (e.g. truncating total_plaintext_size) causes chunk authentication to fail.
 static Span<u8 const> HeaderAad(Header const& header) { return {(u8 const*)&header, sizeof(Header)}; }
 
-// Decrypt a single chunk from the source reader.
-// source_offset is the file offset where this chunk's ciphertext begins.
-// plaintext_size is the number of plaintext bytes in this chunk (may be less than chunk_size for last chunk).
-static ErrorCodeOr<void> DecryptChunk(Reader& source,
-                                      Header const& header,
-                                      u64 source_offset,
-                                      usize plaintext_size,
-                                      u64 chunk_index,
-                                      u8 const* package_key,
-                                      u8* plaintext_out,
-                                      u8* ciphertext_buf) {
-    auto const ct_plus_tag_size = plaintext_size + k_tag_size;
-    source.pos = (usize)source_offset;
-    auto const bytes_read = TRY(source.Read(ciphertext_buf, ct_plus_tag_size));
-    if (bytes_read < ct_plus_tag_size) return ErrorCode {EncryptedPackageError::DecryptionFailed};
-
+static ErrorCodeOr<void> AuthenticateAndDecryptChunk(Header const& header,
+                                                     u64 chunk_index,
+                                                     usize plaintext_size,
+                                                     u8 const* package_key,
+                                                     u8 const* ciphertext,
+                                                     u8* plaintext_out) {
     u8 nonce[k_nonce_size];
     DeriveChunkNonce(nonce, header.nonce_seed, chunk_index);
 
     auto const aad = HeaderAad(header);
-    auto const* tag = ciphertext_buf + plaintext_size;
     if (!XChaCha20Poly1305Decrypt(plaintext_out,
-                                  ciphertext_buf,
+                                  ciphertext,
                                   plaintext_size,
                                   aad.data,
                                   aad.size,
-                                  tag,
+                                  ciphertext + plaintext_size,
                                   nonce,
                                   package_key))
         return ErrorCode {EncryptedPackageError::DecryptionFailed};
-
     return k_success;
 }
 
+// Decrypt a single chunk from the source reader.
+// source_offset is the file offset where this chunk's ciphertext begins.
+// plaintext_size is the number of plaintext bytes in this chunk (may be less than chunk_size for last chunk).
+// If source_mutex is given, it's held while reading from the source.
+static ErrorCodeOr<void> DecryptChunk(Reader& source,
+                                      Header const& header,
+                                      u64 source_offset,
+                                      usize plaintext_size,
+                                      u64 chunk_index,
+                                      u8 const* package_key,
+                                      u8* plaintext_out,
+                                      u8* ciphertext_buf,
+                                      Mutex* source_mutex = nullptr) {
+    auto const ct_plus_tag_size = plaintext_size + k_tag_size;
+    {
+        if (source_mutex) source_mutex->Lock();
+        DEFER {
+            if (source_mutex) source_mutex->Unlock();
+        };
+        source.pos = (usize)source_offset;
+        auto const bytes_read = TRY(source.Read(ciphertext_buf, ct_plus_tag_size));
+        if (bytes_read < ct_plus_tag_size) return ErrorCode {EncryptedPackageError::DecryptionFailed};
+    }
+
+    return AuthenticateAndDecryptChunk(header,
+                                       chunk_index,
+                                       plaintext_size,
+                                       package_key,
+                                       ciphertext_buf,
+                                       plaintext_out);
+}
+
 ErrorCodeOr<void> VerifyContentKey(Reader& source, Header const& header, Span<u8 const> package_key) {
     ASSERT(package_key.size == k_key_size);
     auto const first_chunk_plaintext_size = Min((u64)header.chunk_size, header.total_plaintext_size);
@@ -103,48 +125,271 @@ ErrorCodeOr<void> VerifyContentKey(Reader& source, Header const& header, Span<u8
                         ct_buf);
 }
 
+static usize ChunkPlaintextSize(Header const& header, u64 chunk_index) {
+    auto const num_full_chunks = header.total_plaintext_size / header.chunk_size;
+    auto const remainder = header.total_plaintext_size % header.chunk_size;
+    if (chunk_index < num_full_chunks) return header.chunk_size;
+    if (chunk_index == num_full_chunks && remainder > 0) return (usize)remainder;
+    return 0; // past the end
+}
+
+static u64 ChunkFileOffset(Header const& header, u64 chunk_index) {
+    // Each on-disk chunk is plaintext_size + tag bytes. All but possibly the last chunk are
+    // exactly chunk_size, so the offset of any chunk is just the count of full chunks before it.
+    auto const num_full_chunks = header.total_plaintext_size / header.chunk_size;
+    auto const full_chunks_before = Min(chunk_index, num_full_chunks);
+    return sizeof(Header) + (full_chunks_before * ((u64)header.chunk_size + k_tag_size));
+}
+
+static u64 NumChunks(Header const& header) {
+    return (header.total_plaintext_size + header.chunk_size - 1) / header.chunk_size;
+}
+
+constexpr u32 k_max_read_ahead_jobs = k_read_ahead_chunks / k_read_ahead_chunks_per_job;
+
+struct DecryptingReader::ChunkCache {
+    enum class SlotState : u8 {
+        Empty,
+        Queued, // A read-ahead job will decrypt it, but hasn't started yet.
+        Decrypting,
+        Ready,
+    };
+
+    struct Slot {
+        u64 chunk_index;
+        SlotState state;
+        u64 last_used;
+        u8* plaintext;
+    };
+
+    // Copies of the reader's fields: read-ahead jobs only have access to this struct because the
+    // DecryptingReader itself is moveable.
+    Reader* source;
+    Header header;
+    Span<u8 const> package_key;
+    ThreadPool* thread_pool;
+
+    Mutex mutex {}; // Guards everything below.
+    Mutex source_mutex {}; // Reading changes source->pos.
+    ConditionVariable slot_changed {};
+    Span<Slot> slots;
+    u64 clock {};
+    Array<u8*, k_max_read_ahead_jobs> job_ciphertext_buffers {};
+    Array<bool, k_max_read_ahead_jobs> job_buffer_in_use {};
+    u32 num_jobs_in_flight {};
+    bool closing {};
+};
+
+using ChunkCache = DecryptingReader::ChunkCache;
+using SlotState = ChunkCache::SlotState;
+
+static usize JobCiphertextBufferSize(Header const& header) {
+    return k_read_ahead_chunks_per_job * ((usize)header.chunk_size + k_tag_size);
+}
+
+// Call with cache.mutex locked.
+static ChunkCache::Slot* FindSlot(ChunkCache& cache, u64 chunk_index) {
+    for (auto& slot : cache.slots)
+        if (slot.state != SlotState::Empty && slot.chunk_index == chunk_index) return &slot;
+    return nullptr;
+}
+
+// Call with cache.mutex locked. Prefers empty slots, then the least recently used ready slot. A queued slot
+// is only taken as a last resort: its read-ahead job will notice and skip it. Slots that are being
+// decrypted can't be taken, nullptr is returned if that's all there is.
+static ChunkCache::Slot* SlotToReuse(ChunkCache& cache) {
+    ChunkCache::Slot* ready = nullptr;
+    ChunkCache::Slot* queued = nullptr;
+    for (auto& slot : cache.slots) {
+        switch (slot.state) {
+            case SlotState::Empty: return &slot;
+            case SlotState::Ready:
+                if (!ready || slot.last_used < ready->last_used) ready = &slot;
+                break;
+            case SlotState::Queued:
+                if (!queued || slot.last_used < queued->last_used) queued = &slot;
+                break;
+            case SlotState::Decrypting: break;
+        }
+    }
+    return ready ? ready : queued;
+}
+
+static void DecryptChunksJob(ChunkCache& cache, u64 first_chunk, u32 num_chunks, u32 job_buffer_index);
+
+// Call with cache.mutex locked. Reads that continue on from the previous chunk are probably sequential (zip
+// extraction), so we start decrypting the chunks after this one before they're asked for. Contiguous chunks
+// are batched into a job so that they can be fetched from the source in a single read.
+static void ScheduleReadAhead(ChunkCache& cache, u64 chunk_index) {
+    if (!cache.thread_pool || cache.closing) return;
+    if (chunk_index == 0 || !FindSlot(cache, chunk_index - 1)) return;
+
+    // Keep at least half of the cache for chunks that have actually been read.
+    auto const read_ahead = Min(k_read_ahead_chunks, (u32)cache.slots.size / 2);
+    auto const last_chunk = Min(chunk_index + read_ahead, NumChunks(cache.header) - 1);
+
+    auto chunk = chunk_index + 1;
+    while (chunk <= last_chunk) {
+        if (FindSlot(cache, chunk)) {
+            ++chunk;
+            continue;
+        }
+
+        Optional<u32> job_buffer_index {};
+        for (auto const i : Range(k_max_read_ahead_jobs)) {
+            if (!cache.job_buffer_in_use[i]) {
+                job_buffer_index = i;
+                break;
+            }
+        }
+        if (!job_buffer_index) return;
+
+        auto const first_chunk = chunk;
+        u32 num_chunks = 0;
+        while (num_chunks < k_read_ahead_chunks_per_job && chunk <= last_chunk && !FindSlot(cache, chunk)) {
+            auto slot = SlotToReuse(cache);
+            if (!slot || (slot->state != SlotState::Empty && slot->last_used == cache.clock)) break;
+            *slot = {
+                .chunk_index = chunk,
+                .state = SlotState::Queued,
+                .last_used = cache.clock,
+                .plaintext = slot->plaintext,
+            };
+            ++num_chunks;
+            ++chunk;
+        }
+        if (!num_chunks) return;
+
+        cache.job_buffer_in_use[*job_buffer_index] = true;
+        ++cache.num_jobs_in_flight;
+        auto* cache_ptr = &cache;
+        auto const buffer_index = *job_buffer_index;
+        cache.thread_pool->AddJob([cache_ptr, first_chunk, num_chunks, buffer_index]() {
+            DecryptChunksJob(*cache_ptr, first_chunk, num_chunks, buffer_index);
+        });
+    }
+}
+
+static void DecryptChunksJob(ChunkCache& cache, u64 first_chunk, u32 num_chunks, u32 job_buffer_index) {
+    Array<ChunkCache::Slot*, k_read_ahead_chunks_per_job> claimed {};
+    bool any_claimed = false;
+    {
+        ScopedMutexLock lock {cache.mutex};
+        for (auto const i : Range(num_chunks)) {
+            auto slot = FindSlot(cache, first_chunk + i);
+            // A reader may have got here first and decrypted it itself, or reused the slot.
+            if (!slot || slot->state != SlotState::Queued) continue;
+            if (cache.closing) {
+                slot->state = SlotState::Empty;
+                continue;
+            }
+            slot->state = SlotState::Decrypting;
+            claimed[i] = slot;
+            any_claimed = true;
+        }
+        if (!any_claimed) {
+            cache.job_buffer_in_use[job_buffer_index] = false;
+            --cache.num_jobs_in_flight;
+            cache.slot_changed.WakeAll();
+            return;
+        }
+    }
+
+    // One read for the whole batch: the chunks are contiguous in the file.
+    auto const file_offset = ChunkFileOffset(cache.header, first_chunk);
+    usize batch_size = 0;
+    for (auto const i : Range(num_chunks))
+        batch_size += ChunkPlaintextSize(cache.header, first_chunk + i) + k_tag_size;
+    auto* ciphertext = cache.job_ciphertext_buffers[job_buffer_index];
+
+    bool read_ok;
+    {
+        cache.source_mutex.Lock();
+        DEFER { cache.source_mutex.Unlock(); };
+        cache.source->pos = (usize)file_offset;
+        auto const bytes_read = cache.source->Read(ciphertext, batch_size);
+        read_ok = bytes_read.Succeeded() && bytes_read.Value() == batch_size;
+    }
+
+    Array<bool, k_read_ahead_chunks_per_job> succeeded {};
+    usize offset_in_batch = 0;
+    for (auto const i : Range(num_chunks)) {
+        auto const plaintext_size = ChunkPlaintextSize(cache.header, first_chunk + i);
+        if (read_ok && claimed[i]) {
+            succeeded[i] = AuthenticateAndDecryptChunk(cache.header,
+                                                       first_chunk + i,
+                                                       plaintext_size,
+                                                       cache.package_key.data,
+                                                       ciphertext + offset_in_batch,
+                                                       claimed[i]->plaintext)
+                               .Succeeded();
+        }
+        offset_in_batch += plaintext_size + k_tag_size;
+    }
+
+    ScopedMutexLock lock {cache.mutex};
+    // Failures are left for the reader to retry itself so that it gets the real error.
+    for (auto const i : Range(num_chunks))
+        if (claimed[i]) claimed[i]->state = succeeded[i] ? SlotState::Ready : SlotState::Empty;
+    cache.job_buffer_in_use[job_buffer_index] = false;
+    --cache.num_jobs_in_flight;
+    cache.slot_changed.WakeAll();
+}
+
 ErrorCodeOr<DecryptingReader> CreateDecryptingReader(Reader& source,
                                                      Header const& header,
                                                      Span<u8 const> package_key,
-                                                     Allocator& allocator) {
+                                                     Allocator& allocator,
+                                                     DecryptingReaderOptions const& options) {
     ASSERT(package_key.size == k_key_size);
-    auto buf = allocator.Allocate({.size = header.chunk_size, .alignment = 1});
+    ASSERT(options.num_cached_chunks != 0);
+
+    auto cache = allocator.New<ChunkCache>();
+    cache->source = &source;
+    cache->header = header;
+    cache->package_key = package_key;
+    cache->thread_pool = options.thread_pool;
+    cache->slots = allocator.NewMultiple<ChunkCache::Slot>(options.num_cached_chunks);
+    for (auto& slot : cache->slots)
+        slot.plaintext = allocator.AllocateExactSizeUninitialised<u8>(header.chunk_size).data;
+    if (options.thread_pool)
+        for (auto& buffer : cache->job_ciphertext_buffers)
+            buffer = allocator.AllocateExactSizeUninitialised<u8>(JobCiphertextBufferSize(header)).data;
 
     return DecryptingReader {
         .source = &source,
         .header = header,
         .package_key = package_key,
         .allocator = allocator,
-        .chunk_buffer = (u8*)buf.data,
-        .cached_chunk_index = 0,
-        .has_cached_chunk = false,
+        .cache = cache,
     };
 }
 
 void DestroyDecryptingReader(DecryptingReader& dr) {
-    if (dr.chunk_buffer) {
-        dr.allocator.Free({dr.chunk_buffer, dr.header.chunk_size});
-        dr.chunk_buffer = nullptr;
+    if (!dr.cache) return;
+    auto& cache = *dr.cache;
+
+    // Read-ahead jobs hold a pointer to the cache. Jobs that haven't started will see the flag and return
+    // immediately, but they do need to be run, so don't call this from a thread that the pool is waiting on.
+    {
+        ScopedMutexLock lock {cache.mutex};
+        cache.closing = true;
+        while (cache.num_jobs_in_flight)
+            cache.slot_changed.Wait(lock);
     }
-}
 
-static usize ChunkPlaintextSize(Header const& header, u64 chunk_index) {
-    auto const num_full_chunks = header.total_plaintext_size / header.chunk_size;
-    auto const remainder = header.total_plaintext_size % header.chunk_size;
-    if (chunk_index < num_full_chunks) return header.chunk_size;
-    if (chunk_index == num_full_chunks && remainder > 0) return (usize)remainder;
-    return 0; // past the end
-}
-
-static u64 ChunkFileOffset(Header const& header, u64 chunk_index) {
-    // Each on-disk chunk is plaintext_size + tag bytes. All but possibly the last chunk are
-    // exactly chunk_size, so the offset of any chunk is just the count of full chunks before it.
-    auto const num_full_chunks = header.total_plaintext_size / header.chunk_size;
-    auto const full_chunks_before = Min(chunk_index, num_full_chunks);
-    return sizeof(Header) + (full_chunks_before * ((u64)header.chunk_size + k_tag_size));
+    if (cache.thread_pool)
+        for (auto buffer : cache.job_ciphertext_buffers)
+            dr.allocator.Free({buffer, JobCiphertextBufferSize(dr.header)});
+    for (auto& slot : cache.slots)
+        dr.allocator.Free({slot.plaintext, dr.header.chunk_size});
+    dr.allocator.Delete(cache.slots);
+    dr.allocator.Delete(&cache);
+    dr.cache = nullptr;
 }
 
 ErrorCodeOr<usize> ReadAt(DecryptingReader& dr, u64 plaintext_offset, void* buffer, usize buffer_size) {
+    auto& cache = *dr.cache;
     auto* out = (u8*)buffer;
     usize bytes_written = 0;
 
@@ -156,29 +401,57 @@ ErrorCodeOr<usize> ReadAt(DecryptingReader& dr, u64 plaintext_offset, void* buff
         auto const chunk_pt_size = ChunkPlaintextSize(dr.header, chunk_index);
         if (chunk_pt_size == 0) break;
 
-        // Decrypt chunk if not cached. ReadHeader pinned chunk_size to k_default_chunk_size, so
-        // this stack buffer is bounded.
-        if (!dr.has_cached_chunk || dr.cached_chunk_index != chunk_index) {
+        ScopedMutexLock lock {cache.mutex};
+        ChunkCache::Slot* slot;
+        while (true) {
+            slot = FindSlot(cache, chunk_index);
+            if (slot && slot->state == SlotState::Ready) break;
+
+            if (slot && slot->state == SlotState::Decrypting) {
+                cache.slot_changed.Wait(lock);
+                continue;
+            }
+
+            // Not cached, or queued for read-ahead but not started yet. We don't wait for the pool in the
+            // queued case: it might be busy, or it might be waiting on this thread.
+            if (!slot) {
+                slot = SlotToReuse(cache);
+                if (!slot) {
+                    cache.slot_changed.Wait(lock);
+                    continue;
+                }
+                slot->chunk_index = chunk_index;
+            }
+            slot->state = SlotState::Decrypting;
+
+            // ReadHeader pinned chunk_size to k_default_chunk_size, so this stack buffer is bounded.
             u8 ct_buf[k_default_chunk_size + k_tag_size];
-
-            auto const file_offset = ChunkFileOffset(dr.header, chunk_index);
-            TRY(DecryptChunk(*dr.source,
-                             dr.header,
-                             file_offset,
-                             chunk_pt_size,
-                             chunk_index,
-                             dr.package_key.data,
-                             dr.chunk_buffer,
-                             ct_buf));
-            dr.cached_chunk_index = chunk_index;
-            dr.has_cached_chunk = true;
+            cache.mutex.Unlock();
+            auto const result = DecryptChunk(*dr.source,
+                                             dr.header,
+                                             ChunkFileOffset(dr.header, chunk_index),
+                                             chunk_pt_size,
+                                             chunk_index,
+                                             dr.package_key.data,
+                                             slot->plaintext,
+                                             ct_buf,
+                                             &cache.source_mutex);
+            cache.mutex.Lock();
+
+            slot->state = result.Succeeded() ? SlotState::Ready : SlotState::Empty;
+            cache.slot_changed.WakeAll();
+            if (result.HasError()) return result.Error();
+            break;
         }
 
+        slot->last_used = ++cache.clock;
         auto const available = chunk_pt_size - offset_in_chunk;
         auto const to_copy = Min(available, buffer_size - bytes_written);
-        CopyMemory(out + bytes_written, dr.chunk_buffer + offset_in_chunk, to_copy);
+        CopyMemory(out + bytes_written, slot->plaintext + offset_in_chunk, to_copy);
         bytes_written += to_copy;
         plaintext_offset += to_copy;
+
+        ScheduleReadAhead(cache, chunk_index);
     }
 
     return bytes_written;
@@ -346,8 +619,109 @@ TEST_CASE(TestEncryptedPackageRoundtrip) {
     return k_success;
 }
 
+TEST_CASE(TestDecryptingReaderCache) {
+    auto& a = tester.scratch_arena;
+
+    // 40 full chunks and a partial one.
+    constexpr usize k_test_size = (40 * k_default_chunk_size) + 1234;
+    auto plaintext = a.AllocateExactSizeUninitialised<u8>(k_test_size);
+    u64 seed = 1234;
+    for (auto& b : plaintext)
+        b = (u8)RandomIntInRange<u32>(seed, 0, 255);
+
+    Array<u8, k_key_size> package_key;
+    CryptoRandomBytes(package_key.data, k_key_size);
+    auto const encrypted = REQUIRE_UNWRAP(Encrypt(plaintext, package_key, a));
+
+    ThreadPool thread_pool;
+    thread_pool.Init("ep-test", 4u);
+
+    auto const check_read = [&](DecryptingReader& dr, u64 offset, usize size) {
+        CAPTURE(offset);
+        CAPTURE(size);
+        auto buf = a.AllocateExactSizeUninitialised<u8>(size);
+        DEFER { a.Free(buf.ToByteSpan()); };
+        auto const n = REQUIRE_UNWRAP(ReadAt(dr, offset, buf.data, size));
+        auto const expected = (usize)Min<u64>(size, k_test_size - Min<u64>(offset, k_test_size));
+        REQUIRE_EQ(n, expected);
+        REQUIRE(MemoryIsEqual(buf.data, plaintext.data + offset, n));
+    };
+
+    struct Config {
+        String name;
+        DecryptingReaderOptions options;
+    };
+    for (auto const& config : Array {
+             Config {"default, no pool", {}},
+             Config {"single chunk cache", {.num_cached_chunks = 1}},
+             Config {"read-ahead", {.thread_pool = &thread_pool}},
+             Config {"read-ahead with small cache", {.num_cached_chunks = 3, .thread_pool = &thread_pool}},
+         }) {
+        CAPTURE(config.name);
+        auto source = Reader::FromMemory(encrypted);
+        auto const header = REQUIRE_UNWRAP(ReadHeader(source));
+        auto dr = REQUIRE_UNWRAP(CreateDecryptingReader(source, header, package_key, a, config.options));
+        DEFER { DestroyDecryptingReader(dr); };
+
+        // Sequential, in sizes that don't line up with chunks.
+        for (u64 offset = 0; offset < k_test_size; offset += 7000)
+            check_read(dr, offset, 7000);
+
+        // Random access, like miniz jumping between the central directory and local headers.
+        for (auto const i : Range(300)) {
+            (void)i;
+            auto const offset = RandomIntInRange<u64>(seed, 0, k_test_size + 100);
+            auto const size = RandomIntInRange<usize>(seed, 1, 3 * k_default_chunk_size);
+            check_read(dr, offset, size);
+        }
+
+        // Several interleaved sequential streams.
+        Array<u64, 3> stream_offsets {0, k_test_size / 3, 2 * (k_test_size / 3)};
+        for (auto const i : Range(60)) {
+            auto& offset = stream_offsets[(usize)i % stream_offsets.size];
+            check_read(dr, offset, 5000);
+            offset += 5000;
+        }
+    }
+
+    SUBCASE("a tampered chunk fails but its neighbours still read") {
+        constexpr u64 k_tampered_chunk = 5;
+        auto tampered = a.Clone(Span<u8 const>(encrypted));
+        tampered[ChunkFileOffset(*(Header const*)tampered.data, k_tampered_chunk) + 10] ^= 0x01;
+
+        for (auto const pool : Array {(ThreadPool*)nullptr, &thread_pool}) {
+            auto source = Reader::FromMemory(tampered);
+            auto const header = REQUIRE_UNWRAP(ReadHeader(source));
+            auto dr =
+                REQUIRE_UNWRAP(CreateDecryptingReader(source, header, package_key, a, {.thread_pool = pool}));
+            DEFER { DestroyDecryptingReader(dr); };
+
+            // Reading sequentially up to it triggers read-ahead of the tampered chunk.
+            for (u64 offset = 0; offset < k_tampered_chunk * k_default_chunk_size; offset += 4096)
+                check_read(dr, offset, 4096);
+
+            u8 buf[100];
+            for (auto const attempt : Range(2)) {
+                CAPTURE(attempt);
+                auto const r = ReadAt(dr, (k_tampered_chunk * k_default_chunk_size) + 50, buf, sizeof(buf));
+                REQUIRE(r.HasError());
+                CHECK(r.Error() == EncryptedPackageError::DecryptionFailed);
+            }
+
+            // A read spanning into it fails too.
+            CHECK(ReadAt(dr, (k_tampered_chunk * k_default_chunk_size) - 10, buf, sizeof(buf)).HasError());
+
+            check_read(dr, (k_tampered_chunk - 1) * k_default_chunk_size, k_default_chunk_size);
+            check_read(dr, (k_tampered_chunk + 1) * k_default_chunk_size, k_default_chunk_size * 3);
+        }
+    }
+
+    return k_success;
+}
+
 } // namespace encrypted_package
 
 TEST_REGISTRATION(RegisterEncryptedPackageTests) {
     REGISTER_TEST(encrypted_package::TestEncryptedPackageRoundtrip);
+    REGISTER_TEST(encrypted_package::TestDecryptingReaderCache);
 }
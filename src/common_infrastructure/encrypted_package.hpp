@@ -21,6 +21,8 @@
 #include "foundation/foundation.hpp"
 #include "utils/reader.hpp"
 
+struct ThreadPool;
+
 namespace encrypted_package {
 
 constexpr u32 k_magic = U32FromChars("FLOE");
@@ -67,22 +69,39 @@ ErrorCodeOr<Header> ReadHeader(Reader& reader);
 // Try decrypting chunk 0 to verify the package key matches this package.
 ErrorCodeOr<void> VerifyContentKey(Reader& source, Header const& header, Span<u8 const> package_key);
 
+constexpr u32 k_default_num_cached_chunks = 16;
+constexpr u32 k_read_ahead_chunks = 8;
+constexpr u32 k_read_ahead_chunks_per_job = 2;
+
+struct DecryptingReaderOptions {
+    // Decrypted chunks are kept in an LRU cache. miniz jumps back to the central directory and the local
+    // headers often, so even a handful of chunks avoids most re-decryption.
+    u32 num_cached_chunks = k_default_num_cached_chunks;
+
+    // If set, when reads look sequential the following k_read_ahead_chunks chunks are read and authenticated
+    // on the pool's threads, k_read_ahead_chunks_per_job at a time. The pool must outlive the reader. It's
+    // fine if the pool is busy (or is running the thread that reads): a reader that catches up with a chunk
+    // that hasn't been started yet decrypts it itself.
+    ThreadPool* thread_pool = nullptr;
+};
+
 struct DecryptingReader {
+    struct ChunkCache; // Internal, defined in the .cpp.
+
     Reader* source;
     Header header;
     Span<u8 const> package_key; // 32 bytes, must remain valid for lifetime of reader
     Allocator& allocator;
-
-    // Internal: cached decrypted chunk
-    u8* chunk_buffer; // allocated, size = header.chunk_size
-    u64 cached_chunk_index;
-    bool has_cached_chunk;
+    ChunkCache* cache;
 };
 
+// Thread-safe: ReadAt can be called from multiple threads, and the source Reader is only accessed while
+// holding an internal lock.
 ErrorCodeOr<DecryptingReader> CreateDecryptingReader(Reader& source,
                                                      Header const& header,
                                                      Span<u8 const> package_key,
-                                                     Allocator& allocator);
+                                                     Allocator& allocator,
+                                                     DecryptingReaderOptions const& options = {});
 void DestroyDecryptingReader(DecryptingReader& dr);
 
 // Read decrypted bytes at a given offset.
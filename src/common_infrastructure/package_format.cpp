@@ -280,9 +280,16 @@ ErrorCodeOr<void> WriterAddPresetsFolder(mz_zip_archive& zip,
 
 // =================================================================================================
 
-static ErrorCode ZipReadError(PackageReader const& package, SourceLocation loc = SourceLocation::Current()) {
-    if (package.read_callback_error) {
-        auto err = *package.read_callback_error;
+// The read callback can't return an error, so it leaves it here for ZipReadError to pick up. It's per-thread
+// because several threads can extract from the same package at once: each failure must report its own read
+// error, not another thread's.
+static thread_local Optional<ErrorCode> g_read_callback_error {};
+
+// Takes the read callback's error, if any, so that it isn't reported again for a later, unrelated failure.
+static ErrorCode ZipReadError(SourceLocation loc = SourceLocation::Current()) {
+    if (g_read_callback_error) {
+        auto err = *g_read_callback_error;
+        g_read_callback_error = k_nullopt;
         err.source_location = loc;
         return err;
     }
@@ -291,7 +298,7 @@ static ErrorCode ZipReadError(PackageReader const& package, SourceLocation loc =
 
 ErrorCodeOr<mz_zip_archive_file_stat> FileStat(PackageReader& package, mz_uint file_index) {
     mz_zip_archive_file_stat file_stat;
-    if (!mz_zip_reader_file_stat(&package.zip, file_index, &file_stat)) return ZipReadError(package);
+    if (!mz_zip_reader_file_stat(&package.zip, file_index, &file_stat)) return ZipReadError();
     return file_stat;
 }
 
@@ -301,7 +308,7 @@ static ErrorCodeOr<Span<u8 const>>
 ExtractFileToMem(PackageReader& package, mz_zip_archive_file_stat const& file_stat, ArenaAllocator& arena) {
     auto const data = arena.AllocateExactSizeUninitialised<u8>(file_stat.m_uncomp_size);
     if (!mz_zip_reader_extract_to_mem(&package.zip, file_stat.m_file_index, data.data, data.size, 0))
-        return ZipReadError(package);
+        return ZipReadError();
     return data;
 }
 
@@ -326,8 +333,11 @@ ExtractFileToFile(PackageReader& package, mz_zip_archive_file_stat const& file_s
             },
             &context,
             0)) {
-        if (context.result.HasError()) return context.result.Error();
-        return ZipReadError(package);
+        if (context.result.HasError()) {
+            g_read_callback_error = k_nullopt; // The write failed, not a read.
+            return context.result.Error();
+        }
+        return ZipReadError();
     }
     return k_success;
 }
@@ -438,24 +448,25 @@ ErrorCodeOr<void> ReaderInit(PackageReader& package) {
         auto& package = *(PackageReader*)io_opaque_ptr;
         // Seen in production: truncated/corrupted ZIPs with offsets beyond actual file size.
         if (file_offset > package.zip_file_reader.size) {
-            package.read_callback_error = ErrorCode(PackageError::FileCorrupted);
+            g_read_callback_error = ErrorCode(PackageError::FileCorrupted);
             return 0;
         }
-        package.zip_file_reader.pos = file_offset;
-        auto const num_read = TRY_OR(package.zip_file_reader.Read(buffer, buffer_size), {
+        // ReadAt leaves the reader's position alone so this can be called from several threads at once.
+        auto& reader = package.zip_file_reader;
+        auto const num_read = TRY_OR(reader.ReadAt((usize)file_offset, {(u8*)buffer, buffer_size}), {
             // We store the error because we can't pass it out in the return value.
-            package.read_callback_error = error;
+            g_read_callback_error = error;
             return 0;
         });
         return num_read;
     };
     package.zip.m_pIO_opaque = &package;
 
-    if (!mz_zip_reader_init(&package.zip, package.zip_file_reader.size, 0)) return ZipReadError(package);
+    if (!mz_zip_reader_init(&package.zip, package.zip_file_reader.size, 0)) return ZipReadError();
 
     bool known_subdirs = false;
     for (auto const file_index : Range(mz_zip_reader_get_num_files(&package.zip))) {
-        auto const file_stat = TRY_OR(FileStat(package, file_index), return ZipReadError(package););
+        auto const file_stat = TRY(FileStat(package, file_index));
         auto const path = PathWithoutTrailingSlash(file_stat.m_filename);
         for (auto const known_subdir : Array {k_libraries_subdir, k_presets_subdir}) {
             if (path == known_subdir || RelativePathIfInFolder(path, known_subdir)) {
@@ -479,7 +490,7 @@ ErrorCodeOr<Optional<Component>>
 IteratePackageComponents(PackageReader& package, PackageComponentIndex& file_index, ArenaAllocator& arena) {
     DEFER { ++file_index; };
     for (; file_index < mz_zip_reader_get_num_files(&package.zip); ++file_index) {
-        auto const file_stat = TRY_OR(FileStat(package, file_index), return ZipReadError(package););
+        auto const file_stat = TRY(FileStat(package, file_index));
         auto const path = PathWithoutTrailingSlash(file_stat.m_filename);
         for (auto const folder : k_component_subdirs) {
             auto const relative_path = RelativePathIfInFolder(path, folder);
@@ -514,8 +525,7 @@ IteratePackageComponents(PackageReader& package, PackageComponentIndex& file_ind
                     t;
                 }),
                 .checksum_values = !is_mdata_library
-                                       ? TRY_OR(ReaderChecksumValuesForDir(package, path, arena),
-                                                return ZipReadError(package);)
+                                       ? TRY(ReaderChecksumValuesForDir(package, path, arena))
                                        : HashTable<String, ChecksumValues> {},
                 .mdata_checksum = is_mdata_library ? Optional<u32> {(u32)file_stat.m_crc32} : k_nullopt,
                 .library = library,
@@ -6,6 +6,7 @@
 
 #include "foundation/foundation.hpp"
 #include "os/filesystem.hpp"
+#include "os/threading.hpp"
 
 #include "common_infrastructure/preset_bank_info.hpp"
 
@@ -58,7 +59,6 @@ struct PackageReader {
     Reader& zip_file_reader;
     mz_zip_archive zip {};
     u64 seed = RandomSeed();
-    Optional<ErrorCode> read_callback_error {}; // we need a way to pass out the error from the read callback
 };
 
 ErrorCodeOr<void> ReaderInit(PackageReader& package);
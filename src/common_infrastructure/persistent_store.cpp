@@ -3,9 +3,16 @@
 
 #include "persistent_store.hpp"
 
+#if !IS_WINDOWS
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "os/filesystem.hpp"
+#include "os/threading.hpp"
 #include "tests/framework.hpp"
 
+#include "benchmarks/framework.hpp"
 #include "common_errors.hpp"
 
 namespace persistent_store {
@@ -87,107 +94,308 @@ void RemoveValue(StoreTable& store, Id id, Optional<Span<u8 const>> value) {
     }
 }
 
-struct ReadResult {
-    String file_data;
-    s128 file_last_modified {};
+// Store file
+// =================================================================================
+// The file is a FileHeader followed by a journal of records. Each change to the store is appended as a
+// record, so a store that has already replayed the first N bytes of the file only needs to replay what comes
+// after. When the file gets much bigger than the data it describes, it's compacted: a new file with an Add
+// record for each value is written alongside and renamed over the old one. Its generation is one higher so
+// that readers know to start again from the beginning.
+//
+// Files from before the journal have no header, they're the chunks that Write() produces. They read the
+// same as a journal of Add records, and they're compacted to the current format on the first write.
+
+constexpr u64 k_store_file_magic = 0x314c4e524a535046; // "FPSJRNL1"
+constexpr u64 k_max_store_file_size = Mb(100);
+constexpr u64 k_min_compaction_size = Kb(16);
+
+struct FileHeader {
+    u64 magic;
+    u64 generation; // Starts at 1, 0 is used for files that don't have a header.
 };
 
-ErrorCodeOr<ReadResult> ReadEntireStoreFile(String path, ArenaAllocator& arena) {
-    LogDebug(ModuleName::PersistentStore, "Reading persistent_store file: {}", path);
+enum class RecordOp : u8 {
+    Add = 1,
+    RemoveValue,
+    RemoveAll,
+};
 
-    auto file = TRY(OpenFile(path,
-                             {
-                                 .capability = FileMode::Capability::Read,
-                                 .win32_share = FileMode::Share::ReadWrite | FileMode::Share::DeleteRename,
-                                 .creation = FileMode::Creation::OpenExisting,
-                             }));
-    TRY(file.Lock({.type = FileLockOptions::Type::Shared}));
-    DEFER { auto _ = file.Unlock(); };
+struct RecordHeader {
+    u64 id;
+    u32 size;
+    RecordOp op;
+    u8 reserved[3];
+};
 
-    if (TRY(file.FileSize()) > Mb(100)) return ErrorCode {CommonError::InvalidFileFormat};
+static_assert(sizeof(RecordHeader) == sizeof(ChunkHeader));
 
-    auto const file_last_modified = TRY(file.LastModifiedTimeNsSinceEpoch());
-    auto const file_data = TRY(file.ReadWholeFile(arena));
+constexpr FileMode k_store_read_mode {
+    .capability = FileMode::Capability::Read,
+    .win32_share = FileMode::Share::ReadWrite | FileMode::Share::DeleteRename,
+    .creation = FileMode::Creation::OpenExisting,
+};
 
-    return ReadResult {
-        .file_data = file_data,
-        .file_last_modified = file_last_modified,
-    };
+constexpr FileMode k_store_write_mode {
+    .capability = FileMode::Capability::ReadWrite,
+    .win32_share = FileMode::Share::ReadWrite | FileMode::Share::DeleteRename,
+    .creation = FileMode::Creation::OpenAlways,
+    .everyone_read_write = true,
+};
+
+static Optional<FileHeader> ParseFileHeader(Span<u8 const> data) {
+    if (data.size < sizeof(FileHeader)) return k_nullopt;
+    FileHeader header;
+    __builtin_memcpy_inline(&header, data.data, sizeof(FileHeader));
+    if (header.magic != k_store_file_magic) return k_nullopt;
+    return header;
 }
 
-static bool InitIfNeeded(Store& store) {
-    // If the file is newer than the last time we read/wrote it, we need to re-read it; another process may
-    // have updated it.
-    if (store.actual_file_last_modified_microsec.Load(LoadMemoryOrder::Acquire) >
-        store.file_last_modified_microsec)
-        store.init = false;
+static void ApplyRecord(Store& store, RecordOp op, Id id, Span<u8 const> data) {
+    switch (op) {
+        case RecordOp::Add: AddValue((StoreTable&)store, store.arena, id, data); break;
+        case RecordOp::RemoveValue: RemoveValue((StoreTable&)store, id, data); break;
+        case RecordOp::RemoveAll: RemoveValue((StoreTable&)store, id, k_nullopt); break;
+    }
+}
 
-    if (store.init) return store.store_valid;
-    store.init = true;
-    store.store_valid = false;
+// Returns the number of bytes that were whole records. Anything after that is a record that was only partly
+// written because the process writing it crashed.
+static usize ReplayRecords(Store& store, Span<u8 const> data, bool legacy_chunks) {
+    usize pos = 0;
+    while (data.size - pos >= sizeof(RecordHeader)) {
+        RecordHeader header;
+        __builtin_memcpy_inline(&header, data.data + pos, sizeof(RecordHeader));
+
+        auto op = RecordOp::Add;
+        if (!legacy_chunks) {
+            if (header.op < RecordOp::Add || header.op > RecordOp::RemoveAll) break;
+            op = header.op;
+        }
+        if (header.size > data.size - pos - sizeof(RecordHeader)) break;
+
+        ApplyRecord(store, op, header.id, data.SubSpan(pos + sizeof(RecordHeader), header.size));
+        pos += sizeof(RecordHeader) + header.size;
+    }
+    return pos;
+}
+
+static void StoreActualFileState(Store& store, u64 file_size, u64 generation) {
+    store.actual_file_size.Store(file_size, StoreMemoryOrder::Release);
+    store.actual_file_generation.Store(generation, StoreMemoryOrder::Release);
+}
+
+static void ResetToEmpty(Store& store) {
     store.arena.ResetCursorAndConsolidateRegions();
+    (StoreTable&)store = {};
+    store.file_identity = k_nullopt;
+    store.generation = 0;
+    store.synced_file_size = 0;
+    store.replayed_size = 0;
+    store.next_compaction_check_size = 0;
+}
+
+// The file must be locked. Only the part of the journal that we haven't seen is replayed, unless the file has
+// been compacted or replaced since we last looked.
+static ErrorCodeOr<void> SyncWithFile(Store& store, File& file) {
+    auto const file_size = TRY(file.FileSize());
+    if (file_size > k_max_store_file_size) return ErrorCode {CommonError::InvalidFileFormat};
+    auto const identity = TRY(file.Identity());
+
+    MappedFile mapping {};
+    if (file_size) mapping = TRY(MapFile(file, file_size));
+    auto const data = mapping.data;
+
+    auto const header = ParseFileHeader(data);
+    auto const generation = header ? header->generation : 0;
+
+    // Without a header the file isn't a journal: any change means reading it all again.
+    if (!store.file_identity || *store.file_identity != identity || generation != store.generation ||
+        file_size < store.replayed_size || (!header && file_size != store.synced_file_size)) {
+        LogDebug(ModuleName::PersistentStore, "Reading persistent_store file: {}", store.filepath);
+        ResetToEmpty(store);
+        store.file_identity = identity;
+        store.generation = generation;
+        if (header) store.replayed_size = sizeof(FileHeader);
+    }
+
+    if (file_size > store.replayed_size)
+        store.replayed_size += ReplayRecords(store, data.SubSpan(store.replayed_size), !header);
+    store.synced_file_size = file_size;
+    StoreActualFileState(store, file_size, generation);
+    return k_success;
+}
 
-    auto const outcome = ReadEntireStoreFile(store.filepath, store.arena);
+static bool SyncIfNeeded(Store& store) {
+    if (store.init && store.actual_file_size.Load(LoadMemoryOrder::Acquire) == store.synced_file_size &&
+        store.actual_file_generation.Load(LoadMemoryOrder::Acquire) == store.generation)
+        return store.store_valid;
+    store.init = true;
 
-    String data {};
-    if (outcome.HasValue()) {
-        data = outcome.Value().file_data;
-        store.file_last_modified_microsec = (u64)(outcome.Value().file_last_modified / 1000);
-    } else if (outcome.Error() != FilesystemError::PathDoesNotExist)
-        return false;
+    auto const outcome = [&]() -> ErrorCodeOr<void> {
+        auto file = TRY(OpenFile(store.filepath, k_store_read_mode));
+        TRY(file.Lock({.type = FileLockOptions::Type::Shared}));
+        DEFER { auto _ = file.Unlock(); };
+        return SyncWithFile(store, file);
+    }();
+
+    if (outcome.HasError()) {
+        if (outcome.Error() != FilesystemError::PathDoesNotExist) {
+            store.file_identity = k_nullopt;
+            store.store_valid = false;
+            return false;
+        }
+        ResetToEmpty(store);
+        StoreActualFileState(store, 0, 0);
+    }
 
-    (StoreTable&)store = Read(store.arena, data);
     store.store_valid = true;
     return true;
 }
 
-static void WriteFile(Store& store) {
-    auto const file_last_modified = NanosecondsSinceEpoch();
-    store.file_last_modified_microsec = (u64)(file_last_modified / 1000);
+static ErrorCodeOr<void> WriteRecord(Writer writer, RecordOp op, Id id, Span<u8 const> data) {
+    RecordHeader const header {
+        .id = id,
+        .size = (u32)data.size,
+        .op = op,
+        .reserved = {},
+    };
+    TRY(writer.WriteBytes({(u8 const*)&header, sizeof(header)}));
+    if (data.size) TRY(writer.WriteBytes(data));
+    return k_success;
+}
+
+static u64 CompactedSize(StoreTable const& store) {
+    u64 size = sizeof(FileHeader);
+    for (auto const& [id, value, _] : store)
+        for (auto v = value; v; v = v->next)
+            size += sizeof(RecordHeader) + v->data.size;
+    return size;
+}
 
-    auto file = TRY_OR(OpenFile(store.filepath,
-                                {
-                                    .capability = FileMode::Capability::Write,
-                                    .win32_share = FileMode::Share::ReadWrite,
-                                    .creation = FileMode::Creation::CreateAlways,
-                                    .everyone_read_write = true,
-                                }),
-                       return;);
+// Working out the compacted size means looking at every value, so we only do it once the file has grown
+// enough since the last time that it might be worth it.
+static bool ShouldCompact(Store& store, u64 file_size) {
+    if (file_size < store.next_compaction_check_size) return false;
+    store.next_compaction_check_size = Max(k_min_compaction_size, CompactedSize(store) * 2);
+    return file_size >= store.next_compaction_check_size;
+}
 
-    TRY_OR(file.Lock({.type = FileLockOptions::Type::Exclusive}), return);
-    DEFER { auto _ = file.Unlock(); };
+// We must hold the lock on the current file so that no one appends to it while we're replacing it.
+static ErrorCodeOr<void> CompactStoreFile(Store& store) {
+    ArenaAllocatorWithInlineStorage<1000> scratch_arena {Malloc::Instance()};
+    auto const temp_path = fmt::Format(scratch_arena, "{}.compacting", store.filepath);
+    auto const generation = store.generation + 1;
 
-    BufferedWriter<Kb(4)> buffered_writer {
-        .unbuffered_writer = file.Writer(),
-    };
-    DEFER {
-        buffered_writer.FlushReset();
-        auto _ = file.Flush();
-    };
-    TRY_OR(Write(store, buffered_writer.Writer()), {
-        LogError(ModuleName::PersistentStore, "Failed to write data to persistent store: {}", error);
-        return;
-    });
-    auto _ = buffered_writer.Flush();
-    auto _ = file.Flush();
-    auto _ = file.SetLastModifiedTimeNsSinceEpoch(file_last_modified);
+    u64 file_size;
+    FileIdentity identity;
+    {
+        auto file = TRY(OpenFile(temp_path,
+                                 {
+                                     .capability = FileMode::Capability::Write,
+                                     .win32_share = FileMode::Share::ReadWrite,
+                                     .creation = FileMode::Creation::CreateAlways,
+                                     .everyone_read_write = true,
+                                 }));
+
+        BufferedWriter<Kb(4)> buffered_writer {
+            .unbuffered_writer = file.Writer(),
+        };
+        DEFER { buffered_writer.FlushReset(); };
+        auto writer = buffered_writer.Writer();
+
+        FileHeader const header {
+            .magic = k_store_file_magic,
+            .generation = generation,
+        };
+        TRY(writer.WriteBytes({(u8 const*)&header, sizeof(header)}));
+
+        // Replaying prepends each value to its list, so we write them oldest first to keep the order.
+        DynamicArray<Value const*> values {scratch_arena};
+        for (auto const& [id, value, _] : (StoreTable const&)store) {
+            dyn::Clear(values);
+            for (auto v = value; v; v = v->next)
+                dyn::Append(values, v);
+            for (usize i = values.size; i-- > 0;)
+                TRY(WriteRecord(writer, RecordOp::Add, id, values[i]->data));
+        }
+
+        TRY(buffered_writer.Flush());
+        TRY(file.Flush());
+        file_size = TRY(file.FileSize());
+        identity = TRY(file.Identity());
+    }
+
+    TRY(Rename(temp_path, store.filepath));
+
+    store.file_identity = identity;
+    store.generation = generation;
+    store.synced_file_size = file_size;
+    store.replayed_size = file_size;
+    store.next_compaction_check_size = Max(k_min_compaction_size, file_size * 2);
+    StoreActualFileState(store, file_size, generation);
+    return k_success;
+}
+
+static ErrorCodeOr<void> AppendRecord(Store& store, File& file, RecordOp op, Id id, Span<u8 const> data) {
+    // Anything after what we've replayed is a partly-written record from a crashed process.
+    if (store.synced_file_size != store.replayed_size) TRY(file.Truncate(store.replayed_size));
+
+    // A single write, so that a crash leaves at most one partial record at the end. We don't fsync: losing
+    // the last few changes in a power cut is fine, and a partial record is ignored.
+    ArenaAllocatorWithInlineStorage<256> scratch_arena {Malloc::Instance()};
+    DynamicArray<u8> record {scratch_arena};
+    TRY(WriteRecord(dyn::WriterFor(record), op, id, data));
+    TRY(file.WriteAt((s64)store.replayed_size, record));
+
+    store.replayed_size += record.size;
+    store.synced_file_size = store.replayed_size;
+    StoreActualFileState(store, store.synced_file_size, store.generation);
+    return k_success;
+}
+
+// Removing something that isn't there is common (e.g. clearing a flag that was never set). There's no need to
+// put that in the journal.
+static bool ChangesTable(StoreTable const& store, RecordOp op, Id id, Span<u8 const> data) {
+    if (op == RecordOp::Add) return true;
+    auto const values = store.Find(id);
+    if (!values) return false;
+    if (op == RecordOp::RemoveAll) return true;
+    for (auto v = *values; v; v = v->next)
+        if (v->data.size == data.size && MemoryIsEqual(v->data.data, data.data, data.size)) return true;
+    return false;
 }
 
-ErrorCodeOr<s128> ReadStoreFileModifiedTime(String path) {
-    auto file = TRY(OpenFile(path,
-                             {
-                                 .capability = FileMode::Capability::Read,
-                                 .win32_share = FileMode::Share::ReadWrite | FileMode::Share::DeleteRename,
-                                 .creation = FileMode::Creation::OpenExisting,
-                             }));
-    TRY(file.Lock({.type = FileLockOptions::Type::Shared}));
-    DEFER { auto _ = file.Unlock(); };
-
-    return TRY(file.LastModifiedTimeNsSinceEpoch());
+static void WriteChange(Store& store, RecordOp op, Id id, Span<u8 const> data) {
+    auto const outcome = [&]() -> ErrorCodeOr<void> {
+        // Another process might compact the file while we're waiting for the lock, replacing it.
+        auto file = TRY(OpenFileAndLockExclusive(store.filepath, k_store_write_mode));
+        DEFER { auto _ = file.Unlock(); };
+
+        // Catch up with other processes first so that the table we might compact from is complete.
+        TRY(SyncWithFile(store, file));
+        store.init = true;
+        store.store_valid = true;
+
+        if (!ChangesTable(store, op, id, data)) return k_success;
+        ApplyRecord(store, op, id, data);
+
+        auto const size_after_append = store.replayed_size + sizeof(RecordHeader) + data.size;
+        if (store.generation == 0 || ShouldCompact(store, size_after_append)) return CompactStoreFile(store);
+        return AppendRecord(store, file, op, id, data);
+    }();
+
+    if (outcome.HasError()) {
+        LogError(ModuleName::PersistentStore,
+                 "Failed to write data to persistent store: {}",
+                 outcome.Error());
+        // The table might not match the file anymore, start again next time.
+        store.file_identity = k_nullopt;
+        store.init = false;
+    }
 }
 
 // Background thread.
-void StoreActualFileModifiedTime(Store& store) {
+void CheckStoreFileForChanges(Store& store) {
     // We don't need to do this too often, let's save resources.
     {
         constexpr f64 k_seconds_between_checks = 3.0;
@@ -196,15 +404,29 @@ void StoreActualFileModifiedTime(Store& store) {
         store.time_last_checked = now;
     }
 
-    auto const outcome = ReadStoreFileModifiedTime(store.filepath);
-    if (outcome.HasValue()) {
-        store.actual_file_last_modified_microsec.Store((u64)(outcome.Value() / 1000),
-                                                       StoreMemoryOrder::Release);
-    }
+    auto const outcome = [&]() -> ErrorCodeOr<void> {
+        auto file = TRY(OpenFile(store.filepath, k_store_read_mode));
+        TRY(file.Lock({.type = FileLockOptions::Type::Shared}));
+        DEFER { auto _ = file.Unlock(); };
+
+        auto const file_size = TRY(file.FileSize());
+        FileHeader header {};
+        u64 generation = 0;
+        if (file_size >= sizeof(FileHeader)) {
+            auto const num_read = TRY(file.ReadAt(0, &header, sizeof(header)));
+            if (num_read == sizeof(header) && header.magic == k_store_file_magic)
+                generation = header.generation;
+        }
+        StoreActualFileState(store, file_size, generation);
+        return k_success;
+    }();
+
+    if (outcome.HasError() && outcome.Error() == FilesystemError::PathDoesNotExist)
+        StoreActualFileState(store, 0, 0);
 }
 
 Result Get(Store& store, Id id) {
-    if (!InitIfNeeded(store)) return Result {GetResult::StoreInaccessible};
+    if (!SyncIfNeeded(store)) return Result {GetResult::StoreInaccessible};
 
     auto const value_or_null = store.Find(id);
     if (!value_or_null) return Result {GetResult::NotFound};
@@ -212,16 +434,13 @@ Result Get(Store& store, Id id) {
     return Result {value};
 }
 
-void AddValue(Store& store, Id id, Span<u8 const> data) {
-    if (!InitIfNeeded(store)) return;
-    AddValue(store, store.arena, id, data);
-    WriteFile(store);
-}
+void AddValue(Store& store, Id id, Span<u8 const> data) { WriteChange(store, RecordOp::Add, id, data); }
 
 void RemoveValue(Store& store, Id id, Optional<Span<u8 const>> value) {
-    if (!InitIfNeeded(store)) return;
-    RemoveValue((StoreTable&)store, id, value);
-    WriteFile(store);
+    if (value)
+        WriteChange(store, RecordOp::RemoveValue, id, *value);
+    else
+        WriteChange(store, RecordOp::RemoveAll, id, {});
 }
 
 TEST_CASE(TestPersistentStore) {
@@ -286,6 +505,272 @@ TEST_CASE(TestPersistentStore) {
     return k_success;
 }
 
+static Optional<String> GetString(Store& store, Id id) {
+    auto const r = Get(store, id);
+    if (r.tag != GetResult::Found) return k_nullopt;
+    auto const data = r.Get<Value const*>()->data;
+    return String {(char const*)data.data, data.size};
+}
+
+// Normally done every few seconds by a background thread.
+static void CheckNow(Store& store) {
+    store.time_last_checked = {};
+    CheckStoreFileForChanges(store);
+}
+
+static constexpr u32 k_num_concurrent_writers = 4;
+static constexpr u32 k_num_concurrent_writes = 200;
+static constexpr Id k_concurrent_shared_id = 1'000'000;
+
+// Every writer adds its own range of values, removing some of them again, and they all add to a shared id.
+static void WriteConcurrently(String path, u32 writer_index) {
+    Store store {.filepath = path};
+    for (auto const i : Range(k_num_concurrent_writes)) {
+        auto const value = (writer_index * k_num_concurrent_writes) + i;
+        AddValue(store, (Id)value, value);
+        AddValue(store, k_concurrent_shared_id, value);
+        if (i % 3 == 0) RemoveValue(store, (Id)value, k_nullopt);
+    }
+}
+
+TEST_CASE(TestPersistentStoreFile) {
+    auto const path = tests::TempFilename(tester);
+
+    SUBCASE("no file is an empty store") {
+        Store store {.filepath = path};
+        CHECK(Get(store, 1).tag == GetResult::NotFound);
+        RemoveFlag(store, 1);
+        CHECK(Get(store, 1).tag == GetResult::NotFound);
+    }
+
+    SUBCASE("changes are replayed by other stores") {
+        Store a {.filepath = path};
+        Store b {.filepath = path};
+
+        AddValue(a, 1, "hello"_s.ToConstByteSpan());
+        CHECK(GetString(b, 1) == "hello"_s);
+        auto const generation = b.generation;
+
+        AddValue(a, 2, "world"_s.ToConstByteSpan());
+        RemoveFlag(a, 1);
+
+        // b hasn't been told the file changed yet.
+        CHECK(GetString(b, 1) == "hello"_s);
+
+        CheckNow(b);
+        CHECK(Get(b, 1).tag == GetResult::NotFound);
+        CHECK(GetString(b, 2) == "world"_s);
+
+        // Only the new records were replayed, there was no compaction.
+        CHECK_EQ(b.generation, generation);
+        CHECK_EQ(b.replayed_size, a.replayed_size);
+        CHECK_EQ(b.replayed_size, TRY(FileSize(path)));
+    }
+
+    SUBCASE("values keep their order") {
+        Store a {.filepath = path};
+        AddValue(a, 1, (u32)1);
+        AddValue(a, 1, (u32)2);
+        CHECK(GetValueAs<u32>(a, 1) == 2u);
+
+        Store b {.filepath = path};
+        CHECK(GetValueAs<u32>(b, 1) == 2u);
+    }
+
+    SUBCASE("writers catch up before writing") {
+        Store a {.filepath = path};
+        Store b {.filepath = path};
+        for (auto const i : Range<u32>(100)) {
+            auto& store = (i % 2) ? a : b;
+            AddValue(store, 1000, i);
+            AddValue(store, i, i);
+        }
+
+        Store c {.filepath = path};
+        for (auto const i : Range<u32>(100))
+            CHECK(GetValueAs<u32>(c, i) == i);
+        auto const* values = c.Find(1000);
+        REQUIRE(values);
+        CHECK_EQ(SinglyLinkedListSize(*values), 100u);
+    }
+
+    SUBCASE("compaction") {
+        Store a {.filepath = path};
+        Store b {.filepath = path};
+        CHECK(Get(b, 1).tag == GetResult::NotFound);
+
+        Array<u8, 100> data {};
+        for (auto const i : Range<u32>(2000)) {
+            data[0] = (u8)i;
+            AddValue(a, 1, data);
+            if (i != 1999) RemoveValue(a, 1, Span<u8 const> {data});
+        }
+        AddFlag(a, 2);
+
+        CHECK_GT(a.generation, 1u);
+        CHECK_LT(TRY(FileSize(path)), k_min_compaction_size * 2);
+
+        CheckNow(b);
+        REQUIRE(Get(b, 1).tag == GetResult::Found);
+        CHECK_EQ((u8)Get(b, 1).Get<Value const*>()->data[0], (u8)1999);
+        CHECK(GetFlag(b, 2));
+        CHECK_EQ(b.generation, a.generation);
+
+        Store c {.filepath = path};
+        CHECK_EQ(SinglyLinkedListSize(*c.Find(1)), 1u);
+        CHECK(GetFlag(c, 2));
+    }
+
+    SUBCASE("partly-written record is ignored and then overwritten") {
+        {
+            Store a {.filepath = path};
+            AddValue(a, 1, "hello"_s.ToConstByteSpan());
+        }
+
+        // A record that claims more data than there is, as if a write was cut short.
+        RecordHeader const header {.id = 2, .size = 100, .op = RecordOp::Add, .reserved = {}};
+        TRY(AppendFile(path, Span<u8 const> {(u8 const*)&header, sizeof(header)}));
+        TRY(AppendFile(path, "0123456789"_s));
+
+        Store b {.filepath = path};
+        CHECK(GetString(b, 1) == "hello"_s);
+        CHECK(Get(b, 2).tag == GetResult::NotFound);
+        CHECK_LT(b.replayed_size, TRY(FileSize(path)));
+
+        AddValue(b, 3, "world"_s.ToConstByteSpan());
+        CHECK_EQ(b.replayed_size, TRY(FileSize(path)));
+
+        Store c {.filepath = path};
+        CHECK(GetString(c, 1) == "hello"_s);
+        CHECK(Get(c, 2).tag == GetResult::NotFound);
+        CHECK(GetString(c, 3) == "world"_s);
+    }
+
+    SUBCASE("file without a header is upgraded") {
+        {
+            StoreTable table {};
+            AddValue(table, tester.scratch_arena, 1, "old"_s.ToConstByteSpan());
+            DynamicArray<u8> data {tester.scratch_arena};
+            TRY(Write(table, dyn::WriterFor(data)));
+            TRY(WriteFile(path, data));
+        }
+
+        Store a {.filepath = path};
+        CHECK(GetString(a, 1) == "old"_s);
+        CHECK_EQ(a.generation, 0u);
+
+        AddValue(a, 2, "new"_s.ToConstByteSpan());
+        CHECK_EQ(a.generation, 1u);
+        auto const file_data = TRY(ReadEntireFile(path, tester.scratch_arena));
+        CHECK(ParseFileHeader(file_data.ToConstByteSpan()).HasValue());
+
+        Store b {.filepath = path};
+        CHECK(GetString(b, 1) == "old"_s);
+        CHECK(GetString(b, 2) == "new"_s);
+    }
+
+    auto const check_concurrent_writes = [&]() {
+        Store store {.filepath = path};
+        for (auto const value : Range(k_num_concurrent_writers * k_num_concurrent_writes)) {
+            auto const i = value % k_num_concurrent_writes;
+            if (i % 3 == 0)
+                CHECK(Get(store, value).tag == GetResult::NotFound);
+            else
+                CHECK(GetValueAs<u32>(store, value) == value);
+        }
+        auto const* values = store.Find(k_concurrent_shared_id);
+        REQUIRE(values);
+        CHECK_EQ(SinglyLinkedListSize(*values),
+                 (usize)(k_num_concurrent_writers * k_num_concurrent_writes));
+    };
+
+    // Each thread has its own Store and so its own file handle and lock. flock() and LockFileEx() locks
+    // belong to the open file rather than the process, so this is the same as separate processes.
+    SUBCASE("concurrent writers") {
+        Array<Thread, k_num_concurrent_writers> threads {};
+        for (auto const writer_index : Range(k_num_concurrent_writers)) {
+            threads[writer_index].Start([path, writer_index]() { WriteConcurrently(path, writer_index); },
+                                        "store-writer");
+        }
+        for (auto& thread : threads)
+            thread.Join();
+
+        check_concurrent_writes();
+    }
+
+#if !IS_WINDOWS
+    // The same, but with real processes. Windows has no fork() so there we only have the threaded version.
+    SUBCASE("concurrent writer processes") {
+        Array<pid_t, k_num_concurrent_writers - 1> children {};
+        for (auto const writer_index : Range(1u, k_num_concurrent_writers)) {
+            auto const pid = fork();
+            REQUIRE(pid >= 0);
+            if (pid == 0) {
+                // The child must never return into the test framework, and shouldn't run the parent's exit
+                // handlers.
+                try {
+                    WriteConcurrently(path, writer_index);
+                } catch (PanicException) {
+                    _exit(1);
+                }
+                _exit(0);
+            }
+            children[writer_index - 1] = pid;
+        }
+        WriteConcurrently(path, 0);
+
+        for (auto const pid : children) {
+            int status = 0;
+            REQUIRE_EQ(waitpid(pid, &status, 0), pid);
+            CHECK(WIFEXITED(status));
+            CHECK_EQ(WEXITSTATUS(status), 0);
+        }
+
+        check_concurrent_writes();
+    }
+#endif
+
+    return k_success;
+}
+
+// 10k changes made by two instances sharing the store, like toggling favourites, with each instance picking
+// up the other's changes every so often.
+BENCHMARK_FN void BenchmarkPersistentStoreUpdates() {
+    ArenaAllocator arena {PageAllocator::Instance()};
+    u64 seed = RandomSeed();
+    auto const folder = TemporaryDirectoryWithinFolder(
+                            KnownDirectory(arena, KnownDirectoryType::Temporary, {.create = true}),
+                            arena,
+                            seed)
+                            .Value();
+    DEFER { auto _ = Delete(folder, {.type = DeleteOptions::Type::DirectoryRecursively}); };
+    auto const path = path::Join(arena, Array {folder, "persistent_store"_s});
+
+    Store a {.filepath = path};
+    Store b {.filepath = path};
+    for (auto const i : Range<u32>(10'000)) {
+        auto& store = (i % 2) ? a : b;
+        auto& other = (i % 2) ? b : a;
+        auto const id = (Id)(i % 500);
+        if ((i / 500) % 2)
+            RemoveFlag(store, id);
+        else
+            AddFlag(store, id);
+        if (i % 100 == 0) {
+            CheckNow(other);
+            auto flag = GetFlag(other, id);
+            benchmarks::DoNotOptimise(flag);
+        }
+    }
+}
+
 } // namespace persistent_store
 
-TEST_REGISTRATION(RegisterPersistentStoreTests) { REGISTER_TEST(persistent_store::TestPersistentStore); }
+TEST_REGISTRATION(RegisterPersistentStoreTests) {
+    REGISTER_TEST(persistent_store::TestPersistentStore);
+    REGISTER_TEST(persistent_store::TestPersistentStoreFile);
+}
+
+BENCHMARK_REGISTRATION(RegisterPersistentStoreBenchmarks) {
+    REGISTER_BENCHMARK_NAMED(persistent_store::BenchmarkPersistentStoreUpdates, "PersistentStore/10kUpdates");
+}
@@ -3,15 +3,18 @@
 
 #pragma once
 #include "foundation/foundation.hpp"
+#include "os/filesystem.hpp"
 #include "os/misc.hpp"
 
 // Binary key-value store for persistent application data.
 //
 // Keys are always u64 ids, values are arbitrary byte arrays.
-// The underlying file uses locks to ensure that multiple processes can read/write to the store. It makes a
-// reasonable effort to stay in sync with the file on disk, but it is not guaranteed to be up-to-date at all
-// times. Overwriting the file after another process has just written is possible in extreme cases - even if
-// this occurs the file will not be corrupted.
+// The underlying file uses locks to ensure that multiple processes can read/write to the store. The file is
+// a journal: each change is appended to it rather than rewriting the whole thing, and readers map the file
+// and replay only the part they haven't seen yet. When the journal gets much bigger than the data it
+// describes, it's compacted into a new file. A store makes a reasonable effort to stay in sync with the file
+// on disk, but it is not guaranteed to be up-to-date at all times. Changes from other processes are never
+// overwritten though: a write always replays the latest journal before appending to it.
 //
 // We can use this for things like:
 // - Default preset for new instances
@@ -90,9 +93,20 @@ void RemoveValue(StoreTable& store, Id id, Optional<Span<u8 const>> value);
 struct Store : StoreTable {
     ArenaAllocator arena {PageAllocator::Instance()};
     String const filepath;
-    Atomic<u64> actual_file_last_modified_microsec {};
+
+    // What the file looked like when last checked. Set by the background thread, and by the main thread
+    // whenever it reads or writes the file. If these differ from synced_file_size/generation, the main thread
+    // replays the file.
+    Atomic<u64> actual_file_size {};
+    Atomic<u64> actual_file_generation {};
     TimePoint time_last_checked {}; // background thread
-    u64 file_last_modified_microsec {};
+
+    // Main thread.
+    Optional<FileIdentity> file_identity {}; // The file that the table reflects, compaction replaces it.
+    u64 generation {}; // Incremented each time the file is compacted.
+    u64 synced_file_size {};
+    u64 replayed_size {}; // Bytes at the start of the file that are reflected in the table.
+    u64 next_compaction_check_size {};
     bool init = false;
     bool store_valid = false;
 };
@@ -142,7 +156,8 @@ PUBLIC void SetFlag(Store& store, Id id, bool state) {
         RemoveFlag(store, id);
 }
 
-// Background thread.
-void StoreActualFileModifiedTime(Store& store);
+// Background thread. Cheaply checks if another process has changed the file so that the main thread knows
+// to replay it.
+void CheckStoreFileForChanges(Store& store);
 
 } // namespace persistent_store
@@ -164,6 +164,58 @@ u64 PersistentIrHash(ImpulseResponse const& ir) {
     return HashMultipleFnv1a(Array {ir.library.id_string, ir.id});
 }
 
+constexpr u8 k_middle_c = 60;
+
+template <Integral T>
+static T DistanceFromRange(Range<T> range, T value) {
+    if (range.Contains(value) || range.end <= range.start) return 0;
+    if (value < range.start) return (T)(range.start - value);
+    return (T)(value - (range.end - 1));
+}
+
+void RegionLoadOrder(Instrument const& inst, Span<u32> order) {
+    ASSERT_EQ(order.size, inst.regions.size);
+    for (auto [i, o] : Enumerate<u32>(order))
+        o = i;
+
+    auto const tier = [](Region const& r) -> u32 {
+        if (r.trigger.trigger_event != TriggerEvent::NoteOn) return 2; // Release samples can wait.
+        return r.trigger.velocity_range.start == 0 ? 0 : 1;
+    };
+
+    Sort(order, [&](u32 a, u32 b) {
+        auto const& ra = inst.regions[a];
+        auto const& rb = inst.regions[b];
+        if (tier(ra) != tier(rb)) return tier(ra) < tier(rb);
+        auto const key_a = DistanceFromRange(ra.trigger.key_range, k_middle_c);
+        auto const key_b = DistanceFromRange(rb.trigger.key_range, k_middle_c);
+        if (key_a != key_b) return key_a < key_b;
+        if (ra.trigger.velocity_range.start != rb.trigger.velocity_range.start)
+            return ra.trigger.velocity_range.start < rb.trigger.velocity_range.start;
+        return a < b;
+    });
+}
+
+Optional<u32>
+NearestLoadedRegion(LoadedInstrument const& inst, u8 note, u16 velocity, TriggerEvent trigger_event) {
+    Optional<u32> result {};
+    u32 best_distance = LargestRepresentableValue<u32>();
+    for (auto const [i, region] : Enumerate<u32>(inst.instrument.regions)) {
+        if (region.trigger.trigger_event != trigger_event) continue;
+        if (!inst.AudioDataLoaded(i)) continue;
+
+        // Velocities are 0 to 999. Being a semitone out is a bigger compromise than using the wrong
+        // velocity layer.
+        auto const distance = ((u32)DistanceFromRange(region.trigger.key_range, note) * 1000) +
+                              DistanceFromRange(region.trigger.velocity_range, velocity);
+        if (distance < best_distance) {
+            best_distance = distance;
+            result = i;
+        }
+    }
+    return result;
+}
+
 bool FilenameIsFloeLuaFile(String filename) {
     return IsEqualToCaseInsensitiveAscii(filename, "floe.lua") ||
            EndsWithCaseInsensitiveAscii(filename, ".floe.lua"_s);
@@ -257,6 +309,17 @@ VoidOrError<String> PostReadBookkeeping(Library& lib, Allocator& arena, ArenaAll
         BuildSorted(arena, lib.insts_by_id, &lib.root_folders[ToInt(ResourceType::Instrument)]);
     lib.sorted_irs = BuildSorted(arena, lib.irs_by_id, &lib.root_folders[ToInt(ResourceType::Ir)]);
 
+    lib.instrument_search_index = BuildSearchIndex(
+        (u32)lib.sorted_instruments.size,
+        [&](u32 i) { return lib.sorted_instruments[i]->name; },
+        arena,
+        scratch_arena);
+    lib.ir_search_index = BuildSearchIndex(
+        (u32)lib.sorted_irs.size,
+        [&](u32 i) { return lib.sorted_irs[i]->name; },
+        arena,
+        scratch_arena);
+
     for (auto [key, value, _] : lib.insts_by_id) {
         auto& inst = *value;
 
@@ -568,6 +631,91 @@ TEST_CASE(TestConvertVelocityRange) {
 
 } // namespace detail
 
+TEST_CASE(TestProgressiveInstrumentLoading) {
+    Library const lib {.file_format_specifics = LuaSpecifics {}};
+
+    auto const region = [](Range<u8> keys, Range<u16> velocities, TriggerEvent event = TriggerEvent::NoteOn) {
+        Region r {};
+        r.root_key = (u8)(keys.start + (keys.Size() / 2));
+        r.trigger.key_range = keys;
+        r.trigger.velocity_range = velocities;
+        r.trigger.trigger_event = event;
+        return r;
+    };
+
+    // A piano-like layout: 3 key zones, 2 velocity layers each, plus a release sample.
+    Region regions[] {
+        region({0, 48}, {500, 1000}), // 0
+        region({0, 48}, {0, 500}), // 1
+        region({48, 72}, {500, 1000}), // 2
+        region({48, 72}, {0, 500}), // 3
+        region({72, 128}, {500, 1000}), // 4
+        region({72, 128}, {0, 500}), // 5
+        region({48, 72}, {0, 1000}, TriggerEvent::NoteOff), // 6
+    };
+    Instrument const inst {.library = lib, .regions = regions};
+
+    SUBCASE("softest layer nearest middle C loads first, then the rest fill in") {
+        u32 order[ArraySize(regions)];
+        RegionLoadOrder(inst, order);
+        u32 const expected[] {3, 5, 1, 2, 4, 0, 6};
+        for (auto const i : ::Range(ArraySize(regions))) {
+            CAPTURE(i);
+            CHECK_EQ(order[i], expected[i]);
+        }
+    }
+
+    SUBCASE("playable before every region has loaded") {
+        AudioData audio_data {};
+        AudioData const* audio_datas[ArraySize(regions)];
+        for (auto& d : audio_datas)
+            d = &audio_data;
+
+        Atomic<bool> loaded[ArraySize(regions)] {};
+        Atomic<bool> const* loaded_ptrs[ArraySize(regions)];
+        for (auto const i : ::Range(ArraySize(regions)))
+            loaded_ptrs[i] = &loaded[i];
+
+        LoadedInstrument const loaded_inst {
+            .instrument = inst,
+            .audio_datas = audio_datas,
+            .audio_data_loaded = loaded_ptrs,
+        };
+
+        auto const nearest = [&](u8 note, u16 velocity, TriggerEvent event = TriggerEvent::NoteOn) -> s64 {
+            if (auto const r = NearestLoadedRegion(loaded_inst, note, velocity, event)) return *r;
+            return -1;
+        };
+
+        CHECK(!loaded_inst.AllAudioDataLoaded());
+        CHECK_EQ(nearest(60, 100), -1);
+
+        // Only the first region in the load order has arrived: every note uses it.
+        loaded[3].Store(true, StoreMemoryOrder::Release);
+        CHECK(loaded_inst.AudioDataLoaded(3));
+        CHECK_EQ(nearest(60, 100), 3);
+        CHECK_EQ(nearest(20, 900), 3);
+        CHECK_EQ(nearest(100, 0), 3);
+        CHECK_EQ(nearest(60, 100, TriggerEvent::NoteOff), -1);
+
+        // Nearer key zones win over nearer velocity layers.
+        loaded[5].Store(true, StoreMemoryOrder::Release);
+        CHECK_EQ(nearest(100, 900), 5);
+        loaded[2].Store(true, StoreMemoryOrder::Release);
+        CHECK_EQ(nearest(60, 900), 2);
+        CHECK_EQ(nearest(60, 100), 3);
+
+        for (auto& l : loaded)
+            l.Store(true, StoreMemoryOrder::Release);
+        CHECK(loaded_inst.AllAudioDataLoaded());
+    }
+
+    return k_success;
+}
+
 } // namespace sample_lib
 
-TEST_REGISTRATION(RegisterLibraryTests) { REGISTER_TEST(sample_lib::detail::TestConvertVelocityRange); }
+TEST_REGISTRATION(RegisterLibraryTests) {
+    REGISTER_TEST(sample_lib::detail::TestConvertVelocityRange);
+    REGISTER_TEST(sample_lib::TestProgressiveInstrumentLoading);
+}
@@ -3,10 +3,12 @@
 
 #pragma once
 #include "foundation/foundation.hpp"
+#include "os/threading.hpp"
 #include "utils/reader.hpp"
 
 #include "common_infrastructure/audio_data.hpp"
 #include "common_infrastructure/folder_node.hpp"
+#include "common_infrastructure/search_index.hpp"
 #include "common_infrastructure/tags.hpp"
 
 #include "mdata.hpp"
@@ -180,13 +182,41 @@ struct Instrument {
     Array<Span<RoundRobinGroup>, ToInt(TriggerEvent::Count)> round_robin_sequence_groups {};
 };
 
-// An instrument that has all its audio data loaded into memory.
+// An instrument that has its audio data loaded into memory. Multisampled instruments can be handed out
+// before all of their audio has arrived so that they're playable sooner: don't read an AudioData without
+// checking AudioDataLoaded().
 struct LoadedInstrument {
+    bool AudioDataLoaded(usize region_index) const {
+        return !audio_data_loaded.size || audio_data_loaded[region_index]->Load(LoadMemoryOrder::Acquire);
+    }
+    bool AllAudioDataLoaded() const {
+        for (auto const i : ::Range(audio_datas.size))
+            if (!AudioDataLoaded(i)) return false;
+        return true;
+    }
+    AudioData const* GuiWaveformAudioData() const {
+        if (file_for_gui_waveform_loaded && !file_for_gui_waveform_loaded->Load(LoadMemoryOrder::Acquire))
+            return nullptr;
+        return file_for_gui_waveform;
+    }
+
     Instrument const& instrument;
     Span<AudioData const*> audio_datas {}; // parallel to instrument.regions
+    Span<Atomic<bool> const*> audio_data_loaded {}; // parallel to instrument.regions, empty if all loaded
     AudioData const* file_for_gui_waveform {};
+    Atomic<bool> const* file_for_gui_waveform_loaded {}; // null if loaded
 };
 
+// The order to load a multisampled instrument's audio so that it's playable as soon as possible: note-on
+// regions that reach down to velocity zero, nearest middle C first; then the remaining regions, again
+// nearest middle C first. order must be the same size as inst.regions.
+void RegionLoadOrder(Instrument const& inst, Span<u32> order);
+
+// For an instrument that is still loading: the loaded region that best stands in for a note whose own
+// regions haven't arrived yet. Its audio will be pitched to the note like any other region.
+Optional<u32>
+NearestLoadedRegion(LoadedInstrument const& inst, u8 note, u16 velocity, TriggerEvent trigger_event);
+
 struct ImpulseResponse {
     Library const& library;
 
@@ -277,15 +307,17 @@ struct Library {
     } background_overlay;
     HashTable<String, Instrument*> insts_by_id {};
     Span<Instrument*> sorted_instruments {};
+    SearchIndex instrument_search_index {}; // Item indices match sorted_instruments.
     Array<FolderNode, ToInt(ResourceType::Count)> root_folders {};
     HashTable<String, ImpulseResponse*> irs_by_id {};
     Span<ImpulseResponse*> sorted_irs {};
+    SearchIndex ir_search_index {}; // Item indices match sorted_irs.
     HashTable<LibraryPath, FileAttribution, sample_lib::Hash> files_requiring_attribution {};
     u32 num_instrument_samples {};
     u32 num_regions {};
     String path {}; // real filesystem path to mdata or lua file
     u64 file_hash {};
-    ErrorCodeOr<Reader> (*create_file_reader)(Library const&, LibraryPath path) {};
+    ErrorCodeOr<Reader> (*create_file_reader)(Library const&, LibraryPath path, FileReaderOptions options) {};
     FileFormatSpecifics file_format_specifics;
 };
 
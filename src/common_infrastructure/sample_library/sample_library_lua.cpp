@@ -1913,7 +1913,8 @@ static constexpr luaL_Reg k_lua_standard_libs[] = {
     {LUA_UTF8LIBNAME, luaopen_utf8},
 };
 
-static ErrorCodeOr<Reader> CreateLuaFileReader(Library const& library, LibraryPath path) {
+static ErrorCodeOr<Reader>
+CreateLuaFileReader(Library const& library, LibraryPath path, FileReaderOptions options) {
     PathArena arena {Malloc::Instance()};
     auto const dir = ({
         auto d = path::Directory(library.path);
@@ -1921,7 +1922,7 @@ static ErrorCodeOr<Reader> CreateLuaFileReader(Library const& library, LibraryPa
         ASSERT(path::IsAbsolute(*d));
         *d;
     });
-    return Reader::FromFile(path::Join(arena, Array {dir, path.str}));
+    return Reader::FromFile(path::Join(arena, Array {dir, path.str}), options);
 }
 
 static int NewLibrary(lua_State* lua) {
@@ -3201,7 +3202,7 @@ void ForEachReferencedFile(Library const& lib, FunctionRef<void(LibraryPath)> ca
 bool CheckAllReferencedFilesExist(Library const& lib, Writer error_writer) {
     bool success = true;
     ForEachReferencedFile(lib, [&](LibraryPath path) {
-        auto outcome = lib.create_file_reader(lib, path);
+        auto outcome = lib.create_file_reader(lib, path, {});
         if (outcome.HasError()) {
             auto _ =
                 fmt::FormatToWriter(error_writer, "Error: file in Lua \"{}\": {}.\n", path, outcome.Error());
@@ -18,7 +18,8 @@ static String GetString(Library const& library, mdata::StringInPool s) {
                                        s);
 }
 
-static ErrorCodeOr<Reader> CreateMdataFileReader(Library const& library, LibraryPath library_file_path) {
+static ErrorCodeOr<Reader>
+CreateMdataFileReader(Library const& library, LibraryPath library_file_path, FileReaderOptions) {
     auto const mdata_info = library.file_format_specifics.Get<MdataSpecifics>();
     auto f = mdata_info.files_by_path.Find(library_file_path.str);
     if (!f) return ErrorCode {FilesystemError::PathDoesNotExist};
@@ -0,0 +1,640 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "sample_io.hpp"
+
+#if IS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "os/filesystem.hpp"
+#include "os/misc.hpp"
+#include "tests/framework.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/thread_extra/thread_pool.hpp"
+
+#include "benchmarks/framework.hpp"
+#include "common_infrastructure/common_errors.hpp"
+#include "common_infrastructure/sample_library/audio_file.hpp"
+
+void ReleaseSampleIoReadResult(SampleIoRead& read) {
+    if (read.owned_data.size) Malloc::Instance().Free(read.owned_data);
+    read.owned_data = {};
+    read.data = {};
+    read.reader = k_nullopt;
+    read.error = k_nullopt;
+    read.bytes_read = 0;
+}
+
+// Call with queue.mutex locked.
+static SampleIoRead* PopPendingRead(SampleIoQueue& queue) {
+    auto const read = queue.pending_first;
+    if (!read) return nullptr;
+    queue.pending_first = read->next;
+    if (!queue.pending_first) queue.pending_last = nullptr;
+    read->next = nullptr;
+    return read;
+}
+
+// Returns true if the file still needs to be read into read.owned_data.
+static bool OpenRead(SampleIoRead& read) {
+    auto outcome = read.open(read);
+    if (outcome.HasError()) {
+        read.error = outcome.Error();
+        return false;
+    }
+    read.reader = outcome.ReleaseValue();
+    auto& reader = *read.reader;
+
+    if (reader.memory) {
+        read.data = {reader.memory, reader.size};
+        return false;
+    }
+    if (reader.mapped_file) {
+        read.data = reader.mapped_file->data;
+        return false;
+    }
+    if (!reader.size) return false;
+
+    read.owned_data = Malloc::Instance().AllocateExactSizeUninitialised<u8>(reader.size);
+    read.bytes_read = 0;
+    return true;
+}
+
+static void ReadBlocking(SampleIoRead& read) {
+    auto const outcome = read.reader->ReadAt(0, read.owned_data);
+    if (outcome.HasError())
+        read.error = outcome.Error();
+    else if (outcome.Value() != read.owned_data.size)
+        read.error = ErrorCode {CommonError::CorruptFile}; // The file shrank while we were reading it.
+    else
+        read.data = read.owned_data;
+}
+
+static void FallbackThreadProc(SampleIoQueue& queue) {
+    while (true) {
+        SampleIoRead* read;
+        {
+            ScopedMutexLock lock {queue.mutex};
+            while (!queue.pending_first && !queue.stop_requested)
+                queue.work_available.Wait(lock);
+            read = PopPendingRead(queue);
+            if (!read) return; // Stop requested and everything has been read.
+        }
+        if (OpenRead(*read)) ReadBlocking(*read);
+        read->on_complete(*read);
+    }
+}
+
+#if IS_LINUX
+
+// We use the raw syscalls rather than liburing, we only need a small part of it.
+struct SampleIoQueue::IoUring {
+    static constexpr u64 k_event_fd_user_data = 0;
+
+    int ring_fd = -1;
+    int event_fd = -1;
+    u64 event_fd_value {};
+
+    void* sq_ring {};
+    usize sq_ring_size {};
+    void* cq_ring {};
+    usize cq_ring_size {};
+    io_uring_sqe* sqes {};
+    usize sqes_size {};
+
+    u32* sq_head {};
+    u32* sq_tail {};
+    u32* sq_array {};
+    u32 sq_mask {};
+    u32* cq_head {};
+    u32* cq_tail {};
+    io_uring_cqe* cqes {};
+    u32 cq_mask {};
+
+    u32 num_unsubmitted {};
+    u32 num_reads_in_flight {};
+};
+
+using IoUring = SampleIoQueue::IoUring;
+
+static void DestroyIoUring(IoUring& ring) {
+    if (ring.sqes) munmap(ring.sqes, ring.sqes_size);
+    if (ring.cq_ring && ring.cq_ring != ring.sq_ring) munmap(ring.cq_ring, ring.cq_ring_size);
+    if (ring.sq_ring) munmap(ring.sq_ring, ring.sq_ring_size);
+    if (ring.ring_fd != -1) close(ring.ring_fd);
+    if (ring.event_fd != -1) close(ring.event_fd);
+}
+
+static bool SetupIoUring(IoUring& ring, u32 entries) {
+    io_uring_params params {};
+    auto const fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        LogInfo(ModuleName::SampleLibraryServer, "io_uring unavailable ({}), using threads", errno);
+        return false;
+    }
+    ring.ring_fd = fd;
+
+    // IORING_OP_READ arrived in the same kernel version (5.6) as this feature flag.
+    if (!(params.features & IORING_FEAT_RW_CUR_POS) || !(params.features & IORING_FEAT_NODROP)) {
+        LogInfo(ModuleName::SampleLibraryServer, "io_uring too old, using threads");
+        return false;
+    }
+
+    ring.sq_ring_size = params.sq_off.array + (params.sq_entries * sizeof(u32));
+    ring.cq_ring_size = params.cq_off.cqes + (params.cq_entries * sizeof(io_uring_cqe));
+    bool const single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) ring.sq_ring_size = ring.cq_ring_size = Max(ring.sq_ring_size, ring.cq_ring_size);
+
+    auto const map = [&](usize size, off_t offset) -> void* {
+        auto const p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    };
+    ring.sq_ring = map(ring.sq_ring_size, IORING_OFF_SQ_RING);
+    if (!ring.sq_ring) return false;
+    ring.cq_ring = single_mmap ? ring.sq_ring : map(ring.cq_ring_size, IORING_OFF_CQ_RING);
+    if (!ring.cq_ring) return false;
+    ring.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    ring.sqes = (io_uring_sqe*)map(ring.sqes_size, IORING_OFF_SQES);
+    if (!ring.sqes) return false;
+
+    auto const sq = (u8*)ring.sq_ring;
+    ring.sq_head = (u32*)(sq + params.sq_off.head);
+    ring.sq_tail = (u32*)(sq + params.sq_off.tail);
+    ring.sq_array = (u32*)(sq + params.sq_off.array);
+    ring.sq_mask = *(u32*)(sq + params.sq_off.ring_mask);
+    auto const cq = (u8*)ring.cq_ring;
+    ring.cq_head = (u32*)(cq + params.cq_off.head);
+    ring.cq_tail = (u32*)(cq + params.cq_off.tail);
+    ring.cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring.cq_mask = *(u32*)(cq + params.cq_off.ring_mask);
+
+    ring.event_fd = eventfd(0, EFD_CLOEXEC);
+    if (ring.event_fd == -1) return false;
+
+    return true;
+}
+
+// We never have more submissions outstanding than the ring has room for, so this doesn't fail.
+static void PushRead(IoUring& ring, int fd, void* buffer, usize size, u64 offset, u64 user_data) {
+    auto const tail = *ring.sq_tail; // Only we write the tail.
+    ASSERT(tail - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE) <= ring.sq_mask);
+    auto const index = tail & ring.sq_mask;
+    auto& sqe = ring.sqes[index];
+    ZeroMemory(&sqe, sizeof(sqe));
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = fd;
+    sqe.addr = (u64)(uintptr)buffer;
+    sqe.len = (u32)Min<usize>(size, Mb(512));
+    sqe.off = offset;
+    sqe.user_data = user_data;
+    ring.sq_array[index] = index;
+    __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++ring.num_unsubmitted;
+}
+
+static void PushEventFdRead(IoUring& ring) {
+    PushRead(ring,
+             ring.event_fd,
+             &ring.event_fd_value,
+             sizeof(ring.event_fd_value),
+             0,
+             IoUring::k_event_fd_user_data);
+}
+
+static void PushFileRead(IoUring& ring, SampleIoRead& read) {
+    auto& reader = *read.reader;
+    PushRead(ring,
+             reader.file->handle,
+             read.owned_data.data + read.bytes_read,
+             read.owned_data.size - read.bytes_read,
+             reader.file_base_pos + read.bytes_read,
+             (u64)(uintptr)&read);
+}
+
+// Submits everything pushed and waits for at least min_complete completions.
+static void EnterIoUring(IoUring& ring, u32 min_complete) {
+    while (true) {
+        auto const result = syscall(__NR_io_uring_enter,
+                                    ring.ring_fd,
+                                    ring.num_unsubmitted,
+                                    min_complete,
+                                    min_complete ? IORING_ENTER_GETEVENTS : 0u,
+                                    nullptr,
+                                    0);
+        if (result >= 0) {
+            ring.num_unsubmitted -= (u32)result;
+            return;
+        }
+        if (errno == EINTR) continue;
+        // The kernel is short of resources or wants us to reap completions; both resolve as in-flight reads
+        // complete.
+        if (errno == EAGAIN || errno == EBUSY) return;
+        Panic("io_uring_enter failed");
+    }
+}
+
+static void CompleteFileRead(IoUring& ring, SampleIoRead& read, s32 result) {
+    if (result == -EINTR || result == -EAGAIN) {
+        PushFileRead(ring, read);
+        return;
+    }
+
+    if (result < 0)
+        read.error = FilesystemErrnoErrorCode(-result, "io_uring read");
+    else if (result == 0)
+        read.error = ErrorCode {CommonError::CorruptFile}; // The file shrank while we were reading it.
+    else {
+        read.bytes_read += (usize)result;
+        if (read.bytes_read != read.owned_data.size) {
+            PushFileRead(ring, read); // Short read, carry on from where it got to.
+            return;
+        }
+        read.data = read.owned_data;
+    }
+
+    --ring.num_reads_in_flight;
+    read.on_complete(read);
+}
+
+static void ReapCompletions(IoUring& ring) {
+    auto head = *ring.cq_head; // Only we write the head.
+    auto const tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        auto const cqe = ring.cqes[head & ring.cq_mask];
+        ++head;
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+        if (cqe.user_data == IoUring::k_event_fd_user_data)
+            PushEventFdRead(ring);
+        else
+            CompleteFileRead(ring, *(SampleIoRead*)(uintptr)cqe.user_data, cqe.res);
+    }
+}
+
+static void IoUringThreadProc(SampleIoQueue& queue) {
+    auto& ring = *queue.io_uring;
+    PushEventFdRead(ring);
+
+    while (true) {
+        // Start as many queued reads as there's room for.
+        while (ring.num_reads_in_flight < queue.options.max_reads_in_flight) {
+            SampleIoRead* read;
+            {
+                ScopedMutexLock lock {queue.mutex};
+                read = PopPendingRead(queue);
+            }
+            if (!read) break;
+
+            if (!OpenRead(*read)) {
+                read->on_complete(*read);
+                continue;
+            }
+            if (!read->reader->file) {
+                // Callback-based readers can't go through the ring.
+                ReadBlocking(*read);
+                read->on_complete(*read);
+                continue;
+            }
+            PushFileRead(ring, *read);
+            ++ring.num_reads_in_flight;
+        }
+
+        if (!ring.num_reads_in_flight) {
+            ScopedMutexLock lock {queue.mutex};
+            if (queue.stop_requested && !queue.pending_first) break;
+        }
+
+        // The eventfd read is always in flight, so we'll wake for new reads being queued as well as for
+        // in-flight reads completing.
+        EnterIoUring(ring, 1);
+        ReapCompletions(ring);
+    }
+}
+
+static void WakeIoUringThread(IoUring& ring) {
+    u64 const value = 1;
+    auto const _ = write(ring.event_fd, &value, sizeof(value));
+}
+
+#else
+
+struct SampleIoQueue::IoUring {};
+
+#endif
+
+void InitSampleIoQueue(SampleIoQueue& queue, SampleIoQueueOptions options) {
+    ASSERT(!queue.threads.size);
+    ASSERT(options.max_reads_in_flight && options.num_fallback_threads);
+    queue.options = options;
+    queue.stop_requested = false;
+
+#if IS_LINUX
+    if (options.allow_io_uring) {
+        auto ring = Malloc::Instance().New<IoUring>();
+        // +1 for the eventfd read.
+        if (SetupIoUring(*ring, NextPowerOf2(options.max_reads_in_flight + 1))) {
+            queue.io_uring = ring;
+            queue.threads = Malloc::Instance().NewMultiple<Thread>(1);
+            queue.threads[0].Start([&queue]() { IoUringThreadProc(queue); }, "sample-io");
+            return;
+        }
+        DestroyIoUring(*ring);
+        Malloc::Instance().Delete(ring);
+    }
+#endif
+
+    queue.threads = Malloc::Instance().NewMultiple<Thread>(options.num_fallback_threads);
+    for (auto [i, thread] : Enumerate<u32>(queue.threads)) {
+        thread.Start([&queue]() { FallbackThreadProc(queue); },
+                     fmt::FormatInline<k_max_thread_name_size>("sample-io:{}", i));
+    }
+}
+
+void DeinitSampleIoQueue(SampleIoQueue& queue) {
+    {
+        ScopedMutexLock lock {queue.mutex};
+        queue.stop_requested = true;
+    }
+#if IS_LINUX
+    if (queue.io_uring) WakeIoUringThread(*queue.io_uring);
+#endif
+    queue.work_available.WakeAll();
+
+    for (auto& thread : queue.threads)
+        thread.Join();
+    Malloc::Instance().Delete(queue.threads);
+    queue.threads = {};
+
+#if IS_LINUX
+    if (queue.io_uring) {
+        DestroyIoUring(*queue.io_uring);
+        Malloc::Instance().Delete(queue.io_uring);
+        queue.io_uring = nullptr;
+    }
+#endif
+}
+
+void QueueSampleIoRead(SampleIoQueue& queue, SampleIoRead& read) {
+    ASSERT(read.open && read.on_complete);
+    read.next = nullptr;
+    {
+        ScopedMutexLock lock {queue.mutex};
+        ASSERT(!queue.stop_requested);
+        if (queue.pending_last)
+            queue.pending_last->next = &read;
+        else
+            queue.pending_first = &read;
+        queue.pending_last = &read;
+    }
+
+#if IS_LINUX
+    if (queue.io_uring) {
+        WakeIoUringThread(*queue.io_uring);
+        return;
+    }
+#endif
+    queue.work_available.WakeOne();
+}
+
+bool SampleIoQueueUsesIoUring(SampleIoQueue const& queue) { return queue.io_uring != nullptr; }
+
+// Sample stores are often on a RAM disk in tests; use one if we have it so that we test the ring without
+// depending on the speed of the disk.
+static String TmpfsFolderIfAvailable(tests::Tester& tester) {
+    if constexpr (IS_LINUX) {
+        if (auto const o = GetFileType("/dev/shm"); o.HasValue() && o.Value() == FileType::Directory) {
+            u64 seed = RandomSeed();
+            if (auto const dir = TemporaryDirectoryWithinFolder("/dev/shm", tester.scratch_arena, seed);
+                dir.HasValue())
+                return dir.Value();
+        }
+    }
+    return tests::TempFolderUnique(tester);
+}
+
+TEST_CASE(TestSampleIoQueue) {
+    auto& a = tester.scratch_arena;
+    auto const folder = TmpfsFolderIfAvailable(tester);
+    DEFER { auto _ = Delete(folder, {.type = DeleteOptions::Type::DirectoryRecursively}); };
+
+    struct TestRead {
+        SampleIoRead read;
+        String path;
+        Span<u8 const> expected;
+        bool should_fail;
+        bool matched;
+        AtomicCountdown* countdown;
+    };
+
+    constexpr u32 k_num_files = 150; // More than fit in the ring at once.
+    auto const memory_data = "in memory"_s.ToByteSpan();
+    u64 seed = 99;
+    auto reads = a.NewMultiple<TestRead>(k_num_files + 2);
+    for (auto const i : Range(k_num_files)) {
+        auto const size = (i == 0) ? 0 : RandomIntInRange<usize>(seed, 1, Kb(300));
+        auto data = a.AllocateExactSizeUninitialised<u8>(size);
+        for (auto& b : data)
+            b = (u8)RandomIntInRange<u32>(seed, 0, 255);
+        auto const path = path::Join(a, Array {folder, (String)fmt::Format(a, "{}.bin", i)});
+        TRY(WriteFile(path, data));
+        reads[i].path = path;
+        reads[i].expected = data;
+    }
+    reads[k_num_files].path = path::Join(a, Array {folder, "does-not-exist.bin"_s});
+    reads[k_num_files].should_fail = true;
+    reads[k_num_files + 1].expected = memory_data;
+
+    auto const check_backend = [&](SampleIoQueueOptions options) {
+        SampleIoQueue queue;
+        InitSampleIoQueue(queue, options);
+        if (!options.allow_io_uring) CHECK(!SampleIoQueueUsesIoUring(queue));
+        tester.log.Debug("Using io_uring: {}", SampleIoQueueUsesIoUring(queue));
+
+        AtomicCountdown countdown {(u32)reads.size};
+        for (auto& r : reads) {
+            r.matched = false;
+            r.countdown = &countdown;
+            r.read = {
+                .open = [](SampleIoRead& read) -> ErrorCodeOr<Reader> {
+                    auto& t = *(TestRead*)read.user_data;
+                    if (!t.path.size) return Reader::FromMemory(t.expected);
+                    return Reader::FromFile(t.path, {.min_size_to_map = FileReaderOptions::k_never_map});
+                },
+                .on_complete =
+                    [](SampleIoRead& read) {
+                        auto& t = *(TestRead*)read.user_data;
+                        if (t.should_fail)
+                            t.matched = read.error.HasValue();
+                        else
+                            t.matched = !read.error && read.data == t.expected;
+                        ReleaseSampleIoReadResult(read);
+                        t.countdown->CountDown();
+                    },
+                .user_data = &r,
+            };
+        }
+
+        // Queue from a couple of threads at once.
+        Thread other_thread;
+        other_thread.Start(
+            [&]() {
+                for (usize i = 1; i < reads.size; i += 2)
+                    QueueSampleIoRead(queue, reads[i].read);
+            },
+            "io-test");
+        for (usize i = 0; i < reads.size; i += 2)
+            QueueSampleIoRead(queue, reads[i].read);
+        other_thread.Join();
+
+        countdown.WaitUntilZero();
+        DeinitSampleIoQueue(queue);
+
+        for (auto const& r : reads) {
+            CAPTURE(r.path);
+            CHECK(r.matched);
+        }
+    };
+
+    SUBCASE("io_uring, if available") { check_backend({}); }
+    SUBCASE("io_uring with few reads in flight") { check_backend({.max_reads_in_flight = 2}); }
+    SUBCASE("blocking threads") { check_backend({.allow_io_uring = false}); }
+
+    SUBCASE("deinit completes everything queued") {
+        SampleIoQueue queue;
+        InitSampleIoQueue(queue, {.max_reads_in_flight = 4});
+        AtomicCountdown countdown {(u32)reads.size};
+        for (auto& r : reads) {
+            r.countdown = &countdown;
+            r.read = {
+                .open = [](SampleIoRead& read) -> ErrorCodeOr<Reader> {
+                    auto& t = *(TestRead*)read.user_data;
+                    if (!t.path.size) return Reader::FromMemory(t.expected);
+                    return Reader::FromFile(t.path);
+                },
+                .on_complete =
+                    [](SampleIoRead& read) {
+                        ReleaseSampleIoReadResult(read);
+                        ((TestRead*)read.user_data)->countdown->CountDown();
+                    },
+                .user_data = &r,
+            };
+            QueueSampleIoRead(queue, r.read);
+        }
+        DeinitSampleIoQueue(queue);
+        CHECK(countdown.TryWait());
+    }
+
+    return k_success;
+}
+
+TEST_REGISTRATION(RegisterSampleIoTests) { REGISTER_TEST(TestSampleIoQueue); }
+
+static constexpr FileReaderOptions k_unmapped_reader {.min_size_to_map = FileReaderOptions::k_never_map};
+
+// Loading an instrument's worth of samples: 64 files of 1 MB. Compares the old approach where each thread
+// pool job opens, reads and decodes a file, against reading through the queue and decoding as reads
+// complete. Cold runs ask the OS to drop the files from the page cache first (Linux only).
+BENCHMARK_FN void BenchmarkLoadInstrumentSamples(bool use_queue, bool cold_cache) {
+    ArenaAllocator arena {PageAllocator::Instance()};
+    u64 seed = RandomSeed();
+    auto const folder = TemporaryDirectoryWithinFolder(
+                            KnownDirectory(arena, KnownDirectoryType::Temporary, {.create = true}),
+                            arena,
+                            seed)
+                            .Value();
+    DEFER { auto _ = Delete(folder, {.type = DeleteOptions::Type::DirectoryRecursively}); };
+
+    constexpr u32 k_num_files = 64;
+    DynamicArray<String> paths {arena};
+    auto const data = arena.AllocateExactSizeUninitialised<s16>(Mb(1) / sizeof(s16));
+    for (auto const file_index : Range(k_num_files)) {
+        for (auto [i, sample] : Enumerate(data))
+            sample = (s16)((s32)((i * (file_index + 3)) % 2000) + RandomIntInRange<s32>(seed, -64, 64));
+        auto const filename = fmt::Format(arena, "{}{}", file_index, k_raw_16_bit_stereo_44100_format_ext);
+        auto const path = path::Join(arena, Array {folder, (String)filename});
+        if (WriteFile(path, data.ToByteSpan()).HasError()) Panic("failed to write benchmark file");
+        dyn::Append(paths, path);
+    }
+
+    ThreadPool thread_pool;
+    thread_pool.Init("io-bench", {});
+    SampleIoQueue queue;
+    if (use_queue) InitSampleIoQueue(queue);
+    DEFER {
+        if (use_queue) DeinitSampleIoQueue(queue);
+    };
+
+    struct Load {
+        SampleIoRead read;
+        String path;
+        ThreadPool* thread_pool;
+        AtomicCountdown* countdown;
+    };
+    auto loads = arena.NewMultiple<Load>(k_num_files);
+
+    for (auto const iteration : Range(4)) {
+        (void)iteration;
+        if (cold_cache) {
+#if IS_LINUX
+            for (auto const path : paths) {
+                auto file = OpenFile(path, FileMode::Read()).Value();
+                posix_fadvise(file.handle, 0, 0, POSIX_FADV_DONTNEED);
+            }
+#endif
+        }
+
+        AtomicCountdown countdown {k_num_files};
+        for (auto [i, load] : Enumerate(loads)) {
+            load.path = paths[i];
+            load.thread_pool = &thread_pool;
+            load.countdown = &countdown;
+            if (!use_queue) {
+                thread_pool.AddJob([l = &load]() {
+                    auto reader = Reader::FromFile(l->path, k_unmapped_reader).Value();
+                    auto const audio = DecodeAudioFile(reader, l->path, Malloc::Instance()).Value();
+                    Malloc::Instance().Free(audio.interleaved_samples.ToByteSpan());
+                    l->countdown->CountDown();
+                });
+                continue;
+            }
+            load.read = {
+                .open = [](SampleIoRead& read) -> ErrorCodeOr<Reader> {
+                    auto& l = *(Load*)read.user_data;
+                    return Reader::FromFile(l.path, k_unmapped_reader);
+                },
+                .on_complete =
+                    [](SampleIoRead& read) {
+                        auto& l = *(Load*)read.user_data;
+                        l.thread_pool->AddJob([&l]() {
+                            auto reader = Reader::FromMemory(l.read.data);
+                            auto const audio = DecodeAudioFile(reader, l.path, Malloc::Instance()).Value();
+                            Malloc::Instance().Free(audio.interleaved_samples.ToByteSpan());
+                            ReleaseSampleIoReadResult(l.read);
+                            l.countdown->CountDown();
+                        });
+                    },
+                .user_data = &load,
+            };
+            QueueSampleIoRead(queue, load.read);
+        }
+        countdown.WaitUntilZero();
+    }
+}
+
+BENCHMARK_REGISTRATION(RegisterSampleIoBenchmarks) {
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkLoadInstrumentSamples(false, true); },
+                             "LoadInstrumentSamples/ThreadPool/Cold");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkLoadInstrumentSamples(true, true); },
+                             "LoadInstrumentSamples/IoQueue/Cold");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkLoadInstrumentSamples(false, false); },
+                             "LoadInstrumentSamples/ThreadPool/Warm");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkLoadInstrumentSamples(true, false); },
+                             "LoadInstrumentSamples/IoQueue/Warm");
+}
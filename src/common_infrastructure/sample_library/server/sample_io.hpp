@@ -0,0 +1,73 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "foundation/foundation.hpp"
+#include "os/threading.hpp"
+#include "utils/reader.hpp"
+
+// Reads whole sample files into memory ahead of decoding them, so that decoding threads don't sit waiting on
+// slow storage (network mounts, spinning disks).
+//
+// On Linux, a single I/O thread keeps many reads in flight at once using io_uring. Elsewhere, or if io_uring
+// isn't available (old kernels, sandboxes that block it), a few blocking threads do the reads instead.
+
+struct SampleIoRead {
+    // Set by the caller. Called on an I/O thread to open the file. The Reader should be file-backed; if it's
+    // in-memory or memory-mapped, no read is needed and data points straight into it. Return an error to
+    // abandon the read; on_complete is still called.
+    ErrorCodeOr<Reader> (*open)(SampleIoRead& read) {};
+
+    // Set by the caller. Called on an I/O thread once the file has been read, or failed. The queue doesn't
+    // touch the read after this, so this is where it can be handed to a decoding job.
+    void (*on_complete)(SampleIoRead& read) {};
+
+    void* user_data {};
+
+    // Results, valid in on_complete. Free with ReleaseSampleIoReadResult().
+    Optional<ErrorCode> error {};
+    Span<u8 const> data {};
+    Optional<Reader> reader {};
+    Span<u8> owned_data {}; // Malloc, if we had to read the file.
+
+    // Internal.
+    SampleIoRead* next {};
+    usize bytes_read {};
+};
+
+void ReleaseSampleIoReadResult(SampleIoRead& read);
+
+struct SampleIoQueueOptions {
+    bool allow_io_uring = true;
+    u32 max_reads_in_flight = 64; // io_uring only
+    u32 num_fallback_threads = 4;
+};
+
+struct SampleIoQueue {
+    NON_COPYABLE_AND_MOVEABLE(SampleIoQueue);
+    SampleIoQueue() = default;
+    ~SampleIoQueue() { ASSERT(!threads.size); }
+
+    // private
+    struct IoUring;
+
+    SampleIoQueueOptions options {};
+    Mutex mutex {};
+    ConditionVariable work_available {}; // Fallback threads only.
+    SampleIoRead* pending_first {}; // Guarded by mutex. FIFO.
+    SampleIoRead* pending_last {};
+    bool stop_requested {};
+    IoUring* io_uring {};
+    Span<Thread> threads {};
+};
+
+void InitSampleIoQueue(SampleIoQueue& queue, SampleIoQueueOptions options = {});
+
+// Completes every read that has been queued, then stops the I/O threads.
+void DeinitSampleIoQueue(SampleIoQueue& queue);
+
+// Thread-safe. read must stay alive until its on_complete has been called.
+void QueueSampleIoRead(SampleIoQueue& queue, SampleIoRead& read);
+
+bool SampleIoQueueUsesIoUring(SampleIoQueue const& queue);
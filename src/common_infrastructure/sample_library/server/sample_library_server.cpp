@@ -17,6 +17,8 @@
 #include "common_infrastructure/sample_library/library_id_cache.hpp"
 #include "common_infrastructure/sample_library/sample_library.hpp"
 
+#include "sample_memory_pool.hpp"
+
 #include "build_resources/embedded_files.h"
 
 namespace sample_lib_server {
@@ -359,7 +361,7 @@ static Optional<DirectoryWatcher> CreateDirectoryWatcher(ThreadsafeErrorNotifica
 // ==========================================================================================================
 // Library resource loading
 
-using AudioDataAllocator = PageAllocator;
+using AudioDataAllocator = SampleMemoryPool;
 
 ListedAudioData::~ListedAudioData() {
     ZoneScoped;
@@ -387,65 +389,131 @@ ListedImpulseResponse::~ListedImpulseResponse() {
 // Just a little helper that we pass around when working with the thread pool.
 struct ThreadPoolArgs {
     ThreadPool& pool;
+    SampleIoQueue& io_queue;
     AtomicCountdown& num_thread_pool_jobs;
     Semaphore& completed_signaller;
+    JobPriority decode_priority;
 };
 
-static void
-LoadAudioAsync(ListedAudioData& audio_data, sample_lib::Library const& lib, ThreadPoolArgs thread_pool_args) {
-    thread_pool_args.num_thread_pool_jobs.Increase();
-    thread_pool_args.pool.AddJob([&, thread_pool_args]() {
-        try {
-            ZoneScoped;
-            DEFER {
-                thread_pool_args.completed_signaller.Signal();
-
-                // NOTE: it's important that we do this last, because once the number of thread pool jobs
-                // reaches 0, objects in the thread_pool_args could be destroyed.
-                thread_pool_args.num_thread_pool_jobs.CountDown();
-            };
+// An audio file is read by the I/O queue, then decoded in a thread pool job as soon as the read completes.
+// This keeps lots of reads in flight at once rather than each thread pool job blocking on its own read.
+struct AudioLoad {
+    SampleIoRead read;
+    ListedAudioData* audio_data;
+    sample_lib::Library const* lib;
+    ThreadPoolArgs thread_pool_args;
+    bool cancelled;
+};
 
-            {
-                auto state = audio_data.state.Load(LoadMemoryOrder::Acquire);
-                FileLoadingState new_state;
-                do {
-                    if (state == FileLoadingState::PendingLoad)
-                        new_state = FileLoadingState::Loading;
-                    else if (state == FileLoadingState::PendingCancel)
-                        new_state = FileLoadingState::CompletedCancelled;
-                    else
-                        PanicIfReached();
-                } while (!audio_data.state.CompareExchangeWeak(state,
-                                                               new_state,
-                                                               RmwMemoryOrder::AcquireRelease,
-                                                               LoadMemoryOrder::Acquire));
-
-                if (new_state == FileLoadingState::CompletedCancelled) return;
-            }
+static void FinishAudioLoad(AudioLoad* load) {
+    auto const thread_pool_args = load->thread_pool_args;
+    ReleaseSampleIoReadResult(load->read);
+    Malloc::Instance().Delete(load);
 
-            // At this point we must be in the Loading state so other threads know not to interfere. The
-            // memory ordering used with the atomic 'state' variable reflects this: the Acquire memory order
-            // above, and the Release memory order at the end.
-            ASSERT_EQ(audio_data.state.Load(LoadMemoryOrder::Acquire), FileLoadingState::Loading);
+    thread_pool_args.completed_signaller.Signal();
 
-            auto const outcome = [&audio_data, &lib]() -> ErrorCodeOr<AudioData> {
-                auto reader = TRY(lib.create_file_reader(lib, audio_data.path));
-                return DecodeAudioFile(reader, audio_data.path.str, AudioDataAllocator::Instance());
-            }();
+    // NOTE: it's important that we do this last, because once the number of thread pool jobs reaches 0,
+    // objects in the thread_pool_args could be destroyed.
+    thread_pool_args.num_thread_pool_jobs.CountDown();
+}
 
-            FileLoadingState result;
-            if (outcome.HasValue()) {
-                audio_data.audio_data = outcome.Value();
-                result = FileLoadingState::CompletedSucessfully;
-            } else {
-                audio_data.error = outcome.Error();
-                result = FileLoadingState::CompletedWithError;
-            }
-            audio_data.state.Store(result, StoreMemoryOrder::Release);
-        } catch (PanicException) {
-            // Pass. We're an audio plugin, we don't want to crash the host.
+static void SetAudioLoadResult(ListedAudioData& audio_data, ErrorCodeOr<AudioData> const& outcome) {
+    // At this point we must be in the Loading state so other threads know not to interfere. The memory
+    // ordering used with the atomic 'state' variable reflects this: the Acquire memory order when we started
+    // loading, and the Release memory order here.
+    ASSERT_EQ(audio_data.state.Load(LoadMemoryOrder::Acquire), FileLoadingState::Loading);
+
+    FileLoadingState result;
+    if (outcome.HasValue()) {
+        audio_data.audio_data = outcome.Value();
+        audio_data.loaded.Store(true, StoreMemoryOrder::Release);
+        result = FileLoadingState::CompletedSucessfully;
+    } else {
+        audio_data.error = outcome.Error();
+        result = FileLoadingState::CompletedWithError;
+    }
+    audio_data.state.Store(result, StoreMemoryOrder::Release);
+}
+
+// Called on an I/O thread.
+static ErrorCodeOr<Reader> OpenAudioFile(SampleIoRead& read) {
+    auto& load = *(AudioLoad*)read.user_data;
+    auto& audio_data = *load.audio_data;
+
+    auto state = audio_data.state.Load(LoadMemoryOrder::Acquire);
+    FileLoadingState new_state;
+    do {
+        if (state == FileLoadingState::PendingLoad)
+            new_state = FileLoadingState::Loading;
+        else if (state == FileLoadingState::PendingCancel)
+            new_state = FileLoadingState::CompletedCancelled;
+        else
+            PanicIfReached();
+    } while (!audio_data.state.CompareExchangeWeak(state,
+                                                   new_state,
+                                                   RmwMemoryOrder::AcquireRelease,
+                                                   LoadMemoryOrder::Acquire));
+
+    if (new_state == FileLoadingState::CompletedCancelled) {
+        load.cancelled = true;
+        return Reader::FromMemory({}); // Nothing to read.
+    }
+
+    // We want the queue to do the reading rather than page-faulting through a mapping on the decode thread.
+    return load.lib->create_file_reader(*load.lib,
+                                        audio_data.path,
+                                        {.min_size_to_map = FileReaderOptions::k_never_map});
+}
+
+// Called on an I/O thread.
+static void OnAudioFileRead(SampleIoRead& read) {
+    auto load = (AudioLoad*)read.user_data;
+    try {
+        // Unless the decode job takes the load over, we finish it here - even if we panic - so that the read
+        // buffer is freed and num_thread_pool_jobs still reaches zero.
+        bool handed_to_decode_job = false;
+        DEFER {
+            if (!handed_to_decode_job) FinishAudioLoad(load);
+        };
+
+        if (load->cancelled) return;
+        if (read.error) {
+            SetAudioLoadResult(*load->audio_data, *read.error);
+            return;
         }
+
+        load->thread_pool_args.pool.AddJob(
+            [load]() {
+                try {
+                    ZoneScoped;
+                    DEFER { FinishAudioLoad(load); };
+                    auto reader = Reader::FromMemory(load->read.data);
+                    SetAudioLoadResult(
+                        *load->audio_data,
+                        DecodeAudioFile(reader, load->audio_data->path.str, AudioDataAllocator::Instance()));
+                } catch (PanicException) {
+                    // Pass. We're an audio plugin, we don't want to crash the host.
+                }
+            },
+            load->thread_pool_args.decode_priority);
+        handed_to_decode_job = true;
+    } catch (PanicException) {
+        // Pass. We're an audio plugin, we don't want to crash the host.
+    }
+}
+
+static void
+LoadAudioAsync(ListedAudioData& audio_data, sample_lib::Library const& lib, ThreadPoolArgs thread_pool_args) {
+    thread_pool_args.num_thread_pool_jobs.Increase();
+    auto load = Malloc::Instance().New<AudioLoad>(AudioLoad {
+        .read = {.open = OpenAudioFile, .on_complete = OnAudioFileRead},
+        .audio_data = &audio_data,
+        .lib = &lib,
+        .thread_pool_args = thread_pool_args,
+        .cancelled = false,
     });
+    load->read.user_data = load;
+    QueueSampleIoRead(thread_pool_args.io_queue, load->read);
 }
 
 // If the audio load is cancelled, or pending-cancel, then queue up a load again.
@@ -504,6 +572,7 @@ static ListedAudioData* FetchOrCreateAudioData(LibrariesAtomicList::Node& lib_no
         .library_ref_count = lib_node.reader_uses,
         .state = FileLoadingState::PendingLoad,
         .error = {},
+        .loaded = false,
     };
     lib_node.reader_uses.FetchAdd(1, RmwMemoryOrder::Relaxed);
 
@@ -547,18 +616,27 @@ static ListedInstrument* FetchOrCreateInstrument(LibrariesAtomicList::Node& lib_
 
     new_inst->inst.audio_datas =
         new_inst->arena.AllocateExactSizeUninitialised<AudioData const*>(inst.regions.size);
-    for (auto region_index : Range(inst.regions.size)) {
+    new_inst->inst.audio_data_loaded =
+        new_inst->arena.AllocateExactSizeUninitialised<Atomic<bool> const*>(inst.regions.size);
+
+    // The I/O queue is first-in-first-out, so the order we request the audio is the order it loads.
+    auto load_order = new_inst->arena.AllocateExactSizeUninitialised<u32>(inst.regions.size);
+    sample_lib::RegionLoadOrder(inst, load_order);
+
+    for (auto const region_index : load_order) {
         auto& region_info = inst.regions[region_index];
-        auto& audio_data = new_inst->inst.audio_datas[region_index];
 
         auto ref_audio_data =
             FetchOrCreateAudioData(lib_node, region_info.path, thread_pool_args, new_inst->debug_id);
-        audio_data = &ref_audio_data->audio_data;
+        new_inst->inst.audio_datas[region_index] = &ref_audio_data->audio_data;
+        new_inst->inst.audio_data_loaded[region_index] = &ref_audio_data->loaded;
 
         dyn::AppendIfNotAlreadyThere(audio_data_set, ref_audio_data);
 
-        if (inst.audio_file_path_for_waveform == region_info.path)
+        if (inst.audio_file_path_for_waveform == region_info.path) {
             new_inst->inst.file_for_gui_waveform = &ref_audio_data->audio_data;
+            new_inst->inst.file_for_gui_waveform_loaded = &ref_audio_data->loaded;
+        }
     }
 
     for (auto d : audio_data_set)
@@ -644,6 +722,8 @@ struct PendingResource {
         return 0;
     }
     bool IsDesired() const {
+        // A closed channel no longer wants anything.
+        if (!request.async_comms_channel.used.Load(LoadMemoryOrder::Acquire)) return false;
         return state.Get<ListedPointer>().Get<ListedInstrument*>() ==
                request.async_comms_channel.desired_inst[LayerIndex()];
     }
@@ -652,6 +732,7 @@ struct PendingResource {
     StateUnion state {State::AwaitingLibrary};
     QueuedRequest request;
     uintptr_t debug_id;
+    bool result_sent = false; // A multisampled instrument can be sent before all of its audio has loaded.
 
     PendingResource* next = nullptr;
 };
@@ -662,6 +743,44 @@ struct PendingResources {
     AtomicCountdown thread_pool_jobs {0};
 };
 
+static void
+SendLoadResult(Server& server, PendingResource const& pending_resource, LoadResult::Result const& result) {
+    server.channels.Use([&](auto&) {
+        if (!pending_resource.request.async_comms_channel.used.Load(LoadMemoryOrder::Acquire)) return;
+
+        // We always add results with a ref count of 1, we do that manually rather than call Retain()
+        // because here we accept that ref count might be 0 here: something that is disallowed in Retain().
+        if (auto const resource = result.TryGet<Resource>()) {
+            Atomic<u32>* ref_count = nullptr;
+            switch (resource->tag) {
+                case LoadRequestType::Instrument:
+                    ref_count = resource->Get<ResourcePointer<sample_lib::LoadedInstrument>>().ref_count;
+                    break;
+                case LoadRequestType::Ir:
+                    ref_count = resource->Get<ResourcePointer<sample_lib::LoadedIr>>().ref_count;
+                    break;
+            }
+            if (ref_count) ref_count->FetchAdd(1, RmwMemoryOrder::Relaxed);
+        }
+        pending_resource.request.async_comms_channel.results.Push(LoadResult {
+            .id = pending_resource.request.id,
+            .result = result,
+        });
+        pending_resource.request.async_comms_channel.result_added_callback();
+    });
+}
+
+// A multisampled instrument is playable once any of its note-on regions has loaded: the layer processor
+// stands in the nearest loaded region for the others until they arrive.
+static bool InstrumentIsPlayable(sample_lib::LoadedInstrument const& inst) {
+    if (inst.instrument.category != sample_lib::SamplerCategory::Multisample)
+        return inst.AllAudioDataLoaded();
+    for (auto const [i, region] : Enumerate(inst.instrument.regions))
+        if (region.trigger.trigger_event == sample_lib::TriggerEvent::NoteOn && inst.AudioDataLoaded(i))
+            return true;
+    return false;
+}
+
 static void DumpPendingResourcesDebugInfo(PendingResources& pending_resources) {
     ASSERT_EQ(CurrentThreadId(), pending_resources.server_thread_id);
     LogDebug(ModuleName::SampleLibraryServer,
@@ -753,14 +872,21 @@ static bool UpdatePendingResources(PendingResources& pending_resources,
 
     ThreadPoolArgs thread_pool_args {
         .pool = server.thread_pool,
+        .io_queue = server.io_queue,
         .num_thread_pool_jobs = pending_resources.thread_pool_jobs,
         .completed_signaller = server.work_signaller,
+        .decode_priority = JobPriority::Normal,
     };
 
     // Fill in library
     for (auto& pending_resource : pending_resources.list) {
         if (pending_resource.state != PendingResource::State::AwaitingLibrary) continue;
 
+        // Speculative loads shouldn't hold up the decoding of audio that's wanted now.
+        auto request_thread_pool_args = thread_pool_args;
+        if (pending_resource.request.async_comms_channel.low_priority)
+            request_thread_pool_args.decode_priority = JobPriority::Low;
+
         auto const library_id = ({
             sample_lib::LibraryId n {};
             switch (pending_resource.request.request.tag) {
@@ -823,7 +949,7 @@ static bool UpdatePendingResources(PendingResources& pending_resources,
                             .instrument_loading_percents[load_inst.layer_index]
                             .Store(0, StoreMemoryOrder::Relaxed);
 
-                        auto inst = FetchOrCreateInstrument(*lib, **i, thread_pool_args);
+                        auto inst = FetchOrCreateInstrument(*lib, **i, request_thread_pool_args);
                         ASSERT(inst);
 
                         pending_resource.request.async_comms_channel.desired_inst[load_inst.layer_index] =
@@ -857,7 +983,7 @@ static bool UpdatePendingResources(PendingResources& pending_resources,
                     if (ir) {
                         error_notifications.RemoveError(find_ir_error_id);
 
-                        auto listed_ir = FetchOrCreateImpulseResponse(*lib, **ir, thread_pool_args);
+                        auto listed_ir = FetchOrCreateImpulseResponse(*lib, **ir, request_thread_pool_args);
 
                         pending_resource.state = PendingResource::ListedPointer {listed_ir};
 
@@ -928,7 +1054,9 @@ static bool UpdatePendingResources(PendingResources& pending_resources,
                                 .ValueOr("Unknown"));
             }
 
-            CancelLoadingAudioForInstrumentIfPossible(&listed_inst, pending_resource.debug_id);
+            // If the instrument has already been sent it may be playing, so let the rest of its audio load.
+            if (!pending_resource.result_sent)
+                CancelLoadingAudioForInstrumentIfPossible(&listed_inst, pending_resource.debug_id);
             if (pending_resource.IsDesired())
                 pending_resource.LoadingPercent().Store(-1, StoreMemoryOrder::Relaxed);
             pending_resource.state = *error;
@@ -959,12 +1087,33 @@ static bool UpdatePendingResources(PendingResources& pending_resources,
                 f32 const percent = 100.0f * ((f32)num_completed / (f32)i->audio_data_set.size);
                 pending_resource.LoadingPercent().Store(RoundPositiveFloat(percent),
                                                         StoreMemoryOrder::Relaxed);
+
+                // Send it as soon as it's playable rather than leaving the layer silent until every region
+                // has loaded. We carry on tracking it for the loading percentage and errors.
+                if (!pending_resource.result_sent && InstrumentIsPlayable(i->inst)) {
+                    SendLoadResult(
+                        server,
+                        pending_resource,
+                        Resource {ResourcePointer<sample_lib::LoadedInstrument> {i->inst, i->ref_count}});
+                    pending_resource.result_sent = true;
+                    TracyMessageEx({k_trace_category, k_trace_colour, pending_resource.debug_id},
+                                   "instID:{} sent before fully loaded, {}/{}",
+                                   i->debug_id,
+                                   num_completed,
+                                   i->audio_data_set.size);
+                }
             }
+        } else if (pending_resource.result_sent) {
+            // It's been sent so it may be playing; let the rest of its audio load.
+            pending_resource.state = PendingResource::State::Cancelled;
         } else {
             // If it's not desired by any others it can be cancelled
             bool const is_desired_by_another = ({
                 bool desired = false;
                 for (auto& other_pending_resource : pending_resources.list) {
+                    if (!other_pending_resource.request.async_comms_channel.used.Load(
+                            LoadMemoryOrder::Acquire))
+                        continue;
                     for (auto other_desired :
                          other_pending_resource.request.async_comms_channel.desired_inst) {
                         if (other_desired == i) {
@@ -1049,51 +1198,20 @@ static bool UpdatePendingResources(PendingResources& pending_resources,
                 case PendingResource::State::CompletedSuccessfully: break;
             }
 
-            LoadResult result {
-                .id = pending_resource.request.id,
-                .result = ({
-                    LoadResult::Result r {LoadResult::ResultType::Cancelled};
-                    switch (pending_resource.state.tag) {
-                        case PendingResource::State::AwaitingLibrary:
-                        case PendingResource::State::AwaitingAudio: PanicIfReached(); break;
-                        case PendingResource::State::Cancelled: break;
-                        case PendingResource::State::Failed:
-                            r = pending_resource.state.Get<ErrorCode>();
-                            break;
-                        case PendingResource::State::CompletedSuccessfully:
-                            r = pending_resource.state.Get<Resource>();
-                            break;
-                    }
-                    r;
-                }),
-            };
+            // An instrument that was sent before all of its audio loaded has already had its result.
+            if (pending_resource.result_sent) return true;
 
-            server.channels.Use([&](auto&) {
-                if (pending_resource.request.async_comms_channel.used.Load(LoadMemoryOrder::Acquire)) {
-                    // We always add results with a ref count of 1, we do that manually rather than call
-                    // Retain() because here we accept that ref count might be 0 here: something that is
-                    // disallowed in Retain().
-                    if (auto ref_count = ({
-                            Atomic<u32>* rc = nullptr;
-                            if (auto resource = pending_resource.state.TryGet<Resource>()) {
-                                switch (resource->tag) {
-                                    case LoadRequestType::Instrument:
-                                        rc = resource->Get<ResourcePointer<sample_lib::LoadedInstrument>>()
-                                                 .ref_count;
-                                        break;
-                                    case LoadRequestType::Ir:
-                                        rc = resource->Get<ResourcePointer<sample_lib::LoadedIr>>().ref_count;
-                                        break;
-                                }
-                            }
-                            rc;
-                        })) {
-                        ref_count->FetchAdd(1, RmwMemoryOrder::Relaxed);
-                    }
-                    pending_resource.request.async_comms_channel.results.Push(result);
-                    pending_resource.request.async_comms_channel.result_added_callback();
-                }
-            });
+            LoadResult::Result result {LoadResult::ResultType::Cancelled};
+            switch (pending_resource.state.tag) {
+                case PendingResource::State::AwaitingLibrary:
+                case PendingResource::State::AwaitingAudio: PanicIfReached(); break;
+                case PendingResource::State::Cancelled: break;
+                case PendingResource::State::Failed: result = pending_resource.state.Get<ErrorCode>(); break;
+                case PendingResource::State::CompletedSuccessfully:
+                    result = pending_resource.state.Get<Resource>();
+                    break;
+            }
+            SendLoadResult(server, pending_resource, result);
             return true;
         },
         [](PendingResource*) {
@@ -1124,6 +1242,11 @@ static void ServerThreadUpdateMetrics(Server& server) {
     server.num_insts_loaded.Store(num_insts_loaded, StoreMemoryOrder::Relaxed);
     server.num_samples_loaded.Store(num_samples_loaded, StoreMemoryOrder::Relaxed);
     server.total_bytes_used_by_samples.Store(total_bytes_used, StoreMemoryOrder::Relaxed);
+
+    auto const pool_stats = AudioDataAllocator::Instance().Stats();
+    server.sample_memory_reserved_bytes.Store(pool_stats.bytes_reserved, StoreMemoryOrder::Relaxed);
+    server.sample_memory_locked_bytes.Store(pool_stats.bytes_locked, StoreMemoryOrder::Relaxed);
+    server.sample_memory_fragmentation.Store(pool_stats.Fragmentation(), StoreMemoryOrder::Relaxed);
 }
 
 static void RemoveUnreferencedObjects(Server& server) {
@@ -1255,7 +1378,8 @@ static sample_lib::Library* BuiltinLibrary() {
         .path = ":memory:",
         .file_hash = 100,
         .create_file_reader = [](sample_lib::Library const&,
-                                 sample_lib::LibraryPath path) -> ErrorCodeOr<Reader> {
+                                 sample_lib::LibraryPath path,
+                                 FileReaderOptions) -> ErrorCodeOr<Reader> {
             if (path == k_icon_path) {
                 auto data = EmbeddedIconImage();
                 return Reader::FromMemory({data.data, data.size});
@@ -1365,6 +1489,7 @@ Server::Server(ThreadPool& pool,
         libraries_by_id.Insert(BuiltinLibrary()->id, node);
     }
 
+    InitSampleIoQueue(io_queue);
     thread.Start([this]() { ServerThreadProc(*this); }, "samp-lib-server");
 }
 
@@ -1372,6 +1497,7 @@ Server::~Server() {
     end_thread.Store(true, StoreMemoryOrder::Release);
     work_signaller.Signal();
     thread.Join();
+    DeinitSampleIoQueue(io_queue);
     ASSERT(channels.Use([](auto& c) { return c.Empty(); }), "missing channel close");
 }
 
@@ -1384,6 +1510,7 @@ AsyncCommsChannel& OpenAsyncCommsChannel(Server& server, OpenAsyncCommsChannelAr
             .result_added_callback = Move(args.result_added_callback),
             .library_changed_callback = Move(args.library_changed_callback),
             .used = true,
+            .low_priority = args.low_priority,
         };
         for (auto& p : channel->instrument_loading_percents)
             p.raw = -1;
@@ -1437,6 +1564,12 @@ void SetExtraScanFolders(Server& server, Span<String const> extra_folders) {
     SetFolders(server.scan_folders, extra_folders);
 }
 
+void SetSampleMemoryLockBudget(Server& server, u64 bytes) {
+    AudioDataAllocator::Instance().SetLockBudget(bytes);
+    server.sample_memory_locked_bytes.Store(AudioDataAllocator::Instance().Stats().bytes_locked,
+                                            StoreMemoryOrder::Relaxed);
+}
+
 detail::LibrariesAtomicList& LibrariesList(Server& server) { return server.libraries; }
 
 bool LibraryLessThan(sample_lib::LibraryId const&,
@@ -1547,6 +1680,16 @@ static Type& ExtractSuccess(tests::Tester& tester, LoadResult const& result, Loa
     return *opt_r;
 }
 
+// Multisampled instruments are sent as soon as they're playable, the rest of their audio follows.
+static void WaitUntilAllAudioLoaded(sample_lib::LoadedInstrument const& inst) {
+    for (auto const attempt : Range(1000)) {
+        (void)attempt;
+        if (inst.AllAudioDataLoaded()) return;
+        SleepThisThread(10);
+    }
+    Panic("timed out waiting for instrument audio");
+}
+
 TEST_CASE(TestSampleLibraryServer) {
     struct Fixture {
         [[maybe_unused]] Fixture(tests::Tester&) { thread_pool.Init("pool", 8u); }
@@ -1700,6 +1843,7 @@ TEST_CASE(TestSampleLibraryServer) {
                                         request);
                                     CHECK_EQ(i->instrument.name, "Groups And Refs"_s);
                                     CHECK_EQ(i->audio_datas.size, 4u);
+                                    WaitUntilAllAudioLoaded(*i);
                                     for (auto& d : i->audio_datas)
                                         CHECK_NEQ(d->interleaved_samples.size, 0u);
                                 },
@@ -1723,6 +1867,7 @@ TEST_CASE(TestSampleLibraryServer) {
                                         request);
                                     CHECK_EQ(i->instrument.name, "Groups And Refs (copy)"_s);
                                     CHECK_EQ(i->audio_datas.size, 4u);
+                                    WaitUntilAllAudioLoaded(*i);
                                     for (auto& d : i->audio_datas)
                                         CHECK_NEQ(d->interleaved_samples.size, 0u);
                                 },
@@ -1746,6 +1891,7 @@ TEST_CASE(TestSampleLibraryServer) {
                                         request);
                                     CHECK_EQ(i->instrument.name, "Single Sample"_s);
                                     CHECK_EQ(i->audio_datas.size, 1u);
+                                    WaitUntilAllAudioLoaded(*i);
                                     for (auto& d : i->audio_datas)
                                         CHECK_NEQ(d->interleaved_samples.size, 0u);
                                 },
@@ -1772,6 +1918,7 @@ TEST_CASE(TestSampleLibraryServer) {
                                         request);
                                     CHECK_EQ(i->instrument.name, "Same Sample Twice"_s);
                                     CHECK_EQ(i->audio_datas.size, 2u);
+                                    WaitUntilAllAudioLoaded(*i);
                                     for (auto& d : i->audio_datas)
                                         CHECK_NEQ(d->interleaved_samples.size, 0u);
                                 },
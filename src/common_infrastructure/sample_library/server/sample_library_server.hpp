@@ -14,6 +14,7 @@
 #include "common_infrastructure/sample_library/sample_library.hpp"
 #include "common_infrastructure/state/instrument.hpp"
 
+#include "sample_io.hpp"
 #include "scan_folders.hpp"
 
 // Sample library server
@@ -167,6 +168,7 @@ struct AsyncCommsChannel {
     ResultAddedCallback result_added_callback;
     LibraryChangedCallback library_changed_callback;
     Atomic<bool> used {};
+    bool low_priority {};
     AsyncCommsChannel* next {};
 };
 
@@ -194,6 +196,7 @@ struct ListedAudioData {
     Atomic<u32>& library_ref_count;
     Atomic<FileLoadingState> state {FileLoadingState::PendingLoad};
     Optional<ErrorCode> error {};
+    Atomic<bool> loaded {}; // Set once audio_data is valid; it stays valid.
 };
 
 struct ListedInstrument {
@@ -249,6 +252,9 @@ struct Server {
     // public
     Atomic<bool> disable_file_watching {false}; // set to true/false as needed
     Atomic<u64> total_bytes_used_by_samples {}; // filled by the server thread
+    Atomic<u64> sample_memory_reserved_bytes {}; // filled by the server thread, includes unused pool memory
+    Atomic<u64> sample_memory_locked_bytes {}; // filled by the server thread
+    Atomic<f32> sample_memory_fragmentation {}; // filled by the server thread, 0 to 1
     Atomic<u32> num_insts_loaded {};
     Atomic<u32> num_samples_loaded {};
 
@@ -261,6 +267,7 @@ struct Server {
     // error_notifications instead of this.
     ThreadsafeErrorNotifications& error_notifications;
     ThreadPool& thread_pool;
+    SampleIoQueue io_queue {}; // Sample files are read through this and decoded on thread_pool.
     Atomic<RequestId> request_id_counter {};
     ArenaAllocator channels_arena {Malloc::Instance()};
     MutexProtected<ArenaList<AsyncCommsChannel>> channels {};
@@ -332,11 +339,12 @@ struct OpenAsyncCommsChannelArgs {
     ThreadsafeErrorNotifications& error_notifications;
     AsyncCommsChannel::ResultAddedCallback result_added_callback;
     AsyncCommsChannel::LibraryChangedCallback library_changed_callback;
+    bool low_priority = false; // Decode this channel's audio after everyone else's: for prefetching.
 };
 AsyncCommsChannel& OpenAsyncCommsChannel(Server& server, OpenAsyncCommsChannelArgs const& args);
 
 // You will not receive any more results after this is called. Results that are still in the channel's queue
-// will be released at some point after this is called.
+// will be released at some point after this is called. Loads that only this channel wanted are cancelled.
 // [threadsafe]
 void CloseAsyncCommsChannel(Server& server, AsyncCommsChannel& channel);
 
@@ -356,6 +364,11 @@ RequestId SendAsyncLoadRequest(Server& server, AsyncCommsChannel& channel, LoadR
 // [threadsafe]
 void SetExtraScanFolders(Server& server, Span<String const> folders);
 
+// Lock up to this many bytes of sample memory into RAM so that the audio thread never page-faults when reading
+// samples. 0 disables it. The OS may lock less than this; see sample_memory_locked_bytes.
+// [threadsafe]
+void SetSampleMemoryLockBudget(Server& server, u64 bytes);
+
 // The server takes a lazy-loading approach. It only scans a folder when it's requested. Call this function to
 // trigger a scan of any unscanned folders.
 // [threadsafe]
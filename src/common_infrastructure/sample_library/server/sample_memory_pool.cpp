@@ -0,0 +1,328 @@
+// Copyright 2025-2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "sample_memory_pool.hpp"
+
+#include "tests/framework.hpp"
+
+using GranuleBits = Bitset<SampleMemoryPool::k_granules_per_slab>;
+
+static u32 LargestFreeRun(GranuleBits const& used) {
+    u32 largest = 0;
+    u32 run = 0;
+    for (auto const i : Range((u32)SampleMemoryPool::k_granules_per_slab)) {
+        if (used.Get(i))
+            run = 0;
+        else
+            largest = Max(largest, ++run);
+    }
+    return largest;
+}
+
+// The caller must know that such a run exists.
+static u32 FirstFreeRun(GranuleBits const& used, u32 num_granules) {
+    u32 run = 0;
+    for (auto const i : Range((u32)SampleMemoryPool::k_granules_per_slab)) {
+        if (used.Get(i))
+            run = 0;
+        else if (++run == num_granules)
+            return i + 1 - num_granules;
+    }
+    PanicIfReached();
+}
+
+SampleMemoryPool::~SampleMemoryPool() {
+    while (slabs) {
+        auto const slab = slabs;
+        slabs = slab->next;
+        if (slab->locked) UnlockPages(slab->data, k_slab_size);
+        FreePages(slab->data, k_slab_size);
+        Malloc::Instance().Free({(u8*)slab, sizeof(*slab)});
+    }
+    while (large_allocations) {
+        auto const large = large_allocations;
+        large_allocations = large->next;
+        if (large->locked) UnlockPages(large->data, large->size);
+        FreePages(large->data, large->size);
+        Malloc::Instance().Free({(u8*)large, sizeof(*large)});
+    }
+}
+
+bool SampleMemoryPool::TryLock(u8* data, usize size) {
+    if (stats.bytes_locked + size > lock_budget) return false;
+    if (!LockPages(data, size)) return false;
+    stats.bytes_locked += size;
+    return true;
+}
+
+void SampleMemoryPool::Unlock(u8* data, usize size) {
+    UnlockPages(data, size);
+    stats.bytes_locked -= size;
+}
+
+void SampleMemoryPool::ApplyLockBudget() {
+    auto const for_each_region = [&](auto&& function) {
+        for (auto s = slabs; s; s = s->next)
+            function(s->data, k_slab_size, s->locked);
+        for (auto l = large_allocations; l; l = l->next)
+            function(l->data, l->size, l->locked);
+    };
+
+    // Keep the oldest locks that still fit in the budget.
+    u64 kept = 0;
+    for_each_region([&](u8* data, usize size, bool& locked) {
+        if (!locked) return;
+        if (kept + size <= lock_budget)
+            kept += size;
+        else {
+            Unlock(data, size);
+            locked = false;
+        }
+    });
+
+    for_each_region([&](u8* data, usize size, bool& locked) {
+        if (!locked) locked = TryLock(data, size);
+    });
+}
+
+Span<u8> SampleMemoryPool::AllocateFromSlab(usize num_granules) {
+    ASSERT(num_granules && num_granules <= k_granules_per_slab);
+
+    auto link = &slabs;
+    for (; *link; link = &(*link)->next)
+        if ((*link)->largest_free_run >= num_granules) break;
+
+    if (!*link) {
+        auto const data = (u8*)AllocateHugePages(k_slab_size);
+        if (!data) return {};
+        auto const slab = Malloc::Instance().New<Slab>();
+        slab->data = data;
+        slab->largest_free_run = k_granules_per_slab;
+        slab->locked = TryLock(data, k_slab_size);
+        *link = slab;
+        stats.bytes_reserved += k_slab_size;
+        ++stats.num_slabs;
+    }
+
+    auto& slab = **link;
+    auto const first = FirstFreeRun(slab.used_granules, (u32)num_granules);
+    for (auto const i : Range(first, first + (u32)num_granules))
+        slab.used_granules.Set(i);
+    slab.num_used_granules += (u32)num_granules;
+    slab.largest_free_run = LargestFreeRun(slab.used_granules);
+    stats.bytes_used += num_granules * k_granule_size;
+
+    return {slab.data + (first * k_granule_size), num_granules * k_granule_size};
+}
+
+Span<u8> SampleMemoryPool::AllocateLarge(usize size) {
+    auto const mapping_size = AlignForward(size, k_huge_page_size);
+    auto const data = (u8*)AllocateHugePages(mapping_size);
+    if (!data) return {};
+
+    auto link = &large_allocations;
+    while (*link)
+        link = &(*link)->next;
+    auto const large = Malloc::Instance().New<LargeAllocation>();
+    large->data = data;
+    large->size = mapping_size;
+    large->locked = TryLock(data, mapping_size);
+    *link = large;
+
+    stats.bytes_reserved += mapping_size;
+    stats.bytes_in_large_allocations += mapping_size;
+    ++stats.num_large_allocations;
+
+    return {data, mapping_size};
+}
+
+void SampleMemoryPool::FreeAllocation(Span<u8> allocation) {
+    for (auto link = &slabs; *link; link = &(*link)->next) {
+        auto& slab = **link;
+        if (allocation.data < slab.data || allocation.data >= slab.data + k_slab_size) continue;
+
+        auto const first = (u32)((usize)(allocation.data - slab.data) / k_granule_size);
+        auto const num_granules = (u32)(AlignForward(allocation.size, k_granule_size) / k_granule_size);
+        for (auto const i : Range(first, first + num_granules)) {
+            ASSERT(slab.used_granules.Get(i));
+            slab.used_granules.Clear(i);
+        }
+        slab.num_used_granules -= num_granules;
+        slab.largest_free_run = LargestFreeRun(slab.used_granules);
+        stats.bytes_used -= num_granules * k_granule_size;
+
+        if (slab.num_used_granules != 0) return;
+
+        // We keep one empty slab around so that repeatedly loading and unloading an instrument doesn't
+        // repeatedly map and unmap memory.
+        bool another_slab_is_empty = false;
+        for (auto s = slabs; s; s = s->next) {
+            if (s != &slab && s->num_used_granules == 0) {
+                another_slab_is_empty = true;
+                break;
+            }
+        }
+        if (!another_slab_is_empty) return;
+
+        *link = slab.next;
+        if (slab.locked) Unlock(slab.data, k_slab_size);
+        FreePages(slab.data, k_slab_size);
+        Malloc::Instance().Free({(u8*)&slab, sizeof(slab)});
+        stats.bytes_reserved -= k_slab_size;
+        --stats.num_slabs;
+        ApplyLockBudget();
+        return;
+    }
+
+    for (auto link = &large_allocations; *link; link = &(*link)->next) {
+        auto const large = *link;
+        if (large->data != allocation.data) continue;
+
+        *link = large->next;
+        if (large->locked) Unlock(large->data, large->size);
+        FreePages(large->data, large->size);
+        stats.bytes_reserved -= large->size;
+        stats.bytes_in_large_allocations -= large->size;
+        --stats.num_large_allocations;
+        Malloc::Instance().Free({(u8*)large, sizeof(*large)});
+        ApplyLockBudget();
+        return;
+    }
+
+    PanicIfReached();
+}
+
+Span<u8> SampleMemoryPool::DoCommand(AllocatorCommandUnion const& command_union) {
+    CheckAllocatorCommandIsValid(command_union);
+
+    switch (command_union.tag) {
+        case AllocatorCommand::Allocate: {
+            auto const& cmd = command_union.Get<AllocateCommand>();
+            ASSERT(cmd.alignment <= k_granule_size);
+
+            Span<u8> result;
+            {
+                mutex.Lock();
+                DEFER { mutex.Unlock(); };
+                if (cmd.size > k_max_slab_allocation_size)
+                    result = AllocateLarge(cmd.size);
+                else
+                    result = AllocateFromSlab(AlignForward(cmd.size, k_granule_size) / k_granule_size);
+            }
+            if (!result.data) Panic("out of memory");
+
+            return {result.data, cmd.allow_oversized_result ? result.size : cmd.size};
+        }
+
+        case AllocatorCommand::Free: {
+            auto const& cmd = command_union.Get<FreeCommand>();
+            if (cmd.allocation.size == 0) return {};
+
+            mutex.Lock();
+            DEFER { mutex.Unlock(); };
+            FreeAllocation(cmd.allocation);
+            return {};
+        }
+
+        case AllocatorCommand::Resize: {
+            auto const& cmd = command_union.Get<ResizeCommand>();
+            return ResizeUsingNewAllocation(cmd, k_granule_size);
+        }
+    }
+
+    return {};
+}
+
+void SampleMemoryPool::SetLockBudget(u64 bytes) {
+    mutex.Lock();
+    DEFER { mutex.Unlock(); };
+    lock_budget = bytes;
+    ApplyLockBudget();
+}
+
+SampleMemoryPoolStats SampleMemoryPool::Stats() {
+    mutex.Lock();
+    DEFER { mutex.Unlock(); };
+    auto result = stats;
+    result.largest_free_block = 0;
+    for (auto s = slabs; s; s = s->next)
+        result.largest_free_block = Max<u64>(result.largest_free_block, s->largest_free_run * k_granule_size);
+    return result;
+}
+
+TEST_CASE(TestSampleMemoryPool) {
+    SampleMemoryPool pool;
+    constexpr auto k_granule = SampleMemoryPool::k_granule_size;
+
+    SUBCASE("allocations are usable and are returned to the pool") {
+        auto samples = pool.AllocateExactSizeUninitialised<f32>(1000);
+        REQUIRE_EQ(samples.size, 1000u);
+        CHECK_EQ((uintptr)samples.data % k_granule, 0u);
+        for (auto [i, s] : Enumerate(samples))
+            s = (f32)i;
+        CHECK_EQ(samples[999], 999.0f);
+
+        auto large = pool.AllocateExactSizeUninitialised<u8>(SampleMemoryPool::k_max_slab_allocation_size + 1);
+        FillMemory(large, 1);
+
+        auto stats = pool.Stats();
+        CHECK_EQ(stats.num_slabs, 1u);
+        CHECK_EQ(stats.num_large_allocations, 1u);
+        CHECK_EQ(stats.bytes_used, (u64)k_granule);
+        CHECK(stats.bytes_in_large_allocations >= large.size);
+
+        pool.Free(samples.ToByteSpan());
+        pool.Free(large);
+
+        stats = pool.Stats();
+        CHECK_EQ(stats.bytes_used, 0u);
+        CHECK_EQ(stats.num_large_allocations, 0u);
+        CHECK_EQ(stats.bytes_in_large_allocations, 0u);
+        CHECK_EQ(stats.num_slabs, 1u); // A spare is kept.
+        CHECK_EQ(stats.Fragmentation(), 0.0f);
+    }
+
+    SUBCASE("freed holes are reused first-fit") {
+        DynamicArray<Span<u8>> allocations {tester.scratch_arena};
+        for (auto _ : Range(8))
+            dyn::Append(allocations, pool.Allocate({.size = k_granule, .alignment = 16}));
+        for (usize i = 0; i < allocations.size; i += 2)
+            pool.Free(allocations[i]);
+
+        auto const stats = pool.Stats();
+        CHECK_EQ(stats.bytes_used, 4 * (u64)k_granule);
+        CHECK_EQ(stats.largest_free_block, (SampleMemoryPool::k_granules_per_slab - 8) * (u64)k_granule);
+        CHECK(stats.Fragmentation() > 0.0f);
+
+        auto const reused = pool.Allocate({.size = 100, .alignment = 16});
+        CHECK(reused.data == allocations[0].data);
+        pool.Free(reused);
+
+        auto const too_big_for_holes = pool.Allocate({.size = k_granule + 1, .alignment = 16});
+        CHECK(too_big_for_holes.data >= allocations[7].data + k_granule);
+        pool.Free(too_big_for_holes);
+
+        for (usize i = 1; i < allocations.size; i += 2)
+            pool.Free(allocations[i]);
+        CHECK_EQ(pool.Stats().bytes_used, 0u);
+    }
+
+    SUBCASE("lock budget") {
+        pool.SetLockBudget(SampleMemoryPool::k_slab_size);
+        auto const a = pool.Allocate({.size = k_granule, .alignment = 16});
+
+        // The OS may refuse to lock (RLIMIT_MEMLOCK), but we must never go over the budget.
+        auto stats = pool.Stats();
+        CHECK(stats.bytes_locked <= SampleMemoryPool::k_slab_size);
+
+        pool.SetLockBudget(0);
+        stats = pool.Stats();
+        CHECK_EQ(stats.bytes_locked, 0u);
+
+        pool.Free(a);
+    }
+
+    return k_success;
+}
+
+TEST_REGISTRATION(RegisterSampleMemoryPoolTests) { REGISTER_TEST(TestSampleMemoryPool); }
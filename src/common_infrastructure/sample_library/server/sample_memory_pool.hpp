@@ -0,0 +1,86 @@
+// Copyright 2025-2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "foundation/foundation.hpp"
+#include "os/misc.hpp"
+#include "os/threading.hpp"
+
+struct SampleMemoryPoolStats {
+    f32 Fragmentation() const {
+        auto const free = bytes_reserved - bytes_used - bytes_in_large_allocations;
+        if (!free) return 0;
+        return 1.0f - ((f32)largest_free_block / (f32)free);
+    }
+
+    u64 bytes_reserved {}; // Everything obtained from the OS.
+    u64 bytes_used {}; // Handed out from slabs, rounded up to the granule size.
+    u64 bytes_in_large_allocations {};
+    u64 bytes_locked {};
+    u64 largest_free_block {}; // Largest allocation that fits without reserving more memory.
+    u32 num_slabs {};
+    u32 num_large_allocations {};
+};
+
+// Allocator for decoded audio data. Memory comes from huge-page-backed slabs so that playback of many
+// different samples doesn't thrash the TLB. Optionally, memory is locked (mlock) up to a budget so that the
+// audio thread never page-faults when it reads a sample that hasn't been touched for a while.
+//
+// Allocations are rounded up to k_granule_size and placed first-fit in a slab. Allocations too big to share a
+// slab get their own huge-page mapping. Thread-safe: samples are decoded on many threads at once.
+class SampleMemoryPool final : public Allocator {
+  public:
+    static constexpr usize k_granule_size = 16 * 1024;
+    static constexpr usize k_slab_size = 16 * k_huge_page_size;
+    static constexpr usize k_granules_per_slab = k_slab_size / k_granule_size;
+    static constexpr usize k_max_slab_allocation_size = k_slab_size / 2;
+
+    SampleMemoryPool() = default;
+    ~SampleMemoryPool();
+    NON_COPYABLE_AND_MOVEABLE(SampleMemoryPool);
+
+    Span<u8> DoCommand(AllocatorCommandUnion const& command_union) override;
+
+    // 0 disables locking. Slabs and large allocations are locked in the order they were created until the
+    // budget is used up. The OS may refuse to lock even within the budget; bytes_locked shows what actually
+    // happened.
+    void SetLockBudget(u64 bytes);
+
+    SampleMemoryPoolStats Stats();
+
+    static SampleMemoryPool& Instance() {
+        static SampleMemoryPool a;
+        return a;
+    }
+
+  private:
+    struct Slab {
+        u8* data {};
+        Bitset<k_granules_per_slab> used_granules {};
+        u32 num_used_granules {};
+        u32 largest_free_run {}; // In granules.
+        bool locked {};
+        Slab* next {};
+    };
+
+    struct LargeAllocation {
+        u8* data {};
+        usize size {};
+        bool locked {};
+        LargeAllocation* next {};
+    };
+
+    bool TryLock(u8* data, usize size);
+    void Unlock(u8* data, usize size);
+    void ApplyLockBudget();
+    Span<u8> AllocateFromSlab(usize num_granules);
+    Span<u8> AllocateLarge(usize size);
+    void FreeAllocation(Span<u8> allocation);
+
+    Mutex mutex {};
+    Slab* slabs {}; // Oldest first.
+    LargeAllocation* large_allocations {}; // Oldest first.
+    u64 lock_budget {};
+    SampleMemoryPoolStats stats {};
+};
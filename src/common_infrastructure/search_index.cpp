@@ -0,0 +1,285 @@
+// Copyright 2025-2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "search_index.hpp"
+
+#include "os/threading.hpp"
+#include "tests/framework.hpp"
+
+static Atomic<u64> g_next_search_index_id {1};
+
+static constexpr u32 Trigram(char const* c) {
+    return (u32)(u8)c[0] | ((u32)(u8)c[1] << 8) | ((u32)(u8)c[2] << 16);
+}
+
+static constexpr usize NumBitsetWords(u32 num_bits) { return (num_bits + 63) / 64; }
+static constexpr bool BitIsSet(Span<u64 const> bits, u32 i) { return bits[i / 64] & (1ull << (i % 64)); }
+static constexpr void SetBit(Span<u64> bits, u32 i) { bits[i / 64] |= 1ull << (i % 64); }
+
+SearchIndex BuildSearchIndex(u32 num_items,
+                             FunctionRef<String(u32 item_index)> item_text,
+                             Allocator& allocator,
+                             ArenaAllocator& scratch_arena) {
+    SearchIndex result {};
+    if (!num_items) return result;
+
+    result.id = g_next_search_index_id.FetchAdd(1, RmwMemoryOrder::Relaxed);
+
+    result.item_text_offsets = allocator.AllocateExactSizeUninitialised<u32>(num_items + 1);
+    usize total_size = 0;
+    for (auto const i : Range(num_items)) {
+        result.item_text_offsets[i] = CheckedCast<u32>(total_size);
+        total_size += item_text(i).size;
+    }
+    result.item_text_offsets[num_items] = CheckedCast<u32>(total_size);
+
+    auto text = allocator.AllocateExactSizeUninitialised<char>(total_size);
+    for (auto const i : Range(num_items)) {
+        auto const src = item_text(i);
+        for (auto const j : Range(src.size))
+            text[result.item_text_offsets[i] + j] = ToLowercaseAscii(src[j]);
+    }
+    result.text = text;
+
+    // Pass 1: count how many distinct items contain each trigram.
+    struct TrigramInfo {
+        u32 num_items;
+        u32 last_item_plus_one; // Dedupes trigrams that appear multiple times in one item.
+        u32 write_pos;
+    };
+    auto counts = HashTable<u32, TrigramInfo>::Create(scratch_arena, 1024);
+    DEFER { counts.Free(scratch_arena); };
+    usize total_postings = 0;
+    for (auto const i : Range(num_items)) {
+        auto const item = result.ItemText(i);
+        if (item.size < 3) continue;
+        for (auto const pos : Range(item.size - 2)) {
+            auto& info =
+                counts.FindOrInsertGrowIfNeeded(scratch_arena, Trigram(item.data + pos), {}).element.data;
+            if (info.last_item_plus_one == i + 1) continue;
+            info.last_item_plus_one = i + 1;
+            ++info.num_items;
+            ++total_postings;
+        }
+    }
+
+    // Pass 2: carve up one postings array and fill it. Items are visited in order so each list is sorted.
+    auto postings = allocator.AllocateExactSizeUninitialised<u32>(total_postings);
+    result.trigram_postings = HashTable<u32, Span<u32 const>>::Create(allocator, counts.size);
+    {
+        u32 offset = 0;
+        for (auto [trigram, info, hash] : counts) {
+            info.write_pos = offset;
+            info.last_item_plus_one = 0;
+            result.trigram_postings.InsertWithoutGrowing(trigram,
+                                                         postings.SubSpan(offset, info.num_items),
+                                                         hash);
+            offset += info.num_items;
+        }
+        ASSERT(offset == total_postings);
+    }
+    for (auto const i : Range(num_items)) {
+        auto const item = result.ItemText(i);
+        if (item.size < 3) continue;
+        for (auto const pos : Range(item.size - 2)) {
+            auto& info = *counts.Find(Trigram(item.data + pos));
+            if (info.last_item_plus_one == i + 1) continue;
+            info.last_item_plus_one = i + 1;
+            postings[info.write_pos++] = i;
+        }
+    }
+
+    return result;
+}
+
+void SearchIndexQuery(SearchIndex const& index,
+                      String lowercase_query,
+                      Span<u64> matches,
+                      Span<u64 const> candidates) {
+    auto const num_items = index.NumItems();
+    ASSERT(matches.size >= NumBitsetWords(num_items));
+    if (candidates.size) ASSERT(candidates.size >= NumBitsetWords(num_items));
+
+    auto const check = [&](u32 item_index) {
+        if (candidates.size && !BitIsSet(candidates, item_index)) return;
+        if (lowercase_query.size == 0 || ContainsSpan(index.ItemText(item_index), lowercase_query))
+            SetBit(matches, item_index);
+    };
+
+    if (lowercase_query.size < 3) {
+        for (auto const i : Range(num_items))
+            check(i);
+        return;
+    }
+
+    // Every matching item must contain every trigram of the query, so we only need to verify the items of
+    // the rarest one.
+    Span<u32 const> rarest {};
+    bool found_any = false;
+    for (auto const pos : Range(lowercase_query.size - 2)) {
+        auto const postings = index.trigram_postings.Find(Trigram(lowercase_query.data + pos));
+        if (!postings) return; // No item contains this trigram.
+        if (!found_any || postings->size < rarest.size) {
+            rarest = *postings;
+            found_any = true;
+        }
+    }
+
+    for (auto const item_index : rarest)
+        check(item_index);
+}
+
+void SearchResultsCache::BeginQuery(String query) {
+    auto& prev_gen = generations[current];
+    auto& older_gen = generations[current ^ 1];
+
+    if (older_gen.query.size && IsEqualToCaseInsensitiveAscii(query, older_gen.query)) {
+        // Going back to the previous query (e.g. backspace): its results are still valid.
+        current ^= 1;
+        narrowing = false;
+    } else {
+        narrowing = prev_gen.query.size && ContainsCaseInsensitiveAscii(query, prev_gen.query);
+        if (narrowing)
+            current ^= 1;
+        else {
+            prev_gen.results = {};
+            prev_gen.arena.ResetCursorAndConsolidateRegions();
+            dyn::Clear(prev_gen.query);
+        }
+
+        auto& gen = generations[current];
+        gen.results = {};
+        gen.arena.ResetCursorAndConsolidateRegions();
+        dyn::Clear(gen.query);
+        for (auto const c : query)
+            dyn::Append(gen.query, ToLowercaseAscii(c));
+    }
+
+    last_index_id = 0;
+    last_results = {};
+}
+
+Span<u64 const> SearchResultsCache::ResultsFor(SearchIndex const& index) {
+    if (index.id == last_index_id) return last_results;
+
+    auto& gen = generations[current];
+    if (auto const r = gen.results.Find(index.id)) {
+        last_index_id = index.id;
+        last_results = *r;
+        return last_results;
+    }
+
+    Span<u64 const> candidates {};
+    if (narrowing)
+        if (auto const r = generations[current ^ 1].results.Find(index.id)) candidates = *r;
+
+    auto bits = gen.arena.NewMultiple<u64>(NumBitsetWords(index.NumItems()));
+    SearchIndexQuery(index, gen.query, bits, candidates);
+    gen.results.InsertGrowIfNeeded(gen.arena, index.id, bits);
+
+    last_index_id = index.id;
+    last_results = bits;
+    return last_results;
+}
+
+bool SearchResultsCache::Matches(SearchIndex const& index, String query, u32 item_index) {
+    ASSERT(item_index < index.NumItems());
+
+    // We can't cache queries that don't fit; the index text is lowercase so we can still use it.
+    if (query.size > k_max_query_size) return ContainsCaseInsensitiveAscii(index.ItemText(item_index), query);
+
+    auto const& gen = generations[current];
+    if (!IsEqualToCaseInsensitiveAscii(query, gen.query)) BeginQuery(query);
+
+    return BitIsSet(ResultsFor(index), item_index);
+}
+
+TEST_CASE(TestSearchIndex) {
+    auto& a = tester.scratch_arena;
+
+    Array const names {
+        "Warm Pad"_s,
+        "Cold Pad"_s,
+        "PADDED Lead"_s,
+        "Bass"_s,
+        ""_s,
+        "Ab"_s,
+        "Wind Chimes"_s,
+        "padpadpad"_s,
+    };
+
+    auto const index = BuildSearchIndex(
+        (u32)names.size,
+        [&](u32 i) { return names[i]; },
+        a,
+        a);
+
+    CHECK_EQ(index.NumItems(), (u32)names.size);
+    CHECK(index.id != 0);
+
+    auto const check_query_matches_brute_force = [&](String query) {
+        DynamicArray<char> lowercase {a};
+        for (auto const c : query)
+            dyn::Append(lowercase, ToLowercaseAscii(c));
+
+        auto bits = a.NewMultiple<u64>(1);
+        SearchIndexQuery(index, (String)lowercase, bits);
+        for (auto const [i, name] : Enumerate<u32>(names)) {
+            CAPTURE(query);
+            CAPTURE(name);
+            CHECK_EQ(BitIsSet(bits, i), ContainsCaseInsensitiveAscii(name, query));
+        }
+    };
+
+    SUBCASE("matches the same as a case-insensitive substring search") {
+        for (auto const q : Array {"pad"_s,
+                                   "PAD"_s,
+                                   "d p"_s,
+                                   "Padded"_s,
+                                   "a"_s,
+                                   "ab"_s,
+                                   ""_s,
+                                   "xyz"_s,
+                                   "wind chimes"_s,
+                                   "wind chimesx"_s,
+                                   "dpa"_s})
+            check_query_matches_brute_force(q);
+    }
+
+    SUBCASE("cache refines results as the query grows and shrinks") {
+        SearchResultsCache cache {};
+        auto const check_cache = [&](String query) {
+            for (auto const [i, name] : Enumerate<u32>(names)) {
+                CAPTURE(query);
+                CAPTURE(name);
+                CHECK_EQ(cache.Matches(index, query, i), ContainsCaseInsensitiveAscii(name, query));
+            }
+        };
+
+        check_cache("p");
+        check_cache("pa");
+        CHECK(cache.narrowing);
+        check_cache("pad");
+        check_cache("pad");
+        check_cache("pa");
+        CHECK(!cache.narrowing);
+        check_cache("padd");
+        check_cache("bass");
+        CHECK(!cache.narrowing);
+        check_cache("");
+    }
+
+    SUBCASE("empty index") {
+        auto const empty = BuildSearchIndex(
+            0,
+            [&](u32) { return String {}; },
+            a,
+            a);
+        CHECK_EQ(empty.NumItems(), 0u);
+        CHECK_EQ(empty.id, 0u);
+    }
+
+    return k_success;
+}
+
+TEST_REGISTRATION(RegisterSearchIndexTests) { REGISTER_TEST(TestSearchIndex); }
@@ -0,0 +1,59 @@
+// Copyright 2025-2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+#pragma once
+
+#include "foundation/foundation.hpp"
+
+// A trigram index over a list of items' text, built once when a collection of items is published (a preset
+// folder, a library's instruments, etc.) and then queried from the GUI thread. Matching semantics are the
+// same as ContainsCaseInsensitiveAscii(item_text, query): ASCII case-insensitive substring.
+//
+// Items are identified by their index in the order they were given when building.
+struct SearchIndex {
+    u32 NumItems() const { return item_text_offsets.size ? (u32)item_text_offsets.size - 1 : 0; }
+    String ItemText(u32 item_index) const {
+        return text.SubSpan(item_text_offsets[item_index],
+                            item_text_offsets[item_index + 1] - item_text_offsets[item_index]);
+    }
+
+    u64 id {}; // Unique for every built index, 0 if the index is empty.
+    String text {}; // Lowercase text of all items, back-to-back.
+    Span<u32> item_text_offsets {}; // NumItems() + 1 entries.
+    HashTable<u32, Span<u32 const>> trigram_postings {}; // Trigram -> ascending item indices.
+};
+
+// item_text(item_index) should return the searchable text for the item.
+SearchIndex BuildSearchIndex(u32 num_items,
+                             FunctionRef<String(u32 item_index)> item_text,
+                             Allocator& allocator,
+                             ArenaAllocator& scratch_arena);
+
+// Sets a bit in matches for every item that contains the query. If candidates is given, only those items are
+// considered. query must already be lowercase. matches must have space for NumItems() bits and be zeroed.
+void SearchIndexQuery(SearchIndex const& index,
+                      String lowercase_query,
+                      Span<u64> matches,
+                      Span<u64 const> candidates = {});
+
+// Caches the results of a search across frames. Each index is queried at most once per search string. When
+// the search string is extended (the common case when typing), only the previous matches are re-checked.
+struct SearchResultsCache {
+    static constexpr usize k_max_query_size = 128;
+
+    bool Matches(SearchIndex const& index, String query, u32 item_index);
+
+    struct Generation {
+        ArenaAllocator arena {Malloc::Instance(), 0, 1024};
+        HashTable<u64, Span<u64 const>> results {}; // Index id -> match bitset.
+        DynamicArrayBounded<char, k_max_query_size> query {}; // Lowercase.
+    };
+
+    void BeginQuery(String query);
+    Span<u64 const> ResultsFor(SearchIndex const& index);
+
+    Array<Generation, 2> generations {};
+    u8 current {};
+    bool narrowing {}; // The previous generation's query is a substring of the current one.
+    u64 last_index_id {};
+    Span<u64 const> last_results {};
+};
@@ -9,6 +9,8 @@
 #include "utils/json/json_reader.hpp"
 #include "utils/json/json_writer.hpp"
 
+#include "benchmarks/framework.hpp"
+
 #include "common_infrastructure/audio_utils.hpp"
 #include "common_infrastructure/common_errors.hpp"
 #include "common_infrastructure/constants.hpp"
@@ -2035,6 +2037,15 @@ LoadPresetFile(String const filepath, ArenaAllocator& scratch_arena, DecodeState
                           options);
 }
 
+ErrorCodeOr<void> EncodeState(StateSnapshot const& state, CodeStateArguments const& args) {
+    ASSERT(args.mode == CodeStateArguments::Mode::Encode);
+    // CodeState shares its code with decoding so it needs a mutable state, and it temporarily scrubs the
+    // extras when writing preset files. We give it a copy rather than casting away const: the state might be
+    // read by other threads, and copying is cheap next to the encoding itself.
+    auto state_copy = state;
+    return CodeState(state_copy, args);
+}
+
 bool PresetFilePredatesEmbeddedUuid(u16 state_version) {
     return state_version < ToInt(StateVersion::AddedPresetUuid);
 }
@@ -2050,30 +2061,28 @@ ErrorCodeOr<void> SavePresetFile(String path, StateSnapshot const& state, bool w
     }
 
     auto file = TRY(OpenFile(path, FileMode::Write()));
-    return CodeState(const_cast<StateSnapshot&>(state),
-                     CodeStateArguments {
-                         .mode = CodeStateArguments::Mode::Encode,
-                         .read_or_write_data = [&file](void* data, usize bytes) -> ErrorCodeOr<void> {
-                             TRY(file.Write({(u8 const*)data, bytes}));
-                             return k_success;
-                         },
-                         .source = StateSource::PresetFile,
-                         .write_experimental_params = write_experiment_params,
-                     });
+    return EncodeState(state,
+                       CodeStateArguments {
+                           .mode = CodeStateArguments::Mode::Encode,
+                           .read_or_write_data = [&file](void* data, usize bytes) -> ErrorCodeOr<void> {
+                               TRY(file.Write({(u8 const*)data, bytes}));
+                               return k_success;
+                           },
+                           .source = StateSource::PresetFile,
+                           .write_experimental_params = write_experiment_params,
+                       });
 }
 
 ErrorCodeOr<StateSnapshot>
 DecodeFromMemory(Span<u8 const> data, StateSource source, DecodeStateOptions options) {
     StateSnapshot state;
-    usize read_pos = 0;
+    auto reader = Reader::FromMemory(data);
     TRY(CodeState(state,
                   CodeStateArguments {
                       .mode = CodeStateArguments::Mode::Decode,
-                      .read_or_write_data = [&](void* out_data, usize bytes) -> ErrorCodeOr<void> {
-                          if ((read_pos + bytes) > data.size)
+                      .read_or_write_data = [&reader](void* out_data, usize bytes) -> ErrorCodeOr<void> {
+                          if (TRY(reader.Read(out_data, bytes)) != bytes)
                               return ErrorCode(CommonError::InvalidFileFormat);
-                          CopyMemory(out_data, data.data + read_pos, bytes);
-                          read_pos += bytes;
                           return k_success;
                       },
                       .source = source,
@@ -2083,6 +2092,28 @@ DecodeFromMemory(Span<u8 const> data, StateSource source, DecodeStateOptions opt
     return state;
 }
 
+ErrorCodeOr<Span<u8 const>> EncodeToMemory(StateSnapshot const& state,
+                                           ArenaAllocator& arena,
+                                           StateSource source,
+                                           bool write_experimental_params) {
+    // Enough for a typical state so that we rarely need to grow.
+    constexpr usize k_initial_capacity = 16 * 1024;
+
+    DynamicArray<u8> buffer {arena};
+    buffer.Reserve(k_initial_capacity);
+    TRY(EncodeState(state,
+                    CodeStateArguments {
+                        .mode = CodeStateArguments::Mode::Encode,
+                        .read_or_write_data = [&buffer](void* data, usize bytes) -> ErrorCodeOr<void> {
+                            dyn::AppendSpan(buffer, Span<u8 const> {(u8 const*)data, bytes});
+                            return k_success;
+                        },
+                        .source = source,
+                        .write_experimental_params = write_experimental_params,
+                    }));
+    return buffer.ToOwnedSpanUnchangedCapacity().items;
+}
+
 //=================================================
 //  _______        _
 // |__   __|      | |
@@ -3201,3 +3232,39 @@ TEST_REGISTRATION(RegisterStateCodingTests) {
     REGISTER_TEST(TestPresetUuidRoundTrip);
     REGISTER_TEST(TestDecodeSanitisesParamValues);
 }
+
+BENCHMARK_FN void BenchmarkEncodeDecodeDawState() {
+    StateSnapshot state = DefaultStateSnapshot();
+    state.ir_id = sample_lib::IrId {
+        .library = sample_lib::HashLibraryIdStringWithoutRegistration("Author - IR Library"_s),
+        .ir_id = "Folder/Impulse Response"_s,
+    };
+    for (auto& inst : state.inst_ids) {
+        inst = sample_lib::InstrumentId {
+            .library = sample_lib::HashLibraryIdStringWithoutRegistration("Author - Library"_s),
+            .inst_id = "Folder/Instrument"_s,
+        };
+    }
+    for (auto const param : Range(k_num_parameters)) {
+        if (param % 4 == 0) {
+            Bitset<128> bits {};
+            bits.Set(1);
+            bits.Set(20);
+            state.extras.param_learned_ccs[param] = bits;
+        }
+    }
+    dyn::Assign(state.extras.instance_id, "benchmark-instance"_s);
+    dyn::Assign(state.extras.display_name, "Benchmark State"_s);
+
+    ArenaAllocator arena {PageAllocator::Instance()};
+    for (auto const _ : Range(10000u)) {
+        auto const data = EncodeToMemory(state, arena, StateSource::Daw, true);
+        ASSERT(data.HasValue());
+        auto decoded = DecodeFromMemory(data.Value(), StateSource::Daw);
+        ASSERT(decoded.HasValue());
+        benchmarks::DoNotOptimise(decoded);
+        arena.ResetCursorAndConsolidateRegions();
+    }
+}
+
+BENCHMARK_REGISTRATION(RegisterStateCodingBenchmarks) { REGISTER_BENCHMARK(BenchmarkEncodeDecodeDawState); }
@@ -28,6 +28,9 @@ struct CodeStateArguments {
 // "Code" as in decode/encode
 ErrorCodeOr<void> CodeState(StateSnapshot& state, CodeStateArguments const& args);
 
+// For encoding a state that the caller only has const access to. args.mode must be Encode.
+ErrorCodeOr<void> EncodeState(StateSnapshot const& state, CodeStateArguments const& args);
+
 enum class PresetFormat : u8 { Floe, Mirage, Count };
 
 Optional<PresetFormat> PresetFormatFromPath(String path);
@@ -45,6 +48,13 @@ struct DecodeStateOptions {
 ErrorCodeOr<StateSnapshot>
 DecodeFromMemory(Span<u8 const> data, StateSource source, DecodeStateOptions options = {});
 
+// Encodes the whole state into a single buffer so that it can be written out in one go rather than field by
+// field.
+ErrorCodeOr<Span<u8 const>> EncodeToMemory(StateSnapshot const& state,
+                                           ArenaAllocator& arena,
+                                           StateSource source,
+                                           bool write_experimental_params);
+
 ErrorCodeOr<StateSnapshot>
 LoadPresetFile(String filepath, ArenaAllocator& scratch_arena, DecodeStateOptions options = {});
 
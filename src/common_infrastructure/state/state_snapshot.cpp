@@ -3,6 +3,8 @@
 
 #include "state_snapshot.hpp"
 
+#include "tests/framework.hpp"
+
 template <typename DynArrayT>
 requires dyn::DynArray<DynArrayT>
 void AssignDiffDescription(DynArrayT& diff_desc,
@@ -158,6 +160,34 @@ template void AssignDiffDescription<DynamicArrayBounded<char, Kb(4)>>(DynamicArr
 template void
 AssignDiffDescription<DynamicArray<char>>(DynamicArray<char>&, StateSnapshot const&, StateSnapshot const&);
 
+// Calls f(a_member, b_member) for the member that makes up the part.
+template <typename Function>
+static auto WithPart(StateSnapshot const& a, StateSnapshot const& b, StateSnapshotPart part, Function&& f) {
+    switch (part) {
+        case StateSnapshotPart::Ir: return f(a.ir_id, b.ir_id);
+        case StateSnapshotPart::Instruments: return f(a.inst_ids, b.inst_ids);
+        case StateSnapshotPart::Params: return f(a.param_values, b.param_values);
+        case StateSnapshotPart::FxOrder: return f(a.fx_order, b.fx_order);
+        case StateSnapshotPart::FxVisible: return f(a.fx_visible, b.fx_visible);
+        case StateSnapshotPart::Metadata: return f(a.metadata, b.metadata);
+        case StateSnapshotPart::VelocityCurves: return f(a.velocity_curve_points, b.velocity_curve_points);
+        case StateSnapshotPart::HarmonyIntervals: return f(a.harmony_intervals, b.harmony_intervals);
+        case StateSnapshotPart::ArpSteps: return f(a.arp_steps, b.arp_steps);
+        case StateSnapshotPart::SliceArpConfigs: return f(a.slice_arp_configs, b.slice_arp_configs);
+        case StateSnapshotPart::MacroNames: return f(a.macro_names, b.macro_names);
+        case StateSnapshotPart::MacroDestinations: return f(a.macro_destinations, b.macro_destinations);
+        case StateSnapshotPart::Count: break;
+    }
+    PanicIfReached();
+    return f(a.ir_id, b.ir_id);
+}
+
+bool StateSnapshotPartsEqual(StateSnapshot const& a, StateSnapshot const& b, StateSnapshotPart part) {
+    return WithPart(a, b, part, [](auto const& a_member, auto const& b_member) {
+        return a_member == b_member;
+    });
+}
+
 StateSnapshot const& DefaultStateSnapshot() {
     static StateSnapshot const state = ({
         StateSnapshot s {};
@@ -174,3 +204,105 @@ StateSnapshot const& DefaultStateSnapshot() {
     });
     return state;
 }
+
+TEST_CASE(TestStateSnapshotParts) {
+    auto const without_extras_equal = [](StateSnapshot const& a, StateSnapshot const& b) {
+        auto b_copy = b;
+        b_copy.extras = a.extras;
+        return a == b_copy;
+    };
+
+    auto const check_equivalent_to_full_comparison = [&](StateSnapshot const& a, StateSnapshot const& b) {
+        bool any_differ = false;
+        for (auto const part : Range(ToInt(StateSnapshotPart::Count)))
+            if (!StateSnapshotPartsEqual(a, b, (StateSnapshotPart)part)) any_differ = true;
+        CHECK_EQ(any_differ, !without_extras_equal(a, b));
+    };
+
+    SUBCASE("random edits") {
+        auto& seed = tester.random_seed;
+        auto const base = DefaultStateSnapshot();
+        auto state = base;
+        auto params_hash = HashParamValues(state.param_values);
+
+        for (auto const _ : Range(2000)) {
+            auto const prev = state;
+            auto const layer = RandomIntInRange<u32>(seed, 0, k_num_layers - 1);
+            switch (RandomIntInRange<u32>(seed, 0, 9)) {
+                case 0: {
+                    auto const index = RandomIntInRange<usize>(seed, 0, k_num_parameters - 1);
+                    constexpr f32 k_values[] = {0.0f, -0.0f, 0.5f, 1.0f};
+                    auto const value = k_values[RandomIntInRange<usize>(seed, 0, ArraySize(k_values) - 1)];
+                    params_hash ^= ParamValueHashTerm(index, state.param_values[index]) ^
+                                   ParamValueHashTerm(index, value);
+                    state.param_values[index] = value;
+                    break;
+                }
+                case 1:
+                    state.inst_ids[layer] =
+                        (WaveformType)RandomIntInRange<u32>(seed, 0, ToInt(WaveformType::Count) - 1);
+                    break;
+                case 2:
+                    Swap(state.fx_order[RandomIntInRange<usize>(seed, 0, k_num_effect_types - 1)],
+                         state.fx_order[RandomIntInRange<usize>(seed, 0, k_num_effect_types - 1)]);
+                    break;
+                case 3:
+                    state.fx_visible.Flip(RandomIntInRange<usize>(seed, 0, k_num_effect_types - 1));
+                    break;
+                case 4: {
+                    // Varying lengths leave old bytes in the unused capacity.
+                    constexpr String k_authors[] = {""_s, "a"_s, "ab"_s, "a longer author name"_s};
+                    dyn::Assign(state.metadata.author,
+                                k_authors[RandomIntInRange<usize>(seed, 0, ArraySize(k_authors) - 1)]);
+                    break;
+                }
+                case 5:
+                    state.harmony_intervals[layer].Flip(
+                        RandomIntInRange<usize>(seed, 0, k_num_harmony_interval_bits - 1));
+                    break;
+                case 6: {
+                    auto const step = RandomIntInRange<usize>(seed, 0, k_arp_max_steps - 1);
+                    state.arp_steps[layer][step].velocity = RandomIntInRange<u16>(seed, 0, 2);
+                    break;
+                }
+                case 7: state.slice_arp_configs[layer].loop_length = RandomIntInRange<u8>(seed, 0, 2); break;
+                case 8: {
+                    constexpr String k_names[] = {"Macro"_s, "M"_s, "Brightness"_s};
+                    dyn::Assign(state.macro_names[RandomIntInRange<usize>(seed, 0, k_num_macros - 1)],
+                                k_names[RandomIntInRange<usize>(seed, 0, ArraySize(k_names) - 1)]);
+                    break;
+                }
+                case 9:
+                    // Extras aren't part of the patch.
+                    state.extras.preset_uuid = RandomIntInRange<u64>(seed, 0, 2);
+                    break;
+            }
+
+            CHECK_EQ(params_hash, HashParamValues(state.param_values));
+            check_equivalent_to_full_comparison(prev, state);
+            check_equivalent_to_full_comparison(base, state);
+        }
+    }
+
+    SUBCASE("negative zero") {
+        auto a = DefaultStateSnapshot();
+        auto b = a;
+        a.param_values[0] = 0.0f;
+        b.param_values[0] = -0.0f;
+        CHECK_EQ(HashParamValues(a.param_values), HashParamValues(b.param_values));
+        CHECK(StateSnapshotPartsEqual(a, b, StateSnapshotPart::Params));
+    }
+
+    SUBCASE("equal parts with different bytes") {
+        auto a = DefaultStateSnapshot();
+        auto b = a;
+        dyn::Assign(a.metadata.author, "a long name"_s);
+        dyn::Assign(a.metadata.author, "x"_s);
+        dyn::Assign(b.metadata.author, "x"_s);
+        CHECK(StateSnapshotPartsEqual(a, b, StateSnapshotPart::Metadata));
+    }
+
+    return k_success;
+}
+
+TEST_REGISTRATION(RegisterStateSnapshotTests) { REGISTER_TEST(TestStateSnapshotParts); }
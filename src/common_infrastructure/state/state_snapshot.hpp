@@ -56,6 +56,8 @@ struct StateExtras {
     bool modified_from_preset {};
 };
 
+// IMPORTANT: new fields must also be added to ForEachDeltaSection in the plugin's undo.cpp, and to
+// StateSnapshotPart unless they're extras.
 struct StateSnapshot {
     f32& LinearParam(ParamIndex index) { return param_values[ToInt(index)]; }
     f32 LinearParam(ParamIndex index) const { return param_values[ToInt(index)]; }
@@ -78,6 +80,29 @@ struct StateSnapshot {
     StateExtras extras {};
 };
 
+// The audible patch split into parts: everything in the snapshot except the extras.
+enum class StateSnapshotPart : u8 {
+    Ir,
+    Instruments,
+    Params,
+    FxOrder,
+    FxVisible,
+    Metadata,
+    VelocityCurves,
+    HarmonyIntervals,
+    ArpSteps,
+    SliceArpConfigs,
+    MacroNames,
+    MacroDestinations,
+    Count,
+};
+
+using StateSnapshotParts = Bitset<ToInt(StateSnapshotPart::Count)>;
+
+// Compares only the member that makes up the part. The parts cover everything except the extras, so code that
+// knows which parts might have changed only needs to compare those.
+bool StateSnapshotPartsEqual(StateSnapshot const& a, StateSnapshot const& b, StateSnapshotPart part);
+
 enum class StateSource : u8 {
     PresetFile,
     Daw,
@@ -0,0 +1,347 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "grouped_hash_table.hpp"
+
+#include "benchmarks/framework.hpp"
+#include "tests/framework.hpp"
+#include "utils/leak_detecting_allocator.hpp"
+
+template <HashTableOrdering k_ordering>
+TEST_CASE(TestGroupedHashTable) {
+    auto& a = tester.scratch_arena;
+
+    SUBCASE("table") {
+        DynamicGroupedHashTable<String, usize, nullptr, k_ordering> tab {a, 16u};
+
+        CHECK(tab.table.size == 0);
+        CHECK(tab.table.Capacity() >= 16);
+        CHECK(tab.begin() == tab.end());
+
+        CHECK(tab.Insert("foo", 42));
+        CHECK(tab.Insert("bar", 31337));
+        CHECK(tab.Insert("qux", 64));
+        CHECK(tab.Insert("900", 900));
+        CHECK(tab.Insert("112", 112));
+        CHECK(!tab.Insert("foo", 1));
+
+        CHECK(tab.Find("foo"));
+        CHECK(tab.Find("bar"));
+        CHECK(!tab.Find("baz"));
+        CHECK(tab.table.size == 5);
+
+        {
+            usize count = 0;
+            for (auto item : tab) {
+                CHECK(item.key.size);
+                if (item.key == "112") item.value++;
+                ++count;
+            }
+            CHECK(count == 5);
+            auto v = tab.Find("112");
+            CHECK(v && *v == 113);
+        }
+
+        for (auto const i : Range(10000uz))
+            CHECK(tab.Insert(fmt::Format(a, "key{}", i), i));
+        CHECK(tab.table.size == 10005);
+        for (auto const i : Range(10000uz)) {
+            auto v = tab.Find(fmt::Format(a, "key{}", i));
+            REQUIRE(v);
+            CHECK_EQ(*v, i);
+        }
+
+        DynamicGroupedHashTable<String, usize, nullptr, k_ordering> other {a, 16u};
+        CHECK(other.Insert("foo", 42));
+        tab.Assign(other);
+        CHECK(tab.table.size == 1);
+        CHECK(tab.Find("foo"));
+    }
+
+    SUBCASE("grow and delete") {
+        for (auto insertions : Range(4uz, 64uz)) {
+            GroupedHashTable<usize, usize, nullptr, k_ordering> tab {};
+            for (auto i : Range(insertions)) {
+                auto const result = tab.FindOrInsertGrowIfNeeded(a, i, i * 2);
+                CHECK(result.inserted);
+                CHECK_EQ(result.element.data, i * 2);
+            }
+            CHECK_EQ(tab.size, insertions);
+            for (auto i : Range(insertions))
+                CHECK(tab.Delete(i));
+            CHECK_EQ(tab.size, 0uz);
+            for (auto i : Range(insertions * 4)) {
+                auto const result = tab.FindOrInsertGrowIfNeeded(a, i, i * 2);
+                CHECK(result.inserted);
+            }
+            CHECK_EQ(tab.size, insertions * 4);
+        }
+    }
+
+    SUBCASE("reserve") {
+        for (auto count : Range(4uz, 64uz)) {
+            GroupedHashTable<usize, usize, nullptr, k_ordering> tab {};
+            tab.Reserve(a, count);
+            for (auto i : Range(count)) {
+                auto const result = tab.FindOrInsertWithoutGrowing(i, i * 2);
+                CHECK(result.inserted);
+            }
+            CHECK_EQ(tab.size, count);
+        }
+    }
+
+    SUBCASE("tombstones don't accumulate") {
+        // Constant churn at a fixed size: tombstones must be recycled or cleared by rehashing rather than
+        // making the table grow.
+        GroupedHashTable<usize, usize, nullptr, k_ordering> tab {};
+        tab.Reserve(a, 100);
+        auto const capacity = tab.Capacity();
+        for (auto i : Range(100uz))
+            CHECK(tab.InsertGrowIfNeeded(a, i, i));
+        for (auto i : Range(100uz, 20000uz)) {
+            CHECK(tab.Delete(i - 100));
+            CHECK(tab.InsertGrowIfNeeded(a, i, i));
+        }
+        CHECK_EQ(tab.size, 100uz);
+        CHECK_EQ(tab.Capacity(), capacity);
+        for (auto i : Range(19900uz, 20000uz))
+            CHECK(tab.Contains(i));
+    }
+
+    SUBCASE("colliding control bytes") {
+        // With NoHash, these keys share their low bits and so their probe start, and many will share a
+        // control byte too. Lookups have to fall back to comparing keys.
+        GroupedHashTable<u64, u64, NoHash, k_ordering> tab {};
+        for (auto i : Range(1u, 200u))
+            CHECK(tab.InsertGrowIfNeeded(a, (u64)i << 40, i));
+        for (auto i : Range(1u, 200u)) {
+            auto v = tab.Find((u64)i << 40);
+            REQUIRE(v);
+            CHECK_EQ(*v, (u64)i);
+        }
+        CHECK(!tab.Contains(201ull << 40));
+        CHECK(tab.ContainsSkipKeyCheck(5ull << 40));
+    }
+
+    SUBCASE("move") {
+        LeakDetectingAllocator a2;
+
+        SUBCASE("construct") {
+            DynamicGroupedHashTable<String, int, nullptr, k_ordering> tab1 {a2};
+            CHECK(tab1.Insert("foo", 100));
+            DynamicGroupedHashTable<String, int, nullptr, k_ordering> const tab2 {Move(tab1)};
+            CHECK(tab2.Find("foo"));
+        }
+        SUBCASE("assign same allocator") {
+            DynamicGroupedHashTable<String, int, nullptr, k_ordering> tab1 {a2};
+            CHECK(tab1.Insert("foo", 100));
+            DynamicGroupedHashTable<String, int, nullptr, k_ordering> tab2 {a2};
+            tab2 = Move(tab1);
+            CHECK(tab2.Find("foo"));
+        }
+        SUBCASE("assign different allocator") {
+            DynamicGroupedHashTable<String, int, nullptr, k_ordering> tab1 {a2};
+            CHECK(tab1.Insert("foo", 100));
+            DynamicGroupedHashTable<String, int, nullptr, k_ordering> tab2 {Malloc::Instance()};
+            tab2 = Move(tab1);
+            CHECK(tab2.Find("foo"));
+        }
+    }
+
+    SUBCASE("intersect and remove if") {
+        DynamicGroupedHashTable<String, int, nullptr, k_ordering> tab1 {a};
+        CHECK(tab1.Insert("foo", 100));
+        CHECK(tab1.Insert("bar", 200));
+        CHECK(tab1.Insert("qux", 300));
+
+        DynamicGroupedHashTable<String, int, nullptr, k_ordering> tab2 {a};
+        CHECK(tab2.Insert("bar", 200));
+        CHECK(tab2.Insert("qux", 400));
+        CHECK(tab2.Insert("baz", 400));
+
+        tab1.table.IntersectWith(tab2);
+        CHECK(tab1.table.size == 2);
+        CHECK(tab1.Find("bar"));
+        CHECK(tab1.Find("qux"));
+
+        CHECK_EQ(tab1.RemoveIf([](String, int v) { return v == 300; }), 1uz);
+        CHECK(tab1.table.size == 1);
+        CHECK(!tab1.Find("qux"));
+    }
+
+    SUBCASE("set") {
+        GroupedHashTable<String, DummyValueType, nullptr, k_ordering> set {};
+        CHECK(set.InsertGrowIfNeeded(a, "a", {}));
+        CHECK(set.InsertGrowIfNeeded(a, "b", {}));
+        CHECK(!set.InsertGrowIfNeeded(a, "a", {}));
+        usize count = 0;
+        for (auto const [key, hash] : set) {
+            CHECK(key.size);
+            CHECK(hash != 0);
+            ++count;
+        }
+        CHECK_EQ(count, 2uz);
+    }
+
+    if constexpr (k_ordering == HashTableOrdering::Ordered) {
+        SUBCASE("ordered") {
+            DynamicGroupedHashTable<String, int, nullptr, k_ordering> tab {a};
+            for (auto const key : Array {"b"_s, "c", "a", "d"})
+                CHECK(tab.Insert(key, 0));
+
+            auto check_order = [&](Span<String const> expected) {
+                auto it = tab.begin();
+                for (auto const& key : expected) {
+                    REQUIRE(it != tab.end());
+                    CHECK_EQ((*it).key, key);
+                    ++it;
+                }
+                CHECK(it == tab.end());
+            };
+
+            check_order(Array {"a"_s, "b", "c", "d"});
+
+            CHECK(tab.Delete("b"));
+            check_order(Array {"a"_s, "c", "d"});
+
+            // Growing must keep the order.
+            for (auto const i : Range(100))
+                CHECK(tab.Insert(fmt::Format(a, "z{03}", i), i));
+            String prev {};
+            for (auto const item : tab) {
+                CHECK(prev < item.key);
+                prev = item.key;
+            }
+
+            tab.DeleteAll();
+            CHECK(tab.Insert("y", 200));
+            CHECK(tab.Insert("x", 100));
+            check_order(Array {"x"_s, "y"});
+        }
+    }
+
+    SUBCASE("matches HashTable") {
+        // Random inserts and deletes, checked against the existing table.
+        GroupedHashTable<u64, u64, nullptr, k_ordering> grouped {};
+        HashTable<u64, u64, nullptr, k_ordering> reference {};
+        u64 seed = 0x1234;
+        for (auto const i : Range(20000u)) {
+            auto const key = RandomIntInRange<u64>(seed, 1, 3000);
+            if (RandomIntInRange<u32>(seed, 0, 2) == 0) {
+                CHECK_EQ(grouped.Delete(key), reference.Delete(key));
+            } else {
+                auto const g = grouped.FindOrInsertGrowIfNeeded(a, key, i);
+                auto const r = reference.FindOrInsertGrowIfNeeded(a, key, i);
+                CHECK_EQ(g.inserted, r.inserted);
+                CHECK_EQ(g.element.data, r.element.data);
+            }
+            CHECK_EQ(grouped.size, reference.size);
+        }
+
+        usize count = 0;
+        for (auto const item : grouped) {
+            auto v = reference.Find(item.key);
+            REQUIRE(v);
+            CHECK_EQ(*v, item.value);
+            ++count;
+        }
+        CHECK_EQ(count, reference.size);
+
+        if constexpr (k_ordering == HashTableOrdering::Ordered) {
+            auto it = reference.begin();
+            for (auto const item : grouped) {
+                CHECK_EQ(item.key, (*it).key);
+                ++it;
+            }
+        }
+    }
+
+    return k_success;
+}
+
+TEST_REGISTRATION(RegisterGroupedHashTableTests) {
+    REGISTER_TEST(TestGroupedHashTable<HashTableOrdering::Ordered>);
+    REGISTER_TEST(TestGroupedHashTable<HashTableOrdering::Unordered>);
+}
+
+// Keys for the benchmarks: a mix of short strings like those we hash most (tags, names, paths) and integers.
+template <typename KeyType>
+static Span<KeyType> BenchmarkKeys(ArenaAllocator& arena, usize count, u64 seed) {
+    auto keys = arena.AllocateExactSizeUninitialised<KeyType>(count);
+    for (auto& key : keys) {
+        if constexpr (Same<KeyType, String>)
+            key = fmt::Format(arena,
+                              "Library/Folder {}/Instrument {}",
+                              RandomU64(seed) % 64,
+                              RandomU64(seed));
+        else
+            key = RandomU64(seed) | 1;
+    }
+    return keys;
+}
+
+enum class HashTableBenchmark { Insert, FindHit, FindMiss, Churn };
+
+// Runs the same operations on either table type. Tables are kept at sizes that are typical for us: up to
+// a few thousand items.
+template <typename TableType, HashTableBenchmark k_benchmark>
+BENCHMARK_FN void BenchmarkHashTable() {
+    using KeyType = TableType::KeyType;
+    ArenaAllocator arena {PageAllocator::Instance()};
+    constexpr usize k_num_keys = 4000;
+    constexpr usize k_num_rounds = 400;
+
+    auto const keys = BenchmarkKeys<KeyType>(arena, k_num_keys, 1);
+    auto const missing_keys = BenchmarkKeys<KeyType>(arena, k_num_keys, 2);
+
+    TableType table {};
+    if constexpr (k_benchmark != HashTableBenchmark::Insert)
+        for (auto const [i, key] : Enumerate(keys))
+            table.InsertGrowIfNeeded(arena, key, i);
+
+    usize found = 0;
+    for (auto const round : Range(k_num_rounds)) {
+        if constexpr (k_benchmark == HashTableBenchmark::Insert) {
+            table.Free(arena);
+            for (auto const [i, key] : Enumerate(keys))
+                table.InsertGrowIfNeeded(arena, key, i);
+        } else if constexpr (k_benchmark == HashTableBenchmark::FindHit) {
+            for (auto const& key : keys)
+                found += table.Find(key) != nullptr;
+        } else if constexpr (k_benchmark == HashTableBenchmark::FindMiss) {
+            for (auto const& key : missing_keys)
+                found += table.Find(key) != nullptr;
+        } else if constexpr (k_benchmark == HashTableBenchmark::Churn) {
+            // Swap a tenth of the keys out and back in again.
+            auto const begin = (round % 10) * (k_num_keys / 10);
+            for (auto const i : Range(begin, begin + (k_num_keys / 10)))
+                table.Delete(keys[i]);
+            for (auto const i : Range(begin, begin + (k_num_keys / 10)))
+                table.InsertGrowIfNeeded(arena, keys[i], i);
+        }
+    }
+    benchmarks::DoNotOptimise(found);
+}
+
+BENCHMARK_REGISTRATION(RegisterHashTableBenchmarks) {
+#define REGISTER_HASH_TABLE_BENCHMARK(table, key, benchmark)                                                 \
+    REGISTER_BENCHMARK_NAMED((BenchmarkHashTable<table<key, usize>, HashTableBenchmark::benchmark>),         \
+                             #table "/" #benchmark "/" #key)
+    REGISTER_HASH_TABLE_BENCHMARK(HashTable, String, Insert);
+    REGISTER_HASH_TABLE_BENCHMARK(GroupedHashTable, String, Insert);
+    REGISTER_HASH_TABLE_BENCHMARK(HashTable, String, FindHit);
+    REGISTER_HASH_TABLE_BENCHMARK(GroupedHashTable, String, FindHit);
+    REGISTER_HASH_TABLE_BENCHMARK(HashTable, String, FindMiss);
+    REGISTER_HASH_TABLE_BENCHMARK(GroupedHashTable, String, FindMiss);
+    REGISTER_HASH_TABLE_BENCHMARK(HashTable, String, Churn);
+    REGISTER_HASH_TABLE_BENCHMARK(GroupedHashTable, String, Churn);
+    REGISTER_HASH_TABLE_BENCHMARK(HashTable, u64, Insert);
+    REGISTER_HASH_TABLE_BENCHMARK(GroupedHashTable, u64, Insert);
+    REGISTER_HASH_TABLE_BENCHMARK(HashTable, u64, FindHit);
+    REGISTER_HASH_TABLE_BENCHMARK(GroupedHashTable, u64, FindHit);
+    REGISTER_HASH_TABLE_BENCHMARK(HashTable, u64, FindMiss);
+    REGISTER_HASH_TABLE_BENCHMARK(GroupedHashTable, u64, FindMiss);
+    REGISTER_HASH_TABLE_BENCHMARK(HashTable, u64, Churn);
+    REGISTER_HASH_TABLE_BENCHMARK(GroupedHashTable, u64, Churn);
+#undef REGISTER_HASH_TABLE_BENCHMARK
+}
@@ -0,0 +1,668 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+#include "foundation/container/hash_table.hpp"
+#include "foundation/memory/allocators.hpp"
+#include "foundation/utils/simd.hpp"
+
+// An open-addressing hash table in the style of Abseil's SwissTable. It has the same API as HashTable but a
+// different layout: every slot has a control byte, and the hashes, keys and values each live in their own
+// array. A lookup compares 16 control bytes at once using SSE2 or NEON and only looks at the keys whose 7-bit
+// hash fragment matches, so most lookups touch one run of control bytes and one key. Deleted slots only
+// become tombstones if a probe could have passed over them.
+//
+// Because there's no Element struct, FindElement/DeleteElement/Elements() are replaced by FindIndex and
+// DeleteIndex, and FindOrInsert gives you references to the key and value instead of an Element.
+
+namespace grouped_hash_table {
+
+constexpr usize k_group_size = 16;
+
+// A full slot's control byte is 7 bits of its hash, so the top bit is only set for these.
+constexpr u8 k_ctrl_empty = 0x80;
+constexpr u8 k_ctrl_deleted = 0xfe;
+
+PUBLIC ALWAYS_INLINE constexpr bool IsFull(u8 ctrl) { return (ctrl & 0x80) == 0; }
+
+// Slots of a group that matched. One bit per slot on x86; one nibble per slot on NEON because that's the
+// cheapest way to narrow its comparison results.
+struct GroupMask {
+#if defined(__aarch64__)
+    static constexpr u32 k_shift = 2;
+#else
+    static constexpr u32 k_shift = 0;
+#endif
+
+    explicit operator bool() const { return bits != 0; }
+    u32 LowestIndex() const { return (u32)__builtin_ctzll(bits) >> k_shift; }
+    void ClearLowest() { bits &= bits - 1; }
+
+    // The number of unmatched slots before the first match, counting from the start or the end of the group.
+    u32 UnmatchedAtStart() const { return bits ? LowestIndex() : (u32)k_group_size; }
+    u32 UnmatchedAtEnd() const {
+        if (!bits) return (u32)k_group_size;
+        return ((u32)__builtin_clzll(bits) >> k_shift) - (u32)((64 >> k_shift) - k_group_size);
+    }
+
+    u64 bits;
+};
+
+struct Group {
+#if defined(__x86_64__)
+    // Probes start at any slot, so this is usually unaligned.
+    static ALWAYS_INLINE Group Load(u8 const* ctrl) { return {_mm_loadu_si128((__m128i const*)ctrl)}; }
+    ALWAYS_INLINE GroupMask Match(u8 h2) const {
+        return {(u64)(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char)h2), ctrl))};
+    }
+    ALWAYS_INLINE GroupMask MatchEmpty() const { return Match(k_ctrl_empty); }
+    ALWAYS_INLINE GroupMask MatchEmptyOrDeleted() const { return {(u64)(u32)_mm_movemask_epi8(ctrl)}; }
+
+    __m128i ctrl;
+#elif defined(__aarch64__)
+    static ALWAYS_INLINE Group Load(u8 const* ctrl) { return {vld1q_u8(ctrl)}; }
+    static ALWAYS_INLINE GroupMask Narrow(uint8x16_t matches) {
+        auto const nibbles = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+        return {vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull};
+    }
+    ALWAYS_INLINE GroupMask Match(u8 h2) const { return Narrow(vceqq_u8(ctrl, vdupq_n_u8(h2))); }
+    ALWAYS_INLINE GroupMask MatchEmpty() const { return Match(k_ctrl_empty); }
+    ALWAYS_INLINE GroupMask MatchEmptyOrDeleted() const {
+        return Narrow(vcltzq_s8(vreinterpretq_s8_u8(ctrl)));
+    }
+
+    uint8x16_t ctrl;
+#else
+    static Group Load(u8 const* ctrl) {
+        Group g;
+        __builtin_memcpy(g.ctrl, ctrl, k_group_size);
+        return g;
+    }
+    GroupMask Match(u8 h2) const {
+        u64 bits = 0;
+        for (usize i = 0; i < k_group_size; ++i)
+            if (ctrl[i] == h2) bits |= 1ull << i;
+        return {bits};
+    }
+    GroupMask MatchEmpty() const { return Match(k_ctrl_empty); }
+    GroupMask MatchEmptyOrDeleted() const {
+        u64 bits = 0;
+        for (usize i = 0; i < k_group_size; ++i)
+            if (!IsFull(ctrl[i])) bits |= 1ull << i;
+        return {bits};
+    }
+
+    u8 ctrl[k_group_size];
+#endif
+};
+
+} // namespace grouped_hash_table
+
+template <TriviallyCopyable KeyType_,
+          TriviallyCopyableOrDummy ValueType_,
+          HashFunction<KeyType_> k_hash_function_ = nullptr,
+          HashTableOrdering k_ordering_ = HashTableOrdering::Unordered,
+          LessThanFunction<KeyType_, ValueType_> k_less_than_function = nullptr>
+struct GroupedHashTable {
+    using KeyType = KeyType_;
+    using ValueType = ValueType_;
+    static constexpr HashFunction<KeyType> k_hash_function = k_hash_function_;
+    static constexpr HashTableOrdering k_ordering = k_ordering_;
+    static constexpr bool k_has_values = !Same<DummyValueType, ValueType>;
+    static constexpr usize k_group_size = grouped_hash_table::k_group_size;
+
+    struct KeyRef {
+        KeyType const& key;
+        u64 hash;
+    };
+    struct KeyValueRef {
+        KeyType const& key;
+        ValueType& data;
+        u64 hash;
+    };
+    using ElementRef = Conditional<k_has_values, KeyValueRef, KeyRef>;
+
+    struct FindOrInsertResult {
+        ElementRef element;
+        bool inserted;
+    };
+
+    struct Iterator {
+        friend bool operator==(Iterator const& a, Iterator const& b) {
+            return &a.table == &b.table && a.index == b.index;
+        }
+        friend bool operator!=(Iterator const& a, Iterator const& b) {
+            return &a.table != &b.table || a.index != b.index;
+        }
+        friend bool operator<(Iterator const& a, Iterator const& b) {
+            ASSERT(&a.table == &b.table);
+            return a.index < b.index;
+        }
+        auto operator*() const {
+            usize slot;
+            if constexpr (k_ordering == HashTableOrdering::Unordered)
+                slot = index;
+            else
+                slot = table.order_indices[index];
+            ASSERT_HOT(grouped_hash_table::IsFull(table.ctrl[slot]));
+
+            if constexpr (!k_has_values) {
+                struct Item {
+                    KeyType const& key;
+                    u64 hash;
+                };
+                return Item {.key = table.keys[slot], .hash = table.hashes[slot]};
+            } else {
+                struct Item {
+                    KeyType const& key;
+                    ValueType& value;
+                    u64 hash;
+                };
+                return Item {
+                    .key = table.keys[slot],
+                    .value = table.values[slot],
+                    .hash = table.hashes[slot],
+                };
+            }
+        }
+        Iterator& operator++() {
+            ++index;
+            if constexpr (k_ordering == HashTableOrdering::Unordered)
+                for (; index < table.Capacity(); ++index)
+                    if (grouped_hash_table::IsFull(table.ctrl[index])) break;
+            return *this;
+        }
+        Iterator& operator--() {
+            static_assert(UnsignedInt<decltype(index)>, "we rely on wrap-around");
+            --index;
+            if constexpr (k_ordering == HashTableOrdering::Unordered)
+                for (; index < table.Capacity(); --index)
+                    if (grouped_hash_table::IsFull(table.ctrl[index])) break;
+            return *this;
+        }
+
+        GroupedHashTable const& table;
+        usize index {};
+    };
+
+    // Same rules as HashTable::Hash.
+    static u64 Hash(KeyType k) {
+        u64 result;
+        if constexpr (k_hash_function == nullptr)
+            if constexpr (requires { k.Hash(); })
+                result = k.Hash();
+            else
+                result = ::Hash(k);
+        else
+            result = k_hash_function(k);
+
+        // 0 means 'calculate it for me' in the functions below.
+        ASSERT_HOT(result != 0);
+        return result;
+    }
+
+    // The probe position comes from the low bits of the hash, as in HashTable, so that keys hashed with
+    // NoHash stay spread out. The control byte comes from the top bits after mixing, so that those same keys
+    // don't all share one.
+    static ALWAYS_INLINE u8 H2(u64 hash) { return (u8)((hash * 0x9e3779b97f4a7c15ull) >> 57); }
+
+    static constexpr usize CapacityForCount(usize count) {
+        // We consider more than 7/8 full too full.
+        return Max(k_group_size, NextPowerOf2(count + (count / 7) + 1));
+    }
+
+    [[nodiscard]] static GroupedHashTable Create(Allocator& a, usize size) {
+        GroupedHashTable table {};
+        table.Reserve(a, size);
+        return table;
+    }
+
+    usize Capacity() const { return ctrl ? mask + 1 : 0; }
+
+    bool LoadFactorTooHigh(usize extra = 0) const {
+        return (size + num_deleted + extra) > (Capacity() - (Capacity() / 8));
+    }
+
+    // Quadratic probing, a group at a time. Groups are read unaligned, so the first k_group_size control
+    // bytes are mirrored after the last one.
+    template <typename Function>
+    ALWAYS_INLINE void Probe(u64 hash, Function&& f) const {
+        auto pos = (usize)hash & mask;
+        usize step = 0;
+        while (true) {
+            if (f(pos, grouped_hash_table::Group::Load(ctrl + pos))) return;
+            step += k_group_size;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    Optional<usize> FindIndex(KeyType key, u64 hash = 0) const {
+        if (!ctrl) return k_nullopt;
+        if (!hash) hash = Hash(key);
+        auto const h2 = H2(hash);
+        Optional<usize> result {};
+        Probe(hash, [&](usize pos, grouped_hash_table::Group group) {
+            for (auto m = group.Match(h2); m; m.ClearLowest()) {
+                auto const index = (pos + m.LowestIndex()) & mask;
+                if (hashes[index] == hash && keys[index] == key) {
+                    result = index;
+                    return true;
+                }
+            }
+            return (bool)group.MatchEmpty();
+        });
+        return result;
+    }
+
+    bool Contains(KeyType key, u64 hash = 0) const { return FindIndex(key, hash).HasValue(); }
+
+    // Finds an element but doesn't protect against hash collisions.
+    bool ContainsSkipKeyCheck(u64 hash) const {
+        ASSERT(hash);
+        if (!ctrl) return false;
+        auto const h2 = H2(hash);
+        bool result = false;
+        Probe(hash, [&](usize pos, grouped_hash_table::Group group) {
+            for (auto m = group.Match(h2); m; m.ClearLowest()) {
+                if (hashes[(pos + m.LowestIndex()) & mask] == hash) {
+                    result = true;
+                    return true;
+                }
+            }
+            return (bool)group.MatchEmpty();
+        });
+        return result;
+    }
+
+    ValueType* Find(KeyType key, u64 hash = 0) const
+    requires(k_has_values)
+    {
+        auto const index = FindIndex(key, hash);
+        if (!index) return nullptr;
+        return &values[*index];
+    }
+
+    ElementRef ElementAt(usize index) const {
+        ASSERT_HOT(grouped_hash_table::IsFull(ctrl[index]));
+        if constexpr (k_has_values)
+            return {.key = keys[index], .data = values[index], .hash = hashes[index]};
+        else
+            return {.key = keys[index], .hash = hashes[index]};
+    }
+
+    void SetCtrl(usize index, u8 value) {
+        ctrl[index] = value;
+        if (index < k_group_size) ctrl[Capacity() + index] = value;
+    }
+
+    void DeleteIndex(usize index) {
+        using namespace grouped_hash_table;
+        ASSERT_HOT(IsFull(ctrl[index]));
+        RemoveFromOrderedIndicesIfNeeded(index);
+        --size;
+
+        // If every group that covers this slot also has an empty slot, no probe has ever gone past it, so it
+        // can be empty rather than a tombstone.
+        auto const empty_before = Group::Load(ctrl + ((index - k_group_size) & mask)).MatchEmpty();
+        auto const empty_after = Group::Load(ctrl + index).MatchEmpty();
+        if (empty_after.UnmatchedAtStart() + empty_before.UnmatchedAtEnd() < k_group_size) {
+            SetCtrl(index, k_ctrl_empty);
+        } else {
+            SetCtrl(index, k_ctrl_deleted);
+            ++num_deleted;
+        }
+    }
+
+    bool Delete(KeyType key) {
+        auto const index = FindIndex(key);
+        if (!index) return false;
+        DeleteIndex(*index);
+        return true;
+    }
+
+    void DeleteAll() {
+        if (ctrl) FillMemory(ctrl, grouped_hash_table::k_ctrl_empty, Capacity() + k_group_size);
+        size = 0;
+        num_deleted = 0;
+    }
+
+    void Free(Allocator& a) {
+        if (auto const capacity = Capacity()) {
+            a.Free(Span {ctrl, capacity + k_group_size}.ToByteSpan());
+            a.Free(Span {hashes, capacity}.ToByteSpan());
+            a.Free(Span {keys, capacity}.ToByteSpan());
+            if constexpr (k_has_values) a.Free(Span {values, capacity}.ToByteSpan());
+            if constexpr (k_ordering == HashTableOrdering::Ordered)
+                a.Free(Span {order_indices, capacity}.ToByteSpan());
+        }
+        *this = {};
+    }
+
+    // Reserves space for at least 'count' elements. Rehashes the container, which also clears out
+    // tombstones. Allocator must be the same as previously used on this table.
+    void Reserve(Allocator& allocator, usize count) {
+        auto old = *this;
+        auto const capacity = CapacityForCount(Max(count, size));
+
+        ctrl = allocator.template AllocateExactSizeUninitialised<u8>(capacity + k_group_size).data;
+        FillMemory(ctrl, grouped_hash_table::k_ctrl_empty, capacity + k_group_size);
+        hashes = allocator.template AllocateExactSizeUninitialised<u64>(capacity).data;
+        keys = allocator.template AllocateExactSizeUninitialised<KeyType>(capacity).data;
+        if constexpr (k_has_values)
+            values = allocator.template AllocateExactSizeUninitialised<ValueType>(capacity).data;
+        if constexpr (k_ordering == HashTableOrdering::Ordered)
+            order_indices = allocator.template AllocateExactSizeUninitialised<usize>(capacity).data;
+        mask = capacity - 1;
+        size = 0;
+        num_deleted = 0;
+
+        auto move_from_old = [&](usize old_index) {
+            auto const index = InsertSlot(old.hashes[old_index]);
+            SetCtrl(index, old.ctrl[old_index]);
+            hashes[index] = old.hashes[old_index];
+            keys[index] = old.keys[old_index];
+            if constexpr (k_has_values) values[index] = old.values[old_index];
+            ++size;
+            return index;
+        };
+
+        // The order doesn't change, so there's no need to sort it again.
+        if constexpr (k_ordering == HashTableOrdering::Ordered) {
+            for (auto const i : Range(old.size))
+                order_indices[i] = move_from_old(old.order_indices[i]);
+        } else {
+            for (auto const i : Range(old.Capacity()))
+                if (grouped_hash_table::IsFull(old.ctrl[i])) move_from_old(i);
+        }
+
+        old.Free(allocator);
+    }
+
+    // The first free slot in the probe sequence. There must be room.
+    usize InsertSlot(u64 hash) const {
+        usize result = 0;
+        Probe(hash, [&](usize pos, grouped_hash_table::Group group) {
+            if (auto const m = group.MatchEmptyOrDeleted()) {
+                result = (pos + m.LowestIndex()) & mask;
+                return true;
+            }
+            return false;
+        });
+        return result;
+    }
+
+    // The key must not already be in the table and there must be room.
+    usize InsertNew(KeyType key, ValueType value, u64 hash) {
+        auto const index = InsertSlot(hash);
+        if (ctrl[index] == grouped_hash_table::k_ctrl_deleted) --num_deleted;
+        SetCtrl(index, H2(hash));
+        hashes[index] = hash;
+        keys[index] = key;
+        if constexpr (k_has_values) values[index] = value;
+        AddToOrderedIndicesIfNeeded(index);
+        ++size;
+        return index;
+    }
+
+    void MakeRoomForOneMore(Allocator& allocator) {
+        if (!ctrl)
+            Reserve(allocator, 0);
+        else if (LoadFactorTooHigh(1))
+            // Rehash in place if it's mostly tombstones, otherwise grow.
+            Reserve(allocator, num_deleted > size ? size + 1 : (size + 1) * 2);
+    }
+
+    bool InsertWithoutGrowing(KeyType key, ValueType value, u64 hash = 0) {
+        if (!ctrl) {
+            PanicIfReached();
+            return false;
+        }
+        if (!hash) hash = Hash(key);
+        if (FindIndex(key, hash)) return false; // Already exists.
+        if (LoadFactorTooHigh(1)) {
+            PanicIfReached();
+            return false; // Too full.
+        }
+        InsertNew(key, value, hash);
+        return true;
+    }
+
+    // The allocator must be the same as used before on with this table.
+    bool InsertGrowIfNeeded(Allocator& allocator, KeyType key, ValueType value, u64 hash = 0) {
+        if (!hash) hash = Hash(key);
+        if (FindIndex(key, hash)) return false; // Already exists.
+        MakeRoomForOneMore(allocator);
+        InsertNew(key, value, hash);
+        return true;
+    }
+
+    FindOrInsertResult FindOrInsertWithoutGrowing(KeyType key, ValueType value, u64 hash = 0) {
+        if (!ctrl) PanicIfReached(); // Not initialized.
+        if (!hash) hash = Hash(key);
+        if (auto const index = FindIndex(key, hash)) return {.element = ElementAt(*index), .inserted = false};
+        if (LoadFactorTooHigh(1)) PanicIfReached(); // Too full.
+        return {.element = ElementAt(InsertNew(key, value, hash)), .inserted = true};
+    }
+
+    FindOrInsertResult
+    FindOrInsertGrowIfNeeded(Allocator& allocator, KeyType key, ValueType value, u64 hash = 0) {
+        if (!hash) hash = Hash(key);
+        if (auto const index = FindIndex(key, hash)) return {.element = ElementAt(*index), .inserted = false};
+        MakeRoomForOneMore(allocator);
+        return {.element = ElementAt(InsertNew(key, value, hash)), .inserted = true};
+    }
+
+    Iterator begin() const {
+        if (!size) return end();
+        if constexpr (k_ordering == HashTableOrdering::Unordered) {
+            for (usize index = 0; index < Capacity(); ++index)
+                if (grouped_hash_table::IsFull(ctrl[index])) return Iterator {*this, index};
+            return end();
+        } else {
+            return Iterator {*this, 0};
+        }
+    }
+    Iterator end() const {
+        if constexpr (k_ordering == HashTableOrdering::Unordered)
+            return Iterator {*this, Capacity()};
+        else
+            return Iterator {*this, size};
+    }
+
+    void Assign(GroupedHashTable const& other, Allocator& allocator) {
+        if (this == &other) return;
+
+        Free(allocator);
+        if (!other.ctrl) return;
+
+        auto const capacity = other.Capacity();
+        *this = other;
+        ctrl = allocator.Clone(Span {other.ctrl, capacity + k_group_size}).data;
+        hashes = allocator.Clone(Span {other.hashes, capacity}).data;
+        keys = allocator.Clone(Span {other.keys, capacity}).data;
+        if constexpr (k_has_values) values = allocator.Clone(Span {other.values, capacity}).data;
+        if constexpr (k_ordering == HashTableOrdering::Ordered)
+            order_indices = allocator.Clone(Span {other.order_indices, capacity}).data;
+    }
+
+    // Takes another table and intersects it with this one: only elements that are present in both tables
+    // will remain.
+    void IntersectWith(GroupedHashTable const& other) {
+        if (!ctrl) return;
+        for (auto const i : Range(Capacity()))
+            if (grouped_hash_table::IsFull(ctrl[i]) && !other.FindIndex(keys[i], hashes[i])) DeleteIndex(i);
+    }
+
+    template <typename PredicateType>
+    usize RemoveIf(PredicateType&& should_remove) {
+        if (!ctrl) return 0;
+
+        usize num_removed = 0;
+        for (auto const i : Range(Capacity())) {
+            if (!grouped_hash_table::IsFull(ctrl[i])) continue;
+            bool remove;
+            if constexpr (k_has_values)
+                remove = should_remove(keys[i], values[i]);
+            else
+                remove = should_remove(keys[i], DummyValueType {});
+            if (remove) {
+                DeleteIndex(i);
+                ++num_removed;
+            }
+        }
+        return num_removed;
+    }
+
+    void RemoveFromOrderedIndicesIfNeeded(usize slot) {
+        if constexpr (k_ordering == HashTableOrdering::Ordered) {
+            bool found = false;
+            for (usize i = 0; i < size; ++i) {
+                if (order_indices[i] == slot) {
+                    for (usize j = i; j < size - 1; ++j)
+                        order_indices[j] = order_indices[j + 1];
+                    found = true;
+                    break;
+                }
+            }
+            ASSERT_HOT(found);
+        }
+    }
+
+    void AddToOrderedIndicesIfNeeded(usize slot) {
+        if constexpr (k_ordering == HashTableOrdering::Ordered) {
+            auto items = Span {order_indices, size};
+            auto const insert_index = BinarySearchForSlotToInsert(items, [&](usize other_slot) {
+                if constexpr (k_less_than_function != nullptr) {
+                    if (k_less_than_function(keys[other_slot],
+                                             ValueRef(other_slot),
+                                             keys[slot],
+                                             ValueRef(slot)))
+                        return -1;
+                } else if (keys[other_slot] < keys[slot]) {
+                    return -1;
+                }
+                // Keys are unique in a hash table, so we don't need to check for equality.
+                return 1;
+            });
+            MakeRoomForInsertion(items, insert_index, 1); // This increases the size by 1.
+            items[insert_index] = slot;
+        }
+    }
+
+    ValueType const& ValueRef(usize slot) const {
+        if constexpr (k_has_values) {
+            return values[slot];
+        } else {
+            static constexpr DummyValueType k_dummy {};
+            return k_dummy;
+        }
+    }
+
+    u8* ctrl {}; // Capacity() + k_group_size, the last k_group_size mirror the first.
+    u64* hashes {};
+    KeyType* keys {};
+    [[no_unique_address]] Conditional<k_has_values, ValueType*, DummyValueType> values {};
+    usize mask {};
+    usize size {};
+    usize num_deleted {};
+
+    // Indices of slots, in order. Same capacity as the other arrays, size elements are used.
+    [[no_unique_address]] Conditional<k_ordering == HashTableOrdering::Ordered, usize*, DummyValueType>
+        order_indices {};
+};
+
+template <TriviallyCopyable KeyType_,
+          TriviallyCopyableOrDummy ValueType_,
+          HashFunction<KeyType_> k_hash_function_ = nullptr,
+          HashTableOrdering k_ordering_ = HashTableOrdering::Unordered,
+          LessThanFunction<KeyType_, ValueType_> k_less_than_function = nullptr>
+struct DynamicGroupedHashTable {
+    using KeyType = KeyType_;
+    using ValueType = ValueType_;
+    using Table = GroupedHashTable<KeyType, ValueType, k_hash_function_, k_ordering_, k_less_than_function>;
+
+    DynamicGroupedHashTable(Allocator& alloc, usize reserve_count = 0) : allocator(alloc) {
+        if (reserve_count) Reserve(reserve_count);
+    }
+
+    ~DynamicGroupedHashTable() { Free(); }
+
+    DynamicGroupedHashTable(DynamicGroupedHashTable&& other)
+        : allocator(other.allocator)
+        , table(other.table) {
+        other.table = {};
+    }
+
+    DynamicGroupedHashTable& operator=(DynamicGroupedHashTable&& other) {
+        Free();
+
+        if (&other.allocator == &allocator) {
+            table = other.table;
+        } else {
+            table.Assign(other.table, allocator);
+            other.Free();
+        }
+
+        other.table = {};
+
+        return *this;
+    }
+
+    NON_COPYABLE(DynamicGroupedHashTable);
+
+    void Free() { table.Free(allocator); }
+
+    void Reserve(usize count) { table.Reserve(allocator, count); }
+
+    ValueType* Find(KeyType key) const
+    requires(Table::k_has_values)
+    {
+        return table.Find(key);
+    }
+    Optional<usize> FindIndex(KeyType key) const { return table.FindIndex(key); }
+
+    bool Delete(KeyType key) { return table.Delete(key); }
+    void DeleteIndex(usize i) { table.DeleteIndex(i); }
+    void DeleteAll() { table.DeleteAll(); }
+
+    template <typename PredicateType>
+    usize RemoveIf(PredicateType&& should_remove) {
+        return table.RemoveIf(Forward<PredicateType>(should_remove));
+    }
+
+    void Assign(Table const& other) { table.Assign(other, allocator); }
+
+    auto Insert(KeyType key, ValueType value, u64 hash = 0) {
+        return table.InsertGrowIfNeeded(allocator, key, value, hash);
+    }
+    Table::FindOrInsertResult FindOrInsert(KeyType key, ValueType value, u64 hash = 0) {
+        return table.FindOrInsertGrowIfNeeded(allocator, key, value, hash);
+    }
+    bool Contains(KeyType key, u64 hash = 0) const { return table.Contains(key, hash); }
+
+    auto begin() const { return table.begin(); }
+    auto end() const { return table.end(); }
+
+    operator Table() const { return this->table; }
+
+    Allocator& allocator;
+    Table table {};
+};
+
+// Ordered versions
+template <TriviallyCopyable KeyType,
+          TriviallyCopyableOrDummy ValueType,
+          HashFunction<KeyType> k_hash_function = nullptr,
+          LessThanFunction<KeyType, ValueType> k_less_than_function = nullptr>
+using OrderedGroupedHashTable =
+    GroupedHashTable<KeyType, ValueType, k_hash_function, HashTableOrdering::Ordered, k_less_than_function>;
+
+template <TriviallyCopyable KeyType,
+          TriviallyCopyableOrDummy ValueType,
+          HashFunction<KeyType> k_hash_function = nullptr,
+          LessThanFunction<KeyType, ValueType> k_less_than_function = nullptr>
+using DynamicOrderedGroupedHashTable = DynamicGroupedHashTable<KeyType,
+                                                               ValueType,
+                                                               k_hash_function,
+                                                               HashTableOrdering::Ordered,
+                                                               k_less_than_function>;
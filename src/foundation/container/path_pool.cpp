@@ -1,6 +1,7 @@
 // Copyright 2025-2026 Sam Windell
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include "benchmarks/framework.hpp"
 #include "tests/framework.hpp"
 
 TEST_CASE(TestPathPool) {
@@ -21,8 +22,72 @@ TEST_CASE(TestPathPool) {
         for (auto p : paths)
             pool.Free(p);
 
-        CHECK(pool.used_list == nullptr);
-        CHECK(pool.free_list != nullptr);
+        CHECK_EQ(pool.NumUsed(), 0uz);
+        CHECK(FindIf(pool.free_lists, [](PathPool::Path* p) { return p != nullptr; }).HasValue());
+    }
+
+    SUBCASE("prefixes are separate strings") {
+        auto const abcde = pool.Clone("abcde", a);
+        auto const abc = pool.Clone("abc", a);
+        auto const ab = pool.Clone("ab", a);
+        CHECK(abcde.data != abc.data);
+        CHECK(abc.data != ab.data);
+        CHECK_EQ(pool.NumUsed(), 3uz);
+
+        // Freeing the longer string mustn't affect its prefixes.
+        pool.Free(abcde);
+        CHECK_EQ(abc, "abc"_s);
+        CHECK_EQ(ab, "ab"_s);
+
+        // Reusing the freed buffer for a different string mustn't either.
+        auto const xyz = pool.Clone("xyz", a);
+        CHECK_EQ(xyz, "xyz"_s);
+        CHECK_EQ(abc, "abc"_s);
+        CHECK_EQ(ab, "ab"_s);
+
+        // A string that is a prefix of one in the pool is not a match for it.
+        auto const abcd = pool.Clone("abcd", a);
+        CHECK(abcd.data != abc.data);
+        CHECK_EQ(abcd, "abcd"_s);
+    }
+
+    SUBCASE("identical strings share a buffer") {
+        auto const p1 = pool.Clone("path/to/file", a);
+        auto const p2 = pool.Clone("path/to/file", a);
+        CHECK(p1.data == p2.data);
+        CHECK_EQ(pool.NumUsed(), 1uz);
+
+        pool.Free(p1);
+        CHECK_EQ(pool.NumUsed(), 1uz);
+        CHECK_EQ(p2, "path/to/file"_s);
+        pool.Free(p2);
+        CHECK_EQ(pool.NumUsed(), 0uz);
+    }
+
+    SUBCASE("freeing a string that isn't from the pool") {
+        auto const p = pool.Clone("foo", a);
+        pool.Free("foo"_s);
+        pool.Free("bar"_s);
+        CHECK_EQ(pool.NumUsed(), 1uz);
+        CHECK_EQ(p, "foo"_s);
+    }
+
+    SUBCASE("buffers are reused by size class") {
+        auto const small = pool.Clone("small", a);
+        pool.Free(small);
+        auto const other = pool.Clone("other", a);
+        CHECK(other.data == small.data);
+
+        auto long_string = a.AllocateExactSizeUninitialised<char>(200);
+        for (auto& c : long_string)
+            c = 'x';
+        auto const big = pool.Clone((String)long_string, a);
+        CHECK(big.data != small.data);
+        pool.Free(big);
+
+        // A short string can use a larger free buffer.
+        auto const reused = pool.Clone("short", a);
+        CHECK(reused.data == big.data);
     }
 
     SUBCASE("very long string") {
@@ -44,12 +109,12 @@ TEST_CASE(TestPathPoolFreeListReuseRefCounting) {
     auto const s1 = pool.Clone("hello_world"_s, arena);
     pool.Free(s1);
 
-    // Reuse from free_list, then clone again via StartsWithSpan match.
+    // Reuse from a free list, then clone again via the existing entry.
     auto const s2 = pool.Clone("hello_world"_s, arena);
     auto const s3 = pool.Clone("hello_world"_s, arena);
     pool.Free(s3);
 
-    // s2 should still be valid; the entry must not have been moved back to the free_list.
+    // s2 should still be valid; the entry must not have been moved back to a free list.
     pool.Clone("goodbye_wor"_s, arena);
     CHECK_EQ(s2, "hello_world"_s);
 
@@ -60,3 +125,34 @@ TEST_REGISTRATION(RegisterPathPoolTests) {
     REGISTER_TEST(TestPathPool);
     REGISTER_TEST(TestPathPoolFreeListReuseRefCounting);
 }
+
+// Similar to what scanning a large library folder does: lots of paths with long shared prefixes, some
+// cloned more than once, and a portion freed and replaced.
+BENCHMARK_FN void BenchmarkPathPoolIntern100k() {
+    ArenaAllocator arena {PageAllocator::Instance()};
+    constexpr usize k_num_paths = 100'000;
+
+    auto paths = arena.AllocateExactSizeUninitialised<String>(k_num_paths);
+    for (auto const i : Range(k_num_paths))
+        paths[i] = fmt::Format(arena,
+                               "/home/user/Libraries/Folder {}/Subfolder {}/sample-{}.flac",
+                               i / 1000,
+                               (i / 10) % 100,
+                               i);
+
+    for (usize round = 0; round < 5; ++round) {
+        PathPool pool {};
+        auto cloned = arena.AllocateExactSizeUninitialised<String>(k_num_paths);
+        for (auto const i : Range(k_num_paths))
+            cloned[i] = pool.Clone(paths[i], arena);
+        for (usize i = 0; i < k_num_paths; i += 4)
+            pool.Clone(paths[i], arena);
+        for (usize i = 0; i < k_num_paths; i += 2)
+            pool.Free(cloned[i]);
+        for (usize i = 0; i < k_num_paths; i += 2)
+            cloned[i] = pool.Clone(paths[i], arena);
+        benchmarks::DoNotOptimise(cloned);
+    }
+}
+
+BENCHMARK_REGISTRATION(RegisterPathPoolBenchmarks) { REGISTER_BENCHMARK(BenchmarkPathPoolIntern100k); }
@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #pragma once
+#include "foundation/container/array.hpp"
+#include "foundation/container/grouped_hash_table.hpp"
 #include "foundation/memory/allocators.hpp"
 #include "foundation/utils/linked_list.hpp"
 
@@ -10,62 +12,69 @@
 // Makes string allocations reusable within an arena. The lifetime is managed by the arena, but you can
 // (optionally) Clone/Free individual strings within that lifetime to avoid lots of reallocations. It avoids
 // having make everything RAII ready (std C++ style).
+//
+// Strings are interned: cloning a string that's already in the pool returns the same buffer and bumps its
+// reference count. Lookups are by hash and exact match, so cloning and freeing cost the same however many
+// strings are in the pool. Freed buffers go onto a free list for their size class (buffers are a power of 2
+// in size), ready for the next string that fits.
 struct PathPool {
     struct Path {
         MutableString buffer;
         u32 buffer_refs {};
-        Path* next {};
+        Path* next {}; // Only used when in a free list.
     };
 
+    static constexpr usize k_num_size_classes = sizeof(usize) * 8;
+
+    static u32 SizeClass(usize buffer_size) { return (u32)__builtin_ctzg(NextPowerOf2(buffer_size)); }
+
+    // The allocator must be the same each time: the pool's index is allocated from it too.
     String Clone(String p, Allocator& arena, usize min_size = 64) {
-        for (auto i = used_list; i != nullptr; i = i->next) {
-            if (StartsWithSpan(i->buffer, p)) {
-                ++i->buffer_refs;
-                return {i->buffer.data, p.size};
-            }
+        auto const hash = decltype(used)::Hash(p);
+        if (auto const existing = used.Find(p, hash)) {
+            ++(*existing)->buffer_refs;
+            return {(*existing)->buffer.data, p.size};
         }
 
-        {
-            Path* prev_free = nullptr;
-            for (auto free = free_list; free != nullptr; free = free->next) {
-                // if we find a free path that is big enough, use it
-                if (free->buffer.size >= p.size) {
-                    SinglyLinkedListRemove(free_list, free, prev_free);
-                    SinglyLinkedListPrepend(used_list, free);
+        Path* path = nullptr;
 
-                    free->buffer_refs = 1;
-                    CopyMemory(free->buffer.data, p.data, p.size);
-                    return {free->buffer.data, p.size};
-                }
-                prev_free = free;
+        // Any buffer in the size class that could hold p, or a larger one, will do.
+        for (auto size_class = SizeClass(Max(p.size, 1uz)); size_class < k_num_size_classes; ++size_class) {
+            if (free_lists[size_class]) {
+                path = SinglyLinkedListPop(free_lists[size_class]);
+                break;
             }
         }
 
-        auto new_path = arena.NewUninitialised<Path>();
-        new_path->buffer = arena.AllocateExactSizeUninitialised<char>(Max(p.size, min_size));
-        new_path->buffer_refs = 1;
-        CopyMemory(new_path->buffer.data, p.data, p.size);
-        if (new_path->buffer.size != p.size)
-            ZeroMemory(new_path->buffer.data + p.size, new_path->buffer.size - p.size);
-        SinglyLinkedListPrepend(used_list, new_path);
-        return {new_path->buffer.data, p.size};
+        if (!path) {
+            path = arena.NewUninitialised<Path>();
+            path->buffer = arena.AllocateExactSizeUninitialised<char>(NextPowerOf2(Max(p.size, min_size)));
+            path->next = nullptr;
+        }
+
+        path->buffer_refs = 1;
+        CopyMemory(path->buffer.data, p.data, p.size);
+        if (path->buffer.size != p.size) ZeroMemory(path->buffer.data + p.size, path->buffer.size - p.size);
+
+        String const result {path->buffer.data, p.size};
+        used.InsertGrowIfNeeded(arena, result, path, hash);
+        return result;
     }
 
     // It is ok if the string is not in the pool.
     void Free(String p) {
-        Path* prev = nullptr;
-        for (auto i = used_list; i != nullptr; i = i->next) {
-            if (i->buffer.data == p.data) {
-                if (--i->buffer_refs == 0) {
-                    SinglyLinkedListRemove(used_list, i, prev);
-                    SinglyLinkedListPrepend(free_list, i);
-                }
-                return;
-            }
-            prev = i;
+        auto const index = used.FindIndex(p);
+        if (!index) return;
+        auto path = used.values[*index];
+        if (path->buffer.data != p.data) return; // Same text, but not from this pool.
+        if (--path->buffer_refs == 0) {
+            used.DeleteIndex(*index);
+            SinglyLinkedListPrepend(free_lists[SizeClass(path->buffer.size)], path);
         }
     }
 
-    Path* used_list {};
-    Path* free_list {};
+    usize NumUsed() const { return used.size; }
+
+    GroupedHashTable<String, Path*> used {};
+    Array<Path*, k_num_size_classes> free_lists {};
 };
@@ -29,6 +29,7 @@
 #include "container/dynamic_array.hpp" // IWYU pragma: export
 #include "container/function.hpp" // IWYU pragma: export
 #include "container/function_queue.hpp" // IWYU pragma: export
+#include "container/grouped_hash_table.hpp" // IWYU pragma: export
 #include "container/hash_table.hpp" // IWYU pragma: export
 #include "container/optional.hpp" // IWYU pragma: export
 #include "container/pair.hpp" // IWYU pragma: export
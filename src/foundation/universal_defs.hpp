@@ -270,6 +270,15 @@ __attribute__((always_inline)) inline bool Any(VecType x) {
     return false;
 }
 
+// Per-element choice: a where mask is set, b where it isn't. mask is the result of a vector comparison, so
+// each element is all ones or all zeros.
+template <Vector VecType, Vector MaskType>
+__attribute__((always_inline)) inline VecType Select(MaskType mask, VecType a, VecType b) {
+    static_assert(sizeof(MaskType) == sizeof(VecType));
+    auto const bits = (mask & __builtin_bit_cast(MaskType, a)) | (~mask & __builtin_bit_cast(MaskType, b));
+    return __builtin_bit_cast(VecType, bits);
+}
+
 // Template helpers
 // ================================================================================================
 // This section contains code from SerenityOS's file: serenity/AK/StdLibExtraDetails.h
@@ -151,7 +151,7 @@ static ErrorCodeOr<int> Main(ArgsCstr args) {
 
         if (lib->create_file_reader) {
             for (auto const item : referenced_paths) {
-                auto r = lib->create_file_reader(*lib, sample_lib::LibraryPath {item.key});
+                auto r = lib->create_file_reader(*lib, sample_lib::LibraryPath {item.key}, {});
                 if (r.HasError()) dyn::Append(missing, item.key);
             }
         }
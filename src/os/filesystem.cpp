@@ -366,6 +366,29 @@ File::~File() {
     handle = File::k_invalid_file_handle;
 }
 
+ErrorCodeOr<File> OpenFileAndLockExclusive(String filename, FileMode mode) {
+    FileMode const check_mode {
+        .capability = FileMode::Capability::Read,
+        .win32_share = mode.win32_share,
+        .creation = FileMode::Creation::OpenExisting,
+    };
+
+    constexpr u32 k_max_attempts = 10;
+    for (u32 attempt = 0; attempt < k_max_attempts; ++attempt) {
+        auto file = TRY(OpenFile(filename, mode));
+        TRY(file.Lock({.type = FileLockOptions::Type::Exclusive}));
+        auto const locked_identity = TRY(file.Identity());
+
+        if (auto current = OpenFile(filename, check_mode); current.HasValue()) {
+            auto const current_identity = current.Value().Identity();
+            if (current_identity.HasValue() && current_identity.Value() == locked_identity) return file;
+        }
+
+        TRY(file.Unlock());
+    }
+    return ErrorCode {FilesystemError::FilesystemBusy};
+}
+
 ErrorCodeOr<usize> WriteFile(String filename, Span<u8 const> data) {
     auto file = OpenFile(filename, FileMode::Write());
     if (file.HasError()) return file.Error();
@@ -926,6 +949,32 @@ TEST_CASE(TestFileApi) {
         CHECK_EQ(String(buffer, 2), k_data.SubSpan(2));
     }
 
+    SUBCASE("ReadAt doesn't use the file position") {
+        TRY(WriteFile(filename1, k_data.ToByteSpan()));
+        auto f = TRY(OpenFile(filename1, FileMode::Read()));
+        char buffer[4];
+        CHECK_EQ(TRY(f.ReadAt(1, buffer, 2)), 2u);
+        CHECK_EQ(String(buffer, 2), k_data.SubSpan(1, 2));
+        CHECK_EQ(TRY(f.ReadAt(2, buffer, 4)), 2u);
+        CHECK_EQ(String(buffer, 2), k_data.SubSpan(2));
+        CHECK_EQ(TRY(f.ReadAt(10, buffer, 4)), 0u);
+        if constexpr (!IS_WINDOWS) CHECK_EQ(TRY(f.CurrentPosition()), 0u);
+    }
+
+    SUBCASE("Map a file") {
+        TRY(WriteFile(filename1, k_data.ToByteSpan()));
+        MappedFile mapping;
+        {
+            auto f = TRY(OpenFile(filename1, FileMode::Read()));
+            mapping = TRY(MapFile(f, k_data.size));
+        }
+        mapping.Advise(FileAccessPattern::Sequential);
+        CHECK_EQ(String((char const*)mapping.data.data, mapping.data.size), k_data);
+        auto moved = Move(mapping);
+        CHECK_EQ(mapping.data.size, 0u);
+        CHECK_EQ(moved.data.size, k_data.size);
+    }
+
     SUBCASE("Lock a file") {
         for (auto const type : Array {FileLockOptions::Type::Exclusive, FileLockOptions::Type::Shared}) {
             for (auto const non_blocking : Array {true, false}) {
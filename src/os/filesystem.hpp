@@ -139,6 +139,14 @@ struct FileLockOptions {
     bool non_blocking = false;
 };
 
+// Identifies a file regardless of its path: the device and inode on POSIX, the volume serial number and file
+// index on Windows.
+struct FileIdentity {
+    bool operator==(FileIdentity const&) const = default;
+    u64 device;
+    u64 inode;
+};
+
 // File is created with OpenFile()
 struct File {
 #if IS_WINDOWS
@@ -180,12 +188,18 @@ struct File {
     ErrorCodeOr<s128> LastModifiedTimeNsSinceEpoch();
     ErrorCodeOr<void> SetLastModifiedTimeNsSinceEpoch(s128 time);
 
+    ErrorCodeOr<FileIdentity> Identity();
+
     ErrorCodeOr<MutableString>
     ReadSectionOfFile(usize const bytes_offset_from_file_start, usize const size_in_bytes, Allocator& a);
     ErrorCodeOr<MutableString> ReadWholeFile(Allocator& a);
 
     ErrorCodeOr<usize> Read(void* data, usize num_bytes);
 
+    // Reads from the given offset without using the file position (pread), so multiple threads can read
+    // from the same File at once. On Windows the file position is still moved, but it's never used.
+    ErrorCodeOr<usize> ReadAt(u64 offset, void* data, usize num_bytes);
+
     ::Writer Writer() {
         ::Writer result;
         result.Set<File>(*this, [](File& f, Span<u8 const> bytes) -> ErrorCodeOr<void> {
@@ -221,6 +235,44 @@ struct File {
 };
 
 ErrorCodeOr<File> OpenFile(String filename, FileMode mode);
+
+// Opens the file and takes an exclusive lock on it. Another process might replace the file at the path, by
+// renaming a new one over it, while we're waiting for the lock. So once we have the lock we check that it's
+// still the file at the path, and try again if not. On Windows, mode must share DeleteRename so that the
+// replacing can happen.
+ErrorCodeOr<File> OpenFileAndLockExclusive(String filename, FileMode mode);
+
+enum class FileAccessPattern : u8 { Sequential, Random };
+
+// A read-only view of the whole of a file, created with MapFile(). It stays valid after the File is closed.
+// If another process truncates the file while it's mapped, reading past the new end crashes (SIGBUS on
+// POSIX), so only map files that we don't expect to change underneath us, such as sample library files.
+struct MappedFile {
+    MappedFile() = default;
+    MappedFile(MappedFile&& other) : data(other.data) { other.data = {}; }
+    MappedFile& operator=(MappedFile&& other) {
+        Unmap();
+        data = other.data;
+        other.data = {};
+        return *this;
+    }
+    MappedFile(MappedFile const& other) = delete;
+    MappedFile& operator=(MappedFile const& other) = delete;
+    ~MappedFile() { Unmap(); }
+
+    // Tells the OS how we're going to read the mapping (madvise). Sequential also asks for the whole file to
+    // be read ahead. These are just hints; they're ignored if unsupported.
+    void Advise(FileAccessPattern pattern);
+
+    Span<u8 const> data {};
+
+  private:
+    void Unmap();
+};
+
+// size must be the size of the file and not 0.
+ErrorCodeOr<MappedFile> MapFile(File& file, u64 size);
+
 ErrorCodeOr<MutableString> ReadEntireFile(String filename, Allocator& a);
 ErrorCodeOr<MutableString> ReadSectionOfFile(String filename,
                                              usize const bytes_offset_from_file_start,
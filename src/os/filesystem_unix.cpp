@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -176,6 +177,12 @@ ErrorCodeOr<void> File::SetLastModifiedTimeNsSinceEpoch(s128 ns_since_epoch) {
     return k_success;
 }
 
+ErrorCodeOr<FileIdentity> File::Identity() {
+    struct stat file_stat;
+    if (fstat(handle, &file_stat) != 0) return FilesystemErrnoErrorCode(errno, "fstat");
+    return FileIdentity {.device = (u64)file_stat.st_dev, .inode = (u64)file_stat.st_ino};
+}
+
 void File::CloseFile() {
     if (handle != -1) close(handle);
     handle = -1;
@@ -224,6 +231,38 @@ ErrorCodeOr<usize> File::Read(void* data, usize num_bytes) {
     return static_cast<usize>(num_read);
 }
 
+ErrorCodeOr<usize> File::ReadAt(u64 offset, void* data, usize num_bytes) {
+    auto const num_read = ::pread(handle, data, num_bytes, (off_t)offset);
+    if (num_read == -1) return FilesystemErrnoErrorCode(errno, "pread");
+    return static_cast<usize>(num_read);
+}
+
+ErrorCodeOr<MappedFile> MapFile(File& file, u64 size) {
+    ASSERT(size != 0);
+    auto const data = mmap(nullptr, (usize)size, PROT_READ, MAP_PRIVATE, file.handle, 0);
+    if (data == MAP_FAILED) return FilesystemErrnoErrorCode(errno, "mmap");
+    MappedFile result;
+    result.data = {(u8 const*)data, (usize)size};
+    return result;
+}
+
+void MappedFile::Advise(FileAccessPattern pattern) {
+    if (!data.size) return;
+    auto const address = (void*)data.data;
+    switch (pattern) {
+        case FileAccessPattern::Sequential:
+            madvise(address, data.size, MADV_SEQUENTIAL);
+            madvise(address, data.size, MADV_WILLNEED);
+            break;
+        case FileAccessPattern::Random: madvise(address, data.size, MADV_RANDOM); break;
+    }
+}
+
+void MappedFile::Unmap() {
+    if (data.size) munmap((void*)data.data, data.size);
+    data = {};
+}
+
 ErrorCodeOr<u64> File::FileSize() {
     TRY(Seek(0, SeekOrigin::End));
     auto const size = CurrentPosition();
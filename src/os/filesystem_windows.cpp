@@ -111,6 +111,16 @@ ErrorCodeOr<void> File::SetLastModifiedTimeNsSinceEpoch(s128 time) {
     return k_success;
 }
 
+ErrorCodeOr<FileIdentity> File::Identity() {
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(handle, &info))
+        return FilesystemWin32ErrorCode(GetLastError(), "GetFileInformationByHandle");
+    return FileIdentity {
+        .device = info.dwVolumeSerialNumber,
+        .inode = ((u64)info.nFileIndexHigh << 32) | info.nFileIndexLow,
+    };
+}
+
 void File::CloseFile() {
     if (handle) CloseHandle(handle);
 }
@@ -156,6 +166,50 @@ ErrorCodeOr<usize> File::Read(void* data, usize num_bytes) {
     return CheckedCast<usize>(num_read);
 }
 
+ErrorCodeOr<usize> File::ReadAt(u64 offset, void* data, usize num_bytes) {
+    OVERLAPPED overlapped {};
+    overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD num_read;
+    if (!ReadFile(handle, data, CheckedCast<DWORD>(num_bytes), &num_read, &overlapped)) {
+        // Unlike ReadFile without an offset, reading at or past the end is reported as an error.
+        if (auto const error = GetLastError(); error != ERROR_HANDLE_EOF)
+            return FilesystemWin32ErrorCode(error, "ReadFile");
+        return (usize)0;
+    }
+    return CheckedCast<usize>(num_read);
+}
+
+ErrorCodeOr<MappedFile> MapFile(File& file, u64 size) {
+    ASSERT(size != 0);
+    auto const mapping = CreateFileMappingW(file.handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) return FilesystemWin32ErrorCode(GetLastError(), "CreateFileMappingW");
+    // The view keeps the mapping object alive.
+    DEFER { CloseHandle(mapping); };
+    auto const data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, CheckedCast<SIZE_T>(size));
+    if (!data) return FilesystemWin32ErrorCode(GetLastError(), "MapViewOfFile");
+    MappedFile result;
+    result.data = {(u8 const*)data, (usize)size};
+    return result;
+}
+
+void MappedFile::Advise(FileAccessPattern pattern) {
+    if (!data.size) return;
+    switch (pattern) {
+        case FileAccessPattern::Sequential: {
+            WIN32_MEMORY_RANGE_ENTRY range {.VirtualAddress = (void*)data.data, .NumberOfBytes = data.size};
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+            break;
+        }
+        case FileAccessPattern::Random: break;
+    }
+}
+
+void MappedFile::Unmap() {
+    if (data.size) UnmapViewOfFile(data.data);
+    data = {};
+}
+
 ErrorCodeOr<u64> File::FileSize() {
     LARGE_INTEGER size;
     if (!GetFileSizeEx(handle, &size)) return FilesystemWin32ErrorCode(GetLastError(), "GetFileSize");
@@ -58,6 +58,17 @@ void* AllocatePages(usize bytes);
 void FreePages(void* ptr, usize bytes);
 void TryShrinkPages(void* ptr, usize old_size, usize new_size);
 
+// Like AllocatePages, but asks the OS to back the memory with huge pages so that large, randomly-accessed
+// buffers need far fewer TLB entries. Falls back to normal pages if huge pages aren't available. bytes must be
+// a multiple of k_huge_page_size. Free with FreePages.
+constexpr usize k_huge_page_size = 2 * 1024 * 1024;
+void* AllocateHugePages(usize bytes);
+
+// Pins pages in physical memory so that touching them never page-faults. Fails if it would go over the OS's
+// limit for the process (RLIMIT_MEMLOCK on Unix, the working set size on Windows).
+bool LockPages(void* ptr, usize bytes);
+void UnlockPages(void* ptr, usize bytes);
+
 // Malloc-like allocator but with alignment support.
 struct Memory {
     Memory() = default;
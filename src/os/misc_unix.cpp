@@ -89,6 +89,46 @@ void FreePages(void* ptr, usize bytes) {
     munmap(ptr, bytes);
 }
 
+void* AllocateHugePages(usize bytes) {
+    ASSERT(bytes % k_huge_page_size == 0);
+
+    if (UseMallocForPages()) {
+        auto const p = aligned_alloc(k_huge_page_size, bytes);
+        TracyAlloc(p, bytes);
+        return p;
+    }
+
+#ifdef MAP_HUGETLB
+    // Explicit huge pages only work if the system has reserved some (vm.nr_hugepages), which is rarely the
+    // case, but when it is they're the best option: they're never split up or swapped out.
+    if (auto const p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0);
+        p != MAP_FAILED) {
+        TracyAlloc(p, bytes);
+        return p;
+    }
+#endif
+
+    // Transparent huge pages need a huge-page-aligned range, so we over-allocate and trim the ends.
+    auto const mapping_size = bytes + k_huge_page_size;
+    auto const mapping =
+        (u8*)mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (mapping == MAP_FAILED) return nullptr;
+    auto const p = __builtin_align_up(mapping, k_huge_page_size);
+    if (auto const head = (usize)(p - mapping)) munmap(mapping, head);
+    if (auto const tail = (usize)((mapping + mapping_size) - (p + bytes))) munmap(p + bytes, tail);
+
+#ifdef MADV_HUGEPAGE
+    madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+
+    TracyAlloc(p, bytes);
+    return p;
+}
+
+bool LockPages(void* ptr, usize bytes) { return mlock(ptr, bytes) == 0; }
+
+void UnlockPages(void* ptr, usize bytes) { munlock(ptr, bytes); }
+
 void TryShrinkPages(void* ptr, usize old_size, usize new_size) {
     if (UseMallocForPages()) return;
 
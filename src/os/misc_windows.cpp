@@ -145,6 +145,25 @@ void FreePages(void* ptr, usize bytes) {
     ASSERT(result != 0, "VirtualFree failed");
 }
 
+void* AllocateHugePages(usize bytes) {
+    ASSERT(bytes % k_huge_page_size == 0);
+
+    // Large pages need the SeLockMemoryPrivilege which most users don't have; VirtualAlloc fails quickly in
+    // that case and we use normal pages instead.
+    if (auto const large_page_size = GetLargePageMinimum(); large_page_size && bytes % large_page_size == 0) {
+        if (auto p = VirtualAlloc(nullptr, bytes, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE)) {
+            TracyAlloc(p, bytes);
+            return p;
+        }
+    }
+
+    return AllocatePages(bytes);
+}
+
+bool LockPages(void* ptr, usize bytes) { return VirtualLock(ptr, bytes) != 0; }
+
+void UnlockPages(void* ptr, usize bytes) { VirtualUnlock(ptr, bytes); }
+
 void TryShrinkPages(void* ptr, usize old_size, usize new_size) {
     (void)ptr;
     (void)old_size;
@@ -107,12 +107,15 @@ static void SetPinnedSnapshot(Engine& engine, StateSnapshot const& state, String
         ASSERT(path::IsAbsolute(preset_path));
     }
     engine.pinned_snapshot.state = state;
+    engine.pinned_snapshot.params_hash = HashParamValues(state.param_values);
+    MarkAllStatePartsChanged(engine.processor);
     dyn::Assign(engine.pinned_snapshot.preset_path, preset_path);
     engine.pinned_snapshot.preset_path_needs_lookup = preset_path.size == 0;
     ASSERT(engine.pinned_snapshot.state.extras.display_name.size);
 }
 
 static void AfterStateChanged(Engine& engine) {
+    MarkAllStatePartsChanged(engine.processor);
     NotifyListener(engine);
     engine.host.request_callback(&engine.host);
     engine.pending_state_change.Clear();
@@ -383,6 +386,58 @@ static StateSnapshot const& PinnedSnapshotForModificationCheck(Engine& engine) {
     return result;
 }
 
+// The params' hash is kept up to date as they change, so when it matches the pinned snapshot's we can skip
+// comparing the params, and when it doesn't we only need to compare the params.
+static bool ParamsDifferFromPinned(Parameters const& params, Engine::PinnedSnapshot const& pinned) {
+    if constexpr (!PRODUCTION_BUILD) ASSERT(params.values_hash == HashParamValues(params.values));
+    if (params.values_hash == pinned.params_hash) return false;
+    return params.values != pinned.state.param_values;
+}
+
+static void CaptureStatePart(Engine const& engine, StateSnapshotPart part, StateSnapshot& out) {
+    switch (part) {
+        case StateSnapshotPart::FxVisible: out.fx_visible = engine.fx_visible; break;
+        case StateSnapshotPart::Metadata: out.metadata = engine.state_metadata; break;
+        case StateSnapshotPart::MacroNames: out.macro_names = engine.macro_names; break;
+        default: CaptureStateSnapshotPart(engine.processor, part, out); break;
+    }
+}
+
+// Compares the non-param parts that are flagged in main_state_parts_to_check against the pinned snapshot, and
+// unflags the ones found equal, so the cost is in proportion to what's been edited. If current is null, each
+// part is captured as it's compared.
+static bool FlaggedPartsDifferFromPinned(Engine& engine, StateSnapshot const* current) {
+    auto& to_check = engine.processor.main_state_parts_to_check;
+
+    // Arp recording writes steps on the audio thread, so they can't be flagged where they're edited.
+    bool arp_recording = false;
+    for (auto const& layer : engine.processor.layer_processors)
+        if (layer.arp_state.recording.Load(LoadMemoryOrder::Relaxed)) arp_recording = true;
+    if (arp_recording) to_check.Set(ToInt(StateSnapshotPart::ArpSteps));
+
+    bool differ = false;
+    to_check.ForEachSetBit([&](usize part_index) {
+        auto const part = (StateSnapshotPart)part_index;
+        if (differ || part == StateSnapshotPart::Params) return;
+        if (!current) CaptureStatePart(engine, part, engine.modification_check_scratch);
+        auto const& compare = current ? *current : engine.modification_check_scratch;
+        if (!StateSnapshotPartsEqual(compare, engine.pinned_snapshot.state, part)) {
+            differ = true;
+            return;
+        }
+        if (!(part == StateSnapshotPart::ArpSteps && arp_recording)) to_check.Clear(part_index);
+    });
+    return differ;
+}
+
+static bool PartsOtherThanParamsDiffer(StateSnapshot const& a, StateSnapshot const& b) {
+    for (auto const part : Range(ToInt(StateSnapshotPart::Count))) {
+        if ((StateSnapshotPart)part == StateSnapshotPart::Params) continue;
+        if (!StateSnapshotPartsEqual(a, b, (StateSnapshotPart)part)) return true;
+    }
+    return false;
+}
+
 StateSnapshot CurrentStateSnapshot(Engine& engine) {
     StateSnapshot snapshot = CaptureStateSnapshot(engine.processor);
 
@@ -404,9 +459,14 @@ StateSnapshot CurrentStateSnapshot(Engine& engine) {
     auto const& last = PinnedSnapshotForModificationCheck(engine);
     if (last.extras.modified_from_preset) {
         snapshot.extras = last.extras;
-    } else {
+    } else if (engine.pending_state_change) {
         snapshot.extras = last.extras; // Ignore extras before the != next line.
         snapshot.extras.modified_from_preset = snapshot != last;
+    } else {
+        snapshot.extras = last.extras;
+        snapshot.extras.modified_from_preset =
+            ParamsDifferFromPinned(engine.processor.main_params, engine.pinned_snapshot) ||
+            FlaggedPartsDifferFromPinned(engine, &snapshot);
     }
 
     snapshot.extras.instance_id = InstanceId(engine.autosave_state);
@@ -631,6 +691,8 @@ void ApplySectionOfState(Engine& engine,
         }
     }
 
+    // Sections can touch several parts, so rather than tracking which, have them all checked.
+    MarkAllStatePartsChanged(engine.processor);
     NotifyListener(engine);
     engine.host.request_callback(&engine.host);
 }
@@ -641,13 +703,38 @@ StateSnapshot const* PinnedPresetState(Engine const& engine) {
 }
 
 bool StateModifiedFromPinned(Engine& engine) {
+    // The GUI asks this every frame, so unless a state change is pending we avoid capturing a snapshot: the
+    // params are checked by their hash, and the other parts only if they've been flagged as edited since they
+    // were last found equal to the pinned snapshot.
+    if (!engine.pending_state_change) {
+        auto const& pinned = engine.pinned_snapshot;
+        bool const changed = pinned.state.extras.modified_from_preset ||
+                             ParamsDifferFromPinned(engine.processor.main_params, pinned) ||
+                             FlaggedPartsDifferFromPinned(engine, nullptr);
+
+        if constexpr (!PRODUCTION_BUILD) {
+            // Catches an edit to a part that didn't call MarkStatePartChanged.
+            auto const current = CurrentStateSnapshot(engine);
+            ASSERT(changed == (pinned.state.extras.modified_from_preset ||
+                               current.param_values != pinned.state.param_values ||
+                               PartsOtherThanParamsDiffer(current, pinned.state)));
+            if (changed)
+                AssignDiffDescription(engine.state_change_description, pinned.state, current);
+            else
+                dyn::Clear(engine.state_change_description);
+        }
+
+        return changed;
+    }
+
     auto const current = CurrentStateSnapshot(engine);
     bool const changed = current.extras.modified_from_preset;
 
     if constexpr (!PRODUCTION_BUILD) {
-        auto const& last = PinnedSnapshotForModificationCheck(engine);
         if (changed)
-            AssignDiffDescription(engine.state_change_description, last, current);
+            AssignDiffDescription(engine.state_change_description,
+                                  PinnedSnapshotForModificationCheck(engine),
+                                  current);
         else
             dyn::Clear(engine.state_change_description);
     }
@@ -685,6 +772,7 @@ String IrName(Engine const& engine) {
 void LoadConvolutionIr(Engine& engine, Optional<sample_lib::IrId> ir_id) {
     ASSERT(g_is_logical_main_thread);
     engine.processor.convo.ir_id = ir_id;
+    MarkStatePartChanged(engine.processor, StateSnapshotPart::Ir);
 
     if (ir_id)
         SendAsyncLoadRequest(engine.shared_engine_systems.sample_library_server,
@@ -703,6 +791,7 @@ void LoadConvolutionIr(Engine& engine, Optional<sample_lib::IrId> ir_id) {
 void LoadInstrument(Engine& engine, u32 layer_index, InstrumentId inst_id) {
     ASSERT(g_is_logical_main_thread);
     engine.processor.layer_processors[layer_index].instrument_id = inst_id;
+    MarkStatePartChanged(engine.processor, StateSnapshotPart::Instruments);
 
     switch (inst_id.tag) {
         case InstrumentType::Sampler:
@@ -789,6 +878,9 @@ void LoadPresetFromFile(Engine& engine, String path) {
     auto state_outcome = LoadPresetFile(path, scratch_arena);
     auto const error_id = HashMultiple(Array {"preset-load"_s, path});
 
+    // Keep a prefetch of this preset alive the longest: LoadState's requests are about to reuse it.
+    TouchPrefetchedPreset(engine.preset_prefetcher, Hash(path));
+
     if (state_outcome.HasValue()) {
         auto& state = state_outcome.Value();
         FillStateExtrasFromPath(state, path);
@@ -808,6 +900,11 @@ void LoadPresetFromFile(Engine& engine, String path) {
     }
 }
 
+void PrefetchPresetFile(Engine& engine, PresetPrefetchReason reason, String path) {
+    ASSERT(g_is_logical_main_thread);
+    PrefetchPresetFile(engine.preset_prefetcher, reason, path);
+}
+
 void SaveCurrentStateToFile(Engine& engine, String path) {
     ASSERT(path.size);
     ASSERT(IsValidUtf8(path));
@@ -869,6 +966,7 @@ static void OnMainThread(Engine& engine) {
         r->Release();
         MarkNeedsAttributionTextUpdate(engine.attribution_requirements);
     }
+    UpdatePresetPrefetcher(engine.preset_prefetcher);
     if (AttributionTextNeedsUpdate(engine.attribution_requirements))
         UpdateAttributionText(engine, scratch_arena);
 
@@ -945,6 +1043,7 @@ Engine::~Engine() {
     DeinitAttributionRequirements(attribution_requirements, scratch_arena);
     package::ShutdownJobs(package_install_jobs);
 
+    DeinitPresetPrefetcher(preset_prefetcher);
     sample_lib_server::CloseAsyncCommsChannel(shared_engine_systems.sample_library_server,
                                               sample_lib_server_async_channel);
 
@@ -986,7 +1085,7 @@ static void PluginOnPollThread(Engine& engine) {
         }
     }
 
-    AutosaveToFileIfNeeded(engine.autosave_state, engine.shared_engine_systems.paths);
+    SubmitAutosaveIfNeeded(engine.autosave_state, engine.shared_engine_systems.autosave_writer);
 }
 
 static void PluginOnPreferenceChanged(Engine& engine, prefs::Key key, prefs::Value const* value) {
@@ -1013,8 +1112,8 @@ usize MegabytesUsedBySamples(Engine const& engine) {
     usize result = 0;
     for (auto& l : engine.processor.layer_processors) {
         if (auto i = l.instrument.TryGet<sample_lib_server::ResourcePointer<sample_lib::LoadedInstrument>>())
-            for (auto& d : (*i)->audio_datas)
-                result += d->RamUsageBytes();
+            for (auto const [index, d] : Enumerate((*i)->audio_datas))
+                if ((*i)->AudioDataLoaded(index)) result += d->RamUsageBytes();
     }
 
     return (result) / (1024 * 1024);
@@ -1029,25 +1128,26 @@ void SetToDefaultState(Engine& engine) {
 static bool PluginSaveState(Engine& engine, clap_ostream const& stream) {
     auto state = CurrentStateSnapshot(engine);
     ASSERT(state.extras.instance_id.size);
-    auto outcome = CodeState(
-        state,
-        CodeStateArguments {
-            .mode = CodeStateArguments::Mode::Encode,
-            .read_or_write_data = [&](void* data, usize bytes) -> ErrorCodeOr<void> {
-                u64 bytes_written = 0;
-                while (bytes_written != bytes) {
-                    ASSERT(bytes_written < bytes);
-                    auto const n =
-                        stream.write(&stream, (u8 const*)data + bytes_written, bytes - bytes_written);
-                    if (n < 0) return ErrorCode(CommonError::PluginHostError);
-                    bytes_written += (u64)n;
-                }
-                return k_success;
-            },
-            .source = StateSource::Daw,
-            .write_experimental_params =
-                prefs::GetBool(engine.shared_engine_systems.prefs, ExperimentalParamsPreferenceDescriptor()),
-        });
+
+    // We encode into memory first so that the host receives a single large write rather than a call per
+    // field; some hosts have expensive stream calls.
+    ArenaAllocator arena {PageAllocator::Instance()};
+    auto const outcome = [&]() -> ErrorCodeOr<void> {
+        auto const data = TRY(EncodeToMemory(
+            state,
+            arena,
+            StateSource::Daw,
+            prefs::GetBool(engine.shared_engine_systems.prefs, ExperimentalParamsPreferenceDescriptor())));
+
+        u64 bytes_written = 0;
+        while (bytes_written != data.size) {
+            ASSERT(bytes_written < data.size);
+            auto const n = stream.write(&stream, data.data + bytes_written, data.size - bytes_written);
+            if (n < 0) return ErrorCode(CommonError::PluginHostError);
+            bytes_written += (u64)n;
+        }
+        return k_success;
+    }();
 
     auto const error_id = SourceLocationHash();
 
@@ -1065,24 +1165,21 @@ static bool PluginSaveState(Engine& engine, clap_ostream const& stream) {
 }
 
 static bool PluginLoadState(Engine& engine, clap_istream const& stream) {
-    StateSnapshot state {};
-    auto const outcome =
-        CodeState(state,
-                  CodeStateArguments {
-                      .mode = CodeStateArguments::Mode::Decode,
-                      .read_or_write_data = [&](void* data, usize bytes) -> ErrorCodeOr<void> {
-                          u64 bytes_read = 0;
-                          while (bytes_read != bytes) {
-                              ASSERT(bytes_read < bytes);
-                              auto const n = stream.read(&stream, (u8*)data + bytes_read, bytes - bytes_read);
-                              if (n == 0) return ErrorCode(CommonError::InvalidFileFormat); // unexpected EOF
-                              if (n < 0) return ErrorCode(CommonError::PluginHostError);
-                              bytes_read += (u64)n;
-                          }
-                          return k_success;
-                      },
-                      .source = StateSource::Daw,
-                  });
+    // Bulk-read the whole stream so that we make as few host calls as possible, then decode from memory.
+    ArenaAllocator arena {PageAllocator::Instance()};
+    auto outcome = [&]() -> ErrorCodeOr<StateSnapshot> {
+        constexpr usize k_read_chunk_size = 16 * 1024;
+        DynamicArray<u8> data {arena};
+        while (true) {
+            auto const pos = data.size;
+            dyn::Resize(data, pos + k_read_chunk_size);
+            auto const n = stream.read(&stream, data.data + pos, k_read_chunk_size);
+            if (n < 0) return ErrorCode(CommonError::PluginHostError);
+            dyn::Resize(data, pos + (usize)n);
+            if (n == 0) break;
+        }
+        return DecodeFromMemory(data.Items(), StateSource::Daw);
+    }();
 
     auto const error_id = SourceLocationHash();
 
@@ -1096,6 +1193,7 @@ static bool PluginLoadState(Engine& engine, clap_istream const& stream) {
     }
 
     engine.error_notifications.RemoveError(error_id);
+    auto& state = outcome.Value();
     // Fallback display name for legacy DAW state that doesn't carry one.
     if (state.extras.display_name.size == 0) dyn::Assign(state.extras.display_name, "DAW State"_s);
     LoadState(engine, state, {.source = StateSource::Daw});
@@ -1147,9 +1245,8 @@ void EndUndoableStep(Engine& engine) {
 static void RestorePinnedSnapshotFromAnchor(Engine& engine) {
     auto const& undo = engine.undo_history.undo;
     for (auto i = undo.Size(); i > 0; --i) {
-        auto const& step = undo.At(i - 1);
-        if (step.is_pinned_snapshot_anchor) {
-            SetPinnedSnapshot(engine, step.snapshot, ""_s);
+        if (undo.EntryAt(i - 1).is_pinned_snapshot_anchor) {
+            SetPinnedSnapshot(engine, undo.SnapshotAt(i - 1), ""_s);
             return;
         }
     }
@@ -14,6 +14,7 @@
 #include "common_infrastructure/state/state_snapshot.hpp"
 
 #include "engine/package_installation.hpp"
+#include "engine/preset_prefetch.hpp"
 #include "engine/undo.hpp"
 #include "processor/processor.hpp"
 #include "shared_engine_systems.hpp"
@@ -40,6 +41,7 @@ struct Engine : ProcessorListener {
 
     struct PinnedSnapshot {
         StateSnapshot state {DefaultStateSnapshot()};
+        u64 params_hash {HashParamValues(DefaultStateSnapshot().param_values)}; // Of state.
         DynamicArray<char> preset_path {Malloc::Instance()}; // May be empty
 
         // We sometimes don't have the full path, but it's worth seeing if it's our known preset index. To
@@ -85,6 +87,10 @@ struct Engine : ProcessorListener {
     Optional<PendingStateChange> pending_state_change {};
     PinnedSnapshot pinned_snapshot {};
 
+    // Parts are captured into this when checking whether the state is modified. It's a member because a
+    // StateSnapshot is too big to construct every frame.
+    StateSnapshot modification_check_scratch {};
+
     // Holds the modified state set aside while auditioning the pinned snapshot.
     Optional<StateSnapshot> stashed_modifications {};
 
@@ -98,7 +104,13 @@ struct Engine : ProcessorListener {
 
     sample_lib_server::AsyncCommsChannel& sample_lib_server_async_channel;
 
-    UndoHistory undo_history {PageAllocator::Instance()};
+    PresetPrefetcher preset_prefetcher {
+        .server = shared_engine_systems.sample_library_server,
+        .thread_pool = shared_engine_systems.thread_pool,
+        .result_added_callback = [&engine = *this]() { engine.host.request_callback(&engine.host); },
+    };
+
+    UndoHistory undo_history {Malloc::Instance()};
     u32 undoable_step_depth {};
     DynamicArrayBounded<char, k_undoable_step_name_max_size> pending_undoable_step_name {};
 };
@@ -161,6 +173,10 @@ void TogglePinnedView(Engine& engine);
 
 void LoadPresetFromFile(Engine& engine, String path);
 
+// Start loading a preset's instruments and IR in the background so that LoadPresetFromFile is quick if it's
+// chosen. Cheap to call repeatedly with the same path.
+void PrefetchPresetFile(Engine& engine, PresetPrefetchReason reason, String path);
+
 void SaveCurrentStateToFile(Engine& engine, String path);
 
 void SetToDefaultState(Engine& engine);
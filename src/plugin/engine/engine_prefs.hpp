@@ -25,3 +25,21 @@ PUBLIC prefs::Descriptor AbbreviatedParamNamesPreferenceDescriptor() {
             "Enable short parameters names in the DAW. e.g. instead of \"Effect Distortion On\", show \"FxDs On\". Restarting your DAW might be required for this change to take effect.",
     };
 }
+
+PUBLIC prefs::Descriptor SampleMemoryLockBudgetPreferenceDescriptor() {
+    return {
+        .key = "sample-memory-lock-budget-mb"_s,
+        .value_requirements =
+            prefs::Descriptor::IntRequirements {
+                .validator =
+                    [](s64& value) {
+                        value = Clamp<s64>(value, 0, 64 * 1024);
+                        return true;
+                    },
+            },
+        .default_value = (s64)0,
+        .gui_label = "Locked sample memory (MB)",
+        .long_description =
+            "Keep up to this many megabytes of loaded samples locked in RAM so the operating system never swaps them out. This avoids rare audio dropouts on machines that are low on memory, but the locked memory is unavailable to other programs. 0 disables it.",
+    };
+}
@@ -0,0 +1,379 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "preset_prefetch.hpp"
+
+#include "os/filesystem.hpp"
+#include "os/threading.hpp"
+#include "tests/framework.hpp"
+
+#include "common_infrastructure/state/state_coding.hpp"
+
+using InstrumentPointer = sample_lib_server::ResourcePointer<sample_lib::LoadedInstrument>;
+using IrPointer = sample_lib_server::ResourcePointer<sample_lib::LoadedIr>;
+
+static void ReleaseSlotAudio(PresetPrefetcher& prefetcher, PresetPrefetchSlot& slot) {
+    if (slot.channel) {
+        // Closing the channel cancels any of its loads that no one else wants, and releases the results we
+        // haven't collected.
+        sample_lib_server::CloseAsyncCommsChannel(prefetcher.server, *slot.channel);
+        slot.channel = nullptr;
+    }
+    for (auto& r : slot.retained_results)
+        r.Release();
+    dyn::Clear(slot.retained_results);
+    dyn::Clear(slot.requests);
+    slot.bytes_used = 0;
+}
+
+static void ClearSlot(PresetPrefetcher& prefetcher, PresetPrefetchSlot& slot) {
+    // Waits if the read has started, but that's only a small file.
+    auto _ = slot.file_read.ShutdownAndRelease();
+    ReleaseSlotAudio(prefetcher, slot);
+    slot.key = 0;
+    dyn::Clear(slot.path);
+}
+
+bool TouchPrefetchedPreset(PresetPrefetcher& prefetcher, u64 key) {
+    for (auto& slot : prefetcher.slots) {
+        if (slot.key == key) {
+            slot.last_used = ++prefetcher.use_counter;
+            return true;
+        }
+    }
+    return false;
+}
+
+static PresetPrefetchSlot& ClaimSlot(PresetPrefetcher& prefetcher, PresetPrefetchReason reason, u64 key) {
+    auto& slot = prefetcher.slots[ToInt(reason)];
+    ClearSlot(prefetcher, slot);
+    slot.key = key;
+    slot.last_used = ++prefetcher.use_counter;
+    return slot;
+}
+
+static void
+SendLoadRequests(PresetPrefetcher& prefetcher, PresetPrefetchSlot& slot, StateSnapshot const& state) {
+    auto const needs_loading = ({
+        bool n = state.ir_id.HasValue();
+        for (auto const& i : state.inst_ids)
+            if (i.tag == InstrumentType::Sampler) n = true;
+        n;
+    });
+    // We still hold the key so that asking again is cheap.
+    if (!needs_loading) return;
+
+    slot.channel = &sample_lib_server::OpenAsyncCommsChannel(
+        prefetcher.server,
+        {
+            .error_notifications = prefetcher.error_notifications,
+            .result_added_callback = prefetcher.result_added_callback,
+            .library_changed_callback = [](sample_lib::LibraryId) {},
+            .low_priority = true,
+        });
+
+    for (auto [layer_index, i] : Enumerate<u32>(state.inst_ids)) {
+        if (i.tag != InstrumentType::Sampler) continue;
+        auto const id = sample_lib_server::SendAsyncLoadRequest(
+            prefetcher.server,
+            *slot.channel,
+            sample_lib_server::LoadRequestInstrumentIdWithLayer {
+                .id = i.Get<sample_lib::InstrumentId>(),
+                .layer_index = layer_index,
+            });
+        dyn::Append(slot.requests, id);
+    }
+
+    if (state.ir_id) {
+        auto const id =
+            sample_lib_server::SendAsyncLoadRequest(prefetcher.server, *slot.channel, *state.ir_id);
+        dyn::Append(slot.requests, id);
+    }
+}
+
+void PrefetchPreset(PresetPrefetcher& prefetcher,
+                    PresetPrefetchReason reason,
+                    u64 key,
+                    StateSnapshot const& state) {
+    ASSERT(key != 0);
+    if (TouchPrefetchedPreset(prefetcher, key)) return;
+    SendLoadRequests(prefetcher, ClaimSlot(prefetcher, reason, key), state);
+}
+
+void PrefetchPresetFile(PresetPrefetcher& prefetcher, PresetPrefetchReason reason, String path) {
+    auto const key = Hash(path);
+    ASSERT(key != 0);
+    if (TouchPrefetchedPreset(prefetcher, key)) return;
+
+    auto& slot = ClaimSlot(prefetcher, reason, key);
+    dyn::Assign(slot.path, path);
+
+    // The slot outlives the job: ClearSlot waits for it. The cleanup doesn't touch the slot, but it does use
+    // the prefetcher, so DeinitPresetPrefetcher waits for the count to reach zero.
+    prefetcher.file_reads_in_flight.Increase();
+    prefetcher.thread_pool.Async(
+        slot.file_read,
+        [path = (String)slot.path]() -> StateSnapshot {
+            ArenaAllocator scratch_arena {PageAllocator::Instance(), Kb(16)};
+            auto const state_outcome = LoadPresetFile(path, scratch_arena);
+            // A preset that can't be read is remembered as having nothing to load. If it's chosen, loading it
+            // for real reports the error.
+            return state_outcome.HasValue() ? state_outcome.Value() : StateSnapshot {};
+        },
+        [&prefetcher]() {
+            prefetcher.result_added_callback();
+            prefetcher.file_reads_in_flight.CountDown();
+        },
+        JobPriority::Low);
+}
+
+// Audio that regions share is only counted once. Audio that's still loading isn't counted yet.
+static u64 BytesUsed(PresetPrefetchSlot const& slot, ArenaAllocator& scratch_arena) {
+    DynamicArray<AudioData const*> audio_datas {scratch_arena};
+    for (auto const& r : slot.retained_results) {
+        if (auto const inst = r.TryExtract<InstrumentPointer>()) {
+            for (auto const [region_index, audio_data] : Enumerate((*inst)->audio_datas))
+                if ((*inst)->AudioDataLoaded(region_index)) dyn::Append(audio_datas, audio_data);
+        } else if (auto const ir = r.TryExtract<IrPointer>()) {
+            if ((*ir)->audio_data) dyn::Append(audio_datas, (*ir)->audio_data);
+        }
+    }
+
+    Sort(audio_datas, [](AudioData const* a, AudioData const* b) { return a < b; });
+
+    u64 bytes = 0;
+    for (auto const [index, audio_data] : Enumerate(audio_datas))
+        if (index == 0 || audio_datas[index - 1] != audio_data) bytes += audio_data->RamUsageBytes();
+    return bytes;
+}
+
+u64 PresetPrefetchBytesUsed(PresetPrefetcher const& prefetcher) {
+    u64 bytes = 0;
+    for (auto const& slot : prefetcher.slots)
+        bytes += slot.bytes_used;
+    return bytes;
+}
+
+void UpdatePresetPrefetcher(PresetPrefetcher& prefetcher) {
+    ArenaAllocatorWithInlineStorage<2000> scratch_arena {PageAllocator::Instance()};
+
+    for (auto& slot : prefetcher.slots) {
+        if (auto const state = slot.file_read.TryReleaseResult())
+            SendLoadRequests(prefetcher, slot, *state);
+
+        if (!slot.channel) continue;
+
+        while (auto r = slot.channel->results.TryPop()) {
+            auto const was_requested = dyn::RemoveValue(slot.requests, r->id) != 0;
+            if (was_requested && r->result.tag == sample_lib_server::LoadResult::ResultType::Success)
+                dyn::Append(slot.retained_results, *r);
+            else
+                r->Release();
+        }
+
+        slot.bytes_used = BytesUsed(slot, scratch_arena);
+        scratch_arena.ResetCursorAndConsolidateRegions();
+    }
+
+    // Drop the audio of the least recently used presets until we're within budget. They keep their key: if
+    // they were cleared, the GUI would ask for them again on the next frame and we'd load and drop them over
+    // and over.
+    while (PresetPrefetchBytesUsed(prefetcher) > prefetcher.memory_budget_bytes) {
+        PresetPrefetchSlot* oldest = nullptr;
+        for (auto& slot : prefetcher.slots)
+            if (slot.bytes_used && (!oldest || slot.last_used < oldest->last_used)) oldest = &slot;
+        ASSERT(oldest);
+        ReleaseSlotAudio(prefetcher, *oldest);
+    }
+}
+
+void DeinitPresetPrefetcher(PresetPrefetcher& prefetcher) {
+    for (auto& slot : prefetcher.slots)
+        ClearSlot(prefetcher, slot);
+    prefetcher.file_reads_in_flight.WaitUntilZero();
+}
+
+//=================================================
+//  _______        _
+// |__   __|      | |
+//    | | ___  ___| |_ ___
+//    | |/ _ \/ __| __/ __|
+//    | |  __/\__ \ |_\__ \
+//    |_|\___||___/\__|___/
+//
+//=================================================
+
+static bool SlotHasFinishedLoading(PresetPrefetchSlot const& slot) {
+    if (slot.requests.size) return false;
+    for (auto const& r : slot.retained_results)
+        if (auto const inst = r.TryExtract<InstrumentPointer>())
+            if (!(*inst)->AllAudioDataLoaded()) return false;
+    return true;
+}
+
+static bool WaitForPrefetcher(PresetPrefetcher& prefetcher, FunctionRef<bool()> done) {
+    for (auto const attempt : Range(1000)) {
+        (void)attempt;
+        UpdatePresetPrefetcher(prefetcher);
+        if (done()) return true;
+        SleepThisThread(10);
+    }
+    return false;
+}
+
+TEST_CASE(TestPresetPrefetch) {
+    struct Fixture {
+        [[maybe_unused]] Fixture(tests::Tester&) { thread_pool.Init("pool", 4u); }
+        ThreadPool thread_pool;
+    };
+    auto& fixture = CreateOrFetchFixtureObject<Fixture>(tester);
+
+    ThreadsafeErrorNotifications error_notif {};
+    sample_lib_server::Server server {fixture.thread_pool, {}, error_notif};
+    auto const libraries_dir = (String)path::Join(tester.scratch_arena,
+                                                  Array {
+                                                      tests::TestFilesFolder(tester),
+                                                      tests::k_libraries_test_files_subdir,
+                                                  });
+    sample_lib_server::SetExtraScanFolders(server, Array {libraries_dir});
+
+    auto const state_with_inst = [](sample_lib::InstrumentId const& id) {
+        StateSnapshot state {};
+        state.inst_ids[0] = id;
+        return state;
+    };
+    auto const state_a = state_with_inst({
+        .library = sample_lib::IdFromAuthorAndName("Tester", "Test Lua"),
+        .inst_id = "Single Sample"_s,
+    });
+    auto const state_b = state_with_inst({
+        .library = sample_lib::IdForMdataLibrary("SharedFilesMdata"_s),
+        .inst_id = "Groups And Refs"_s,
+    });
+    constexpr u64 k_key_a = 1;
+    constexpr u64 k_key_b = 2;
+
+    PresetPrefetcher prefetcher {
+        .server = server,
+        .thread_pool = fixture.thread_pool,
+        .result_added_callback = []() {},
+    };
+    DEFER { DeinitPresetPrefetcher(prefetcher); };
+
+    auto& hovered = prefetcher.slots[ToInt(PresetPrefetchReason::Hovered)];
+    auto& next = prefetcher.slots[ToInt(PresetPrefetchReason::Next)];
+
+    SUBCASE("prefetched loads are reused") {
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Hovered, k_key_a, state_a);
+        REQUIRE(WaitForPrefetcher(prefetcher, [&]() { return SlotHasFinishedLoading(hovered); }));
+        REQUIRE_EQ(hovered.retained_results.size, 1u);
+        CHECK(hovered.bytes_used != 0);
+        auto const prefetched = *hovered.retained_results[0].TryExtract<InstrumentPointer>();
+
+        // Asking again, for any reason, is a no-op.
+        auto const channel = hovered.channel;
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Next, k_key_a, state_a);
+        CHECK(hovered.channel == channel);
+        CHECK(next.key == 0);
+
+        // This is what LoadState does when the preset is chosen.
+        auto& engine_channel = sample_lib_server::OpenAsyncCommsChannel(
+            server,
+            {
+                .error_notifications = error_notif,
+                .result_added_callback = []() {},
+                .library_changed_callback = [](sample_lib::LibraryId) {},
+            });
+        DEFER { sample_lib_server::CloseAsyncCommsChannel(server, engine_channel); };
+        sample_lib_server::SendAsyncLoadRequest(server,
+                                                engine_channel,
+                                                sample_lib_server::LoadRequestInstrumentIdWithLayer {
+                                                    .id = state_a.inst_ids[0].Get<sample_lib::InstrumentId>(),
+                                                    .layer_index = 0,
+                                                });
+
+        Optional<sample_lib_server::LoadResult> result {};
+        for (auto const attempt : Range(1000)) {
+            (void)attempt;
+            result = engine_channel.results.TryPop();
+            if (result) break;
+            SleepThisThread(10);
+        }
+        REQUIRE(result);
+        DEFER { result->Release(); };
+        auto const loaded = result->TryExtract<InstrumentPointer>();
+        REQUIRE(loaded);
+        CHECK(loaded->resource == prefetched.resource);
+        CHECK((*loaded)->AllAudioDataLoaded());
+    }
+
+    SUBCASE("prefetching for the same reason replaces the previous preset") {
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Hovered, k_key_a, state_a);
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Hovered, k_key_b, state_b);
+        CHECK_EQ(hovered.key, k_key_b);
+        CHECK(!TouchPrefetchedPreset(prefetcher, k_key_a));
+        CHECK(WaitForPrefetcher(prefetcher, [&]() { return SlotHasFinishedLoading(hovered); }));
+    }
+
+    SUBCASE("presets without sampler instruments or IRs are remembered") {
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Hovered, k_key_a, StateSnapshot {});
+        CHECK(TouchPrefetchedPreset(prefetcher, k_key_a));
+        CHECK(!hovered.channel);
+    }
+
+    SUBCASE("memory budget is respected") {
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Hovered, k_key_a, state_a);
+        REQUIRE(WaitForPrefetcher(prefetcher, [&]() { return SlotHasFinishedLoading(hovered); }));
+        REQUIRE(hovered.bytes_used != 0);
+
+        // Room for exactly what we have: the next preset pushes us over and the older one's audio must go.
+        prefetcher.memory_budget_bytes = hovered.bytes_used;
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Next, k_key_b, state_b);
+        CHECK(WaitForPrefetcher(prefetcher, [&]() { return hovered.bytes_used == 0; }));
+        CHECK(!hovered.channel);
+        CHECK(WaitForPrefetcher(prefetcher, [&]() { return SlotHasFinishedLoading(next); }));
+        CHECK_LTE(PresetPrefetchBytesUsed(prefetcher), prefetcher.memory_budget_bytes);
+
+        // A budget of nothing drops everything.
+        prefetcher.memory_budget_bytes = 0;
+        UpdatePresetPrefetcher(prefetcher);
+        CHECK_EQ(PresetPrefetchBytesUsed(prefetcher), 0u);
+    }
+
+    SUBCASE("presets dropped for the budget aren't requested again") {
+        prefetcher.memory_budget_bytes = 0;
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Hovered, k_key_a, state_a);
+        REQUIRE(WaitForPrefetcher(prefetcher, [&]() { return !hovered.channel; }));
+
+        // This is what the GUI does every frame while the preset stays hovered.
+        for (auto const frame : Range(20)) {
+            (void)frame;
+            PrefetchPreset(prefetcher, PresetPrefetchReason::Hovered, k_key_a, state_a);
+            UpdatePresetPrefetcher(prefetcher);
+            CHECK(!hovered.channel);
+            CHECK_EQ(hovered.requests.size, 0u);
+            CHECK_EQ(hovered.key, k_key_a);
+        }
+
+        // Once the slot goes to a different preset, the dropped one can be prefetched again.
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Hovered, k_key_b, state_b);
+        PrefetchPreset(prefetcher, PresetPrefetchReason::Hovered, k_key_a, state_a);
+        CHECK(hovered.channel);
+    }
+
+    SUBCASE("preset files are read on the thread pool") {
+        auto const path = (String)path::Join(tester.scratch_arena,
+                                             Array {tests::TestFilesFolder(tester), "no-such-preset"_s});
+        PrefetchPresetFile(prefetcher, PresetPrefetchReason::Hovered, path);
+        CHECK_EQ(hovered.key, Hash(path));
+        REQUIRE(WaitForPrefetcher(prefetcher, [&]() { return hovered.file_read.IsInactive(); }));
+
+        // It couldn't be read, so it's remembered as having nothing to load.
+        CHECK(!hovered.channel);
+        CHECK(TouchPrefetchedPreset(prefetcher, Hash(path)));
+    }
+
+    return k_success;
+}
+
+TEST_REGISTRATION(RegisterPresetPrefetchTests) { REGISTER_TEST(TestPresetPrefetch); }
@@ -0,0 +1,86 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+#include "foundation/foundation.hpp"
+#include "os/threading.hpp"
+#include "utils/error_notifications.hpp"
+#include "utils/thread_extra/thread_pool.hpp"
+
+#include "common_infrastructure/constants.hpp"
+#include "common_infrastructure/sample_library/server/sample_library_server.hpp"
+#include "common_infrastructure/state/state_snapshot.hpp"
+
+// Speculatively loads the instruments and IR of presets that the user is likely to pick next, so that
+// choosing one doesn't mean waiting for its audio to decode. The prefetcher holds a reference to what it has
+// loaded; when the preset is chosen, LoadState's requests find the audio already in the sample library
+// server and complete straight away.
+//
+// There's one slot per reason. Prefetching a different preset for the same reason replaces the slot's
+// previous preset, which cancels whatever of it was still loading. Loads are made at low priority on their
+// own channels so they never hold up audio that's wanted now.
+//
+// When the memory budget is exceeded, the least recently used presets have their audio dropped but keep their
+// slot, so asking for them again doesn't load them again. They stay like that until their slot is given to a
+// different preset.
+
+enum class PresetPrefetchReason : u8 {
+    Hovered,
+    KeyboardFocused,
+    Next,
+    Previous,
+    Count,
+};
+
+struct PresetPrefetchSlot {
+    u64 key {}; // Identifies the preset, 0 if the slot is empty.
+    DynamicArray<char> path {Malloc::Instance()}; // Set when the preset is read from a file.
+    Future<StateSnapshot> file_read {}; // Reads path on the thread pool.
+    sample_lib_server::AsyncCommsChannel* channel {};
+    DynamicArrayBounded<sample_lib_server::RequestId, k_num_layers + 1> requests {};
+    DynamicArrayBounded<sample_lib_server::LoadResult, k_num_layers + 1> retained_results {};
+    u64 bytes_used {}; // Updated in UpdatePresetPrefetcher.
+    u64 last_used {}; // Compared against PresetPrefetcher::use_counter.
+};
+
+struct PresetPrefetcher {
+    sample_lib_server::Server& server;
+    ThreadPool& thread_pool;
+
+    // Called from the server thread or the thread pool when a prefetch result is ready, so the owner knows to
+    // call UpdatePresetPrefetcher.
+    sample_lib_server::AsyncCommsChannel::ResultAddedCallback result_added_callback;
+
+    // Once prefetched audio exceeds this, the least recently used presets are dropped, even if that means
+    // dropping everything.
+    u64 memory_budget_bytes = Mb(512);
+
+    // Prefetches fail quietly: if the preset is chosen, loading it for real will report the problem.
+    ThreadsafeErrorNotifications error_notifications {};
+    Array<PresetPrefetchSlot, ToInt(PresetPrefetchReason::Count)> slots {};
+    u64 use_counter {};
+    AtomicCountdown file_reads_in_flight {0};
+};
+
+// Main thread. key identifies the preset; calling this again with the same key is cheap, it just marks the
+// preset as recently used.
+void PrefetchPreset(PresetPrefetcher& prefetcher,
+                    PresetPrefetchReason reason,
+                    u64 key,
+                    StateSnapshot const& state);
+
+// Main thread. Reads the preset file on the thread pool, and then prefetches it as PrefetchPreset does. The
+// key is Hash(path).
+void PrefetchPresetFile(PresetPrefetcher& prefetcher, PresetPrefetchReason reason, String path);
+
+// Main thread. Returns true if the preset is held in any slot, whether or not its audio has loaded yet or
+// has been dropped to stay within budget, and marks it as recently used.
+bool TouchPrefetchedPreset(PresetPrefetcher& prefetcher, u64 key);
+
+// Main thread. Collects results and enforces the memory budget.
+void UpdatePresetPrefetcher(PresetPrefetcher& prefetcher);
+
+u64 PresetPrefetchBytesUsed(PresetPrefetcher const& prefetcher);
+
+// Main thread. Releases everything, closes the channels and waits for any file reads to finish.
+void DeinitPresetPrefetcher(PresetPrefetcher& prefetcher);
@@ -8,6 +8,7 @@
 
 #include "common_infrastructure/error_reporting.hpp"
 
+#include "engine/engine_prefs.hpp"
 #include "plugin/plugin.hpp"
 
 void SharedEngineSystems::StartPollingThreadIfNeeded() {
@@ -30,8 +31,9 @@ void SharedEngineSystems::StartPollingThreadIfNeeded() {
                     for (auto index : registered_floe_instances)
                         OnPollThread(index);
                 }
+                WritePendingAutosaves(autosave_writer, paths);
                 check_for_update::CheckForUpdateIfNeeded(check_for_update_state);
-                persistent_store::StoreActualFileModifiedTime(persistent_store);
+                persistent_store::CheckStoreFileForChanges(persistent_store);
             }
         },
         "polling");
@@ -109,6 +111,8 @@ SharedEngineSystems::SharedEngineSystems(Span<sentry::Tag const> tags)
                 dyn::AppendIfNotAlreadyThere(extra_scan_folders, v->Get<String>());
             }
             SetExtraScanFolders(preset_server, extra_scan_folders);
+        } else if (auto const mb = prefs::MatchInt(key, value, SampleMemoryLockBudgetPreferenceDescriptor())) {
+            sample_lib_server::SetSampleMemoryLockBudget(sample_library_server, (u64)*mb * 1024 * 1024);
         }
         ErrorReportingOnPreferenceChanged(key, value);
         check_for_update::OnPreferenceChanged(check_for_update_state, key, value);
@@ -140,6 +144,9 @@ SharedEngineSystems::SharedEngineSystems(Span<sentry::Tag const> tags)
 
     sample_lib_server::SetExtraScanFolders(sample_library_server,
                                            ExtraScanFolders(paths, prefs, ScanFolderType::Libraries));
+    sample_lib_server::SetSampleMemoryLockBudget(
+        sample_library_server,
+        (u64)prefs::GetInt(prefs, SampleMemoryLockBudgetPreferenceDescriptor()) * 1024 * 1024);
 
     InitPresetServer(preset_server, paths.always_scanned_folder[ToInt(ScanFolderType::Presets)]);
     SetExtraScanFolders(preset_server, ExtraScanFolders(paths, prefs, ScanFolderType::Presets));
@@ -152,6 +159,9 @@ SharedEngineSystems::~SharedEngineSystems() {
         polling_thread.Join();
     }
 
+    WritePendingAutosaves(autosave_writer, paths);
+    DeinitAutosaveWriter(autosave_writer);
+
     ShutdownPresetServer(preset_server);
 
     prefs::WriteIfNeeded(prefs);
@@ -5,6 +5,7 @@
 #include "foundation/foundation.hpp"
 #include "utils/thread_extra/thread_pool.hpp"
 
+#include "common_infrastructure/autosave.hpp"
 #include "common_infrastructure/paths.hpp"
 #include "common_infrastructure/persistent_store.hpp"
 #include "common_infrastructure/preferences.hpp"
@@ -42,6 +43,7 @@ struct SharedEngineSystems {
     Optional<LockableSharedMemory> shared_attributions_store {};
     PresetServer preset_server;
     check_for_update::State check_for_update_state;
+    AutosaveWriter autosave_writer {};
 
     Thread polling_thread {};
     Mutex polling_mutex {};
@@ -5,47 +5,194 @@
 
 #include "tests/framework.hpp"
 
+// Calls f(a_member, b_member) for each part of the snapshot that is stored as a unit in a delta, apart from
+// param_values which are handled individually. IMPORTANT: when adding fields to StateSnapshot they must be
+// added here too.
+template <typename SnapshotA, typename SnapshotB, typename Function>
+static void ForEachDeltaSection(SnapshotA& a, SnapshotB& b, Function&& f) {
+    f(a.ir_id, b.ir_id);
+    f(a.inst_ids, b.inst_ids);
+    f(a.fx_order, b.fx_order);
+    f(a.fx_visible, b.fx_visible);
+    f(a.metadata, b.metadata);
+    for (auto const i : Range(k_num_layers)) {
+        f(a.velocity_curve_points[i], b.velocity_curve_points[i]);
+        f(a.harmony_intervals[i], b.harmony_intervals[i]);
+        f(a.arp_steps[i], b.arp_steps[i]);
+        f(a.slice_arp_configs[i], b.slice_arp_configs[i]);
+    }
+    f(a.macro_names, b.macro_names);
+    f(a.macro_destinations, b.macro_destinations);
+    f(a.extras.instance_id, b.extras.instance_id);
+    f(a.extras.param_learned_ccs, b.extras.param_learned_ccs);
+    f(a.extras.instance_config, b.extras.instance_config);
+    f(a.extras.display_name, b.extras.display_name);
+    f(a.extras.display_category, b.extras.display_category);
+    f(a.extras.preset_uuid, b.extras.preset_uuid);
+    f(a.extras.modified_from_preset, b.extras.modified_from_preset);
+}
+
+using DeltaSectionMask = u64;
+static_assert(14 + (k_num_layers * 4) <= sizeof(DeltaSectionMask) * 8);
+
+static void AppendBytes(DynamicArray<u8>& out, auto const& value) {
+    dyn::AppendSpan(out, Span<u8 const> {(u8 const*)&value, sizeof(value)});
+}
+
+// Delta format: changed-params bitset, the new value of each changed param, a mask of changed sections,
+// then the raw bytes of each changed section.
+static void EncodeDelta(StateSnapshot const& from, StateSnapshot const& to, DynamicArray<u8>& out) {
+    dyn::Clear(out);
+
+    Bitset<k_num_parameters> changed_params {};
+    for (auto const i : Range(k_num_parameters))
+        if (from.param_values[i] != to.param_values[i]) changed_params.Set(i);
+    AppendBytes(out, changed_params);
+    changed_params.ForEachSetBit([&](usize i) { AppendBytes(out, to.param_values[i]); });
+
+    auto const mask_pos = out.size;
+    DeltaSectionMask changed_sections = 0;
+    AppendBytes(out, changed_sections);
+    u32 section_index = 0;
+    ForEachDeltaSection(from, to, [&](auto const& a, auto const& b) {
+        if (a != b) {
+            changed_sections |= (DeltaSectionMask)1 << section_index;
+            AppendBytes(out, b);
+        }
+        ++section_index;
+    });
+    CopyMemory(out.data + mask_pos, &changed_sections, sizeof(changed_sections));
+}
+
+static void ApplyDelta(StateSnapshot& state, Span<u8 const> delta) {
+    usize pos = 0;
+    auto const read = [&](auto& value) {
+        ASSERT(pos + sizeof(value) <= delta.size);
+        CopyMemory(&value, delta.data + pos, sizeof(value));
+        pos += sizeof(value);
+    };
+
+    Bitset<k_num_parameters> changed_params;
+    read(changed_params);
+    changed_params.ForEachSetBit([&](usize i) { read(state.param_values[i]); });
+
+    DeltaSectionMask changed_sections;
+    read(changed_sections);
+    u32 section_index = 0;
+    ForEachDeltaSection(state, state, [&](auto& section, auto&) {
+        if (changed_sections & ((DeltaSectionMask)1 << section_index)) read(section);
+        ++section_index;
+    });
+    ASSERT(pos == delta.size);
+}
+
 UndoStepRing::UndoStepRing(Allocator& a, u32 cap) : allocator(a), capacity(cap) {
-    auto const span = allocator.AllocateExactSizeUninitialised<UndoableStep>(capacity);
+    auto const span = allocator.AllocateExactSizeUninitialised<Entry>(capacity);
     items = span.data;
 }
 
 UndoStepRing::~UndoStepRing() {
-    if (items) allocator.Free(Span<u8> {(u8*)items, capacity * sizeof(UndoableStep)});
+    Clear();
+    if (items) allocator.Free(Span<u8> {(u8*)items, capacity * sizeof(Entry)});
+}
+
+void UndoStepRing::FreeEntry(Entry& entry) {
+    if (entry.delta.size) allocator.Free(entry.delta.ToByteSpan());
+    entry.delta = {};
 }
 
-void UndoStepRing::PushEvictOldest(UndoableStep const& entry) {
+void UndoStepRing::PushEvictOldest(UndoableStep const& step) {
     if (size == capacity) {
+        // The oldest entry must always be a keyframe, so if the next one is a delta, make it a keyframe.
+        if (auto& new_oldest = At(Min(1u, size - 1)); new_oldest.chain_length != 0) {
+            auto const snapshot = SnapshotAt(1);
+            EncodeDelta(DefaultStateSnapshot(), snapshot, delta_buffer);
+            FreeEntry(new_oldest);
+            new_oldest.delta = allocator.Clone(delta_buffer.Items());
+            new_oldest.chain_length = 0;
+
+            // Entries that chained back through it now chain back to it.
+            for (u32 i = 2; i < size && At(i).chain_length != 0; ++i)
+                At(i).chain_length = (u8)(i - 1);
+        }
+
+        FreeEntry(At(0));
         head = (head + 1) % capacity;
         --size;
     }
-    items[(head + size) % capacity] = entry;
+
+    u8 chain_length = 0;
+    if (size && EntryAt(size - 1).chain_length < k_keyframe_interval - 1)
+        chain_length = EntryAt(size - 1).chain_length + 1;
+
+    EncodeDelta(chain_length ? top.snapshot : DefaultStateSnapshot(), step.snapshot, delta_buffer);
+
+    auto& entry = items[(head + size) % capacity];
+    entry = {
+        .name = step.name,
+        .is_pinned_snapshot_anchor = step.is_pinned_snapshot_anchor,
+        .chain_length = chain_length,
+        .delta = allocator.Clone(delta_buffer.Items()),
+    };
     ++size;
+    top = step;
 }
 
 UndoableStep UndoStepRing::PopTop() {
     ASSERT(size);
-    auto const result = items[(head + size - 1) % capacity];
+    auto const result = top;
+    FreeEntry(At(size - 1));
     --size;
+    if (size) {
+        auto const& entry = EntryAt(size - 1);
+        top.snapshot = ReconstructSnapshot(size - 1);
+        top.name = entry.name;
+        top.is_pinned_snapshot_anchor = entry.is_pinned_snapshot_anchor;
+    }
     return result;
 }
 
 UndoableStep const& UndoStepRing::Top() const {
     ASSERT(size);
-    return items[(head + size - 1) % capacity];
+    return top;
+}
+
+void UndoStepRing::SetTopIsPinnedSnapshotAnchor() {
+    ASSERT(size);
+    At(size - 1).is_pinned_snapshot_anchor = true;
+    top.is_pinned_snapshot_anchor = true;
 }
 
-UndoableStep& UndoStepRing::At(u32 i) {
+UndoStepRing::Entry& UndoStepRing::At(u32 i) {
     ASSERT(i < size);
     return items[(head + i) % capacity];
 }
 
-UndoableStep const& UndoStepRing::At(u32 i) const {
+UndoStepRing::Entry const& UndoStepRing::EntryAt(u32 i) const {
     ASSERT(i < size);
     return items[(head + i) % capacity];
 }
 
+StateSnapshot UndoStepRing::SnapshotAt(u32 i) const {
+    ASSERT(i < size);
+    if (i == size - 1) return top.snapshot;
+    return ReconstructSnapshot(i);
+}
+
+StateSnapshot UndoStepRing::ReconstructSnapshot(u32 i) const {
+    ASSERT(i < size);
+    auto const keyframe_index = i - EntryAt(i).chain_length;
+    ASSERT(EntryAt(keyframe_index).chain_length == 0);
+
+    auto result = DefaultStateSnapshot();
+    for (auto const j : Range(keyframe_index, i + 1))
+        ApplyDelta(result, EntryAt(j).delta);
+    return result;
+}
+
 void UndoStepRing::Clear() {
+    for (auto const i : Range(size))
+        FreeEntry(At(i));
     head = 0;
     size = 0;
 }
@@ -70,7 +217,7 @@ void UndoHistory::Clear() {
 
 void UndoHistory::Record(UndoableStep const& step) {
     if (undo.Size() && undo.Top().snapshot == step.snapshot) {
-        if (step.is_pinned_snapshot_anchor) undo.At(undo.Size() - 1).is_pinned_snapshot_anchor = true;
+        if (step.is_pinned_snapshot_anchor) undo.SetTopIsPinnedSnapshotAnchor();
         return;
     }
     undo.PushEvictOldest(step);
@@ -125,16 +272,16 @@ TEST_CASE(TestUndoStepRing) {
         ring.PushEvictOldest(make('c'));
         ring.PushEvictOldest(make('d'));
         REQUIRE_EQ(ring.Size(), 4u);
-        REQUIRE_EQ(String {ring.At(0).name}, "a"_s);
+        REQUIRE_EQ(String {ring.EntryAt(0).name}, "a"_s);
 
         ring.PushEvictOldest(make('e'));
         REQUIRE_EQ(ring.Size(), 4u);
-        REQUIRE_EQ(String {ring.At(0).name}, "b"_s);
-        REQUIRE_EQ(String {ring.At(3).name}, "e"_s);
+        REQUIRE_EQ(String {ring.EntryAt(0).name}, "b"_s);
+        REQUIRE_EQ(String {ring.EntryAt(3).name}, "e"_s);
         REQUIRE_EQ(String {ring.Top().name}, "e"_s);
 
         ring.PushEvictOldest(make('f'));
-        REQUIRE_EQ(String {ring.At(0).name}, "c"_s);
+        REQUIRE_EQ(String {ring.EntryAt(0).name}, "c"_s);
         REQUIRE_EQ(String {ring.Top().name}, "f"_s);
     }
 
@@ -145,10 +292,96 @@ TEST_CASE(TestUndoStepRing) {
         REQUIRE(!ring.Size());
 
         ring.PushEvictOldest(make('x'));
-        REQUIRE_EQ(String {ring.At(0).name}, "x"_s);
+        REQUIRE_EQ(String {ring.EntryAt(0).name}, "x"_s);
+    }
+
+    return k_success;
+}
+
+TEST_CASE(TestUndoStepRingDeltas) {
+    constexpr u32 k_capacity = 40;
+    UndoStepRing ring {tester.scratch_arena, k_capacity};
+
+    auto random_seed = (u64)0x1234;
+    DynamicArray<StateSnapshot> expected {tester.scratch_arena};
+    StateSnapshot state = DefaultStateSnapshot();
+
+    // Make a mix of small edits of the kind that undo usually sees.
+    auto const next_state = [&]() {
+        switch (RandomIntInRange<u32>(random_seed, 0, 3)) {
+            case 0: {
+                auto const param = RandomIntInRange<u32>(random_seed, 0, k_num_parameters - 1);
+                state.param_values[param] = RandomFloat01<f32>(random_seed);
+                break;
+            }
+            case 1: {
+                auto& step = state.arp_steps[RandomIntInRange<u32>(random_seed, 0, k_num_layers - 1)]
+                                            [RandomIntInRange<u32>(random_seed, 0, k_arp_max_steps - 1)];
+                step.velocity = (u16)RandomIntInRange<u32>(random_seed, 0, 1000);
+                break;
+            }
+            case 2: {
+                state.harmony_intervals[0].Flip(RandomIntInRange<u32>(random_seed, 0, 5));
+                break;
+            }
+            case 3: {
+                dyn::AssignFitInCapacity(state.metadata.author, "someone"_s);
+                state.extras.preset_uuid = RandomU64(random_seed);
+                break;
+            }
+        }
+        return state;
+    };
+
+    auto const push = [&](StateSnapshot const& s) {
+        UndoableStep step {};
+        step.snapshot = s;
+        ring.PushEvictOldest(step);
+        if (expected.size == k_capacity) dyn::Remove(expected, 0);
+        dyn::Append(expected, s);
+    };
+
+    auto const check_all = [&]() {
+        REQUIRE_EQ(ring.Size(), (u32)expected.size);
+        for (auto const i : Range(ring.Size())) {
+            CAPTURE(i);
+            CHECK(ring.SnapshotAt(i) == expected[i]);
+        }
+        CHECK_EQ(ring.EntryAt(0).chain_length, 0);
+        for (auto const i : Range(ring.Size()))
+            CHECK(ring.EntryAt(i).chain_length < UndoStepRing::k_keyframe_interval);
+    };
+
+    SUBCASE("reconstructs every entry") {
+        for (auto const _ : Range(25u))
+            push(next_state());
+        check_all();
+    }
+
+    SUBCASE("reconstructs after eviction") {
+        for (auto const _ : Range(k_capacity * 3))
+            push(next_state());
+        check_all();
+    }
+
+    SUBCASE("pop then push") {
+        for (auto const _ : Range(k_capacity + 7))
+            push(next_state());
+        for (auto const _ : Range(10u)) {
+            auto const popped = ring.PopTop();
+            CHECK(popped.snapshot == Last(expected));
+            dyn::Pop(expected);
+            CHECK(ring.Top().snapshot == Last(expected));
+        }
+        for (auto const _ : Range(5u))
+            push(next_state());
+        check_all();
     }
 
     return k_success;
 }
 
-TEST_REGISTRATION(RegisterUndoHistoryTests) { REGISTER_TEST(TestUndoStepRing); }
+TEST_REGISTRATION(RegisterUndoHistoryTests) {
+    REGISTER_TEST(TestUndoStepRing);
+    REGISTER_TEST(TestUndoStepRingDeltas);
+}
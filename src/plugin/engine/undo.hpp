@@ -25,27 +25,48 @@ struct UndoableStep {
 
 static_assert(TriviallyCopyable<UndoableStep>);
 
+// Entries are stored as compact deltas rather than full snapshots: each entry holds only the params and
+// sub-structures that changed relative to the entry below it. Every k_keyframe_interval entries (and always
+// for the oldest entry) we store a keyframe instead, which is a delta against the default state, so
+// reconstructing any entry applies a bounded number of deltas. The top entry is kept fully materialised
+// since that's what is read most often.
 struct UndoStepRing {
     NON_COPYABLE(UndoStepRing);
 
+    static constexpr u8 k_keyframe_interval = 16;
+
+    struct Entry {
+        DynamicArrayBounded<char, k_undoable_step_name_max_size> name;
+        bool is_pinned_snapshot_anchor;
+        u8 chain_length; // 0 if this is a keyframe, else the number of deltas back to a keyframe.
+        Span<u8> delta;
+    };
+
     UndoStepRing(Allocator& a, u32 capacity);
     ~UndoStepRing();
 
     void PushEvictOldest(UndoableStep const& entry);
     UndoableStep PopTop();
     UndoableStep const& Top() const;
+    void SetTopIsPinnedSnapshotAnchor();
 
     void Clear();
     u32 Size() const { return size; }
 
-    UndoableStep& At(u32 i);
-    UndoableStep const& At(u32 i) const;
+    Entry const& EntryAt(u32 i) const;
+    StateSnapshot SnapshotAt(u32 i) const;
+
+    Entry& At(u32 i);
+    void FreeEntry(Entry& entry);
+    StateSnapshot ReconstructSnapshot(u32 i) const;
 
     Allocator& allocator;
-    UndoableStep* items {};
+    Entry* items {};
     u32 capacity {};
     u32 head {0};
     u32 size {0};
+    UndoableStep top {};
+    DynamicArray<u8> delta_buffer {allocator};
 };
 
 struct UndoHistory {
@@ -18,10 +18,11 @@
 
 // ArpStep is a small atomic; user edits are Load/modify/Store so we don't lose neighbouring fields.
 template <typename Mutate>
-static void ModifyStep(ArpeggiatorState& s, u32 i, Mutate&& mutate) {
+static void ModifyStep(GuiState& g, ArpeggiatorState& s, u32 i, Mutate&& mutate) {
     auto step = s.steps[i].Load(LoadMemoryOrder::Relaxed);
     mutate(step);
     s.steps[i].Store(step, StoreMemoryOrder::Relaxed);
+    MarkStatePartChanged(g.engine.processor, StateSnapshotPart::ArpSteps);
 }
 
 void DoArpStepSequencer(GuiState& g,
@@ -154,7 +155,9 @@ void DoArpStepSequencer(GuiState& g,
             auto const set_vel_at = [&](u32 step_index, f32 vel) {
                 while (step_index > 0 && snapshot.StepAt(step_index).tie)
                     --step_index;
-                ModifyStep(arp_state, step_index, [vel](ArpStep& s) { s.velocity = ArpStep::From01(vel); });
+                ModifyStep(g, arp_state, step_index, [vel](ArpStep& s) {
+                    s.velocity = ArpStep::From01(vel);
+                });
             };
 
             auto const curr_sf = pos_to_step(io.cursor_pos.x);
@@ -374,7 +377,7 @@ void DoArpStepSequencer(GuiState& g,
                 imgui.PushId((u64)i);
                 auto const toggle_id = imgui.MakeId(SourceLocationHash());
                 if (imgui.ButtonBehaviour(label_click_rect, toggle_id, {})) {
-                    ModifyStep(arp_state, i, [](ArpStep& s) { s.on = !s.on; });
+                    ModifyStep(g, arp_state, i, [](ArpStep& s) { s.on = !s.on; });
                     RecordUndoableStep(g.engine, "Arp step on/off"_s);
                 }
                 label_hot = imgui.IsHot(toggle_id);
@@ -403,7 +406,7 @@ void DoArpStepSequencer(GuiState& g,
                                              })
                                         .button_fired) {
                                     for (u32 j = 0; j < active_steps; ++j)
-                                        ModifyStep(arp_state, j, [](ArpStep& s) { s.on = true; });
+                                        ModifyStep(g, arp_state, j, [](ArpStep& s) { s.on = true; });
                                     RecordUndoableStep(g.engine, "Reset all arp steps"_s);
                                 }
                             },
@@ -532,9 +535,9 @@ void DoArpStepSequencer(GuiState& g,
                 is_fixed ? "Reset every step's note to C4 (60)"_s : "Reset every step's pitch offset to 0"_s,
                 [&]() {
                     if (is_fixed)
-                        ModifyStep(arp_state, i, [](ArpStep& s) { s.note = 60; });
+                        ModifyStep(g, arp_state, i, [](ArpStep& s) { s.note = 60; });
                     else
-                        ModifyStep(arp_state, i, [](ArpStep& s) { s.interval = 0; });
+                        ModifyStep(g, arp_state, i, [](ArpStep& s) { s.interval = 0; });
                     RecordUndoableStep(g.engine, "Reset arp step note"_s);
                 },
                 [&]() {
@@ -542,9 +545,9 @@ void DoArpStepSequencer(GuiState& g,
                     for (u32 j = 0; j < active_steps; ++j) {
                         if (j == i) continue;
                         if (is_fixed)
-                            ModifyStep(arp_state, j, [n = this_step.note](ArpStep& s) { s.note = n; });
+                            ModifyStep(g, arp_state, j, [n = this_step.note](ArpStep& s) { s.note = n; });
                         else
-                            ModifyStep(arp_state, j, [iv = this_step.interval](ArpStep& s) {
+                            ModifyStep(g, arp_state, j, [iv = this_step.interval](ArpStep& s) {
                                 s.interval = iv;
                             });
                     }
@@ -553,9 +556,9 @@ void DoArpStepSequencer(GuiState& g,
                 [&]() {
                     for (u32 j = 0; j < active_steps; ++j)
                         if (is_fixed)
-                            ModifyStep(arp_state, j, [](ArpStep& s) { s.note = 60; });
+                            ModifyStep(g, arp_state, j, [](ArpStep& s) { s.note = 60; });
                         else
-                            ModifyStep(arp_state, j, [](ArpStep& s) { s.interval = 0; });
+                            ModifyStep(g, arp_state, j, [](ArpStep& s) { s.interval = 0; });
                     RecordUndoableStep(g.engine, "Reset all arp step notes"_s);
                 });
 
@@ -565,21 +568,21 @@ void DoArpStepSequencer(GuiState& g,
 
             if (dragger_result.value_changed) {
                 if (is_fixed)
-                    ModifyStep(arp_state, i, [val](ArpStep& s) {
+                    ModifyStep(g, arp_state, i, [val](ArpStep& s) {
                         s.note = (u7)Clamp((int)(val + 0.5f), 0, 127);
                     });
                 else
-                    ModifyStep(arp_state, i, [val](ArpStep& s) {
+                    ModifyStep(g, arp_state, i, [val](ArpStep& s) {
                         s.interval = (s8)Clamp((int)Round(val), -48, 48);
                     });
             }
             if (dragger_result.new_string_value) {
                 if (is_fixed) {
                     if (auto const midi_note = MidiNoteFromName(*dragger_result.new_string_value))
-                        ModifyStep(arp_state, i, [n = *midi_note](ArpStep& s) { s.note = n; });
+                        ModifyStep(g, arp_state, i, [n = *midi_note](ArpStep& s) { s.note = n; });
                 } else {
                     if (auto const o = ParseInt(*dragger_result.new_string_value, ParseIntBase::Decimal))
-                        ModifyStep(arp_state,
+                        ModifyStep(g, arp_state,
                                    i,
                                    [v = (s8)Clamp((s64)o.Value(), (s64)-48, (s64)48)](ArpStep& s) {
                                        s.interval = v;
@@ -635,7 +638,7 @@ void DoArpStepSequencer(GuiState& g,
                 imgui.PushId((u64)(i + (k_arp_max_steps * 2)));
                 auto const tie_id = imgui.MakeId(SourceLocationHash());
                 if (imgui.ButtonBehaviour(tie_click_rect, tie_id, {})) {
-                    ModifyStep(arp_state, i, [](ArpStep& s) { s.tie = !s.tie; });
+                    ModifyStep(g, arp_state, i, [](ArpStep& s) { s.tie = !s.tie; });
                     RecordUndoableStep(g.engine, "Arp step tie"_s);
                 }
                 tie_hot = imgui.IsHot(tie_id);
@@ -712,20 +715,20 @@ void DoArpStepSequencer(GuiState& g,
                     "Reset gate to 100%"_s,
                     "Reset every step's gate to 100%"_s,
                     [&]() {
-                        ModifyStep(arp_state, i, [](ArpStep& s) { s.gate = ArpStep::From01(1.0f); });
+                        ModifyStep(g, arp_state, i, [](ArpStep& s) { s.gate = ArpStep::From01(1.0f); });
                         RecordUndoableStep(g.engine, "Reset arp step gate"_s);
                     },
                     [&]() {
                         auto const this_gate = snapshot.StepAt(i).gate;
                         for (u32 j = 0; j < active_steps; ++j) {
                             if (j == i) continue;
-                            ModifyStep(arp_state, j, [g = this_gate](ArpStep& s) { s.gate = g; });
+                            ModifyStep(g, arp_state, j, [g = this_gate](ArpStep& s) { s.gate = g; });
                         }
                         RecordUndoableStep(g.engine, "Apply arp step gate to all"_s);
                     },
                     [&]() {
                         for (u32 j = 0; j < active_steps; ++j)
-                            ModifyStep(arp_state, j, [](ArpStep& s) { s.gate = ArpStep::From01(1.0f); });
+                            ModifyStep(g, arp_state, j, [](ArpStep& s) { s.gate = ArpStep::From01(1.0f); });
                         RecordUndoableStep(g.engine, "Reset all arp step gates"_s);
                     });
 
@@ -735,12 +738,14 @@ void DoArpStepSequencer(GuiState& g,
 
                 if (dragger_result.value_changed) {
                     auto const new_gate = Clamp(gate_pct / 100.0f, 0.05f, 1.0f);
-                    ModifyStep(arp_state, i, [new_gate](ArpStep& s) { s.gate = ArpStep::From01(new_gate); });
+                    ModifyStep(g, arp_state, i, [new_gate](ArpStep& s) {
+                        s.gate = ArpStep::From01(new_gate);
+                    });
                 }
                 if (dragger_result.new_string_value) {
                     if (auto const o = ParseInt(*dragger_result.new_string_value, ParseIntBase::Decimal)) {
                         auto const new_gate = Clamp((f32)o.Value() / 100.0f, 0.05f, 1.0f);
-                        ModifyStep(arp_state, i, [new_gate](ArpStep& s) {
+                        ModifyStep(g, arp_state, i, [new_gate](ArpStep& s) {
                             s.gate = ArpStep::From01(new_gate);
                         });
                     }
@@ -822,7 +827,7 @@ void DoArpStepSequencer(GuiState& g,
                                                  .no_icon_gap = true,
                                              })
                                         .button_fired) {
-                                    ModifyStep(arp_state, i, [](ArpStep& s) { s = {}; });
+                                    ModifyStep(g, arp_state, i, [](ArpStep& s) { s = {}; });
                                     RecordUndoableStep(g.engine, "Reset arp step"_s);
                                 }
 
@@ -839,7 +844,7 @@ void DoArpStepSequencer(GuiState& g,
                                     auto const this_step = snapshot.StepAt(i);
                                     for (u32 j = 0; j < active_steps; ++j) {
                                         if (j == i) continue;
-                                        ModifyStep(arp_state, j, [this_step](ArpStep& s) {
+                                        ModifyStep(g, arp_state, j, [this_step](ArpStep& s) {
                                             s.velocity = this_step.velocity;
                                             s.gate = this_step.gate;
                                             s.on = this_step.on;
@@ -859,7 +864,7 @@ void DoArpStepSequencer(GuiState& g,
                                              })
                                         .button_fired) {
                                     for (u32 j = 0; j < active_steps; ++j)
-                                        ModifyStep(arp_state, j, [](ArpStep& s) { s = {}; });
+                                        ModifyStep(g, arp_state, j, [](ArpStep& s) { s = {}; });
                                     RecordUndoableStep(g.engine, "Reset all arp steps"_s);
                                 }
 
@@ -873,6 +878,7 @@ void DoArpStepSequencer(GuiState& g,
                                                                   : (j + 1) % active_steps;
                                         arp_state.steps[j].Store(snap[src], StoreMemoryOrder::Relaxed);
                                     }
+                                    MarkStatePartChanged(g.engine.processor, StateSnapshotPart::ArpSteps);
                                 };
 
                                 if (MenuItem(
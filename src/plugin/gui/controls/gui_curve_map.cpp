@@ -494,6 +494,8 @@ void DoCurveMap(GuiState& g,
     }
 
     if (changed_values) curve_map.RenderCurveToLookupTable();
+    if (changed_values || remove_real_index || new_point_at_window_pos)
+        MarkStatePartChanged(g.engine.processor, StateSnapshotPart::VelocityCurves);
 
     if (velocity_marker) {
         auto const value = curve_map.ValueAt(working, *velocity_marker);
@@ -68,7 +68,7 @@ static Optional<ImageBytes> ImagePixelsFromLibrary(sample_lib::LibraryId lib_id,
 
     if (!path_in_lib) return err("does not have", k_nullopt);
 
-    auto reader = TRY_OR(lib->create_file_reader(*lib, *path_in_lib), return err("error opening", error));
+    auto reader = TRY_OR(lib->create_file_reader(*lib, *path_in_lib, {}), return err("error opening", error));
 
     auto const file_data = TRY_OR(reader.ReadOrFetchAll(scratch_arena), return err("error reading", error));
 
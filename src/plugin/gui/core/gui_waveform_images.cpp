@@ -71,7 +71,7 @@ static Optional<u64> SourceHashForInstrument(Instrument const& inst, u64 audio_d
         case InstrumentType::Sampler: {
             if (audio_data_hash_override) return audio_data_hash_override;
             auto sampled_inst = inst.GetFromTag<InstrumentType::Sampler>();
-            auto audio_data = sampled_inst->file_for_gui_waveform;
+            auto audio_data = sampled_inst->GuiWaveformAudioData();
             if (!audio_data) return k_nullopt;
             return audio_data->hash;
         }
@@ -85,8 +85,8 @@ static Optional<u64> SourceHashForInstrument(Instrument const& inst, u64 audio_d
 static AudioData const* FindAudioDataByHash(Instrument const& inst, u64 hash) {
     if (inst.tag != InstrumentType::Sampler) return nullptr;
     auto sampled_inst = inst.GetFromTag<InstrumentType::Sampler>();
-    for (auto const audio_data : sampled_inst->audio_datas)
-        if (audio_data && audio_data->hash == hash) return audio_data;
+    for (auto const [i, audio_data] : Enumerate(sampled_inst->audio_datas))
+        if (audio_data && sampled_inst->AudioDataLoaded(i) && audio_data->hash == hash) return audio_data;
     return nullptr;
 }
 
@@ -122,8 +122,9 @@ Optional<ImageID> GetWaveformImage(WaveformImagesTable& table,
             if (audio_data_hash_override) audio_data = FindAudioDataByHash(inst, audio_data_hash_override);
             if (!audio_data) {
                 auto sampled_inst = inst.GetFromTag<InstrumentType::Sampler>();
-                audio_data = sampled_inst->file_for_gui_waveform;
+                audio_data = sampled_inst->GuiWaveformAudioData();
             }
+            if (!audio_data) return k_nullopt; // Still loading.
             source = audio_data;
             break;
         }
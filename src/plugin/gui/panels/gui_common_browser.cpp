@@ -191,6 +191,16 @@ bool MatchesFilterSearch(String filter_text, String search_text) {
     return ContainsCaseInsensitiveAscii(filter_text, search_text);
 }
 
+bool MatchesSearch(CommonBrowserState const& state,
+                   SearchIndex const& index,
+                   Optional<usize> item_index,
+                   String item_name) {
+    if (state.search.size == 0) return true;
+    if (!item_index || *item_index >= index.NumItems())
+        return ContainsCaseInsensitiveAscii(item_name, state.search);
+    return state.search_results_cache.Matches(index, state.search, (u32)*item_index);
+}
+
 constexpr auto k_right_click_menu_popup_id = (imgui::Id)SourceLocationHash();
 
 void DoRightClickMenuForBox(GuiBuilder& builder,
@@ -8,6 +8,7 @@
 #include "common_infrastructure/persistent_store.hpp"
 #include "common_infrastructure/preferences.hpp"
 #include "common_infrastructure/sample_library/server/sample_library_server.hpp"
+#include "common_infrastructure/search_index.hpp"
 #include "common_infrastructure/tags.hpp"
 
 #include "gui/core/gui_library_images.hpp"
@@ -239,6 +240,7 @@ struct CommonBrowserState {
     DynamicArray<u64> expanded_filter_headers {Malloc::Instance()};
 
     DynamicArrayBounded<char, 100> search {};
+    mutable SearchResultsCache search_results_cache {}; // Results for 'search', reused across frames.
     DynamicArrayBounded<char, 100> filter_search {};
     FilterMode filter_mode = FilterMode::Single;
     bool scroll_items_to_start {};
@@ -581,3 +583,10 @@ void DoRightClickMenuForBox(GuiBuilder& builder,
                             RightClickMenuState::Function const& do_menu);
 
 bool MatchesFilterSearch(String filter_text, String search_text);
+
+// Whether the item matches state.search. item_index is the item's index in the search index; items that
+// aren't in the index (k_nullopt) fall back to searching item_name directly.
+bool MatchesSearch(CommonBrowserState const& state,
+                   SearchIndex const& index,
+                   Optional<usize> item_index,
+                   String item_name);
@@ -379,6 +379,7 @@ static void DoSwitchboard(GuiState& g, Box root) {
                                       new_state ? 1.0f : 0.0f,
                                       {});
                     g.engine.fx_visible.SetToValue(ToInt(fx->type), new_state);
+                    MarkStatePartChanged(g.engine.processor, StateSnapshotPart::FxVisible);
                 }
 
                 auto const window_grab_r = ({
@@ -457,6 +458,7 @@ static void DoSwitchboard(GuiState& g, Box root) {
             MoveEffectToNewSlot(ordered_effects, g.dragging_fx_switch->fx, g.dragging_fx_switch->drop_slot);
             g.engine.processor.desired_effects_order.Store(EncodeEffectsArray(ordered_effects),
                                                            StoreMemoryOrder::Release);
+            MarkStatePartChanged(g.engine.processor, StateSnapshotPart::FxOrder);
             g.engine.processor.inbox_flags.FetchOr(audio_thread_inbox::FxOrderChanged,
                                                    RmwMemoryOrder::Release);
             g.engine.processor.host.request_process(&g.engine.processor.host);
@@ -1234,6 +1236,7 @@ DoEffectSections(GuiState& g, GuiFrameContext const& frame_context, Box root, Ef
                 DEFER { EndUndoableStep(g.engine); };
                 SetParameterValue(g.engine.processor, k_effect_info[ToInt(fx->type)].on_param_index, 0, {});
                 g.engine.fx_visible.SetToValue(ToInt(fx->type), false);
+                MarkStatePartChanged(g.engine.processor, StateSnapshotPart::FxVisible);
             }
         }
 
@@ -1407,6 +1410,7 @@ static void DoEffectDragAndDrop(GuiState& g,
     if (effects_order_changed) {
         engine.processor.desired_effects_order.Store(EncodeEffectsArray(ordered_effects),
                                                      StoreMemoryOrder::Release);
+        MarkStatePartChanged(engine.processor, StateSnapshotPart::FxOrder);
         engine.processor.inbox_flags.FetchOr(audio_thread_inbox::FxOrderChanged, RmwMemoryOrder::Release);
         engine.processor.host.request_process(&engine.processor.host);
         RecordUndoableStep(engine, "FX order");
@@ -1473,6 +1477,7 @@ void MidPanelEffectsContent(GuiBuilder& builder,
             for (auto const fx : g.engine.processor.effects_ordered_by_type) {
                 bool const on = RandomIntInRange<u32>(g.engine.random_seed, 0, 1) != 0;
                 g.engine.fx_visible.SetToValue(ToInt(fx->type), on);
+                MarkStatePartChanged(g.engine.processor, StateSnapshotPart::FxVisible);
                 SetParameterValue(g.engine.processor,
                                   k_effect_info[ToInt(fx->type)].on_param_index,
                                   on ? 1.0f : 0.0f,
@@ -1485,6 +1490,7 @@ void MidPanelEffectsContent(GuiBuilder& builder,
             Shuffle(ordered_effects, g.engine.random_seed);
             g.engine.processor.desired_effects_order.Store(EncodeEffectsArray(ordered_effects),
                                                            StoreMemoryOrder::Relaxed);
+            MarkStatePartChanged(g.engine.processor, StateSnapshotPart::FxOrder);
         }
     }
 
@@ -1535,6 +1541,7 @@ void MidPanelEffectsContent(GuiBuilder& builder,
                 if (!g.engine.fx_visible.Get(ToInt(fx->type))) continue;
                 SetParameterValue(g.engine.processor, k_effect_info[ToInt(fx->type)].on_param_index, 0, {});
                 g.engine.fx_visible.SetToValue(ToInt(fx->type), false);
+                MarkStatePartChanged(g.engine.processor, StateSnapshotPart::FxVisible);
             }
         }
     }
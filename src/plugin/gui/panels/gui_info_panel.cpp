@@ -313,6 +313,12 @@ static void MetricsInfoPanel(GuiBuilder& builder, InfoPanelContext& context, Inf
         buffer,
         "Samples RAM usage (all instances): {}",
         fmt::PrettyFileSize((f64)context.server.total_bytes_used_by_samples.Load(LoadMemoryOrder::Relaxed))));
+    do_line(fmt::Assign(
+        buffer,
+        "Samples memory pool: {} reserved, {} locked, {.0}% fragmented",
+        fmt::PrettyFileSize((f64)context.server.sample_memory_reserved_bytes.Load(LoadMemoryOrder::Relaxed)),
+        fmt::PrettyFileSize((f64)context.server.sample_memory_locked_bytes.Load(LoadMemoryOrder::Relaxed)),
+        context.server.sample_memory_fragmentation.Load(LoadMemoryOrder::Relaxed) * 100));
     do_line(fmt::Assign(buffer,
                         "Num loaded instruments (all instances): {}",
                         context.server.num_insts_loaded.Load(LoadMemoryOrder::Relaxed)));
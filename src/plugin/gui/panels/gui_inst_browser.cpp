@@ -28,17 +28,15 @@ static Optional<InstrumentCursor> CurrentCursor(InstBrowserContext const& contex
     return k_nullopt;
 }
 
-static bool InstMatchesSearch(sample_lib::Instrument const& inst, String search) {
-    if (ContainsCaseInsensitiveAscii(inst.name, search)) return true;
-    return false;
-}
-
+// inst_index is the index into the library's sorted_instruments, or k_nullopt for instruments that aren't
+// part of a library's search index, such as the waveforms.
 static bool ShouldSkipInstrument(InstBrowserContext const& context,
                                  InstBrowserState const& state,
-                                 sample_lib::Instrument const& inst) {
+                                 sample_lib::Instrument const& inst,
+                                 Optional<usize> inst_index) {
     auto& common_state = state.common_state;
 
-    if (common_state.search.size && !InstMatchesSearch(inst, common_state.search)) return true;
+    if (!MatchesSearch(common_state, inst.library.instrument_search_index, inst_index, inst.name)) return true;
 
     return IsFilteredOut(common_state, [&](usize index, FilterSelection const& filter) -> bool {
         switch ((BrowserFilter)index) {
@@ -117,7 +115,7 @@ static Optional<InstrumentCursor> IterateInstrument(InstBrowserContext const& co
                  })) {
             auto const& inst = *lib.sorted_instruments[cursor.inst_index];
 
-            if (ShouldSkipInstrument(context, state, inst)) continue;
+            if (ShouldSkipInstrument(context, state, inst, cursor.inst_index)) continue;
 
             return cursor;
         }
@@ -259,7 +257,7 @@ static void InstBrowserWaveformItems(GuiBuilder& builder,
             .folder = &pseudo_folder,
         };
 
-        if (ShouldSkipInstrument(context, state, pseudo_inst)) continue;
+        if (ShouldSkipInstrument(context, state, pseudo_inst, k_nullopt)) continue;
 
         auto const inst_hash = sample_lib::PersistentInstHash(pseudo_inst);
         auto const is_current = waveform_type == context.layer.instrument_id.TryGetOpt<WaveformType>();
@@ -537,8 +535,8 @@ void DoInstBrowserPopup(GuiBuilder& builder, InstBrowserContext& context, InstBr
         root_folder.InsertGrowIfNeeded(builder.arena,
                                        &l->root_folders[ToInt(sample_lib::ResourceType::Instrument)]);
 
-        for (auto const& inst : l->sorted_instruments) {
-            auto const skip = ShouldSkipInstrument(context, state, *inst);
+        for (auto const [inst_index, inst] : Enumerate(l->sorted_instruments)) {
+            auto const skip = ShouldSkipInstrument(context, state, *inst, inst_index);
 
             if (IsFavourite(context.prefs, k_favourite_inst_key, sample_lib::PersistentInstHash(*inst))) {
                 if (!skip) ++favourites_info.num_used_in_items_lists;
@@ -17,15 +17,12 @@ static Optional<IrCursor> CurrentCursor(IrBrowserContext const& context, sample_
     return k_nullopt;
 }
 
-static bool IrMatchesSearch(sample_lib::ImpulseResponse const& ir, String search) {
-    if (ContainsCaseInsensitiveAscii(ir.name, search)) return true;
-    return false;
-}
-
+// ir_index is the index into the library's sorted_irs.
 static bool ShouldSkipIr(IrBrowserContext const& context,
                          IrBrowserState const& state,
-                         sample_lib::ImpulseResponse const& ir) {
-    if (state.common_state.search.size && !IrMatchesSearch(ir, state.common_state.search)) return true;
+                         sample_lib::ImpulseResponse const& ir,
+                         usize ir_index) {
+    if (!MatchesSearch(state.common_state, ir.library.ir_search_index, ir_index, ir.name)) return true;
 
     return IsFilteredOut(state.common_state, [&](usize index, FilterSelection const& filter) -> bool {
         switch ((BrowserFilter)index) {
@@ -103,7 +100,7 @@ static Optional<IrCursor> IterateIr(IrBrowserContext const& context,
                  })) {
             auto const& ir = *lib.sorted_irs[cursor.ir_index];
 
-            if (ShouldSkipIr(context, state, ir)) continue;
+            if (ShouldSkipIr(context, state, ir, cursor.ir_index)) continue;
 
             return cursor;
         }
@@ -327,8 +324,8 @@ void DoIrBrowserPopup(GuiBuilder& builder, IrBrowserContext& context, IrBrowserS
         if (auto& f = l->root_folders[ToInt(sample_lib::ResourceType::Ir)]; f.first_child)
             root_folder.InsertGrowIfNeeded(builder.arena, &f);
 
-        for (auto const& ir : l->sorted_irs) {
-            auto const skip = ShouldSkipIr(context, state, *ir);
+        for (auto const [ir_index, ir] : Enumerate(l->sorted_irs)) {
+            auto const skip = ShouldSkipIr(context, state, *ir, ir_index);
 
             if (IsFavourite(context.prefs, k_favourite_ir_key, sample_lib::PersistentIrHash(*ir))) {
                 if (!skip) ++favourites_info.num_used_in_items_lists;
@@ -1623,6 +1623,7 @@ HarmonySelectionMenu(GuiState& g, LayerProcessor& layer, Box parent, HarmonyInte
                      })
                 .button_fired) {
             layer.harmony_intervals.AssignBlockwise(MakeHarmonyPreset());
+            MarkStatePartChanged(g.engine.processor, StateSnapshotPart::HarmonyIntervals);
             RecordUndoableStep(g.engine, "Harmony intervals"_s);
         }
     });
@@ -1707,6 +1708,8 @@ HarmonySelectionMenu(GuiState& g, LayerProcessor& layer, Box parent, HarmonyInte
                                                            SourceLocationHash() + i);
                                 if (item.button_fired) {
                                     layer.harmony_intervals.AssignBlockwise(preset.intervals);
+                                    MarkStatePartChanged(g.engine.processor,
+                                                         StateSnapshotPart::HarmonyIntervals);
                                     RecordUndoableStep(g.engine, "Harmony preset"_s);
                                 }
                             }
@@ -1776,6 +1779,8 @@ HarmonySelectionMenu(GuiState& g, LayerProcessor& layer, Box parent, HarmonyInte
 
                                     if (g.imgui.ButtonBehaviour(cell_r, id, imgui::ButtonConfig {})) {
                                         layer.harmony_intervals.Flip(bit);
+                                        MarkStatePartChanged(g.engine.processor,
+                                                             StateSnapshotPart::HarmonyIntervals);
                                         RecordUndoableStep(g.engine, "Harmony interval"_s);
                                     }
 
@@ -1879,6 +1884,7 @@ static void DoPlaybackPage(GuiState& g, u8 layer_index, Box parent) {
                     {});
             }
             layer.harmony_intervals.AssignBlockwise(MakeHarmonyPreset(Array {-12, 12}));
+            MarkStatePartChanged(g.engine.processor, StateSnapshotPart::HarmonyIntervals);
         }
     }
 
@@ -2562,6 +2568,7 @@ static void DoArpPage(GuiState& g, u8 layer_index, Box parent) {
                 } else {
                     arp_state.current_step_for_gui.Store(0, StoreMemoryOrder::Relaxed);
                     arp_state.recording.Store(true, StoreMemoryOrder::Relaxed);
+                    MarkStatePartChanged(g.engine.processor, StateSnapshotPart::ArpSteps);
                 }
             }
         }
@@ -2589,8 +2596,10 @@ static void DoArpPage(GuiState& g, u8 layer_index, Box parent) {
                                                         (int)Min(num_slices - 1, (u32)255),
                                                         fmt::Format(g.scratch_arena, "{}", offset_current),
                                                         secondary_greyed);
-            if (offset_new && !secondary_greyed)
+            if (offset_new && !secondary_greyed) {
                 arp_state.slice_start_offset.Store((u8)*offset_new, StoreMemoryOrder::Relaxed);
+                MarkStatePartChanged(g.engine.processor, StateSnapshotPart::SliceArpConfigs);
+            }
 
             auto const length_current = (int)arp_state.slice_loop_length.Load(LoadMemoryOrder::Relaxed);
             auto const length_new = do_int_dragger_cell(
@@ -2601,8 +2610,10 @@ static void DoArpPage(GuiState& g, u8 layer_index, Box parent) {
                 (int)Min(num_slices, (u32)255),
                 length_current ? (String)fmt::Format(g.scratch_arena, "{}", length_current) : "All"_s,
                 secondary_greyed);
-            if (length_new && !secondary_greyed)
+            if (length_new && !secondary_greyed) {
                 arp_state.slice_loop_length.Store((u8)*length_new, StoreMemoryOrder::Relaxed);
+                MarkStatePartChanged(g.engine.processor, StateSnapshotPart::SliceArpConfigs);
+            }
         }
     }
 }
@@ -589,8 +589,10 @@ void DoMacrosEditGui(GuiState& g, Box const& parent) {
                               .selection_col = {.c = Col::Highlight, .alpha = 128},
                           });
 
-            if (result.enter_pressed || result.buffer_changed)
+            if (result.enter_pressed || result.buffer_changed) {
                 dyn::AssignFitInCapacity(g.engine.macro_names[macro_index], result.text);
+                MarkStatePartChanged(g.engine.processor, StateSnapshotPart::MacroNames);
+            }
 
             if (g.imgui.TextInputJustUnfocused(name_input.imgui_id))
                 RecordUndoableStep(g.engine, "Macro rename");
@@ -621,6 +621,7 @@ static void GeneralPreferencesPanel(GuiBuilder& builder, PreferencesPanelContext
         if (k_num_experimental_parameters)
             Setting(builder, context, options_rhs_column, ExperimentalParamsPreferenceDescriptor());
         Setting(builder, context, options_rhs_column, AbbreviatedParamNamesPreferenceDescriptor());
+        Setting(builder, context, options_rhs_column, SampleMemoryLockBudgetPreferenceDescriptor());
     }
 }
 
@@ -108,8 +108,11 @@ static bool ShouldSkipPreset(PresetBrowserContext const& context,
                              PresetFolder::Preset const& preset) {
     ASSERT(folder.folder);
     if (state.common_state.search.size &&
-        (!ContainsCaseInsensitiveAscii(preset.name, state.common_state.search) &&
-         !ContainsCaseInsensitiveAscii(folder.folder->folder, state.common_state.search)))
+        !ContainsCaseInsensitiveAscii(folder.folder->folder, state.common_state.search) &&
+        !MatchesSearch(state.common_state,
+                       folder.folder->search_index,
+                       (usize)(&preset - folder.folder->presets.data),
+                       preset.name))
         return true;
 
     return IsFilteredOut(state.common_state, [&](usize index, FilterSelection const& filter) -> bool {
@@ -436,6 +439,24 @@ void PresetBrowserItems(GuiBuilder& builder, PresetBrowserContext& context, Pres
 
     auto const current_loaded_cursor = ResolveCurrentLoadedCursor(context);
 
+    auto const prefetch = [&](PresetCursor c, PresetPrefetchReason reason) {
+        auto const& folder = context.presets_snapshot.folders[c.folder_index];
+        PrefetchPresetFile(context.engine,
+                           reason,
+                           folder->folder->FullPathForPreset(folder->folder->presets[c.preset_index],
+                                                             builder.arena));
+    };
+
+    // The presets either side of the current one are the likeliest to be chosen next.
+    if (current_loaded_cursor) {
+        if (auto const next =
+                IteratePreset(context, state, *current_loaded_cursor, SearchDirection::Forward, false))
+            prefetch(*next, PresetPrefetchReason::Next);
+        if (auto const prev =
+                IteratePreset(context, state, *current_loaded_cursor, SearchDirection::Backward, false))
+            prefetch(*prev, PresetPrefetchReason::Previous);
+    }
+
     Optional<u64> previous_folder_hash = {};
 
     Optional<BrowserSection> folder_section;
@@ -587,6 +608,15 @@ void PresetBrowserItems(GuiBuilder& builder, PresetBrowserContext& context, Pres
                 }
             }
 
+            if (!is_current) {
+                auto const& nav = state.common_state.keyboard_navigation;
+                constexpr auto k_items_panel = BrowserKeyboardNavigation::Panel::Items;
+                if (item.box.is_hot) prefetch(cursor, PresetPrefetchReason::Hovered);
+                if (nav.focused_panel == k_items_panel &&
+                    nav.focused_items[ToInt(k_items_panel)] == preset.full_path_hash)
+                    prefetch(cursor, PresetPrefetchReason::KeyboardFocused);
+            }
+
             if (item.fired) {
                 if (!is_current)
                     LoadPreset(context, state, cursor, false);
@@ -262,6 +262,7 @@ constexpr u32 k_save_panel_contents_imgui_id = (u32)SourceLocationHash();
 static void CommitMetadataToEngine(Engine& engine, SavePresetPanelState const& state) {
     if (engine.state_metadata == state.metadata) return;
     engine.state_metadata = state.metadata;
+    MarkStatePartChanged(engine.processor, StateSnapshotPart::Metadata);
     RecordUndoableStep(engine, "Edit preset metadata"_s);
 }
 
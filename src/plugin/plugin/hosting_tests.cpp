@@ -7,6 +7,7 @@
 #include "tests/framework.hpp"
 #include "utils/reader.hpp"
 
+#include "common_infrastructure/audio_utils.hpp"
 #include "common_infrastructure/state/state_coding.hpp"
 #include "common_infrastructure/state/state_snapshot.hpp"
 
@@ -16,6 +17,7 @@
 #include "clap/ext/params.h"
 #include "clap/ext/state.h"
 #include "clap/ext/thread-check.h"
+#include "clap/ext/thread-pool.h"
 #include "clap/factory/plugin-factory.h"
 #include "plugin/plugin.hpp"
 #include "plugin/processing_utils/midi.hpp"
@@ -72,6 +74,39 @@ struct TestHost {
             },
     };
 
+    clap_host_thread_pool const host_thread_pool {
+        .request_exec =
+            [](clap_host const* h, u32 num_tasks) {
+                auto& test_host = *(TestHost*)h->host_data;
+                ASSERT(test_host.plugin_created);
+                return test_host.ExecThreadPoolTasks(num_tasks);
+            },
+    };
+
+    // Like a real host's thread pool: the tasks are shared between a few threads and the calling thread, so
+    // they run concurrently and in no particular order.
+    bool ExecThreadPoolTasks(u32 num_tasks) {
+        ASSERT(plugin);
+        auto const plugin_thread_pool =
+            (clap_plugin_thread_pool const*)plugin->get_extension(plugin, CLAP_EXT_THREAD_POOL);
+        if (!plugin_thread_pool) return false;
+
+        Atomic<u32> next_task {0};
+        auto const run_tasks = [&]() {
+            for (auto task = next_task.FetchAdd(1, RmwMemoryOrder::Relaxed); task < num_tasks;
+                 task = next_task.FetchAdd(1, RmwMemoryOrder::Relaxed))
+                plugin_thread_pool->exec(plugin, task);
+        };
+
+        Array<Thread, 2> threads {};
+        for (auto& thread : threads)
+            thread.Start(run_tasks, "test-pool");
+        run_tasks();
+        for (auto& thread : threads)
+            thread.Join();
+        return true;
+    }
+
     clap_host_t const host {
         .clap_version = CLAP_VERSION,
         .host_data = this,
@@ -92,6 +127,8 @@ struct TestHost {
                 return &test_host.host_thread_check;
             else if (NullTermStringsEqual(extension_id, k_floe_clap_extension_id))
                 return &test_host.floe_host_ext;
+            else if (NullTermStringsEqual(extension_id, CLAP_EXT_THREAD_POOL))
+                return test_host.thread_pool_enabled ? &test_host.host_thread_pool : nullptr;
 
             return nullptr;
         },
@@ -114,6 +151,8 @@ struct TestHost {
     Atomic<bool> callback_requested {false};
     FloeClapExtensionHost floe_host_ext {};
     bool plugin_created = false;
+    bool thread_pool_enabled = false;
+    clap_plugin const* plugin {};
 };
 
 struct EventQueue {
@@ -182,6 +221,7 @@ struct ProcessTestOptions {
     u32 constant_block_size; // 0 means random block size
     EventQueue events; // ordered by time, time is in overall frames not per-block
     bool capture_output = false;
+    f64* process_seconds = nullptr; // If set, receives the total time spent inside plugin->process.
 };
 
 constexpr usize k_max_test_block_size = 1024;
@@ -288,7 +328,9 @@ Process(tests::Tester& tester, clap_plugin const* plugin, ArenaAllocator& arena,
 
         tester.log.Debug("processing {} frames with {} events", block_size, events.size);
 
+        Stopwatch const stopwatch;
         auto const status = plugin->process(plugin, &process);
+        if (options.process_seconds) *options.process_seconds += stopwatch.SecondsElapsed();
         CHECK(status != CLAP_PROCESS_ERROR);
 
         for (auto const c : Range(options.num_channels)) {
@@ -478,14 +520,14 @@ static void LoadState(tests::Tester& tester, clap_plugin const* plugin, Span<u8
     REQUIRE(state_ext->load(plugin, &stream));
 }
 
-static void ProcessWithState(tests::Tester& tester,
-                             clap_plugin const* plugin,
-                             TestHost& test_host,
-                             StateProperties state_properties,
-                             ProcessTestOptions options) {
+static Span<Span<f32>> ProcessWithEncodedState(tests::Tester& tester,
+                                               clap_plugin const* plugin,
+                                               TestHost& test_host,
+                                               Span<u8 const> state,
+                                               ProcessTestOptions options) {
     CheckProcessTestOptions(options);
 
-    LoadState(tester, plugin, REQUIRE_UNWRAP(MakeState(tester.scratch_arena, state_properties)));
+    LoadState(tester, plugin, state);
 
     // Floe can't always apply state immediately. Sample libraries might need to be loaded before we have the
     // audio data to play. Here, we wait a little while for this to happen otherwise we might get silence.
@@ -504,7 +546,7 @@ static void ProcessWithState(tests::Tester& tester,
             constexpr f64 k_timeout_ms = 10000;
             if ((TimePoint::Now() - start) > (k_timeout_ms / 1000.0)) {
                 LOG_WARNING("Timeout waiting for state change to complete");
-                return;
+                return {};
             }
 
             SleepThisThread(10);
@@ -543,6 +585,369 @@ static void ProcessWithState(tests::Tester& tester,
                                          .data = captured_output,
                                      }));
     }
+
+    return captured_output;
+}
+
+static Span<Span<f32>> ProcessWithState(tests::Tester& tester,
+                                        clap_plugin const* plugin,
+                                        TestHost& test_host,
+                                        StateProperties state_properties,
+                                        ProcessTestOptions options) {
+    return ProcessWithEncodedState(tester,
+                                   plugin,
+                                   test_host,
+                                   REQUIRE_UNWRAP(MakeState(tester.scratch_arena, state_properties)),
+                                   options);
+}
+
+// Render regressions: a fixed set of patches and MIDI patterns are rendered offline and each render is
+// reduced to a fingerprint which is compared against a baseline in the test files folder. The fingerprint is
+// a loudness envelope and an octave-band spectrum rather than a hash of the samples: it has to survive
+// differences in compilers and instruction sets, but still catch an optimisation that changes the sound. Set
+// FLOE_UPDATE_RENDER_BASELINE=1 to record the baseline after an intentional change; record it from an
+// optimised build so that the CPU costs mean something. A scenario without a baseline is skipped with a
+// warning until one is recorded.
+//
+// The time per sample is always logged. It's only checked against the baseline when
+// FLOE_RENDER_CPU_CHECK=1 is set, because timings on shared or throttled machines are too noisy to gate on.
+
+constexpr auto k_render_baseline_filename = "render_baseline.txt"_s;
+constexpr u32 k_render_envelope_segments = 8;
+constexpr u32 k_render_spectrum_bands = 8; // Octaves, the first starts at bin 4 of the DFT.
+constexpr u32 k_render_dft_size = 2048;
+constexpr u32 k_render_dft_frames = 8; // Spread evenly across the render, per channel.
+constexpr f32 k_render_db_tolerance = 1.0f;
+constexpr f64 k_render_cpu_tolerance = 3.0; // Allowed ratio of measured to baseline CPU cost.
+
+enum class MidiPattern : u8 { SingleNote, Chord, Staccato };
+
+struct RenderScenario {
+    String name; // No spaces, it's the key in the baseline file.
+    String preset_filename; // In the presets test folder. If empty, the state is made from state_properties.
+    StateProperties state_properties;
+    MidiPattern pattern;
+    f64 sample_rate;
+};
+
+constexpr RenderScenario k_render_scenarios[] = {
+    {
+        .name = "sine-preset-single-note"_s,
+        .preset_filename = "sine.floe-preset"_s,
+        .state_properties = {},
+        .pattern = MidiPattern::SingleNote,
+        .sample_rate = 44100,
+    },
+    {
+        .name = "white-noise-preset-chord"_s,
+        .preset_filename = "white-noise.mirage-wraith"_s,
+        .state_properties = {},
+        .pattern = MidiPattern::Chord,
+        .sample_rate = 44100,
+    },
+    {
+        .name = "sine-and-noise-staccato"_s,
+        .preset_filename = {},
+        .state_properties = StateProperties::Sine | StateProperties::WhiteNoise,
+        .pattern = MidiPattern::Staccato,
+        .sample_rate = 48000,
+    },
+    {
+        .name = "all-effects-chord"_s,
+        .preset_filename = {},
+        .state_properties = StateProperties::Ir | StateProperties::Sine | StateProperties::WhiteNoise |
+                            StateProperties::SoundShapersOn,
+        .pattern = MidiPattern::Chord,
+        .sample_rate = 44100,
+    },
+    {
+        .name = "all-effects-staccato-96k"_s,
+        .preset_filename = {},
+        .state_properties = StateProperties::Ir | StateProperties::Sine | StateProperties::SoundShapersOn,
+        .pattern = MidiPattern::Staccato,
+        .sample_rate = 96000,
+    },
+};
+
+static EventQueue MidiPatternEvents(ArenaAllocator& arena, MidiPattern pattern, u32 num_frames) {
+    EventQueue events {};
+    switch (pattern) {
+        case MidiPattern::SingleNote: {
+            events.AppendMidiMessage(arena, 0, MidiMessage::NoteOn(60, 100));
+            events.AppendMidiMessage(arena, num_frames / 2, MidiMessage::NoteOff(60));
+            break;
+        }
+        case MidiPattern::Chord: {
+            Array<u7, 4> const notes {48, 55, 60, 64};
+            for (auto const [i, note] : Enumerate<u32>(notes))
+                events.AppendMidiMessage(arena, i * 1000, MidiMessage::NoteOn(note, 90));
+            for (auto const note : notes)
+                events.AppendMidiMessage(arena, num_frames * 3 / 4, MidiMessage::NoteOff(note));
+            break;
+        }
+        case MidiPattern::Staccato: {
+            constexpr u32 k_num_notes = 16;
+            Array<u7, 4> const notes {60, 63, 67, 70};
+            auto const spacing = num_frames / k_num_notes;
+            for (auto const i : Range(k_num_notes)) {
+                auto const note = notes[i % notes.size];
+                auto const velocity = (u7)(40 + ((i * 29) % 88));
+                events.AppendMidiMessage(arena, i * spacing, MidiMessage::NoteOn(note, velocity));
+                events.AppendMidiMessage(arena, (i * spacing) + (spacing / 3), MidiMessage::NoteOff(note));
+            }
+            break;
+        }
+    }
+    return events;
+}
+
+struct RenderFingerprint {
+    f64 cpu_cost; // Seconds per sample, relative to CalibrationSecondsPerSample().
+    Array<f32, k_render_envelope_segments> envelope_db;
+    Array<f32, k_render_spectrum_bands> spectrum_db;
+};
+
+// The plugin's processing time is divided by the time of this fixed workload, measured on the same machine
+// in the same run, so that the baseline isn't tied to the machine that recorded it.
+static f64 CalibrationSecondsPerSample() {
+    constexpr u32 k_num_samples = 1 << 16;
+    f64 best = LargestRepresentableValue<f64>();
+    for (auto const _ : Range(5)) {
+        u64 seed = 0xca1;
+        f32 y1 = 0;
+        f32 y2 = 0;
+        Stopwatch const stopwatch;
+        for (u32 i = 0; i < k_num_samples; ++i) {
+            auto const x = RandomFloatInRange<f32>(seed, -1, 1);
+            auto const y = (0.2f * x) + (1.6f * y1) - (0.8f * y2);
+            y2 = y1;
+            y1 = y;
+        }
+        [[maybe_unused]] volatile f32 const sink = y1;
+        best = Min(best, stopwatch.SecondsElapsed());
+    }
+    return best / k_num_samples;
+}
+
+static RenderFingerprint FingerprintRender(ArenaAllocator& arena, Span<Span<f32>> channels) {
+    ASSERT(channels.size);
+    auto const num_frames = (u32)channels[0].size;
+    ASSERT(num_frames >= k_render_dft_size);
+
+    RenderFingerprint result {};
+
+    for (auto const segment : Range(k_render_envelope_segments)) {
+        auto const start = num_frames * segment / k_render_envelope_segments;
+        auto const end = num_frames * (segment + 1) / k_render_envelope_segments;
+        f64 sum = 0;
+        for (auto const channel : channels)
+            for (auto const frame : Range(start, end))
+                sum += (f64)channel[frame] * (f64)channel[frame];
+        result.envelope_db[segment] = AmpToDb((f32)Sqrt(sum / (f64)((end - start) * channels.size)));
+    }
+
+    HannWindowedDft dft {arena, k_render_dft_size};
+    Array<f64, k_render_spectrum_bands> band_power {};
+    for (auto const dft_frame : Range(k_render_dft_frames)) {
+        auto const start = (num_frames - k_render_dft_size) * dft_frame / (k_render_dft_frames - 1);
+        for (auto const channel : channels) {
+            dft.SetFrame(channel.SubSpan(start, k_render_dft_size));
+            for (auto const band : Range(k_render_spectrum_bands))
+                for (u32 bin = 4u << band; bin < (8u << band); ++bin)
+                    band_power[band] += dft.BinPower(bin);
+        }
+    }
+
+    // Scaled so that a sine of amplitude A reads roughly A in its band.
+    constexpr f64 k_hann_peak_gain = k_render_dft_size / 4.0;
+    for (auto const band : Range(k_render_spectrum_bands)) {
+        auto const mean_power = band_power[band] / (f64)(k_render_dft_frames * channels.size);
+        result.spectrum_db[band] = AmpToDb((f32)(Sqrt(mean_power) / k_hann_peak_gain));
+    }
+
+    return result;
+}
+
+// One line per scenario: the name, the CPU cost, the envelope and then the spectrum. Lines starting with '#'
+// are comments.
+static Optional<RenderFingerprint> FindInRenderBaseline(String baseline, String scenario_name) {
+    usize line_cursor = 0;
+    while (auto const line = SplitWithIterator(baseline, line_cursor, '\n')) {
+        auto const trimmed = WhitespaceStripped(*line);
+        if (!trimmed.size || trimmed[0] == '#') continue;
+
+        usize cursor = 0;
+        auto const name = SplitWithIterator(trimmed, cursor, ' ', true);
+        if (!name || *name != scenario_name) continue;
+
+        auto const next_value = [&]() -> Optional<f64> {
+            auto const field = SplitWithIterator(trimmed, cursor, ' ', true);
+            if (!field) return k_nullopt;
+            return ParseFloat(*field);
+        };
+
+        RenderFingerprint result {};
+        auto const cpu_cost = next_value();
+        if (!cpu_cost) return k_nullopt;
+        result.cpu_cost = *cpu_cost;
+        for (auto& db : result.envelope_db) {
+            auto const value = next_value();
+            if (!value) return k_nullopt;
+            db = (f32)*value;
+        }
+        for (auto& db : result.spectrum_db) {
+            auto const value = next_value();
+            if (!value) return k_nullopt;
+            db = (f32)*value;
+        }
+        return result;
+    }
+    return k_nullopt;
+}
+
+// Replaces the scenario's line, or appends one.
+static ErrorCodeOr<void> UpdateRenderBaseline(String path,
+                                              String scenario_name,
+                                              RenderFingerprint const& fingerprint,
+                                              ArenaAllocator& arena) {
+    String existing {};
+    if (auto const o = ReadEntireFile(path, arena); o.HasValue())
+        existing = o.Value();
+    else if (o.Error() != FilesystemError::PathDoesNotExist)
+        return o.Error();
+
+    DynamicArray<char> result {arena};
+    if (!existing.size)
+        dyn::AppendSpan(result,
+                        "# Offline render regression baseline, see hosting_tests.cpp.\n"
+                        "# name cpu_cost envelope_db... spectrum_db...\n"_s);
+
+    auto const append_fingerprint = [&]() {
+        fmt::Append(result, "{} {.3}", scenario_name, fingerprint.cpu_cost);
+        for (auto const db : fingerprint.envelope_db)
+            fmt::Append(result, " {.2}", db);
+        for (auto const db : fingerprint.spectrum_db)
+            fmt::Append(result, " {.2}", db);
+        dyn::Append(result, '\n');
+    };
+
+    bool replaced = false;
+    usize line_cursor = 0;
+    while (auto const line = SplitWithIterator(existing, line_cursor, '\n')) {
+        usize cursor = 0;
+        auto const name = SplitWithIterator(WhitespaceStripped(*line), cursor, ' ', true);
+        if (name && *name == scenario_name) {
+            append_fingerprint();
+            replaced = true;
+        } else {
+            dyn::AppendSpan(result, *line);
+            dyn::Append(result, '\n');
+        }
+    }
+    if (!replaced) append_fingerprint();
+
+    TRY(WriteFile(path, result.Items()));
+    return k_success;
+}
+
+static void CheckRenderAgainstBaseline(tests::Tester& tester,
+                                       RenderScenario const& scenario,
+                                       RenderFingerprint const& fingerprint) {
+    auto const baseline_path = (String)path::Join(
+        tester.scratch_arena,
+        Array {tests::TestFilesFolder(tester), k_render_baseline_filename});
+
+    if (GetEnvironmentVariable("FLOE_UPDATE_RENDER_BASELINE", tester.scratch_arena)) {
+        REQUIRE_UNWRAP(UpdateRenderBaseline(baseline_path, scenario.name, fingerprint, tester.scratch_arena));
+        tester.log.Info("Updated render baseline for {}", scenario.name);
+        return;
+    }
+
+    auto const baseline = ReadEntireFile(baseline_path, tester.scratch_arena);
+    if (baseline.HasError()) {
+        LOG_WARNING("Failed to read {}: {}, run with FLOE_UPDATE_RENDER_BASELINE=1 to record it",
+                    baseline_path,
+                    baseline.Error());
+        return;
+    }
+    auto const expected = FindInRenderBaseline(baseline.Value(), scenario.name);
+    if (!expected) {
+        LOG_WARNING("No render baseline for {}, run with FLOE_UPDATE_RENDER_BASELINE=1 to record it",
+                    scenario.name);
+        return;
+    }
+
+    for (auto const segment : Range(k_render_envelope_segments)) {
+        CAPTURE(segment);
+        CHECK_LTE(Abs(fingerprint.envelope_db[segment] - expected->envelope_db[segment]),
+                  k_render_db_tolerance);
+    }
+    for (auto const band : Range(k_render_spectrum_bands)) {
+        CAPTURE(band);
+        CHECK_LTE(Abs(fingerprint.spectrum_db[band] - expected->spectrum_db[band]), k_render_db_tolerance);
+    }
+
+    // Timings from debug or instrumented builds say nothing about the shipped plugin.
+    if constexpr (k_optimised_build) {
+        if (GetEnvironmentVariable("FLOE_RENDER_CPU_CHECK", tester.scratch_arena))
+            CHECK_LTE(fingerprint.cpu_cost, expected->cpu_cost * k_render_cpu_tolerance);
+    }
+}
+
+static void RunRenderScenario(tests::Tester& tester,
+                              clap_plugin_factory const* factory,
+                              char const* plugin_id,
+                              RenderScenario const& scenario) {
+    TestHost test_host {};
+    auto const plugin = factory->create_plugin(factory, &test_host.host, plugin_id);
+    REQUIRE(plugin);
+    test_host.plugin_created = true;
+    test_host.plugin = plugin;
+    DEFER { plugin->destroy(plugin); };
+    REQUIRE(plugin->init(plugin));
+
+    Span<u8 const> state {};
+    if (scenario.preset_filename.size) {
+        auto const preset_path = (String)path::Join(tester.scratch_arena,
+                                                    Array {tests::TestFilesFolder(tester),
+                                                           tests::k_preset_test_files_subdir,
+                                                           scenario.preset_filename});
+        auto const snapshot = REQUIRE_UNWRAP(LoadPresetFile(preset_path, tester.scratch_arena));
+        state = REQUIRE_UNWRAP(EncodeToMemory(snapshot, tester.scratch_arena, StateSource::Daw, false));
+    } else {
+        state = REQUIRE_UNWRAP(MakeState(tester.scratch_arena, scenario.state_properties));
+    }
+
+    auto const num_frames = (u32)(scenario.sample_rate * 1.5);
+    f64 process_seconds = 0;
+    auto const output = ProcessWithEncodedState(
+        tester,
+        plugin,
+        test_host,
+        state,
+        {
+            .seed = 0,
+            .num_frames = num_frames,
+            .num_channels = 2,
+            .sample_rate = scenario.sample_rate,
+            .min_block_size = 256,
+            .max_block_size = 256,
+            .constant_block_size = 256, // Constant so that timings are comparable.
+            .events = MidiPatternEvents(tester.scratch_arena, scenario.pattern, num_frames),
+            .capture_output = true,
+            .process_seconds = &process_seconds,
+        });
+    REQUIRE(output.size); // Empty if the state didn't load in time.
+
+    auto fingerprint = FingerprintRender(tester.scratch_arena, output);
+    auto const seconds_per_sample = process_seconds / num_frames;
+    fingerprint.cpu_cost = seconds_per_sample / CalibrationSecondsPerSample();
+    tester.log.Info("{}: {.1} ns per sample, cost {.3}",
+                    scenario.name,
+                    seconds_per_sample * 1e9,
+                    fingerprint.cpu_cost);
+
+    CheckRenderAgainstBaseline(tester, scenario, fingerprint);
 }
 
 TEST_CASE(TestHostingClap) {
@@ -615,6 +1020,7 @@ TEST_CASE(TestHostingClap) {
             auto const plugin = factory->create_plugin(factory, &test_host.host, plugin_id);
             REQUIRE(plugin);
             test_host.plugin_created = true;
+            test_host.plugin = plugin;
 
             DEFER { plugin->destroy(plugin); };
 
@@ -794,6 +1200,65 @@ TEST_CASE(TestHostingClap) {
                 }
             }
         }
+
+        SUBCASE("thread pool output is identical to serial") {
+            auto factory = (clap_plugin_factory const*)entry->get_factory(CLAP_PLUGIN_FACTORY_ID);
+            REQUIRE(factory);
+            auto const plugin_id = factory->get_plugin_descriptor(factory, 0)->id;
+
+            // Two layers, voices with envelopes and LFOs, and every effect.
+            auto const render = [&](bool use_thread_pool) {
+                TestHost test_host {};
+                test_host.thread_pool_enabled = use_thread_pool;
+
+                auto const plugin = factory->create_plugin(factory, &test_host.host, plugin_id);
+                REQUIRE(plugin);
+                test_host.plugin_created = true;
+                test_host.plugin = plugin;
+                DEFER { plugin->destroy(plugin); };
+                REQUIRE(plugin->init(plugin));
+
+                EventQueue events {};
+                Array<u7, 6> const notes {48, 55, 60, 64, 67, 72};
+                for (auto const [i, note] : Enumerate<u32>(notes))
+                    events.AppendMidiMessage(tester.scratch_arena, i * 1000, MidiMessage::NoteOn(note, 100));
+
+                return ProcessWithState(tester,
+                                        plugin,
+                                        test_host,
+                                        StateProperties::Ir | StateProperties::Sine |
+                                            StateProperties::WhiteNoise | StateProperties::SoundShapersOn,
+                                        {
+                                            .seed = 0x7a5c,
+                                            .num_frames = 22050,
+                                            .num_channels = 2,
+                                            .sample_rate = 44100,
+                                            .min_block_size = 1,
+                                            .max_block_size = 1024,
+                                            .constant_block_size = 0,
+                                            .events = events,
+                                            .capture_output = true,
+                                        });
+            };
+
+            auto const serial = render(false);
+            auto const parallel = render(true);
+            REQUIRE_EQ(serial.size, 2u);
+            REQUIRE_EQ(parallel.size, 2u);
+            for (auto const channel : Range(2u)) {
+                CAPTURE(channel);
+                CHECK(serial[channel] == parallel[channel]);
+            }
+        }
+
+        SUBCASE("render regressions") {
+            auto factory = (clap_plugin_factory const*)entry->get_factory(CLAP_PLUGIN_FACTORY_ID);
+            REQUIRE(factory);
+            auto const plugin_id = factory->get_plugin_descriptor(factory, 0)->id;
+
+            for (auto const& scenario : k_render_scenarios)
+                SUBCASE(scenario.name) { RunRenderScenario(tester, factory, plugin_id, scenario); }
+        }
     }
 
     return k_success;
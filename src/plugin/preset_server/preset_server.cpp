@@ -1058,6 +1058,12 @@ static ErrorCodeOr<void> ScanFolder(PresetServer& server,
         for (auto const& preset : preset_folder->presets)
             HashUpdateFnv1a(preset_folder->all_presets_hash, preset.file_hash);
 
+        preset_folder->search_index = BuildSearchIndex(
+            (u32)preset_folder->presets.size,
+            [&](u32 i) { return preset_folder->presets[i].name; },
+            preset_folder->arena,
+            scratch_arena);
+
         // Check if there's an existing folder with the same scan_folder and folder path.
         Optional<usize> existing_folder_index {};
         for (auto const i : Range(server.folders.size)) {
@@ -7,6 +7,7 @@
 #include "utils/thread_extra/thread_extra.hpp"
 
 #include "common_infrastructure/preset_bank_info.hpp"
+#include "common_infrastructure/search_index.hpp"
 #include "common_infrastructure/state/state_coding.hpp"
 #include "common_infrastructure/state/state_snapshot.hpp"
 
@@ -40,6 +41,7 @@ struct PresetFolder {
     Optional<PresetBank> preset_bank_info {}; // From metadata file (primary importance)
 
     u64 all_presets_hash {}; // Hash of all presets in this folder.
+    SearchIndex search_index {}; // Item indices match presets.
 
     // private
     usize preset_array_capacity {};
@@ -103,4 +103,36 @@ struct Processor {
     State state = State::Idle;
 };
 
+// Processor::Process() for several envelopes that share the same Params, one per vector lane. output and
+// state are the lanes' Processor::output and Processor::state (state as s32). Gives the same results as
+// processing each envelope on its own.
+template <Vector FloatType, Vector StateType>
+inline FloatType ProcessLanes(Params const& params, FloatType& output, StateType& state) {
+    auto const attack = state == (s32)State::Attack;
+    auto const decay = state == (s32)State::Decay;
+    auto const sustain = state == (s32)State::Sustain;
+    auto const release = state == (s32)State::Release;
+
+    auto next = output;
+    next = Select(attack, params.attack_base + output * params.attack_coef, next);
+    next = Select(decay, params.decay_base + output * params.decay_coef, next);
+    next = Select(sustain, (FloatType)params.sustain_amount, next);
+    next = Select(release, params.release_base + output * params.release_coef, next);
+
+    auto const attack_done = attack & (next >= 1.0f);
+    next = Select(attack_done, (FloatType)1.0f, next);
+    state = Select(attack_done, (StateType)(s32)State::Decay, state);
+
+    auto const decay_done = decay & (next <= params.sustain_amount);
+    next = Select(decay_done, (FloatType)params.sustain_amount, next);
+    state = Select(decay_done, (StateType)(s32)State::Sustain, state);
+
+    auto const release_done = release & (next <= 0.0f);
+    next = Select(release_done, (FloatType)0.0f, next);
+    state = Select(release_done, (StateType)(s32)State::Idle, state);
+
+    output = next;
+    return Clamp01(output);
+}
+
 } // namespace adsr
@@ -80,3 +80,17 @@ struct ProcessBlockChanges {
     Bitset<16> pitchwheel_changed;
     DynamicArrayBounded<NoteEvent, k_max_note_events> note_events;
 };
+
+// A host that does nothing, for tests that need an AudioProcessingContext or an AudioProcessor.
+inline clap_host_t const k_stub_host {
+    .clap_version = CLAP_VERSION,
+    .host_data = nullptr,
+    .name = "Test",
+    .vendor = "Test",
+    .url = "",
+    .version = "1",
+    .get_extension = [](clap_host_t const*, char const*) -> void const* { return nullptr; },
+    .request_restart = [](clap_host_t const*) {},
+    .request_process = [](clap_host_t const*) {},
+    .request_callback = [](clap_host_t const*) {},
+};
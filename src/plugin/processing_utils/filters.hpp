@@ -570,8 +570,42 @@ struct CachedHelpers {
     f32 h_2r, h_4r, h_2rag, divisor;
 };
 
-template <ScalarOrVector<f32> FloatType>
-inline void Process(FloatType in, FloatType& out, Data<FloatType>& d, Type type, CachedHelpers const& c) {
+// CachedHelpers for several filters at once, one per vector lane, so that filters with different cutoffs can
+// be processed together.
+template <Vector FloatType>
+struct CachedHelpersLanes {
+    void SetLane(usize lane, CachedHelpers const& c) {
+        g_coeff[lane] = c.g_coeff;
+        r_coeff[lane] = c.r_coeff;
+        k_coeff[lane] = c.k_coeff;
+        h_2r[lane] = c.h_2r;
+        h_4r[lane] = c.h_4r;
+        h_2rag[lane] = c.h_2rag;
+        divisor[lane] = c.divisor;
+    }
+
+    FloatType g_coeff, r_coeff, k_coeff;
+    FloatType h_2r, h_4r, h_2rag, divisor;
+};
+
+// Blends between two sets of coefficients. The SVF stays stable for any cutoff and resonance, and each
+// coefficient moves monotonically with them, so small steps like this are safe. t can be a scalar or vector.
+template <typename Helpers, typename T>
+inline Helpers LerpCoeffs(Helpers const& a, Helpers const& b, T t) {
+    Helpers result;
+    result.g_coeff = a.g_coeff + (t * (b.g_coeff - a.g_coeff));
+    result.r_coeff = a.r_coeff + (t * (b.r_coeff - a.r_coeff));
+    result.k_coeff = a.k_coeff + (t * (b.k_coeff - a.k_coeff));
+    result.h_2r = a.h_2r + (t * (b.h_2r - a.h_2r));
+    result.h_4r = a.h_4r + (t * (b.h_4r - a.h_4r));
+    result.h_2rag = a.h_2rag + (t * (b.h_2rag - a.h_2rag));
+    result.divisor = a.divisor + (t * (b.divisor - a.divisor));
+    return result;
+}
+
+// Helpers is CachedHelpers, or CachedHelpersLanes<FloatType>.
+template <ScalarOrVector<f32> FloatType, typename Helpers>
+inline void Process(FloatType in, FloatType& out, Data<FloatType>& d, Type type, Helpers const& c) {
     auto hp = (in - c.h_2rag * d.z1_a - d.z2_a) / c.divisor;
     auto g = c.g_coeff;
     auto bp = (hp * g) + d.z1_a;
@@ -0,0 +1,391 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "midi_file.hpp"
+
+#include "tests/framework.hpp"
+
+#include "common_infrastructure/common_errors.hpp"
+
+#include "benchmarks/framework.hpp"
+
+constexpr u32 k_default_microseconds_per_quarter = 500000; // 120 BPM
+
+struct MidiFileCursor {
+    bool AtEnd() const { return pos == data.size; }
+
+    ErrorCodeOr<u8> ReadByte() {
+        if (pos == data.size) return ErrorCode {CommonError::CorruptFile};
+        return data[pos++];
+    }
+
+    ErrorCodeOr<u32> ReadBigEndian(usize num_bytes) {
+        if (data.size - pos < num_bytes) return ErrorCode {CommonError::CorruptFile};
+        u32 result = 0;
+        for (auto const _ : Range(num_bytes))
+            result = (result << 8) | data[pos++];
+        return result;
+    }
+
+    // Variable-length quantity: 7 bits per byte, most significant first, high bit set on all but the last.
+    ErrorCodeOr<u32> ReadVarLen() {
+        u32 result = 0;
+        for (auto const _ : Range(4)) {
+            auto const byte = TRY(ReadByte());
+            result = (result << 7) | (byte & 0x7f);
+            if (!(byte & 0x80)) return result;
+        }
+        return ErrorCode {CommonError::CorruptFile};
+    }
+
+    ErrorCodeOr<Span<u8 const>> ReadBytes(usize num_bytes) {
+        if (data.size - pos < num_bytes) return ErrorCode {CommonError::CorruptFile};
+        auto const result = data.SubSpan(pos, num_bytes);
+        pos += num_bytes;
+        return result;
+    }
+
+    Span<u8 const> data;
+    usize pos {};
+};
+
+namespace {
+
+struct TickEvent {
+    u64 tick;
+    u32 order; // Tie-break so that sorting is stable: tracks in file order, then events in track order.
+    u32 microseconds_per_quarter; // Non-zero for tempo changes, in which case message is unused.
+    MidiMessage message;
+};
+
+} // namespace
+
+static ErrorCodeOr<void> ParseTrack(Span<u8 const> track_data,
+                                    DynamicArray<TickEvent>& events,
+                                    u32& next_order,
+                                    u64& end_tick) {
+    MidiFileCursor cursor {.data = track_data};
+    u64 tick = 0;
+    u8 running_status = 0;
+
+    while (!cursor.AtEnd()) {
+        tick += TRY(cursor.ReadVarLen());
+        auto const byte = TRY(cursor.ReadByte());
+
+        if (byte == 0xff) {
+            auto const type = TRY(cursor.ReadByte());
+            auto const length = TRY(cursor.ReadVarLen());
+            auto const meta_data = TRY(cursor.ReadBytes(length));
+            if (type == 0x2f) break; // End of track.
+            if (type == 0x51 && length == 3) {
+                auto const tempo = ((u32)meta_data[0] << 16) | ((u32)meta_data[1] << 8) | meta_data[2];
+                if (tempo) {
+                    dyn::Append(events,
+                                {.tick = tick, .order = next_order++, .microseconds_per_quarter = tempo});
+                }
+            }
+            continue;
+        }
+
+        if (byte == 0xf0 || byte == 0xf7) {
+            // Sysex, or a sysex continuation/escape. Both carry a length so we can skip them.
+            TRY(cursor.ReadBytes(TRY(cursor.ReadVarLen())));
+            running_status = 0;
+            continue;
+        }
+
+        MidiMessage message {};
+        if (byte & 0x80) {
+            // Other system messages aren't allowed in a file; we couldn't know their length.
+            if (byte >= 0xf0) return ErrorCode {CommonError::CorruptFile};
+            running_status = byte;
+            message.status = byte;
+            message.data1 = TRY(cursor.ReadByte());
+        } else {
+            if (!running_status) return ErrorCode {CommonError::CorruptFile};
+            message.status = running_status;
+            message.data1 = byte;
+        }
+
+        auto const type = (MidiMessageType)(message.status >> 4);
+        if (type != MidiMessageType::ProgramChange && type != MidiMessageType::ChannelAftertouch)
+            message.data2 = TRY(cursor.ReadByte());
+        if ((message.data1 | message.data2) & 0x80) return ErrorCode {CommonError::CorruptFile};
+
+        dyn::Append(events, {.tick = tick, .order = next_order++, .message = message});
+    }
+
+    end_tick = Max(end_tick, tick);
+    return k_success;
+}
+
+ErrorCodeOr<MidiFile> ParseMidiFile(Span<u8 const> data, ArenaAllocator& arena) {
+    MidiFileCursor cursor {.data = data};
+
+    auto const header_id = TRY(cursor.ReadBytes(4));
+    if (header_id != "MThd"_s.ToByteSpan()) return ErrorCode {CommonError::InvalidFileFormat};
+    auto const header_size = TRY(cursor.ReadBigEndian(4));
+    if (header_size < 6) return ErrorCode {CommonError::CorruptFile};
+    auto header = MidiFileCursor {.data = TRY(cursor.ReadBytes(header_size))};
+    auto const format = TRY(header.ReadBigEndian(2));
+    auto const num_tracks = TRY(header.ReadBigEndian(2));
+    auto const division = TRY(header.ReadBigEndian(2));
+
+    // Format 2 files are a set of independent sequences; there's no single timeline to render.
+    if (format > 1) return ErrorCode {CommonError::InvalidFileFormat};
+    if ((division & 0x7fff) == 0) return ErrorCode {CommonError::CorruptFile};
+
+    // SMPTE divisions have a fixed tick length; tempo events don't apply.
+    Optional<f64> smpte_seconds_per_tick {};
+    if (division & 0x8000) {
+        auto frames_per_second = (f64)-(s8)(division >> 8);
+        if (frames_per_second == 29) frames_per_second = 29.97;
+        auto const ticks_per_frame = division & 0xff;
+        if (frames_per_second <= 0 || !ticks_per_frame) return ErrorCode {CommonError::CorruptFile};
+        smpte_seconds_per_tick = 1.0 / (frames_per_second * ticks_per_frame);
+    }
+
+    DynamicArray<TickEvent> tick_events {arena};
+    u32 next_order = 0;
+    u64 end_tick = 0;
+    u32 num_tracks_read = 0;
+    while (!cursor.AtEnd() && num_tracks_read != num_tracks) {
+        auto const chunk_id = TRY(cursor.ReadBytes(4));
+        auto const chunk_size = TRY(cursor.ReadBigEndian(4));
+        auto const chunk_data = TRY(cursor.ReadBytes(chunk_size));
+        // Unknown chunk types must be ignored, as per the spec.
+        if (chunk_id != "MTrk"_s.ToByteSpan()) continue;
+        TRY(ParseTrack(chunk_data, tick_events, next_order, end_tick));
+        ++num_tracks_read;
+    }
+    if (num_tracks_read != num_tracks) return ErrorCode {CommonError::CorruptFile};
+
+    Sort(tick_events, [](TickEvent const& a, TickEvent const& b) {
+        if (a.tick != b.tick) return a.tick < b.tick;
+        return a.order < b.order;
+    });
+
+    auto const seconds_per_tick_for_tempo = [&](u32 microseconds_per_quarter) {
+        if (smpte_seconds_per_tick) return *smpte_seconds_per_tick;
+        return (f64)microseconds_per_quarter / (1'000'000.0 * division);
+    };
+
+    auto const bpm_for_tempo = [](u32 microseconds_per_quarter) {
+        return 60'000'000.0 / microseconds_per_quarter;
+    };
+
+    DynamicArray<MidiFileEvent> events {arena};
+    events.Reserve(tick_events.size);
+    DynamicArray<MidiFileTempoChange> tempo_changes {arena};
+    dyn::Append(tempo_changes,
+                {
+                    .time_seconds = 0,
+                    .beats = 0,
+                    .beats_per_minute = bpm_for_tempo(k_default_microseconds_per_quarter),
+                });
+    auto seconds_per_tick = seconds_per_tick_for_tempo(k_default_microseconds_per_quarter);
+    f64 seconds = 0;
+    f64 beats = 0;
+    u64 tick = 0;
+    for (auto const& e : tick_events) {
+        auto const delta_seconds = (f64)(e.tick - tick) * seconds_per_tick;
+        seconds += delta_seconds;
+        beats += delta_seconds * Last(tempo_changes).beats_per_minute / 60;
+        tick = e.tick;
+        if (e.microseconds_per_quarter) {
+            seconds_per_tick = seconds_per_tick_for_tempo(e.microseconds_per_quarter);
+            MidiFileTempoChange const change {
+                .time_seconds = seconds,
+                .beats = beats,
+                .beats_per_minute = bpm_for_tempo(e.microseconds_per_quarter),
+            };
+            // A later change at the same time replaces the earlier one.
+            if (Last(tempo_changes).time_seconds == seconds)
+                Last(tempo_changes) = change;
+            else
+                dyn::Append(tempo_changes, change);
+        } else {
+            dyn::Append(events, {.time_seconds = seconds, .message = e.message});
+        }
+    }
+    seconds += (f64)(end_tick - tick) * seconds_per_tick;
+
+    return MidiFile {
+        .events = events.ToOwnedSpan(),
+        .tempo_changes = tempo_changes.ToOwnedSpan(),
+        .length_seconds = seconds,
+    };
+}
+
+// Builds a file in memory for tests and benchmarks.
+struct MidiFileBuilder {
+    void BeginTrack() {
+        dyn::AppendSpan(bytes, "MTrk"_s.ToByteSpan());
+        track_size_pos = bytes.size;
+        AppendBigEndian(0, 4);
+    }
+    void EndTrack() {
+        AppendVarLen(0);
+        dyn::AppendSpan(bytes, Array<u8, 3> {0xff, 0x2f, 0x00});
+        auto size = bytes.size - track_size_pos - 4;
+        for (auto const i : Range(4))
+            bytes[track_size_pos + 3 - i] = (u8)(size >> (i * 8));
+    }
+    void AppendHeader(u16 format, u16 num_tracks, u16 division) {
+        dyn::AppendSpan(bytes, "MThd"_s.ToByteSpan());
+        AppendBigEndian(6, 4);
+        AppendBigEndian(format, 2);
+        AppendBigEndian(num_tracks, 2);
+        AppendBigEndian(division, 2);
+    }
+    void AppendBigEndian(u32 value, u32 num_bytes) {
+        for (auto const i : Range(num_bytes))
+            dyn::Append(bytes, (u8)(value >> ((num_bytes - 1 - i) * 8)));
+    }
+    void AppendVarLen(u32 value) {
+        u8 buffer[4];
+        u32 size = 0;
+        do {
+            buffer[size++] = value & 0x7f;
+            value >>= 7;
+        } while (value);
+        while (size--)
+            dyn::Append(bytes, (u8)(buffer[size] | (size ? 0x80 : 0)));
+    }
+    void AppendEvent(u32 delta, Span<u8 const> event_bytes) {
+        AppendVarLen(delta);
+        dyn::AppendSpan(bytes, event_bytes);
+    }
+
+    DynamicArray<u8> bytes;
+    usize track_size_pos {};
+};
+
+TEST_CASE(TestMidiFile) {
+    auto& a = tester.scratch_arena;
+
+    SUBCASE("format 1 with a tempo map") {
+        MidiFileBuilder builder {.bytes = {a}};
+        builder.AppendHeader(1, 2, 96);
+
+        // Conductor track: 120 BPM, then 60 BPM from beat 2.
+        builder.BeginTrack();
+        builder.AppendEvent(0, Array<u8, 6> {0xff, 0x51, 0x03, 0x07, 0xa1, 0x20});
+        builder.AppendEvent(0, Array<u8, 7> {0xff, 0x03, 0x04, 'D', 'e', 'm', 'o'});
+        builder.AppendEvent(192, Array<u8, 6> {0xff, 0x51, 0x03, 0x0f, 0x42, 0x40});
+        builder.EndTrack();
+
+        builder.BeginTrack();
+        builder.AppendEvent(0, Array<u8, 3> {0x90, 60, 100});
+        builder.AppendEvent(0, Array<u8, 2> {64, 90}); // Running status.
+        builder.AppendEvent(96, Array<u8, 5> {0xf0, 0x03, 0x7e, 0x00, 0xf7});
+        builder.AppendEvent(0, Array<u8, 3> {0x80, 60, 0});
+        builder.AppendEvent(96, Array<u8, 2> {0xc1, 5});
+        builder.AppendEvent(96, Array<u8, 3> {0x90, 64, 0});
+        builder.EndTrack();
+
+        auto const file = REQUIRE_UNWRAP(ParseMidiFile(builder.bytes, a));
+        REQUIRE_EQ(file.events.size, 5u);
+
+        CHECK_EQ(file.events[0].message.Type(), MidiMessageType::NoteOn);
+        CHECK_EQ(file.events[0].message.NoteNum(), 60);
+        CHECK_APPROX_EQ(file.events[0].time_seconds, 0.0, 1e-9);
+
+        CHECK_EQ(file.events[1].message.Type(), MidiMessageType::NoteOn);
+        CHECK_EQ(file.events[1].message.NoteNum(), 64);
+        CHECK_EQ(file.events[1].message.Velocity(), 90);
+
+        CHECK_EQ(file.events[2].message.Type(), MidiMessageType::NoteOff);
+        CHECK_APPROX_EQ(file.events[2].time_seconds, 0.5, 1e-9);
+
+        CHECK_EQ(file.events[3].message.Type(), MidiMessageType::ProgramChange);
+        CHECK_EQ(file.events[3].message.ChannelNum(), 1);
+        CHECK_APPROX_EQ(file.events[3].time_seconds, 1.0, 1e-9);
+
+        // After the tempo change at tick 192, a beat lasts a second.
+        CHECK_EQ(file.events[4].message.Type(), MidiMessageType::NoteOff);
+        CHECK_APPROX_EQ(file.events[4].time_seconds, 2.0, 1e-9);
+        CHECK_APPROX_EQ(file.length_seconds, 2.0, 1e-9);
+
+        // The tempo at tick 0 replaces the default rather than adding to it.
+        REQUIRE_EQ(file.tempo_changes.size, 2u);
+        CHECK_APPROX_EQ(file.tempo_changes[0].time_seconds, 0.0, 1e-9);
+        CHECK_APPROX_EQ(file.tempo_changes[0].beats_per_minute, 120.0, 1e-9);
+        CHECK_APPROX_EQ(file.tempo_changes[1].time_seconds, 1.0, 1e-9);
+        CHECK_APPROX_EQ(file.tempo_changes[1].beats, 2.0, 1e-9);
+        CHECK_APPROX_EQ(file.tempo_changes[1].beats_per_minute, 60.0, 1e-9);
+    }
+
+    SUBCASE("events at the same tick keep track order") {
+        MidiFileBuilder builder {.bytes = {a}};
+        builder.AppendHeader(1, 3, 480);
+        for (auto const note : Array<u8, 3> {70, 50, 60}) {
+            builder.BeginTrack();
+            builder.AppendEvent(480, Array<u8, 3> {0x90, note, 100});
+            builder.EndTrack();
+        }
+
+        auto const file = REQUIRE_UNWRAP(ParseMidiFile(builder.bytes, a));
+        REQUIRE_EQ(file.events.size, 3u);
+        REQUIRE_EQ(file.tempo_changes.size, 1u);
+        CHECK_APPROX_EQ(file.tempo_changes[0].beats_per_minute, 120.0, 1e-9);
+        CHECK_EQ(file.events[0].message.NoteNum(), 70);
+        CHECK_EQ(file.events[1].message.NoteNum(), 50);
+        CHECK_EQ(file.events[2].message.NoteNum(), 60);
+    }
+
+    SUBCASE("SMPTE division") {
+        MidiFileBuilder builder {.bytes = {a}};
+        builder.AppendHeader(0, 1, (u16)((u8)-25 << 8 | 40)); // 25 fps, 40 ticks per frame.
+        builder.BeginTrack();
+        builder.AppendEvent(0, Array<u8, 6> {0xff, 0x51, 0x03, 0x0f, 0x42, 0x40}); // Ignored.
+        builder.AppendEvent(1000, Array<u8, 3> {0x90, 60, 100});
+        builder.EndTrack();
+
+        auto const file = REQUIRE_UNWRAP(ParseMidiFile(builder.bytes, a));
+        REQUIRE_EQ(file.events.size, 1u);
+        CHECK_APPROX_EQ(file.events[0].time_seconds, 1.0, 1e-9);
+    }
+
+    SUBCASE("invalid files") {
+        CHECK(ParseMidiFile("RIFF"_s.ToByteSpan(), a).HasError());
+
+        MidiFileBuilder builder {.bytes = {a}};
+        builder.AppendHeader(0, 1, 96);
+        builder.BeginTrack();
+        builder.AppendEvent(0, Array<u8, 2> {60, 100}); // Running status without a status byte.
+        builder.EndTrack();
+        CHECK(ParseMidiFile(builder.bytes, a).HasError());
+
+        // Truncated.
+        CHECK(ParseMidiFile(builder.bytes.Items().SubSpan(0, builder.bytes.size - 4), a).HasError());
+    }
+
+    return k_success;
+}
+
+BENCHMARK_FN void BenchmarkParseMidiFile() {
+    // 16 dense tracks, roughly the size of a large orchestral MIDI file.
+    ArenaAllocator arena {PageAllocator::Instance()};
+    MidiFileBuilder builder {.bytes = {arena}};
+    builder.AppendHeader(1, 16, 480);
+    for (auto const track : Range<u8>(16)) {
+        builder.BeginTrack();
+        for (auto const i : Range(20000u)) {
+            auto const note = (u8)(36 + ((i * 7 + track) % 60));
+            builder.AppendEvent(60, Array<u8, 3> {(u8)(0x90 | track), note, 100});
+            builder.AppendEvent(60, Array<u8, 3> {(u8)(0x80 | track), note, 0});
+        }
+        builder.EndTrack();
+    }
+
+    for (auto const _ : Range(20)) {
+        ArenaAllocator parse_arena {PageAllocator::Instance()};
+        auto file = ParseMidiFile(builder.bytes, parse_arena);
+        benchmarks::DoNotOptimise(file);
+    }
+}
+
+TEST_REGISTRATION(RegisterMidiFileTests) { REGISTER_TEST(TestMidiFile); }
+
+BENCHMARK_REGISTRATION(RegisterMidiFileBenchmarks) { REGISTER_BENCHMARK(BenchmarkParseMidiFile); }
@@ -0,0 +1,30 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+#include "foundation/foundation.hpp"
+
+#include "midi.hpp"
+
+// Standard MIDI File (.mid) reading. Formats 0 and 1 are supported; the tracks of a format 1 file are merged
+// into one list. Only channel messages are kept as events: tempo meta events make up the tempo map, other
+// meta events and sysex are skipped. Files without a tempo are 120 BPM, as per the spec.
+
+struct MidiFileEvent {
+    f64 time_seconds;
+    MidiMessage message;
+};
+
+struct MidiFileTempoChange {
+    f64 time_seconds;
+    f64 beats; // Quarter notes since the start of the file.
+    f64 beats_per_minute;
+};
+
+struct MidiFile {
+    Span<MidiFileEvent> events; // Sorted by time. Events at the same time keep their file order.
+    Span<MidiFileTempoChange> tempo_changes; // Sorted by time. Never empty: the first is at 0 seconds.
+    f64 length_seconds; // Time of the last end-of-track, which can be later than the last event.
+};
+
+ErrorCodeOr<MidiFile> ParseMidiFile(Span<u8 const> data, ArenaAllocator& arena);
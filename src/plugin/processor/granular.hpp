@@ -128,33 +128,40 @@ inline String HarmonyIntervalsLabel(HarmonyIntervalsBitset const& intervals, Are
     return arena.Clone(String(buf));
 }
 
-struct Grain {
-    PlayHead playhead {};
-    f64 detune_ratio {1}; // pitch multiplier, assigned randomly at grain spawn
-
-    // Envelope phase: advances from 0→1 over the grain's lifetime. Using f32 avoids
-    // per-sample u32→f32 casts in the hot loop and enables branchless processing.
-    f32 env_phase {};
-    f32 env_phase_inc {}; // = 1.0f / duration_samples, pre-computed at spawn
-
-    f32 pan_pos {}; // -1 (left) to +1 (right), assigned randomly at grain spawn
-    f32 amp {1.0f}; // subtle random amplitude jitter per grain
-    u8 source_index {};
-    bool active {};
-
-    // Steal fade: starts at 1.0 and decreases towards 0 when the grain is being stolen.
-    // steal_fade_dec is 0 for non-stealing grains, making the subtraction a branchless no-op.
-    // When steal_fade reaches 0 the grain is deactivated.
-    f32 steal_fade {1.0f};
-    f32 steal_fade_dec {};
-
-    bool IsStealing() const { return steal_fade_dec > 0.0f; }
-};
+// Grains are rendered in groups of this many, one grain per vector lane.
+#if defined(__AVX__)
+constexpr u32 k_grain_lanes = 8;
+#else
+constexpr u32 k_grain_lanes = 4; // SSE2 and NEON.
+#endif
+using GrainLanes = __attribute__((ext_vector_type(k_grain_lanes))) f32;
+
+constexpr u32 k_num_grain_slots =
+    ((k_max_grains_per_voice + k_grain_lanes - 1) / k_grain_lanes) * k_grain_lanes;
+
+// Degree-3 approximation of f(x) = sin(x * pi/2)^2 (half-Hann rise) on [0, 1].
+// Generated by lolremez:
+//   lolremez --float -d 3 -r "0:1" "sin(x*pi/2)^2"
+//   p(x) = ((-2.2102317*x + 3.3153475)*x - 1.0960758e-1)*x + 2.2458674e-3
+// Estimated max error: 2.2458674e-3.
+// Used for grain envelopes: has zero first derivative at both endpoints, giving
+// Hann-window-like spectral properties (-18 dB/oct sidelobe rolloff) and reducing
+// clicks on short grains compared to the simpler QuarterSineFade.
+ALWAYS_INLINE auto HannRise(ScalarOrVectorFloat auto x) {
+    using T = UnderlyingTypeOfVecOrScalar<decltype(x)>;
+    auto u = x * T(-2.2102318f);
+    u = (u + T(3.3153474f)) * x;
+    u = (u + T(-0.10960758f)) * x;
+    return u + T(0.0022458674f);
+}
 
+// Grain state is kept as a structure of arrays indexed by grain slot, so that the values used for every
+// frame of every grain can be loaded k_grain_lanes grains at a time. Only the first k_max_grains_per_voice
+// slots are used; the rest pad the arrays to a whole number of lane groups.
 struct GrainPool {
     void DeactivateAllGrains() {
-        for (auto& g : grains)
-            g.active = false;
+        for (auto& a : active)
+            a = false;
         for (auto& c : spawn_counters)
             c = 0;
         num_active_non_stealing = 0;
@@ -166,10 +173,31 @@ struct GrainPool {
         smoothing_smoother.Reset();
     }
 
-    Array<Grain, k_max_grains_per_voice> grains {};
+    bool IsStealing(u32 slot) const { return steal_fade_dec[slot] > 0.0f; }
+
+    // Envelope phase: advances from 0→1 over the grain's lifetime. Using f32 avoids
+    // per-sample u32→f32 casts in the hot loop and enables branchless processing.
+    alignas(sizeof(GrainLanes)) f32 env_phase[k_num_grain_slots] {};
+    alignas(sizeof(GrainLanes)) f32 env_phase_inc[k_num_grain_slots] {}; // = 1.0f / duration_samples
+
+    // Steal fade: starts at 1.0 and decreases towards 0 when the grain is being stolen.
+    // steal_fade_dec is 0 for non-stealing grains, making the subtraction a branchless no-op.
+    // When steal_fade reaches 0 the grain is deactivated.
+    alignas(sizeof(GrainLanes)) f32 steal_fade[k_num_grain_slots] {};
+    alignas(sizeof(GrainLanes)) f32 steal_fade_dec[k_num_grain_slots] {};
+
+    // Equal-power pan gains for the grain's random pan position, including its random amplitude jitter.
+    alignas(sizeof(GrainLanes)) f32 gain_left[k_num_grain_slots] {};
+    alignas(sizeof(GrainLanes)) f32 gain_right[k_num_grain_slots] {};
+
+    PlayHead playheads[k_num_grain_slots] {};
+    f64 detune_ratio[k_num_grain_slots] {}; // pitch multiplier, assigned randomly at grain spawn
+    u8 source_index[k_num_grain_slots] {};
+    bool active[k_num_grain_slots] {};
+
     Array<u32, k_max_num_voice_sound_sources> spawn_counters {};
 
-    // Per-sample decrement applied to Grain::steal_fade when a grain is being stolen.
+    // Per-sample decrement applied to steal_fade when a grain is being stolen.
     // Pre-computed from k_grain_steal_fadeout_ms and the sample rate.
     f32 steal_fade_dec_value {};
 
@@ -181,3 +209,131 @@ struct GrainPool {
     // the user adjusts the knob while grains are playing.
     OnePoleLowPassFilter<f32> smoothing_smoother {};
 };
+
+// Per-block values that are the same for every grain of a sound source. The arrays have one element per
+// frame of the block.
+struct GrainBlockParams {
+    AudioData const& audio;
+    u8 source_index;
+    u8 const* start_frames; // Per grain slot: the frame of the block that the grain starts on.
+    f64 const* pitch_ratios;
+    f32 const* env_inv_fades; // 1 / (smoothing * 0.5): steepness of the grain window's sides.
+    f32 const* xfade_vols;
+    f32 amp;
+};
+
+// Adds all grains of one sound source onto buffer. Fetching the sample data is done grain by grain since
+// every grain reads from somewhere different, but the interpolation, windowing and panning are done across
+// k_grain_lanes grains at once. Grains that finish are deactivated.
+NO_UBSAN inline void RenderGrains(GrainPool& pool, GrainBlockParams const& params, Span<f32x2> buffer) {
+    ASSERT_HOT(buffer.size <= k_block_size_max);
+    auto const num_frames = params.audio.num_frames;
+    auto const is_mono = params.audio.channels == 1;
+
+    // Each lane's contribution to each frame, summed across all lane groups. We only sum across lanes once at
+    // the end.
+    GrainLanes sum_left[k_block_size_max] {};
+    GrainLanes sum_right[k_block_size_max] {};
+
+    for (u32 first = 0; first < k_num_grain_slots; first += k_grain_lanes) {
+        u32 lanes_in_use = 0;
+        u32 starts[k_grain_lanes] {};
+        u32 ends[k_grain_lanes] {};
+        for (auto const lane : Range(k_grain_lanes)) {
+            auto const slot = first + lane;
+            if (!pool.active[slot] || pool.source_index[slot] != params.source_index) continue;
+            lanes_in_use |= 1u << lane;
+            starts[lane] = params.start_frames[slot];
+            ends[lane] = (u32)buffer.size;
+            ASSERT_HOT(starts[lane] < ends[lane]);
+        }
+        if (!lanes_in_use) continue;
+
+        auto const phases = *(GrainLanes const*)(void const*)&pool.env_phase[first];
+        auto const phase_incs = *(GrainLanes const*)(void const*)&pool.env_phase_inc[first];
+        auto const steals = *(GrainLanes const*)(void const*)&pool.steal_fade[first];
+        auto const steal_decs = *(GrainLanes const*)(void const*)&pool.steal_fade_dec[first];
+        auto const gains_left = *(GrainLanes const*)(void const*)&pool.gain_left[first];
+        auto const gains_right = *(GrainLanes const*)(void const*)&pool.gain_right[first];
+
+        for (auto const frame : Range((u32)buffer.size)) {
+            // IMPORTANT: this is a very hot code path:
+            // num-active-voices * num-active-grains * num-frames.
+            InterpolationPoints<GrainLanes> left {};
+            InterpolationPoints<GrainLanes> right {};
+            GrainLanes x {};
+            GrainLanes playing {};
+
+            for (auto const lane : Range(k_grain_lanes)) {
+                if (!(lanes_in_use & (1u << lane)) || frame < starts[lane] || frame >= ends[lane]) continue;
+
+                auto& playhead = pool.playheads[first + lane];
+                if (PlaybackEnded(playhead, num_frames)) [[unlikely]] {
+                    ends[lane] = frame;
+                    continue;
+                }
+
+                InterpolationPoints<f32x2> p;
+                if (auto const loop = playhead.loop.NullableValue(); loop && loop->crossfade) [[unlikely]] {
+                    // Crossfades need a second interpolated frame; we let GetSampleFrame do it and
+                    // interpolate between 4 copies of the result, which gives back the same value exactly.
+                    auto const f = GetSampleFrame(params.audio, playhead);
+                    p = {.xm1 = f, .x0 = f, .x1 = f, .x2 = f};
+                } else {
+                    p = SampleInterpolationPoints(params.audio, playhead);
+                    x[lane] = (f32)(playhead.frame_pos - (u32)playhead.frame_pos);
+                }
+                left.xm1[lane] = p.xm1[0];
+                left.x0[lane] = p.x0[0];
+                left.x1[lane] = p.x1[0];
+                left.x2[lane] = p.x2[0];
+                right.xm1[lane] = p.xm1[1];
+                right.x0[lane] = p.x0[1];
+                right.x1[lane] = p.x1[1];
+                right.x2[lane] = p.x2[1];
+                playing[lane] = 1;
+
+                IncrementPlaybackPos(playhead,
+                                     params.pitch_ratios[frame] * pool.detune_ratio[first + lane],
+                                     num_frames);
+            }
+
+            // Window: a Hann rise and fall whose steepness depends on the smoothing parameter, multiplied
+            // by the steal fade-out.
+            auto const t = (f32)frame;
+            auto const phase = phases + (phase_incs * t);
+            auto const inv_fade = params.env_inv_fades[frame];
+            auto const rise = Clamp01(phase * inv_fade);
+            auto const fall = Clamp01((GrainLanes(1) - phase) * inv_fade);
+            auto const fade = Max(steals - (steal_decs * t), GrainLanes(0));
+            auto const env = HannRise(rise) * HannRise(fall) * fade * playing;
+
+            auto const samples_left = DoHermiteInterp(left, x);
+            auto const samples_right = is_mono ? samples_left : DoHermiteInterp(right, x);
+            sum_left[frame] += samples_left * env * gains_left;
+            sum_right[frame] += samples_right * env * gains_right;
+        }
+
+        for (auto const lane : Range(k_grain_lanes)) {
+            if (!(lanes_in_use & (1u << lane))) continue;
+            auto const slot = first + lane;
+            auto const frames_processed = (f32)(ends[lane] - starts[lane]);
+            pool.env_phase[slot] += pool.env_phase_inc[slot] * frames_processed;
+            pool.steal_fade[slot] -= pool.steal_fade_dec[slot] * frames_processed;
+
+            // A grain whose playhead has run off the end of the sample can't make any more sound.
+            if (pool.env_phase[slot] >= 1.0f || pool.steal_fade[slot] <= 0.0f ||
+                PlaybackEnded(pool.playheads[slot], num_frames)) {
+                pool.active[slot] = false;
+                if (!pool.IsStealing(slot)) pool.num_active_non_stealing--;
+            }
+        }
+    }
+
+    for (auto const frame : Range(buffer.size)) {
+        f32x2 out = 0;
+        for (auto const lane : Range(k_grain_lanes))
+            out += f32x2 {sum_left[frame][lane], sum_right[frame][lane]};
+        buffer[frame] += out * (params.amp * params.xfade_vols[frame]);
+    }
+}
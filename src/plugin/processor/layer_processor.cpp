@@ -268,6 +268,7 @@ static void TriggerVoicesIfNeeded(LayerProcessor& layer,
                 ++rr_pos[group_index];
         };
 
+        bool region_still_loading = false;
         for (auto i : Range(inst.instrument.regions.size)) {
             auto const& region = inst.instrument.regions[i];
             auto const& audio_data = inst.audio_datas[i];
@@ -276,6 +277,10 @@ static void TriggerVoicesIfNeeded(LayerProcessor& layer,
                 (!region.trigger.round_robin_index ||
                  *region.trigger.round_robin_index == rr_pos[region.trigger.round_robin_sequencing_group]) &&
                 region.trigger.trigger_event == args.trigger_event) {
+                if (!inst.AudioDataLoaded(i)) {
+                    region_still_loading = true;
+                    continue;
+                }
                 dyn::Append(sampler_params.voice_sample_params,
                             VoiceStartParams::SamplerParams::Region {
                                 .region = region,
@@ -285,6 +290,20 @@ static void TriggerVoicesIfNeeded(LayerProcessor& layer,
             }
         }
 
+        // The instrument is still loading and this note's regions haven't arrived: rather than silence, use
+        // the nearest region that has.
+        if (!sampler_params.voice_sample_params.size && region_still_loading) {
+            if (auto const i =
+                    sample_lib::NearestLoadedRegion(inst, note_for_samples, note_vel, args.trigger_event)) {
+                dyn::Append(sampler_params.voice_sample_params,
+                            VoiceStartParams::SamplerParams::Region {
+                                .region = inst.instrument.regions[*i],
+                                .audio_data = *inst.audio_datas[*i],
+                                .amp = amp,
+                            });
+            }
+        }
+
         if (!sampler_params.voice_sample_params.size) return;
 
         // Do velocity feathering if needed.
@@ -114,10 +114,31 @@ struct Parameters {
     void SetLinearValue(ParamIndex index, f32 value) {
         auto const& range = k_param_descriptors[ToInt(index)].linear_range;
         ASSERT(value >= range.min && value <= range.max);
-        values[ToInt(index)] = value;
+        AssignLinearValue(index, value);
     }
 
+    // Like SetLinearValue but without the range check.
+    void AssignLinearValue(ParamIndex index, f32 value) {
+        auto& v = values[ToInt(index)];
+        values_hash ^= ParamValueHashTerm(ToInt(index), v) ^ ParamValueHashTerm(ToInt(index), value);
+        v = value;
+    }
+
+    void AssignAllLinearValues(Array<f32, k_num_parameters> const& new_values) {
+        values = new_values;
+        RehashValues();
+    }
+
+    // For after writing values directly.
+    void RehashValues() { values_hash = HashParamValues(values); }
+
+    // Write values using the functions above if you want values_hash to stay correct. Only main_params relies
+    // on it: the audio thread's copies write values directly and leave it stale.
     Array<f32, k_num_parameters> values; // Linear values.
+
+    // HashParamValues(values), updated as values change. Compare it against the hash of a snapshot's params
+    // to find out cheaply whether the params might differ from it.
+    u64 values_hash {};
 };
 
 struct ChangedParams {
@@ -3,7 +3,10 @@
 
 #include "processor.hpp"
 
+#include <clap/ext/thread-pool.h>
+
 #include "os/threading.hpp"
+#include "tests/framework.hpp"
 
 #include "common_infrastructure/cc_mapping.hpp"
 #include "common_infrastructure/descriptors/param_descriptors.hpp"
@@ -185,6 +188,7 @@ void AppendMacroDestination(AudioProcessor& processor, AppendMacroDestinationCon
         .param_index = config.param,
         .value = 0.0f,
     });
+    MarkStatePartChanged(processor, StateSnapshotPart::MacroDestinations);
 
     processor.macro_dest_inbox[config.macro_index][*i].Produce({
         .new_value = 0.0f,
@@ -200,6 +204,7 @@ void RemoveMacroDestination(AudioProcessor& processor, RemoveMacroDestinationCon
     auto& macro_dests = processor.main_macro_destinations[config.macro_index];
 
     macro_dests.RemoveAt(config.destination_index);
+    MarkStatePartChanged(processor, StateSnapshotPart::MacroDestinations);
 
     // Update atomics for all shifted destinations.
     for (usize i = config.destination_index; i < k_max_macro_destinations; i++) {
@@ -235,7 +240,10 @@ void RetargetMacroDestinations(AudioProcessor& processor, ParamIndex from, Param
         }
     }
 
-    if (any_changed) processor.host.request_process(&processor.host);
+    if (any_changed) {
+        MarkStatePartChanged(processor, StateSnapshotPart::MacroDestinations);
+        processor.host.request_process(&processor.host);
+    }
 }
 
 void MacroDestinationValueChanged(AudioProcessor& processor, MacroDestinationValueChangedConfig config) {
@@ -243,6 +251,7 @@ void MacroDestinationValueChanged(AudioProcessor& processor, MacroDestinationVal
 
     auto const val =
         processor.main_macro_destinations[config.macro_index].items[config.destination_index].value;
+    MarkStatePartChanged(processor, StateSnapshotPart::MacroDestinations);
 
     processor.macro_dest_inbox[config.macro_index][config.destination_index].Produce({
         .new_value = val,
@@ -533,6 +542,7 @@ void SetInstrument(AudioProcessor& processor,
     if (opts.wipe_arp_slice_config) {
         layer.arp_state.slice_loop_length.Store(0, StoreMemoryOrder::Relaxed);
         layer.arp_state.slice_start_offset.Store(0, StoreMemoryOrder::Relaxed);
+        MarkStatePartChanged(processor, StateSnapshotPart::SliceArpConfigs);
     }
 
     // If we currently have a sampler instrument, we keep it alive by storing it and releasing at a later
@@ -585,12 +595,13 @@ void SetConvolutionIrAudioData(AudioProcessor& processor,
 
 void ApplyState(AudioProcessor& processor, StateSnapshot const& state, StateSource source) {
     ASSERT(g_is_logical_main_thread);
+    MarkAllStatePartsChanged(processor);
 
     if (source == StateSource::Daw)
         for (auto [i, cc] : Enumerate(processor.param_learned_ccs))
             cc.AssignBlockwise(state.extras.param_learned_ccs[i]);
 
-    processor.main_params.values = state.param_values;
+    processor.main_params.AssignAllLinearValues(state.param_values);
 
     processor.desired_effects_order.Store(EncodeEffectsArray(state.fx_order), StoreMemoryOrder::Relaxed);
 
@@ -639,34 +650,60 @@ void ApplyState(AudioProcessor& processor, StateSnapshot const& state, StateSour
     processor.host.request_process(&processor.host);
 }
 
-StateSnapshot CaptureStateSnapshot(AudioProcessor const& processor) {
-    StateSnapshot result {};
-    auto const ordered_fx_pointers =
-        DecodeEffectsArray(processor.desired_effects_order.Load(LoadMemoryOrder::Relaxed),
-                           processor.effects_ordered_by_type);
-    for (auto [i, fx_pointer] : Enumerate(ordered_fx_pointers))
-        result.fx_order[i] = fx_pointer->type;
-
-    for (auto const i : Range(k_num_layers)) {
-        result.inst_ids[i] = processor.layer_processors[i].instrument_id;
-        result.velocity_curve_points[i] = processor.layer_processors[i].velocity_curve_map.points;
-        result.harmony_intervals[i] = processor.layer_processors[i].harmony_intervals.GetBlockwise();
-        for (auto const step_index : Range(k_arp_max_steps))
-            result.arp_steps[i][step_index] =
-                processor.layer_processors[i].arp_state.steps[step_index].Load(LoadMemoryOrder::Relaxed);
-        result.slice_arp_configs[i] = {
-            .start_offset =
-                processor.layer_processors[i].arp_state.slice_start_offset.Load(LoadMemoryOrder::Relaxed),
-            .loop_length =
-                processor.layer_processors[i].arp_state.slice_loop_length.Load(LoadMemoryOrder::Relaxed),
-        };
+void CaptureStateSnapshotPart(AudioProcessor const& processor, StateSnapshotPart part, StateSnapshot& out) {
+    switch (part) {
+        case StateSnapshotPart::Ir: out.ir_id = processor.convo.ir_id; break;
+        case StateSnapshotPart::Instruments:
+            for (auto const i : Range(k_num_layers))
+                out.inst_ids[i] = processor.layer_processors[i].instrument_id;
+            break;
+        case StateSnapshotPart::Params: out.param_values = processor.main_params.values; break;
+        case StateSnapshotPart::FxOrder: {
+            auto const ordered_fx_pointers =
+                DecodeEffectsArray(processor.desired_effects_order.Load(LoadMemoryOrder::Relaxed),
+                                   processor.effects_ordered_by_type);
+            for (auto [i, fx_pointer] : Enumerate(ordered_fx_pointers))
+                out.fx_order[i] = fx_pointer->type;
+            break;
+        }
+        case StateSnapshotPart::VelocityCurves:
+            for (auto const i : Range(k_num_layers))
+                out.velocity_curve_points[i] = processor.layer_processors[i].velocity_curve_map.points;
+            break;
+        case StateSnapshotPart::HarmonyIntervals:
+            for (auto const i : Range(k_num_layers))
+                out.harmony_intervals[i] = processor.layer_processors[i].harmony_intervals.GetBlockwise();
+            break;
+        case StateSnapshotPart::ArpSteps:
+            for (auto const i : Range(k_num_layers)) {
+                auto const& arp_state = processor.layer_processors[i].arp_state;
+                for (auto const step_index : Range(k_arp_max_steps))
+                    out.arp_steps[i][step_index] = arp_state.steps[step_index].Load(LoadMemoryOrder::Relaxed);
+            }
+            break;
+        case StateSnapshotPart::SliceArpConfigs:
+            for (auto const i : Range(k_num_layers)) {
+                auto const& arp_state = processor.layer_processors[i].arp_state;
+                out.slice_arp_configs[i] = {
+                    .start_offset = arp_state.slice_start_offset.Load(LoadMemoryOrder::Relaxed),
+                    .loop_length = arp_state.slice_loop_length.Load(LoadMemoryOrder::Relaxed),
+                };
+            }
+            break;
+        case StateSnapshotPart::MacroDestinations:
+            out.macro_destinations = processor.main_macro_destinations;
+            break;
+        case StateSnapshotPart::FxVisible:
+        case StateSnapshotPart::Metadata:
+        case StateSnapshotPart::MacroNames: break; // Owned by the engine.
+        case StateSnapshotPart::Count: PanicIfReached(); break;
     }
+}
 
-    result.ir_id = processor.convo.ir_id;
-
-    result.param_values = processor.main_params.values;
-
-    result.macro_destinations = processor.main_macro_destinations;
+StateSnapshot CaptureStateSnapshot(AudioProcessor const& processor) {
+    StateSnapshot result {};
+    for (auto const part : Range(ToInt(StateSnapshotPart::Count)))
+        CaptureStateSnapshotPart(processor, (StateSnapshotPart)part, result);
 
     for (auto [i, cc] : Enumerate(processor.param_learned_ccs))
         result.extras.param_learned_ccs[i] = cc.GetBlockwise();
@@ -1190,7 +1227,9 @@ FlushParameterEvents(AudioProcessor& processor, clap_input_events const& in, cla
         SendParamChangesToMainThread(processor, changes_for_main_thread);
     } else {
         // It not activated, we have just updated the main-thread parameters. The audio thread parameters will
-        // be updated in the next time we are activated.
+        // be updated in the next time we are activated. ConsumeParamEventsFromHost writes values directly, so
+        // bring main_params' values_hash back in sync.
+        processor.main_params.RehashValues();
     }
 }
 
@@ -1206,6 +1245,50 @@ static void AudioThreadReset(AudioProcessor& processor) {
     ResetProcessor(processor, changes);
 }
 
+static void ProcessLayerTask(AudioProcessor& processor, u32 layer_index) {
+    auto& tasks = processor.layer_tasks;
+    tasks.results[layer_index] =
+        ProcessLayer(processor.layer_processors[layer_index],
+                     processor.audio_processing_context,
+                     processor.voice_pool,
+                     tasks.num_frames,
+                     tasks.start_fade_out.Get(layer_index),
+                     Span<f32x2>(tasks.scratch_buffers[layer_index].data, tasks.num_frames));
+    tasks.processed[layer_index] = true;
+}
+
+// A layer only writes to its own voices and state, so layers can be processed concurrently. The exception is
+// when a layer might swap its instrument: that ends and starts voices in the shared pool, so we process
+// every layer in order on this thread. Either way, the results are summed in layer order by the caller, so
+// the output doesn't depend on how the work was scheduled.
+static void ProcessLayers(AudioProcessor& processor, u32 num_frames, Bitset<k_num_layers> layers_changed) {
+    ZoneScoped;
+    auto& tasks = processor.layer_tasks;
+    tasks.num_frames = num_frames;
+    tasks.start_fade_out = layers_changed;
+    Fill(tasks.processed, false);
+
+    bool layers_are_independent = !layers_changed.AnyValuesSet();
+    for (auto const& layer : processor.layer_processors)
+        if (layer.inst_change_fade.IsFadingOut() || layer.inst_change_fade.IsSilent())
+            layers_are_independent = false;
+
+    if (layers_are_independent) {
+        if (auto const thread_pool = (clap_host_thread_pool const*)processor.host.get_extension(
+                &processor.host,
+                CLAP_EXT_THREAD_POOL);
+            thread_pool && thread_pool->request_exec) {
+            processor.thread_pool_job = AudioProcessor::ThreadPoolJob::Layers;
+            tasks.fence.Store(0, StoreMemoryOrder::Release);
+            thread_pool->request_exec(&processor.host, k_num_layers);
+        }
+    }
+
+    // As with voices, the host might not have run every task.
+    for (auto const layer_index : Range(k_num_layers))
+        if (!tasks.processed[layer_index]) ProcessLayerTask(processor, layer_index);
+}
+
 static clap_process_status ProcessSubBlock(AudioProcessor& processor,
                                            clap_process const& process,
                                            u32 frame_index,
@@ -1482,24 +1565,18 @@ static clap_process_status ProcessSubBlock(AudioProcessor& processor,
     // Voices and layers
     // ======================================================================================================
     // IMPROVE: support sending the host CLAP_EVENT_NOTE_END events when voices end
+    processor.thread_pool_job = AudioProcessor::ThreadPoolJob::Voices;
     ProcessVoices(processor.voice_pool, sub_block_size, processor.audio_processing_context);
 
     Array<f32x2, k_block_size_max> output_buffer;
     auto const output = Span<f32x2>(output_buffer.data, sub_block_size);
     Fill(output, 0.0f);
 
-    // Safe to share between layers: each layer's result is consumed before the next layer runs.
-    Array<f32x2, k_block_size_max> layer_scratch_buffer;
-    auto const layer_scratch = Span<f32x2>(layer_scratch_buffer.data, sub_block_size);
+    ProcessLayers(processor, sub_block_size, layers_changed);
 
     bool audio_was_generated_by_layers = false;
     for (auto const layer_index : Range(k_num_layers)) {
-        auto const process_result = ProcessLayer(processor.layer_processors[layer_index],
-                                                 processor.audio_processing_context,
-                                                 processor.voice_pool,
-                                                 sub_block_size,
-                                                 layers_changed.Get(layer_index),
-                                                 layer_scratch);
+        auto const& process_result = processor.layer_tasks.results[layer_index];
 
         if (process_result.output) {
             audio_was_generated_by_layers = true;
@@ -1654,7 +1731,7 @@ static void OnMainThread(AudioProcessor& processor) {
     // Consume any parameter changes that were made from the audio thread.
     if (auto const param_changes = processor.param_changes_for_main_thread.PopAll(); param_changes.size) {
         for (auto const p : param_changes)
-            processor.main_params.values[ToInt(p.index)] = p.value;
+            processor.main_params.AssignLinearValue(p.index, p.value);
         processor.listener.OnProcessorChange(ProcessorListener::ParametersChanged);
     }
 
@@ -1662,7 +1739,16 @@ static void OnMainThread(AudioProcessor& processor) {
 }
 
 static void OnThreadPoolExec(AudioProcessor& processor, u32 index) {
-    OnThreadPoolExec(processor.voice_pool, index);
+    switch (processor.thread_pool_job) {
+        case AudioProcessor::ThreadPoolJob::Voices: OnThreadPoolExec(processor.voice_pool, index); break;
+        case AudioProcessor::ThreadPoolJob::Layers: {
+            processor.layer_tasks.fence.Load(LoadMemoryOrder::Acquire);
+            // A misbehaving host; we'd rather not crash.
+            if (index >= k_num_layers) return;
+            ProcessLayerTask(processor, index);
+            break;
+        }
+    }
 }
 
 AudioProcessor::AudioProcessor(clap_host const& host,
@@ -1688,8 +1774,12 @@ AudioProcessor::AudioProcessor(clap_host const& host,
     voice_pool.master_random_seed = &master_random_seed;
     ResetRandomState(*this, 0); // Initialise with default seed for deterministic starting state.
 
-    for (auto const i : Range(k_num_parameters))
-        main_params.values[i] = k_param_descriptors[i].default_linear_value;
+    {
+        Array<f32, k_num_parameters> defaults;
+        for (auto const i : Range(k_num_parameters))
+            defaults[i] = k_param_descriptors[i].default_linear_value;
+        main_params.AssignAllLinearValues(defaults);
+    }
 
     for (u32 i = 0; i < k_num_parameters; ++i)
         param_learned_ccs[i].AssignBlockwise(PinnedCcsForParam(prefs, ParamIndexToId((ParamIndex)i)));
@@ -1713,3 +1803,61 @@ PluginCallbacks<AudioProcessor> const g_processor_callbacks {
     .on_main_thread = OnMainThread,
     .on_thread_pool_exec = OnThreadPoolExec,
 };
+
+TEST_CASE(TestFlushParameterEventsWhileDeactivated) {
+    struct StubListener : ProcessorListener {
+        void OnProcessorChange(ChangeFlags) override {}
+        void OnParamChange(ParamChange, ParamIndex) override {}
+    };
+
+    StubListener listener;
+    prefs::PreferencesTable const prefs {};
+    // AudioProcessor has cacheline-aligned members, so don't use the test arena.
+    auto processor = PageAllocator::Instance().New<AudioProcessor>(k_stub_host, listener, prefs);
+    DEFER { PageAllocator::Instance().Delete(processor); };
+    REQUIRE(!processor->activated);
+
+    auto const index = ParamIndex::MasterVolume;
+    auto const& descriptor = k_param_descriptors[ToInt(index)];
+    auto const new_value = descriptor.default_linear_value == descriptor.linear_range.max
+                               ? descriptor.linear_range.min
+                               : descriptor.linear_range.max;
+
+    clap_event_param_value const event {
+        .header {
+            .size = sizeof(clap_event_param_value),
+            .time = 0,
+            .space_id = CLAP_CORE_EVENT_SPACE_ID,
+            .type = CLAP_EVENT_PARAM_VALUE,
+            .flags = 0,
+        },
+        .param_id = ParamIndexToId(index),
+        .cookie = nullptr,
+        .note_id = -1,
+        .port_index = -1,
+        .channel = -1,
+        .key = -1,
+        .value = (f64)new_value,
+    };
+    clap_input_events const in {
+        .ctx = (void*)&event,
+        .size = [](clap_input_events const*) -> u32 { return 1; },
+        .get = [](clap_input_events const* list, u32) -> clap_event_header_t const* {
+            return &((clap_event_param_value const*)list->ctx)->header;
+        },
+    };
+    clap_output_events const out {
+        .ctx = nullptr,
+        .try_push = [](clap_output_events const*, clap_event_header const*) -> bool { return false; },
+    };
+
+    FlushParameterEvents(*processor, in, out);
+
+    auto const& params = processor->main_params;
+    CHECK_EQ(params.values[ToInt(index)], new_value);
+    CHECK_EQ(params.values_hash, HashParamValues(params.values));
+
+    return k_success;
+}
+
+TEST_REGISTRATION(RegisterProcessorTests) { REGISTER_TEST(TestFlushParameterEventsWhileDeactivated); }
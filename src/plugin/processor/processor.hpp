@@ -244,6 +244,19 @@ struct AudioProcessor {
 
     VoicePool voice_pool {};
 
+    // Audio-thread. The work we hand to the host's thread pool: voices first, then layers.
+    enum class ThreadPoolJob : u8 { Voices, Layers };
+    ThreadPoolJob thread_pool_job {};
+
+    struct {
+        Array<Array<f32x2, k_block_size_max>, k_num_layers> scratch_buffers;
+        Array<LayerProcessResult, k_num_layers> results;
+        Array<bool, k_num_layers> processed;
+        Bitset<k_num_layers> start_fade_out;
+        u32 num_frames;
+        Atomic<u8> fence;
+    } layer_tasks;
+
     Parameters audio_params; // Audio-thread representation of the parameters.
     Parameters main_params; // Main-thread representation of the parameters.
 
@@ -252,6 +265,10 @@ struct AudioProcessor {
     // Main-thread. Macro configurations can only be modified from the main thread.
     MacroDestinations main_macro_destinations {};
 
+    // Main-thread. The non-param parts of the state that might have changed since they were last checked
+    // against the engine's pinned snapshot. Set with MarkStatePartChanged wherever a part is edited.
+    StateSnapshotParts main_state_parts_to_check {};
+
     // Audio-thread representation of macro dests.
     MacroDestinations audio_macro_destinations {};
 
@@ -325,6 +342,20 @@ void ApplyState(AudioProcessor& processor, StateSnapshot const& state, StateSour
 
 StateSnapshot CaptureStateSnapshot(AudioProcessor const& processor);
 
+// Writes just the part into out. Metadata, MacroNames and FxVisible belong to the engine and are left as they
+// are.
+void CaptureStateSnapshotPart(AudioProcessor const& processor, StateSnapshotPart part, StateSnapshot& out);
+
+inline void MarkStatePartChanged(AudioProcessor& processor, StateSnapshotPart part) {
+    ASSERT(g_is_logical_main_thread);
+    processor.main_state_parts_to_check.Set(ToInt(part));
+}
+
+inline void MarkAllStatePartsChanged(AudioProcessor& processor) {
+    ASSERT(g_is_logical_main_thread);
+    processor.main_state_parts_to_check.SetAll();
+}
+
 void ParameterJustStartedMoving(AudioProcessor& processor, ParamIndex index);
 void ParameterJustStoppedMoving(AudioProcessor& processor, ParamIndex index);
 
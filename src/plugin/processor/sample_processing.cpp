@@ -3,6 +3,8 @@
 
 #include "sample_processing.hpp"
 
+#include "granular.hpp"
+
 #include "tests/framework.hpp"
 
 #include "benchmarks/framework.hpp"
@@ -509,11 +511,167 @@ TEST_CASE(TestPlayheadSetupCases) {
     return k_success;
 }
 
+// The straightforward way of rendering grains: one grain at a time, one frame at a time. RenderGrains must
+// sound the same as this.
+static void RenderGrainsOneAtATime(GrainPool& pool, GrainBlockParams const& params, Span<f32x2> buffer) {
+    auto const num_frames = params.audio.num_frames;
+    for (auto const slot : Range(k_num_grain_slots)) {
+        if (!pool.active[slot] || pool.source_index[slot] != params.source_index) continue;
+
+        auto const start = (u32)params.start_frames[slot];
+        auto end = (u32)buffer.size;
+        for (auto const frame : Range(start, (u32)buffer.size)) {
+            auto& playhead = pool.playheads[slot];
+            if (PlaybackEnded(playhead, num_frames)) {
+                end = frame;
+                break;
+            }
+            auto const sample = GetSampleFrame(params.audio, playhead);
+            IncrementPlaybackPos(playhead, params.pitch_ratios[frame] * pool.detune_ratio[slot], num_frames);
+
+            auto const phase = pool.env_phase[slot] + (pool.env_phase_inc[slot] * (f32)frame);
+            auto const rise = Clamp01(phase * params.env_inv_fades[frame]);
+            auto const fall = Clamp01((1.0f - phase) * params.env_inv_fades[frame]);
+            auto const fade = Max(pool.steal_fade[slot] - (pool.steal_fade_dec[slot] * (f32)frame), 0.0f);
+            auto const gain = HannRise(rise) * HannRise(fall) * fade * params.amp * params.xfade_vols[frame];
+            buffer[frame] += sample * f32x2 {pool.gain_left[slot], pool.gain_right[slot]} * gain;
+        }
+
+        auto const frames_processed = (f32)(end - start);
+        pool.env_phase[slot] += pool.env_phase_inc[slot] * frames_processed;
+        pool.steal_fade[slot] -= pool.steal_fade_dec[slot] * frames_processed;
+        if (pool.env_phase[slot] >= 1.0f || pool.steal_fade[slot] <= 0.0f ||
+            PlaybackEnded(pool.playheads[slot], num_frames)) {
+            pool.active[slot] = false;
+            if (!pool.IsStealing(slot)) pool.num_active_non_stealing--;
+        }
+    }
+}
+
+// A full pool with a mix of everything a grain can be doing: reversed, looping, in a loop crossfade,
+// being stolen, about to run off the end of the sample, and belonging to another source.
+static void SetUpTestGrains(GrainPool& pool, AudioData const& audio, Span<u8> start_frames) {
+    pool.Reset(44100);
+    ZeroMemory(start_frames);
+
+    BoundsCheckedLoop const loop {
+        .start = 100,
+        .end = audio.num_frames - 500,
+        .crossfade = 200,
+        .mode = sample_lib::LoopMode::Standard,
+    };
+
+    for (auto const slot : Range(k_max_grains_per_voice)) {
+        if (slot % 7 == 3) continue; // Leave some gaps.
+
+        auto const t = (f32)slot / (f32)k_max_grains_per_voice;
+        auto frame_pos = (f64)(t * (f32)(audio.num_frames - 600));
+        Optional<BoundsCheckedLoop> grain_loop {};
+        if (slot % 4 == 1) {
+            grain_loop = loop;
+            frame_pos = (f64)(loop.end - loop.crossfade + (slot % 50)) + 0.25;
+        } else if (slot % 11 == 0) {
+            frame_pos = (f64)(audio.num_frames - 10) + 0.5;
+        }
+        ResetPlayhead(pool.playheads[slot], frame_pos, grain_loop, slot % 5 == 0, audio.num_frames);
+
+        pool.source_index[slot] = slot % 6 == 0 ? 1 : 0;
+        pool.active[slot] = true;
+        pool.detune_ratio[slot] = 0.5 + (f64)t;
+        pool.env_phase[slot] = t * 0.9f;
+        pool.env_phase_inc[slot] = 1.0f / (f32)(200 + (slot * 3));
+        pool.gain_left[slot] = 0.5f + (t * 0.5f);
+        pool.gain_right[slot] = 1.0f - (t * 0.5f);
+        if (slot % 9 == 0) {
+            pool.steal_fade[slot] = 0.5f;
+            pool.steal_fade_dec[slot] = pool.steal_fade_dec_value;
+        } else {
+            pool.steal_fade[slot] = 1.0f;
+            pool.steal_fade_dec[slot] = 0;
+            ++pool.num_active_non_stealing;
+        }
+        if (slot % 3 == 0) start_frames[slot] = (u8)(slot % k_block_size_max);
+    }
+}
+
+TEST_CASE(TestRenderGrains) {
+    constexpr u32 k_num_frames = 3000;
+    auto data = tester.scratch_arena.AllocateExactSizeUninitialised<f32>(k_num_frames * 2);
+    for (auto const i : Range(k_num_frames)) {
+        data[i * 2] = Sin((k_two_pi<f32> * 7 * (f32)i) / (f32)k_num_frames);
+        data[(i * 2) + 1] = Sin(((k_two_pi<f32> * 11 * (f32)i) / (f32)k_num_frames) + 0.5f);
+    }
+
+    f64 pitch_ratios[k_block_size_max];
+    f32 env_inv_fades[k_block_size_max];
+    f32 xfade_vols[k_block_size_max];
+    for (auto const i : Range(k_block_size_max)) {
+        pitch_ratios[i] = 1.0 + ((f64)i * 0.01);
+        env_inv_fades[i] = 1.0f / (0.3f + ((f32)i * 0.005f));
+        xfade_vols[i] = 0.8f;
+    }
+
+    for (auto const channels : Array {1, 2}) {
+        CAPTURE(channels);
+        AudioData const audio {
+            .hash = 0,
+            .channels = (u8)channels,
+            .sample_rate = 44100,
+            .num_frames = k_num_frames,
+            .interleaved_samples = {data.data, k_num_frames * (usize)channels},
+        };
+
+        auto& pool = *tester.scratch_arena.New<GrainPool>();
+        u8 start_frames[k_num_grain_slots];
+        SetUpTestGrains(pool, audio, start_frames);
+        auto& reference_pool = *tester.scratch_arena.New<GrainPool>(pool);
+
+        bool any_sound = false;
+        for (auto const block : Range(12)) {
+            CAPTURE(block);
+            GrainBlockParams const params {
+                .audio = audio,
+                .source_index = 0,
+                .start_frames = start_frames,
+                .pitch_ratios = pitch_ratios,
+                .env_inv_fades = env_inv_fades,
+                .xfade_vols = xfade_vols,
+                .amp = 0.7f,
+            };
+
+            f32x2 buffer[k_block_size_max] {};
+            f32x2 reference_buffer[k_block_size_max] {};
+            RenderGrains(pool, params, buffer);
+            RenderGrainsOneAtATime(reference_pool, params, reference_buffer);
+
+            for (auto const frame : Range(k_block_size_max)) {
+                CAPTURE(frame);
+                CHECK_APPROX_EQ(buffer[frame][0], reference_buffer[frame][0], 0.0001f);
+                CHECK_APPROX_EQ(buffer[frame][1], reference_buffer[frame][1], 0.0001f);
+                if (buffer[frame][0] != 0 || buffer[frame][1] != 0) any_sound = true;
+            }
+            for (auto const slot : Range(k_num_grain_slots))
+                REQUIRE_EQ(pool.active[slot], reference_pool.active[slot]);
+            CHECK_EQ(pool.num_active_non_stealing, reference_pool.num_active_non_stealing);
+
+            ZeroMemory(Span<u8> {start_frames});
+        }
+        CHECK(any_sound);
+
+        // Grains of the other source were left alone.
+        for (auto const slot : Range(k_max_grains_per_voice))
+            if (slot % 6 == 0 && slot % 7 != 3) CHECK(pool.active[slot]);
+    }
+
+    return k_success;
+}
+
 TEST_REGISTRATION(RegisterSamplePlayheadTests) {
     REGISTER_TEST(TestSamplePlayhead);
     REGISTER_TEST(TestInterpolation);
     REGISTER_TEST(TestStandardLoopSmoothness);
     REGISTER_TEST(TestPlayheadSetupCases);
+    REGISTER_TEST(TestRenderGrains);
 }
 
 // ======================================================================================
@@ -660,9 +818,89 @@ BENCHMARK_FN void BenchmarkGetSampleFrameFractionalIncrement() {
     }
 }
 
+BENCHMARK_FN void BenchmarkRenderGrains(bool one_at_a_time) {
+    // A full pool of looping grains playing through a stereo sample, as a dense granular patch would have.
+    constexpr u32 k_num_frames = 44100;
+    static f32 data[k_num_frames * 2];
+    for (u32 i = 0; i < k_num_frames; ++i) {
+        data[i * 2] = Sin((k_two_pi<f32> * (f32)i) / (f32)k_num_frames);
+        data[(i * 2) + 1] = Sin(((k_two_pi<f32> * (f32)i) / (f32)k_num_frames) + 0.5f);
+    }
+
+    AudioData const audio {
+        .hash = 0,
+        .channels = 2,
+        .sample_rate = 44100,
+        .num_frames = k_num_frames,
+        .interleaved_samples = {data, k_num_frames * 2},
+    };
+
+    BoundsCheckedLoop const loop {
+        .start = 0,
+        .end = k_num_frames,
+        .crossfade = 0,
+        .mode = sample_lib::LoopMode::Standard,
+    };
+
+    static GrainPool initial_pool;
+    initial_pool.Reset(44100);
+    for (auto const slot : Range(k_max_grains_per_voice)) {
+        auto const t = (f32)slot / (f32)k_max_grains_per_voice;
+        ResetPlayhead(initial_pool.playheads[slot], (f64)(t * k_num_frames), loop, false, k_num_frames);
+        initial_pool.active[slot] = true;
+        initial_pool.detune_ratio[slot] = 0.9 + ((f64)t * 0.2);
+        initial_pool.env_phase[slot] = t * 0.5f;
+        initial_pool.env_phase_inc[slot] = 1e-6f;
+        initial_pool.steal_fade[slot] = 1;
+        initial_pool.gain_left[slot] = 0.5f + (t * 0.5f);
+        initial_pool.gain_right[slot] = 1.0f - (t * 0.5f);
+    }
+
+    u8 const start_frames[k_num_grain_slots] {};
+    f64 pitch_ratios[k_block_size_max];
+    f32 env_inv_fades[k_block_size_max];
+    f32 xfade_vols[k_block_size_max];
+    for (auto const i : Range(k_block_size_max)) {
+        pitch_ratios[i] = 1.0;
+        env_inv_fades[i] = 4;
+        xfade_vols[i] = 1;
+    }
+
+    GrainBlockParams const params {
+        .audio = audio,
+        .source_index = 0,
+        .start_frames = start_frames,
+        .pitch_ratios = pitch_ratios,
+        .env_inv_fades = env_inv_fades,
+        .xfade_vols = xfade_vols,
+        .amp = 1,
+    };
+
+    constexpr int k_num_iterations = 20;
+    constexpr u32 k_num_blocks = 1000;
+
+    static GrainPool pool;
+    for (int iter = 0; iter < k_num_iterations; ++iter) {
+        pool = initial_pool;
+        f32x2 sum = 0;
+        for (u32 block = 0; block < k_num_blocks; ++block) {
+            f32x2 buffer[k_block_size_max] {};
+            if (one_at_a_time)
+                RenderGrainsOneAtATime(pool, params, buffer);
+            else
+                RenderGrains(pool, params, buffer);
+            benchmarks::DoNotOptimise(buffer);
+            sum += buffer[0];
+        }
+        benchmarks::DoNotOptimise(sum);
+    }
+}
+
 BENCHMARK_REGISTRATION(RegisterSampleProcessingBenchmarks) {
     REGISTER_BENCHMARK(BenchmarkGetSampleFrameMono);
     REGISTER_BENCHMARK(BenchmarkGetSampleFrameStereo);
     REGISTER_BENCHMARK(BenchmarkGetSampleFrameMonoLooped);
     REGISTER_BENCHMARK(BenchmarkGetSampleFrameFractionalIncrement);
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkRenderGrains(true); }, "RenderGrains/OneAtATime");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkRenderGrains(false); }, "RenderGrains/Lanes");
 }
@@ -25,13 +25,15 @@ union InterpolationPoints<T> {
     };
 };
 
-// 4-point, 3rd-order Hermite interpolation (Laurent de Soras' form).
-inline f32x2 DoHermiteInterp(InterpolationPoints<f32x2> const& p, f32 const x) {
-    f32x2 const c = (p.x1 - p.xm1) * 0.5f;
-    f32x2 const v = p.x0 - p.x1;
-    f32x2 const w = c + v;
-    f32x2 const a = w + v + ((p.x2 - p.x0) * 0.5f);
-    f32x2 const b_neg = w + a;
+// 4-point, 3rd-order Hermite interpolation (Laurent de Soras' form). T is a vector of independent signals,
+// e.g. stereo channels or grains. x is either shared by all of them or a vector of per-signal positions.
+template <typename T>
+inline T DoHermiteInterp(InterpolationPoints<T> const& p, auto const x) {
+    T const c = (p.x1 - p.xm1) * 0.5f;
+    T const v = p.x0 - p.x1;
+    T const w = c + v;
+    T const a = w + v + ((p.x2 - p.x0) * 0.5f);
+    T const b_neg = w + a;
 
     return (((((a * x) - b_neg) * x) + c) * x) + p.x0;
 }
@@ -401,7 +403,9 @@ ALWAYS_INLINE NO_UBSAN constexpr u32 DataIndexAtOffset(signed _BitInt(3) steps,
     return (u32)v;
 }
 
-NO_UBSAN inline f32x2 GetSampleFrame(AudioData const& s, PlayHead const& playhead) {
+// The 4 frames around the playhead that GetSampleFrame interpolates between, ignoring loop crossfades.
+NO_UBSAN inline InterpolationPoints<f32x2> SampleInterpolationPoints(AudioData const& s,
+                                                                     PlayHead const& playhead) {
     auto const loop = playhead.loop.NullableValue();
 
     ASSERT_HOT(s.num_frames != 0);
@@ -418,7 +422,6 @@ NO_UBSAN inline f32x2 GetSampleFrame(AudioData const& s, PlayHead const& playhea
 
     auto const last_frame = s.num_frames - 1;
     auto const frame_index = (u32)playhead.frame_pos;
-    auto const x = (f32)(playhead.frame_pos - frame_index);
 
     InterpolationPoints<u32> const frame_indices = {
         .xm1 = DataIndexAtOffset(-1, frame_index, loop, s.num_frames, last_frame),
@@ -447,25 +450,26 @@ NO_UBSAN inline f32x2 GetSampleFrame(AudioData const& s, PlayHead const& playhea
         p;
     });
 
-    auto result = DoHermiteInterp(({
-                                      InterpolationPoints<f32x2> l;
-                                      if (s.channels == 1)
-                                          l = {
-                                              .xm1 = {data_vals.xm1[0], data_vals.xm1[0]},
-                                              .x0 = {data_vals.x0[0], data_vals.x0[0]},
-                                              .x1 = {data_vals.x1[0], data_vals.x1[0]},
-                                              .x2 = {data_vals.x2[0], data_vals.x2[0]},
-                                          };
-                                      else
-                                          l = {
-                                              .xm1 = {data_vals.xm1[0], data_vals.xm1[1]},
-                                              .x0 = {data_vals.x0[0], data_vals.x0[1]},
-                                              .x1 = {data_vals.x1[0], data_vals.x1[1]},
-                                              .x2 = {data_vals.x2[0], data_vals.x2[1]},
-                                          };
-                                      l;
-                                  }),
-                                  x);
+    if (s.channels == 1)
+        return {
+            .xm1 = {data_vals.xm1[0], data_vals.xm1[0]},
+            .x0 = {data_vals.x0[0], data_vals.x0[0]},
+            .x1 = {data_vals.x1[0], data_vals.x1[0]},
+            .x2 = {data_vals.x2[0], data_vals.x2[0]},
+        };
+    return {
+        .xm1 = {data_vals.xm1[0], data_vals.xm1[1]},
+        .x0 = {data_vals.x0[0], data_vals.x0[1]},
+        .x1 = {data_vals.x1[0], data_vals.x1[1]},
+        .x2 = {data_vals.x2[0], data_vals.x2[1]},
+    };
+}
+
+NO_UBSAN inline f32x2 GetSampleFrame(AudioData const& s, PlayHead const& playhead) {
+    auto const loop = playhead.loop.NullableValue();
+    auto const x = (f32)(playhead.frame_pos - (u32)playhead.frame_pos);
+
+    auto result = DoHermiteInterp(SampleInterpolationPoints(s, playhead), x);
 
     if (loop && loop->crossfade) {
         f32 crossfade_pos = 0;
@@ -9,6 +9,9 @@
 #include "tests/framework.hpp"
 #include "utils/debug/tracy_wrapped.hpp"
 
+#include "benchmarks/framework.hpp"
+
+#include "common_infrastructure/audio_utils.hpp"
 #include "common_infrastructure/constants.hpp"
 #include "common_infrastructure/descriptors/param_descriptors.hpp"
 #include "common_infrastructure/final_binary_type.hpp"
@@ -17,64 +20,86 @@
 #include "processing_utils/audio_processing_context.hpp"
 #include "processor/effect_stereo_widen.hpp"
 
-static void FadeOutVoicesToEnsureMaxActive(VoicePool& pool, AudioProcessingContext const& context) {
-    if (pool.num_active_voices.Load(LoadMemoryOrder::Relaxed) <= k_max_num_active_voices) return;
+static u16 IndexOfVoice(Voice const& v) { return CheckedCast<u16>(&v - v.pool.voices.data); }
+
+// Lower values are better candidates for stealing. Voices that are already on their way out come first, then
+// a voice playing the same note as the one being started, and voices that have only just started come last.
+// Within each category we prefer quieter voices (compared in 6 dB steps), then older ones. A voice in its
+// attack stage is still getting louder, so its current gain isn't used.
+static u64 StealPriority(Voice const& v, VoiceProcessingController const& controller, MidiChannelNote note) {
+    enum : u64 { FadingOut, Releasing, SameNote, Held, Attacking };
+
+    u64 category;
+    if (v.volume_fade.IsFadingOut())
+        category = FadingOut;
+    else if (v.vol_env.state == adsr::State::Release)
+        category = Releasing;
+    else if (v.vol_env.state == adsr::State::Attack)
+        category = Attacking;
+    else if (v.controller == &controller && v.midi_key_trigger == note)
+        category = SameNote;
+    else
+        category = Held;
+
+    // The float's exponent: one step per doubling of gain.
+    u64 gain_step = 0xff;
+    if (v.vol_env.state != adsr::State::Attack)
+        gain_step = (__builtin_bit_cast(u32, Max(v.current_gain, 0.0f)) >> 23) & 0xff;
+
+    constexpr u64 k_time_bits = 52;
+    return (category << 60) | (gain_step << k_time_bits) | (v.time_started & ((1ull << k_time_bits) - 1));
+}
 
-    auto time_started = LargestRepresentableValue<u64>();
-    Voice* oldest_active_voice = nullptr;
+static Voice* FindVoiceToSteal(VoicePool& pool,
+                               VoiceProcessingController const& controller,
+                               MidiChannelNote note,
+                               bool include_fading_out) {
+    auto best_priority = LargestRepresentableValue<u64>();
+    Voice* result = nullptr;
     for (auto& v : pool.EnumerateActiveVoices()) {
-        if (v.time_started < time_started && !v.volume_fade.IsFadingOut()) {
-            time_started = v.time_started;
-            oldest_active_voice = &v;
+        if (!include_fading_out && v.volume_fade.IsFadingOut()) continue;
+        auto const priority = StealPriority(v, controller, note);
+        if (priority < best_priority) {
+            best_priority = priority;
+            result = &v;
         }
     }
+    return result;
+}
+
+static void FadeOutVoicesToEnsureMaxActive(VoicePool& pool,
+                                           VoiceProcessingController const& controller,
+                                           MidiChannelNote note,
+                                           AudioProcessingContext const& context) {
+    if (pool.num_active_voices.Load(LoadMemoryOrder::Relaxed) <= k_max_num_active_voices) return;
+
+    // Fade out the voice we'd steal next.
+    auto voice = FindVoiceToSteal(pool, controller, note, false);
 
     // It's possible that all the voices are fading out already.
-    if (!oldest_active_voice) return;
+    if (!voice) return;
 
-    // Fade out this voice.
-    oldest_active_voice->volume_fade.SetAsFadeOut(context.sample_rate);
+    voice->volume_fade.SetAsFadeOut(context.sample_rate);
 }
 
-static Voice& FindVoice(VoicePool& pool, AudioProcessingContext const& context) {
-    FadeOutVoicesToEnsureMaxActive(pool, context);
+static Voice& FindVoice(VoicePool& pool,
+                        VoiceProcessingController const& controller,
+                        MidiChannelNote note,
+                        AudioProcessingContext const& context) {
+    FadeOutVoicesToEnsureMaxActive(pool, controller, note, context);
 
     // Easy case: find an inactive voice.
-    for (auto& v : pool.voices)
-        if (!v.is_active) return v;
-
-    // All the voices are active, so we do a simple algorithm to find an appropriate voice to steal: quiet and
-    // old.
-
-    // Generate an array of the voice indexes, sorted by age. Where the first index in the array is an index
-    // to the oldest voice.
-    Array<u16, k_num_voices> old_index_to_index;
-    for (auto [i, index] : Enumerate<u16>(old_index_to_index))
-        index = i;
-    Sort(old_index_to_index,
-         [&voices = pool.voices](u16 a, u16 b) { return voices[a].time_started < voices[b].time_started; });
-
-    ASSERT(pool.voices[old_index_to_index[0]].time_started <=
-           pool.voices[old_index_to_index[1]].time_started);
-
-    // We loop through the oldest 1/4 of the voices and find the quietest one to steal - this will hopefully
-    // have the least obvious audible effect.
-    auto quietest_gain = pool.voices[old_index_to_index[0]].current_gain;
-    u16 quietest_voice_index = 0;
-    for (auto const old_index : Range(1uz, old_index_to_index.size / 4)) {
-        auto const voice_index = old_index_to_index[old_index];
-        auto& v = pool.voices[voice_index];
-        if (v.current_gain < quietest_gain) {
-            quietest_gain = v.current_gain;
-            quietest_voice_index = voice_index;
-        }
-    }
+    if (auto const index = pool.active_voice_bits.FirstUnsetBit(); index < k_num_voices)
+        return pool.voices[index];
 
-    auto& result = pool.voices[quietest_voice_index];
-    ASSERT(result.is_active);
+    // All the voices are active, so we steal the one that will hopefully have the least obvious audible
+    // effect. A single pass over the voices: their priorities change every block, so there's no ordering
+    // worth maintaining between note-ons.
+    auto result = FindVoiceToSteal(pool, controller, note, true);
+    ASSERT(result);
 
-    EndVoiceInstantly(result);
-    return result;
+    EndVoiceInstantly(*result);
+    return *result;
 }
 
 void UpdateLFOWaveform(Voice& v) {
@@ -300,22 +325,6 @@ void UpdateLoopInfo(Voice& v) {
     }
 }
 
-// Degree-3 approximation of f(x) = sin(x * pi/2)^2 (half-Hann rise) on [0, 1].
-// Generated by lolremez:
-//   lolremez --float -d 3 -r "0:1" "sin(x*pi/2)^2"
-//   p(x) = ((-2.2102317*x + 3.3153475)*x - 1.0960758e-1)*x + 2.2458674e-3
-// Estimated max error: 2.2458674e-3.
-// Used for grain envelopes: has zero first derivative at both endpoints, giving
-// Hann-window-like spectral properties (-18 dB/oct sidelobe rolloff) and reducing
-// clicks on short grains compared to the simpler QuarterSineFade.
-ALWAYS_INLINE auto HannRise(ScalarOrVectorFloat auto x) {
-    using T = UnderlyingTypeOfVecOrScalar<decltype(x)>;
-    auto u = x * T(-2.2102318f);
-    u = (u + T(3.3153474f)) * x;
-    u = (u + T(-0.10960758f)) * x;
-    return u + T(0.0022458674f);
-}
-
 // SIMD version where 2 pan positions are processed at once.
 // The result is a vector of 4 floats: {left 1, right 1, left 2, right 2}.
 // Constant power pan law (AKA -3dB centre).
@@ -333,7 +342,7 @@ void StartVoice(VoicePool& pool,
                 VoiceProcessingController& voice_controller,
                 VoiceStartParams const& params,
                 AudioProcessingContext const& audio_processing_context) {
-    auto& voice = FindVoice(pool, audio_processing_context);
+    auto& voice = FindVoice(pool, voice_controller, params.midi_key_trigger, audio_processing_context);
 
     auto const sample_rate = audio_processing_context.sample_rate;
     ASSERT(sample_rate != 0);
@@ -508,6 +517,7 @@ void StartVoice(VoicePool& pool,
     }
 
     voice.is_active = true;
+    voice.pool.active_voice_bits.Set(IndexOfVoice(voice));
     voice.pool.num_active_voices.FetchAdd(1, RmwMemoryOrder::Relaxed);
     voice.pool.voices_per_midi_note_for_gui[voice.midi_key_trigger.note].FetchAdd(1, RmwMemoryOrder::Relaxed);
     voice.pool.active_voices_per_layer_for_gui[voice.controller->layer_index].FetchAdd(
@@ -542,6 +552,7 @@ void EndVoiceInstantly(Voice& voice) {
         1,
         RmwMemoryOrder::Relaxed);
     voice.is_active = false;
+    voice.pool.active_voice_bits.Clear(IndexOfVoice(voice));
 
     voice.grain_pool.DeactivateAllGrains();
 }
@@ -568,6 +579,11 @@ void NoteOff(VoicePool& pool, VoiceProcessingController& controller, MidiChannel
         if (v.is_active && v.midi_key_trigger == note && &controller == v.controller) EndVoice(v);
 }
 
+// One element per voice; see k_voice_lanes.
+using VoiceLanes = __attribute__((ext_vector_type(k_voice_lanes))) f32;
+using VoiceLanesS32 = __attribute__((ext_vector_type(k_voice_lanes))) s32;
+using VoiceLanesU32 = __attribute__((ext_vector_type(k_voice_lanes))) u32;
+
 struct VoiceProcessor {
     enum class VoiceBlockResult : u8 {
         Continue,
@@ -600,6 +616,55 @@ struct VoiceProcessor {
         auto const block_result = ApplyGain(voice, output, lfo_amounts, audio_context);
         ApplyFilter(voice, output, lfo_amounts, audio_context);
 
+        FinishBlock(voice, block_result);
+    }
+
+    // Processes voices of the same layer together, one voice per vector lane. Gives the same results as
+    // calling Process() on each voice, give or take float rounding. The sound sources are still rendered one
+    // voice at a time; the LFO, envelopes, gain and filter run across the lanes.
+    static void ProcessLanes(Span<Voice* const> voices,
+                             AudioProcessingContext const& audio_context,
+                             u32 num_frames) {
+        ZoneNamedN(process, "Voice Process Lanes", true);
+        ZoneTextVF(process, "%zu voices", voices.size);
+        ASSERT_HOT(voices.size >= 1 && voices.size <= k_voice_lanes);
+
+        for (auto const voice : voices) {
+            ASSERT_HOT(voice->is_active);
+            ASSERT_HOT(!voice->processed_this_block);
+            ASSERT_HOT(CanShareLanes(*voice, *voices[0]));
+            voice->processed_this_block = true;
+            Fill(Span<f32x2> {voice->buffer.data, num_frames}, 0.0f);
+        }
+
+        Array<VoiceLanes, k_block_size_max> lfo_lanes_buffer;
+        auto const lfo_lanes = Span<VoiceLanes> {lfo_lanes_buffer}.SubSpan(0, num_frames);
+        Array<Array<f32, k_block_size_max>, k_voice_lanes> lfo_amounts;
+        FillLfoLanes(voices, lfo_lanes, lfo_amounts);
+
+        for (auto const [lane, voice] : Enumerate(voices)) {
+            FillBufferWithSampleData(*voice,
+                                     {voice->buffer.data, num_frames},
+                                     Span<f32 const> {lfo_amounts[lane].data, num_frames},
+                                     audio_context);
+        }
+
+        Array<VoiceBlockResult, k_voice_lanes> block_results;
+        Array<u32, k_voice_lanes> num_frames_to_filter;
+        ApplyGainLanes(voices, lfo_lanes, audio_context, block_results, num_frames_to_filter);
+        ApplyFilterLanes(voices, lfo_lanes, audio_context, num_frames_to_filter);
+
+        for (auto const [lane, voice] : Enumerate(voices))
+            FinishBlock(*voice, block_results[lane]);
+    }
+
+    // Voices can be processed in the same lanes if everything the lanes share comes out the same for each.
+    static bool CanShareLanes(Voice const& a, Voice const& b) {
+        return a.controller == b.controller && a.disable_vol_env == b.disable_vol_env &&
+               a.frames_before_starting == 0 && b.frames_before_starting == 0;
+    }
+
+    static void FinishBlock(Voice& voice, VoiceBlockResult block_result) {
         {
             f64 position_for_gui = {};
             for (auto const& s : voice.sound_sources) {
@@ -652,9 +717,10 @@ struct VoiceProcessor {
                 }
 
                 if (ref_num_frames) {
-                    for (auto const& grain : voice.grain_pool.grains) {
-                        if (!grain.active || grain_markers.num_active >= k_max_grains_per_voice) continue;
-                        auto const pos = grain.playhead.RealFramePos(ref_num_frames);
+                    auto const& grains = voice.grain_pool;
+                    for (auto const slot : Range(k_max_grains_per_voice)) {
+                        if (!grains.active[slot]) continue;
+                        auto const pos = grains.playheads[slot].RealFramePos(ref_num_frames);
                         if (pos) {
                             grain_markers.grains[grain_markers.num_active++] = {
                                 .position = (u16)((*pos / (f64)ref_num_frames) *
@@ -827,8 +893,8 @@ struct VoiceProcessor {
 #ifdef TRACY_ENABLE
         {
             u32 num_active = 0;
-            for (auto const& g : pool.grains)
-                if (g.active) num_active++;
+            for (auto const a : pool.active)
+                if (a) num_active++;
             ZoneTextVF(granular_zone,
                        "%u active grains, %u frames, %u ch",
                        num_active,
@@ -839,14 +905,14 @@ struct VoiceProcessor {
 #endif
 
         // Running grains start at frame 0, but for newly spawned grains there might be an offset.
-        u8 grain_start_frame[k_max_grains_per_voice] {};
+        u8 grain_start_frame[k_num_grain_slots] {};
         static_assert(LargestRepresentableValue<RemoveReference<decltype(grain_start_frame[0])>>() >=
                       k_block_size_max);
 
         // Pre-compute source-wide values - all grains will refer to these.
         f64 pitch_ratios[k_block_size_max];
-        alignas(alignof(f32x4)) f32x2 xfade_vols[k_block_size_max];
-        alignas(alignof(f32x4)) f32 env_inv_fades[k_block_size_max];
+        f32 xfade_vols[k_block_size_max];
+        f32 env_inv_fades[k_block_size_max];
         f32 smoothing[k_block_size_max];
         {
             ZoneNamedN(precompute, "Granular: Precompute", true);
@@ -859,8 +925,6 @@ struct VoiceProcessor {
                     sampler.xfade_vol_smoother.LowPass(sampler.xfade_vol,
                                                        context.one_pole_smoothing_cutoff_10ms);
             }
-            for (auto const frame_index : Range<usize>(buffer.size, k_block_size_max))
-                xfade_vols[frame_index] = 0;
 
             {
                 constexpr f32 k_min_smooth_ms = 1.0f;
@@ -872,10 +936,6 @@ struct VoiceProcessor {
                     env_inv_fades[frame_index] = 1.0f / (smoothing[frame_index] * 0.5f);
                 }
             }
-            for (auto const frame_index : Range<usize>(buffer.size, k_block_size_max)) {
-                smoothing[frame_index] = smoothing[buffer.size - 1];
-                env_inv_fades[frame_index] = env_inv_fades[buffer.size - 1];
-            }
         }
 
         // The frame at which the source becomes dead (past-end without a loop). If the source
@@ -913,12 +973,10 @@ struct VoiceProcessor {
 
                 if (pool.spawn_counters[source_index] == 0) {
                     // Find first inactive grain slot.
-                    Grain* new_grain = nullptr;
-                    usize new_grain_index = 0;
-                    for (auto [gi, g] : Enumerate(pool.grains)) {
-                        if (!g.active) {
-                            new_grain = &g;
-                            new_grain_index = gi;
+                    Optional<u32> new_grain {};
+                    for (auto const slot : Range(k_max_grains_per_voice)) {
+                        if (!pool.active[slot]) {
+                            new_grain = slot;
                             break;
                         }
                     }
@@ -932,6 +990,7 @@ struct VoiceProcessor {
                         pool.spawn_counters[source_index] = (u32)(buffer.size - frame_index);
                         continue;
                     }
+                    auto const grain = *new_grain;
 
                     // We need some random floats in a few places, we already have SIMD support for
                     // generating 4 randoms at once, so we can save a few instructions.
@@ -966,9 +1025,9 @@ struct VoiceProcessor {
                         }()) {
                         // Init new grain.
                         {
-                            new_grain->playhead = *grain_playhead;
-                            new_grain->source_index = source_index;
-                            new_grain->env_phase_inc = ({
+                            pool.playheads[grain] = *grain_playhead;
+                            pool.source_index[grain] = source_index;
+                            pool.env_phase_inc[grain] = ({
                                 // Extend grain so fade-out aligns with the next grain's spawn point.
                                 auto const fade_divisor = Max(0.05f, 1.0f - (smoothing[frame_index] * 0.5f));
                                 constexpr f32 k_length_jitter_amount = 0.0f;
@@ -979,15 +1038,20 @@ struct VoiceProcessor {
 
                                 1.0f / (f32)effective_length;
                             });
-                            new_grain->env_phase = 0;
-                            new_grain->active = true;
-                            new_grain->steal_fade = 1.0f;
-                            new_grain->steal_fade_dec = 0;
-
-                            new_grain->pan_pos = (pan_rand * 2.0f - 1.0f) * ctrl.granular.random_pan;
-                            new_grain->amp = 1.0f - (amp_jitter_rand * 0.45f);
+                            pool.env_phase[grain] = 0;
+                            pool.active[grain] = true;
+                            pool.steal_fade[grain] = 1.0f;
+                            pool.steal_fade_dec[grain] = 0;
+
+                            {
+                                auto const pan_pos = (pan_rand * 2.0f - 1.0f) * ctrl.granular.random_pan;
+                                auto const amp = 1.0f - (amp_jitter_rand * 0.45f);
+                                auto const pan_gains = EqualPanGains2(f32x2(pan_pos));
+                                pool.gain_left[grain] = pan_gains[0] * amp;
+                                pool.gain_right[grain] = pan_gains[1] * amp;
+                            }
 
-                            new_grain->detune_ratio = ({
+                            pool.detune_ratio[grain] = ({
                                 f64 r;
                                 if (ctrl.granular.random_detune > 0.0001f) {
                                     auto const detune_semitones =
@@ -1029,7 +1093,7 @@ struct VoiceProcessor {
                         }
 
                         pool.num_active_non_stealing++;
-                        grain_start_frame[new_grain_index] = (u8)frame_index;
+                        grain_start_frame[grain] = (u8)frame_index;
 
                         // Initiate grain steal fading-out if nearing full.
                         if (pool.num_active_non_stealing > k_grain_steal_threshold) {
@@ -1038,10 +1102,10 @@ struct VoiceProcessor {
                             // to pick from. We pick one randomly to avoid any unpleasant-sounding regularity.
                             auto const pick = Rand(voice.random_seed).x % pool.num_active_non_stealing;
                             u32 index = 0;
-                            for (auto& g : pool.grains) {
-                                if (!g.active || g.IsStealing() || &g == new_grain) continue;
+                            for (auto const slot : Range(k_max_grains_per_voice)) {
+                                if (!pool.active[slot] || pool.IsStealing(slot) || slot == grain) continue;
                                 if (index == pick) {
-                                    g.steal_fade_dec = pool.steal_fade_dec_value;
+                                    pool.steal_fade_dec[slot] = pool.steal_fade_dec_value;
                                     pool.num_active_non_stealing--;
                                     break;
                                 }
@@ -1074,131 +1138,27 @@ struct VoiceProcessor {
             }
         }
 
-        // --- Pass 2: process each grain across its full range of the buffer. ---
+        // --- Pass 2: render the grains across their range of the buffer. ---
         {
             ZoneNamedN(granular_pass2, "Granular: Process Grains", true);
-
-            for (auto [grain_index, grain] : Enumerate(pool.grains)) {
-                if (!grain.active || grain.source_index != source_index) continue;
-
-                // IMPORTANT: this is a very hot code path:
-                // num-active-voices * num-active-grains * num-frames.
-
-                auto const start = grain_start_frame[grain_index];
-                auto end = buffer.size;
-                ASSERT_HOT(start < end);
-
-                // --- Fetch samples and advance playhead ---
-                alignas(alignof(f32x4)) f32x2 grain_samples[k_block_size_max] {};
-                {
-                    ZoneNamedN(fetch_zone, "Grain: GetSampleFrame", true);
-
-                    for (auto const i : Range<usize>(start, buffer.size)) {
-                        if (!PlaybackEnded(grain.playhead, num_frames)) [[likely]] {
-                            grain_samples[i] = GetSampleFrame(*sampler.data, grain.playhead);
-                            IncrementPlaybackPos(grain.playhead,
-                                                 pitch_ratios[i] * grain.detune_ratio,
-                                                 num_frames);
-                        } else {
-                            end = i;
-                            break;
-                        }
-                    }
-                }
-
-                alignas(alignof(f32x4)) f32x2 grain_gains[k_block_size_max] {};
-
-                // --- Calculate gains ---
-                {
-                    ZoneNamedN(mix_zone, "Grain: Gain calc", true);
-
-                    auto const amp = s.amp * grain.amp;
-                    auto const grain_pan_gains = EqualPanGains2(f32x2(grain.pan_pos)).xy;
-
-                    // Constants.
-                    auto const amp4 =
-                        __builtin_shufflevector(grain_pan_gains, grain_pan_gains, 0, 1, 0, 1) * amp;
-                    for (u32 i = 0; i < k_block_size_max; i += 2)
-                        *(f32x4*)(void*)(&grain_gains[i]) = amp4;
-
-                    // Xfade.
-                    for (u32 i = 0; i < k_block_size_max; i += 2)
-                        *(f32x4*)(void*)(&grain_gains[i]) *= *(f32x4*)(void*)(&xfade_vols[i]);
-
-                    // Envelopes.
-                    {
-                        static_assert(k_block_size_max % 4 == 0);
-                        alignas(alignof(f32x4)) f32 env_scalars[k_block_size_max];
-                        {
-                            auto const phase_inc = grain.env_phase_inc;
-                            auto const steal_dec = grain.steal_fade_dec;
-                            f32x4 phases = grain.env_phase + (phase_inc * f32x4 {0, 1, 2, 3});
-                            f32x4 steals = grain.steal_fade - (steal_dec * f32x4 {0, 1, 2, 3});
-                            auto const phase_inc4 = phase_inc * 4;
-                            auto const steal_dec4 = steal_dec * 4;
-
-                            for (u32 i = 0; i < k_block_size_max; i += 4) {
-                                auto const inv_fade = *(f32x4 const*)(void const*)(&env_inv_fades[i]);
-                                auto const rise = Clamp01(phases * inv_fade);
-                                auto const fall = Clamp01((f32x4(1) - phases) * inv_fade);
-                                auto const env = HannRise(rise) * HannRise(fall);
-                                auto const fade = Max(steals, f32x4(0));
-                                *(f32x4*)(void*)(&env_scalars[i]) = env * fade;
-                                phases += phase_inc4;
-                                steals -= steal_dec4;
-                            }
-                        }
-
-                        // Zero out-of-range entries (before start and after end).
-                        for (u32 i = 0; i < start; ++i)
-                            env_scalars[i] = 0;
-                        for (auto i = end; i < k_block_size_max; ++i)
-                            env_scalars[i] = 0;
-
-                        for (u32 i = 0; i < k_block_size_max; i += 2) {
-                            auto const env_pair = *(f32x2*)(void*)(&env_scalars[i]);
-                            auto const expanded = __builtin_shufflevector(env_pair, env_pair, 0, 0, 1, 1);
-                            *(f32x4*)(void*)(&grain_gains[i]) *= expanded;
-                        }
-                    }
-
-                    // Advance phases.
-                    {
-                        auto const frames_processed = (f32)(end - start);
-                        grain.env_phase += grain.env_phase_inc * frames_processed;
-                        grain.steal_fade -= grain.steal_fade_dec * frames_processed;
-                        if (grain.env_phase >= 1.0f || grain.steal_fade <= 0.0f) {
-                            grain.active = false;
-                            if (!grain.IsStealing()) pool.num_active_non_stealing--;
-                        }
-                    }
-                }
-
-                // --- Mix into buffer ---
-                {
-                    ZoneNamedN(mix_zone, "Grain: Mix", true);
-
-                    auto const even_size = buffer.size & ~usize(1);
-                    for (usize i = 0; i < even_size; i += 2) {
-                        auto const samples = *(f32x4*)(void*)(&grain_samples[i]);
-                        auto const gains = *(f32x4*)(void*)(&grain_gains[i]);
-                        // The buffer might not be aligned, so we need memcpy.
-                        f32x4 buf;
-                        __builtin_memcpy_inline(&buf, &buffer.data[i], sizeof(f32x4));
-                        buf += samples * gains;
-                        __builtin_memcpy_inline(&buffer.data[i], &buf, sizeof(f32x4));
-                    }
-                    if (buffer.size & 1)
-                        buffer.data[even_size] += grain_samples[even_size] * grain_gains[even_size];
-                }
-            }
+            RenderGrains(pool,
+                         {
+                             .audio = *sampler.data,
+                             .source_index = source_index,
+                             .start_frames = grain_start_frame,
+                             .pitch_ratios = pitch_ratios,
+                             .env_inv_fades = env_inv_fades,
+                             .xfade_vols = xfade_vols,
+                             .amp = s.amp,
+                         },
+                         buffer);
         }
 
         // --- Pass 3: check if the source should end. ---
         if (source_dead_frame < buffer.size) {
             bool any_grain_active = false;
-            for (auto const& g : pool.grains) {
-                if (g.active && g.source_index == source_index) {
+            for (auto const slot : Range(k_max_grains_per_voice)) {
+                if (pool.active[slot] && pool.source_index[slot] == source_index) {
                     any_grain_active = true;
                     break;
                 }
@@ -1415,53 +1375,173 @@ struct VoiceProcessor {
         return VoiceBlockResult::Continue;
     }
 
+    // Filter coefficients need a tan() so rather than calculating them every frame we calculate them at
+    // control points and interpolate in between. An interval falls back to exact coefficients every frame if
+    // the filter switches on or off within it, or if the cutoff or resonance move too far for interpolation
+    // to follow: fast envelopes or audio-rate LFOs.
+    static constexpr u32 k_filter_control_interval = 8;
+    static constexpr f32 k_max_interpolated_cutoff_change = 0.01f; // Linear cutoff, 0 to 1.
+    static constexpr f32 k_max_interpolated_resonance_change = 0.01f;
+
+    // The filter modulation for each frame of a block.
+    struct FilterModulation {
+        Array<f32, k_block_size_max> cutoff; // Linear, smoothed.
+        Array<f32, k_block_size_max> resonance; // Smoothed.
+        Array<f32, k_block_size_max> mix;
+        Array<bool, k_block_size_max> on;
+        Array<bool, k_block_size_max> changed; // Cutoff or resonance moved since the previous frame.
+    };
+
+    struct FilterControlInterval {
+        u32 end; // One past the last frame.
+        u32 end_control_frame; // The frame whose coefficients we interpolate towards.
+        f32 inv_length;
+        bool interpolate;
+    };
+
+    static FilterControlInterval FilterControlIntervalAt(FilterModulation const& mod,
+                                                         u32 start,
+                                                         u32 num_frames,
+                                                         bool allow_interpolation) {
+        FilterControlInterval result {};
+        result.end = Min(start + k_filter_control_interval, num_frames);
+        result.end_control_frame = result.end == num_frames ? num_frames - 1 : result.end;
+        if (result.end_control_frame != start)
+            result.inv_length = 1.0f / (f32)(result.end_control_frame - start);
+
+        result.interpolate = allow_interpolation;
+        for (auto const frame : Range(start, result.end_control_frame + 1))
+            if (!mod.on[frame]) result.interpolate = false;
+        if (result.interpolate) {
+            auto const from = start;
+            auto const to = result.end_control_frame;
+            result.interpolate =
+                Abs(mod.cutoff[to] - mod.cutoff[from]) <= k_max_interpolated_cutoff_change &&
+                Abs(mod.resonance[to] - mod.resonance[from]) <= k_max_interpolated_resonance_change;
+        }
+        return result;
+    }
+
+    static void UpdateFilterCoeffs(Voice& voice,
+                                   FilterModulation const& mod,
+                                   u32 frame,
+                                   AudioProcessingContext const& context) {
+        voice.filter_coeffs.Update(context.sample_rate,
+                                   sv_filter::LinearToHz(Clamp(mod.cutoff[frame], 0.0f, 1.0f)),
+                                   mod.resonance[frame]);
+    }
+
+    // Gets an interpolated interval's coefficients ready: voice.filter_coeffs ends up as those of the end
+    // control frame.
+    static void PrepareInterpolatedFilterCoeffs(Voice& voice,
+                                                FilterModulation const& mod,
+                                                u32 start,
+                                                FilterControlInterval const& interval,
+                                                bool prev_interval_interpolated,
+                                                AudioProcessingContext const& context,
+                                                sv_filter::CachedHelpers& from) {
+        // After an interpolated interval we already have the coefficients for this control frame.
+        if (mod.changed[start] && !prev_interval_interpolated) UpdateFilterCoeffs(voice, mod, start, context);
+        from = voice.filter_coeffs;
+
+        for (auto const frame : Range(start + 1, interval.end_control_frame + 1)) {
+            if (mod.changed[frame]) {
+                UpdateFilterCoeffs(voice, mod, interval.end_control_frame, context);
+                break;
+            }
+        }
+    }
+
+    static void FillFilterModulation(Voice& voice,
+                                     u32 num_frames,
+                                     Span<f32 const> lfo_amounts,
+                                     AudioProcessingContext const& context,
+                                     FilterModulation& mod) {
+        auto const has_filter_lfo = HasFilterLfo(voice);
+
+        for (auto const frame : Range(num_frames)) {
+            auto env = voice.fil_env.Process(voice.controller->fil_env);
+            mod.mix[frame] = voice.filter_mix_smoother.LowPass((f32)voice.controller->filter_on,
+                                                               context.one_pole_smoothing_cutoff_10ms);
+            mod.on[frame] = mod.mix[frame] > 0.00001f;
+            if (!mod.on[frame]) {
+                mod.cutoff[frame] = 0;
+                mod.resonance[frame] = 0;
+                mod.changed[frame] = false;
+                voice.filter_resonance_smoother.Reset();
+                voice.filter_linear_cutoff_smoother.Reset();
+                continue;
+            }
+
+            auto cut = voice.controller->sv_filter_cutoff_linear +
+                       ((env - 0.5f) * voice.controller->fil_env_amount);
+            auto const res = voice.controller->sv_filter_resonance;
+
+            if (has_filter_lfo) cut += (lfo_amounts[frame] * voice.controller->lfo.amount) / 2;
+
+            auto const smoothing = context.one_pole_smoothing_cutoff_1ms;
+            f32 res_change {};
+            mod.resonance[frame] = voice.filter_resonance_smoother.LowPass(res, smoothing, &res_change);
+            f32 cut_change {};
+            mod.cutoff[frame] = voice.filter_linear_cutoff_smoother.LowPass(cut, smoothing, &cut_change);
+            mod.changed[frame] = has_filter_lfo || cut_change > 0.00001f || res_change > 0.00001f;
+        }
+    }
+
     static void ApplyFilter(Voice& voice,
                             Span<f32x2>& buffer,
                             Span<f32 const> lfo_amounts,
                             AudioProcessingContext const& context) {
         ZoneScoped;
         auto const filter_type = voice.controller->filter_type;
-        auto const has_filter_lfo = HasFilterLfo(voice);
+        auto const num_frames = (u32)buffer.size;
 
-        for (auto const [frame_index, val] : Enumerate(buffer)) {
-            auto env = voice.fil_env.Process(voice.controller->fil_env);
-            if (auto const filter_mix =
-                    voice.filter_mix_smoother.LowPass((f32)voice.controller->filter_on,
-                                                      context.one_pole_smoothing_cutoff_10ms);
-                filter_mix > 0.00001f) {
-
-                auto cut = voice.controller->sv_filter_cutoff_linear +
-                           ((env - 0.5f) * voice.controller->fil_env_amount);
-                auto res = voice.controller->sv_filter_resonance;
-
-                if (has_filter_lfo) cut += (lfo_amounts[frame_index] * voice.controller->lfo.amount) / 2;
-
-                f32 res_change {};
-                res = voice.filter_resonance_smoother.LowPass(res,
-                                                              context.one_pole_smoothing_cutoff_1ms,
-                                                              &res_change);
-                f32 cut_change {};
-                cut = voice.filter_linear_cutoff_smoother.LowPass(cut,
-                                                                  context.one_pole_smoothing_cutoff_1ms,
-                                                                  &cut_change);
-
-                if (has_filter_lfo || cut_change > 0.00001f || res_change > 0.00001f) {
-                    cut = sv_filter::LinearToHz(Clamp(cut, 0.0f, 1.0f));
-                    voice.filter_coeffs.Update(context.sample_rate, cut, res);
-                }
+        FilterModulation mod;
+        FillFilterModulation(voice, num_frames, lfo_amounts, context, mod);
 
-                f32x2 wet_buf;
-                sv_filter::Process(val, wet_buf, voice.filters, filter_type, voice.filter_coeffs);
+        auto const filter_frame = [&](u32 frame, sv_filter::CachedHelpers const& coeffs) {
+            auto& val = buffer[frame];
+            f32x2 wet_buf;
+            sv_filter::Process(val, wet_buf, voice.filters, filter_type, coeffs);
 
-                if (filter_mix < 0.999f)
-                    val = val + (filter_mix * (wet_buf - val));
-                else
-                    val = wet_buf;
+            auto const filter_mix = mod.mix[frame];
+            if (filter_mix < 0.999f)
+                val = val + (filter_mix * (wet_buf - val));
+            else
+                val = wet_buf;
+        };
+
+        bool prev_interval_interpolated = false;
+        for (u32 start = 0; start < num_frames;) {
+            auto const interval =
+                FilterControlIntervalAt(mod, start, num_frames, voice.pool.interpolate_filter_coeffs);
+
+            if (interval.interpolate) {
+                sv_filter::CachedHelpers from;
+                PrepareInterpolatedFilterCoeffs(voice,
+                                                mod,
+                                                start,
+                                                interval,
+                                                prev_interval_interpolated,
+                                                context,
+                                                from);
+                for (auto const frame : Range(start, interval.end)) {
+                    auto const t = (f32)(frame - start) * interval.inv_length;
+                    filter_frame(frame, sv_filter::LerpCoeffs(from, voice.filter_coeffs, t));
+                }
             } else {
-                voice.filters = {};
-                voice.filter_resonance_smoother.Reset();
-                voice.filter_linear_cutoff_smoother.Reset();
+                for (auto const frame : Range(start, interval.end)) {
+                    if (!mod.on[frame]) {
+                        voice.filters = {};
+                        continue;
+                    }
+                    if (mod.changed[frame]) UpdateFilterCoeffs(voice, mod, frame, context);
+                    filter_frame(frame, voice.filter_coeffs);
+                }
             }
+
+            prev_interval_interpolated = interval.interpolate;
+            start = interval.end;
         }
     }
 
@@ -1470,8 +1550,497 @@ struct VoiceProcessor {
         for (auto& amount : lfo_amounts)
             amount = -voice.lfo.Tick();
     }
+
+    // Gathers each lane's frame into separate left and right vectors.
+    static void LoadLanes(Span<Voice* const> voices, u32 frame, VoiceLanes& left, VoiceLanes& right) {
+        for (auto const [lane, voice] : Enumerate(voices)) {
+            left[lane] = voice->buffer[frame].x;
+            right[lane] = voice->buffer[frame].y;
+        }
+    }
+
+    static void StoreLanes(Span<Voice* const> voices,
+                           u32 frame,
+                           VoiceLanesS32 lanes_to_store,
+                           VoiceLanes left,
+                           VoiceLanes right) {
+        for (auto const [lane, voice] : Enumerate(voices))
+            if (lanes_to_store[lane]) voice->buffer[frame] = f32x2 {left[lane], right[lane]};
+    }
+
+    // The same as ApplyGain() for each voice. Lanes that end stop changing state from that point on, just as
+    // ApplyGain() returns early.
+    static void ApplyGainLanes(Span<Voice* const> voices,
+                               Span<VoiceLanes const> lfo_lanes,
+                               AudioProcessingContext const& context,
+                               Span<VoiceBlockResult> block_results,
+                               Span<u32> num_frames_to_filter) {
+        ZoneScoped;
+        auto const& controller = *voices[0]->controller;
+        auto const num_frames = (u32)lfo_lanes.size;
+
+        auto const env_on = controller.vol_env_on && !voices[0]->disable_vol_env;
+
+        // LFO parameters
+        auto const has_volume_lfo = HasVolumeLfo(*voices[0]);
+        auto const has_pan_lfo = HasPanLfo(*voices[0]);
+        auto const lfo_amp = (has_volume_lfo || has_pan_lfo) ? controller.lfo.amount : 0.0f;
+        auto const lfo_base = has_volume_lfo ? (1.0f - (Fabs(lfo_amp) / 2.0f)) : 1.0f;
+        auto const lfo_half_amp = lfo_amp / 2.0f;
+
+        VoiceLanesS32 running {};
+        VoiceLanes env_output {};
+        VoiceLanesS32 env_state {};
+        VoiceLanes width_prev {};
+        VoiceLanes gain_left_prev {};
+        VoiceLanes gain_right_prev {};
+        for (auto const [lane, voice] : Enumerate(voices)) {
+            running[lane] = -1;
+            env_output[lane] = voice->vol_env.output;
+            env_state[lane] = (s32)voice->vol_env.state;
+            width_prev[lane] = voice->stereo_width_smoother.prev_output;
+            gain_left_prev[lane] = voice->gain_smoother.prev_output.x;
+            gain_right_prev[lane] = voice->gain_smoother.prev_output.y;
+            block_results[lane] = VoiceBlockResult::Continue;
+            num_frames_to_filter[lane] = num_frames;
+        }
+
+        auto const process_env = [&]() {
+            if (!env_on) return VoiceLanes(1.0f);
+            auto output = env_output;
+            auto state = env_state;
+            auto const env = adsr::ProcessLanes(controller.vol_env, output, state);
+            env_output = Select(running, output, env_output);
+            env_state = Select(running, state, env_state);
+            return env;
+        };
+
+        // Widens, then applies the gain through each lane's gain smoother. A smoother without a previous
+        // value jumps straight to its input, as OnePoleLowPassFilter does.
+        auto const apply_gain = [&](u32 frame,
+                                    VoiceLanes m_scale,
+                                    VoiceLanes s_scale,
+                                    VoiceLanes gain_left,
+                                    VoiceLanes gain_right) {
+            VoiceLanes left {};
+            VoiceLanes right {};
+            LoadLanes(voices, frame, left, right);
+            auto const m = (left + right) * m_scale;
+            auto const s = (right - left) * s_scale;
+
+            auto const invalid = gain_left_prev != gain_left_prev;
+            auto const prev_left = Select(invalid, gain_left, gain_left_prev);
+            auto const prev_right = Select(invalid, gain_right, gain_right_prev);
+            auto const smoothed_left =
+                prev_left + (context.one_pole_smoothing_cutoff_0_2ms * (gain_left - prev_left));
+            auto const smoothed_right =
+                prev_right + (context.one_pole_smoothing_cutoff_0_2ms * (gain_right - prev_right));
+            gain_left_prev = Select(running, smoothed_left, gain_left_prev);
+            gain_right_prev = Select(running, smoothed_right, gain_right_prev);
+
+            StoreLanes(voices, frame, running, (m - s) * smoothed_left, (m + s) * smoothed_right);
+        };
+
+        VoiceLanes final_gain1 = 1.0f;
+
+        for (u32 frame = 0; frame < num_frames; frame += 2) {
+            auto const frame_p1 = frame + 1;
+            auto const frame_p1_is_valid = frame_p1 != num_frames;
+
+            // Calculate envelope gain
+            auto const env1 = process_env();
+            auto const env2 = frame_p1_is_valid ? process_env() : VoiceLanes(1.0f);
+
+            // Calculate volume LFO gain
+            VoiceLanes vol_lfo1 = 1.0f;
+            VoiceLanes vol_lfo2 = 1.0f;
+            if (has_volume_lfo) {
+                vol_lfo1 = lfo_base + (lfo_lanes[frame] * lfo_half_amp);
+                vol_lfo2 = (frame_p1_is_valid) ? lfo_base + (lfo_lanes[frame_p1] * lfo_half_amp) : vol_lfo1;
+            }
+
+            // Calculate fade gain. Volume fades are small state machines so we step them one voice at a time.
+            VoiceLanes fade1 = 1.0f;
+            VoiceLanes fade2 = 1.0f;
+            for (auto const [lane, voice] : Enumerate(voices)) {
+                if (!running[lane]) continue;
+                fade1[lane] = voice->volume_fade.GetFade() * voice->aftertouch_multiplier;
+                if (frame_p1_is_valid)
+                    fade2[lane] = voice->volume_fade.GetFade() * voice->aftertouch_multiplier;
+            }
+
+            // Calculate pan positions
+            VoiceLanes pan_pos1 = controller.pan_pos;
+            auto pan_pos2 = pan_pos1;
+            if (has_pan_lfo) {
+                VoiceLanes const min = -1.0f;
+                VoiceLanes const max = 1.0f;
+                pan_pos1 = Clamp(pan_pos1 + (lfo_lanes[frame] * lfo_amp), min, max);
+                if (frame_p1_is_valid) pan_pos2 = Clamp(pan_pos2 + (lfo_lanes[frame_p1] * lfo_amp), min, max);
+            }
+
+            // Get pan gains, the same as EqualPanGains2
+            auto const half_pos1 = pan_pos1 * 0.5f;
+            auto const half_pos2 = pan_pos2 * 0.5f;
+            auto const pan_left1 = QuarterSineFade(0.5f - half_pos1);
+            auto const pan_right1 = QuarterSineFade(half_pos1 + 0.5f);
+            auto const pan_left2 = QuarterSineFade(0.5f - half_pos2);
+            auto const pan_right2 = QuarterSineFade(half_pos2 + 0.5f);
+
+            // Combine all gains
+            final_gain1 = env1 * vol_lfo1 * fade1;
+            auto final_gain2 = env2 * vol_lfo2 * fade2;
+
+            // Clamp volume LFO contribution
+            if (has_volume_lfo) {
+                final_gain1 = Clamp01(final_gain1);
+                final_gain2 = Clamp01(final_gain2);
+            }
+
+            // Stereo width, the same as DoStereoWidenConstantPower but with a width per lane.
+            VoiceLanes const width = controller.stereo_width;
+            auto const width_start = Select(width_prev != width_prev, width, width_prev);
+            auto const smoothed_width =
+                width_start + (context.one_pole_smoothing_cutoff_10ms * (width - width_start));
+            width_prev = Select(running, smoothed_width, width_prev);
+
+            constexpr f32 k_inv_sqrt_2 = 0.70710678f;
+            auto const half_width = smoothed_width * 0.5f;
+            auto const m_scale = QuadraticPowerFade(1.0f - half_width) * k_inv_sqrt_2;
+            auto const s_scale = QuadraticPowerFade(half_width) * k_inv_sqrt_2;
+
+            // Apply gains to the buffer
+            apply_gain(frame, m_scale, s_scale, final_gain1 * pan_left1, final_gain1 * pan_right1);
+            if (frame_p1_is_valid)
+                apply_gain(frame_p1, m_scale, s_scale, final_gain2 * pan_left2, final_gain2 * pan_right2);
+
+            // Check for early termination conditions
+            for (auto const [lane, voice] : Enumerate(voices)) {
+                if (!running[lane]) continue;
+                if ((env_on && env_state[lane] == (s32)adsr::State::Idle) || voice->volume_fade.IsSilent()) {
+                    for (auto const i : Range<usize>(frame + 2, num_frames))
+                        voice->buffer[i] = 0.0f;
+                    voice->current_gain = final_gain2[lane];
+                    num_frames_to_filter[lane] = frame_p1;
+                    block_results[lane] = VoiceBlockResult::End;
+                    running[lane] = 0;
+                }
+            }
+            if (!Any(running)) break;
+        }
+
+        for (auto const [lane, voice] : Enumerate(voices)) {
+            if (running[lane]) voice->current_gain = final_gain1[lane];
+            voice->vol_env.output = env_output[lane];
+            voice->vol_env.state = (adsr::State)env_state[lane];
+            voice->stereo_width_smoother.prev_output = width_prev[lane];
+            voice->gain_smoother.prev_output = f32x2 {gain_left_prev[lane], gain_right_prev[lane]};
+        }
+    }
+
+    // The same as ApplyFilter() for each voice. Each lane only filters its first num_frames_to_filter frames.
+    static void ApplyFilterLanes(Span<Voice* const> voices,
+                                 Span<VoiceLanes const> lfo_lanes,
+                                 AudioProcessingContext const& context,
+                                 Span<u32 const> num_frames_to_filter) {
+        ZoneScoped;
+        auto const& controller = *voices[0]->controller;
+        auto const filter_type = controller.filter_type;
+        auto const has_filter_lfo = HasFilterLfo(*voices[0]);
+        auto const allow_interpolation = voices[0]->pool.interpolate_filter_coeffs;
+
+        VoiceLanesS32 lane_num_frames {};
+        VoiceLanes env_output {};
+        VoiceLanesS32 env_state {};
+        VoiceLanes mix_prev {};
+        VoiceLanes cut_prev {};
+        VoiceLanes res_prev {};
+        sv_filter::Data<VoiceLanes> filter_left {};
+        sv_filter::Data<VoiceLanes> filter_right {};
+        sv_filter::CachedHelpersLanes<VoiceLanes> coeffs_from {};
+        sv_filter::CachedHelpersLanes<VoiceLanes> coeffs_to {};
+        u32 num_frames = 0;
+        for (auto const lane : Range(k_voice_lanes)) {
+            // Unused lanes get a copy of a real filter so that they don't fill up with infinities.
+            auto const& voice = *voices[Min<usize>(lane, voices.size - 1)];
+            coeffs_from.SetLane(lane, voice.filter_coeffs);
+            coeffs_to.SetLane(lane, voice.filter_coeffs);
+            if (lane >= voices.size) continue;
+            lane_num_frames[lane] = (s32)num_frames_to_filter[lane];
+            num_frames = Max(num_frames, num_frames_to_filter[lane]);
+            env_output[lane] = voice.fil_env.output;
+            env_state[lane] = (s32)voice.fil_env.state;
+            mix_prev[lane] = voice.filter_mix_smoother.prev_output;
+            cut_prev[lane] = voice.filter_linear_cutoff_smoother.prev_output;
+            res_prev[lane] = voice.filter_resonance_smoother.prev_output;
+            filter_left.z1_a[lane] = voice.filters.z1_a.x;
+            filter_left.z2_a[lane] = voice.filters.z2_a.x;
+            filter_right.z1_a[lane] = voice.filters.z1_a.y;
+            filter_right.z2_a[lane] = voice.filters.z2_a.y;
+        }
+
+        // A smoother without a previous value jumps straight to its input, as OnePoleLowPassFilter does.
+        auto const smooth = [](VoiceLanes prev, VoiceLanes input, f32 cutoff, VoiceLanes* change) {
+            auto const invalid = prev != prev;
+            auto const start = Select(invalid, input, prev);
+            auto const output = start + (cutoff * (input - start));
+            if (change) *change = Select(invalid, VoiceLanes(__FLT_MAX__), Abs(output - start));
+            return output;
+        };
+
+        // Modulation, the same as FillFilterModulation() but across the lanes.
+        Array<FilterModulation, k_voice_lanes> mods;
+        for (auto const frame : Range(num_frames)) {
+            auto const running = VoiceLanesS32((s32)frame) < lane_num_frames;
+
+            auto env_output_next = env_output;
+            auto env_state_next = env_state;
+            auto const env = adsr::ProcessLanes(controller.fil_env, env_output_next, env_state_next);
+            env_output = Select(running, env_output_next, env_output);
+            env_state = Select(running, env_state_next, env_state);
+
+            auto const filter_mix = smooth(mix_prev,
+                                           VoiceLanes((f32)controller.filter_on),
+                                           context.one_pole_smoothing_cutoff_10ms,
+                                           nullptr);
+            mix_prev = Select(running, filter_mix, mix_prev);
+
+            auto const mix_audible = filter_mix > 0.00001f;
+            auto const on = running & mix_audible;
+            if (auto const off = running & ~mix_audible; Any(off)) {
+                res_prev = Select(off, VoiceLanes(k_nan<f32>), res_prev);
+                cut_prev = Select(off, VoiceLanes(k_nan<f32>), cut_prev);
+            }
+
+            auto cut = controller.sv_filter_cutoff_linear + ((env - 0.5f) * controller.fil_env_amount);
+            if (has_filter_lfo) cut += (lfo_lanes[frame] * controller.lfo.amount) / 2.0f;
+
+            VoiceLanes res_change;
+            auto const res = smooth(res_prev,
+                                    VoiceLanes(controller.sv_filter_resonance),
+                                    context.one_pole_smoothing_cutoff_1ms,
+                                    &res_change);
+            res_prev = Select(on, res, res_prev);
+            VoiceLanes cut_change;
+            cut = smooth(cut_prev, cut, context.one_pole_smoothing_cutoff_1ms, &cut_change);
+            cut_prev = Select(on, cut, cut_prev);
+
+            auto changed = on;
+            if (!has_filter_lfo) changed &= (cut_change > 0.00001f) | (res_change > 0.00001f);
+
+            for (auto const lane : Range(voices.size)) {
+                if (!running[lane]) continue;
+                auto& mod = mods[lane];
+                mod.mix[frame] = filter_mix[lane];
+                mod.on[frame] = on[lane];
+                mod.cutoff[frame] = on[lane] ? cut[lane] : 0;
+                mod.resonance[frame] = on[lane] ? res[lane] : 0;
+                mod.changed[frame] = changed[lane];
+            }
+        }
+
+        // Filtering, the same as ApplyFilter() but across the lanes. Lanes with exact coefficients have the
+        // same coefficients at both ends of the interpolation.
+        Array<bool, k_voice_lanes> prev_interval_interpolated {};
+        for (u32 start = 0; start < num_frames; start += k_filter_control_interval) {
+            VoiceLanes inv_length {};
+            Array<bool, k_voice_lanes> interpolate {};
+            for (auto const [lane, voice] : Enumerate(voices)) {
+                if (start >= num_frames_to_filter[lane]) continue;
+                auto const& mod = mods[lane];
+                auto const interval =
+                    FilterControlIntervalAt(mod, start, num_frames_to_filter[lane], allow_interpolation);
+                interpolate[lane] = interval.interpolate;
+                if (interval.interpolate) {
+                    sv_filter::CachedHelpers from;
+                    PrepareInterpolatedFilterCoeffs(*voice,
+                                                    mod,
+                                                    start,
+                                                    interval,
+                                                    prev_interval_interpolated[lane],
+                                                    context,
+                                                    from);
+                    coeffs_from.SetLane(lane, from);
+                    inv_length[lane] = interval.inv_length;
+                } else {
+                    coeffs_from.SetLane(lane, voice->filter_coeffs);
+                }
+                coeffs_to.SetLane(lane, voice->filter_coeffs);
+                prev_interval_interpolated[lane] = interval.interpolate;
+            }
+
+            for (auto const frame : Range(start, Min(start + k_filter_control_interval, num_frames))) {
+                VoiceLanesS32 on {};
+                VoiceLanesS32 off {};
+                VoiceLanes filter_mix {};
+                for (auto const [lane, voice] : Enumerate(voices)) {
+                    if (frame >= num_frames_to_filter[lane]) continue;
+                    auto const& mod = mods[lane];
+                    if (!mod.on[frame]) {
+                        off[lane] = -1;
+                        continue;
+                    }
+                    on[lane] = -1;
+                    filter_mix[lane] = mod.mix[frame];
+                    if (!interpolate[lane] && mod.changed[frame]) {
+                        UpdateFilterCoeffs(*voice, mod, frame, context);
+                        coeffs_from.SetLane(lane, voice->filter_coeffs);
+                        coeffs_to.SetLane(lane, voice->filter_coeffs);
+                    }
+                }
+
+                if (Any(off)) {
+                    filter_left.z1_a = Select(off, VoiceLanes(0.0f), filter_left.z1_a);
+                    filter_left.z2_a = Select(off, VoiceLanes(0.0f), filter_left.z2_a);
+                    filter_right.z1_a = Select(off, VoiceLanes(0.0f), filter_right.z1_a);
+                    filter_right.z2_a = Select(off, VoiceLanes(0.0f), filter_right.z2_a);
+                }
+                if (!Any(on)) continue;
+
+                auto const t = VoiceLanes((f32)(frame - start)) * inv_length;
+                auto const coeffs = sv_filter::LerpCoeffs(coeffs_from, coeffs_to, t);
+
+                VoiceLanes left {};
+                VoiceLanes right {};
+                LoadLanes(voices, frame, left, right);
+
+                auto next_left = filter_left;
+                auto next_right = filter_right;
+                VoiceLanes wet_left;
+                VoiceLanes wet_right;
+                sv_filter::Process(left, wet_left, next_left, filter_type, coeffs);
+                sv_filter::Process(right, wet_right, next_right, filter_type, coeffs);
+                filter_left.z1_a = Select(on, next_left.z1_a, filter_left.z1_a);
+                filter_left.z2_a = Select(on, next_left.z2_a, filter_left.z2_a);
+                filter_right.z1_a = Select(on, next_right.z1_a, filter_right.z1_a);
+                filter_right.z2_a = Select(on, next_right.z2_a, filter_right.z2_a);
+
+                auto const partial_mix = filter_mix < 0.999f;
+                StoreLanes(voices,
+                           frame,
+                           on,
+                           Select(partial_mix, left + (filter_mix * (wet_left - left)), wet_left),
+                           Select(partial_mix, right + (filter_mix * (wet_right - right)), wet_right));
+            }
+        }
+
+        for (auto const [lane, voice] : Enumerate(voices)) {
+            voice->fil_env.output = env_output[lane];
+            voice->fil_env.state = (adsr::State)env_state[lane];
+            voice->filter_mix_smoother.prev_output = mix_prev[lane];
+            voice->filter_linear_cutoff_smoother.prev_output = cut_prev[lane];
+            voice->filter_resonance_smoother.prev_output = res_prev[lane];
+            voice->filters.z1_a = f32x2 {filter_left.z1_a[lane], filter_right.z1_a[lane]};
+            voice->filters.z2_a = f32x2 {filter_left.z2_a[lane], filter_right.z2_a[lane]};
+        }
+    }
+
+    // The same as FillLfoBuffer() for each voice. lfo_lanes gets the same values as lfo_amounts, one lane per
+    // voice.
+    static void FillLfoLanes(Span<Voice* const> voices,
+                             Span<VoiceLanes> lfo_lanes,
+                             Array<Array<f32, k_block_size_max>, k_voice_lanes>& lfo_amounts) {
+        ZoneScoped;
+        auto const num_frames = (u32)lfo_lanes.size;
+
+        bool is_random = false;
+        for (auto const voice : voices)
+            if (voice->lfo.waveform == LFO::Waveform::RandomSteps ||
+                voice->lfo.waveform == LFO::Waveform::RandomGlide)
+                is_random = true;
+
+        if (is_random) {
+            // Random waveforms step a random generator per voice, so we leave them to LFO::Tick().
+            for (auto const [lane, voice] : Enumerate(voices))
+                FillLfoBuffer(*voice, {lfo_amounts[lane].data, num_frames});
+            for (auto const frame : Range(num_frames)) {
+                lfo_lanes[frame] = 0;
+                for (auto const lane : Range(voices.size))
+                    lfo_lanes[frame][lane] = lfo_amounts[lane][frame];
+            }
+            return;
+        }
+
+        // The same table lookup as LFO::Tick(), with a phase per lane.
+        VoiceLanesU32 phase {};
+        VoiceLanesU32 phase_increment {};
+        for (auto const [lane, voice] : Enumerate(voices)) {
+            phase[lane] = voice->lfo.phase;
+            phase_increment[lane] = voice->lfo.phase_increment_per_tick;
+        }
+
+        for (auto const frame : Range(num_frames)) {
+            auto const index = phase >> 24; // top 8 bits is the table index
+            auto const frac = ConvertVector(phase & 0x00FFFFFF, VoiceLanes) * (1.0f / (f32)(1 << 24));
+            phase += phase_increment;
+
+            VoiceLanes a {};
+            VoiceLanes b {};
+            for (auto const [lane, voice] : Enumerate(voices)) {
+                a[lane] = voice->lfo.table[index[lane]];
+                b[lane] = voice->lfo.table[index[lane] + 1];
+            }
+
+            auto const output = LinearInterpolate(frac, a, b);
+            lfo_lanes[frame] = -((output + 1.0f) - 1.0f);
+            for (auto const lane : Range(voices.size))
+                lfo_amounts[lane][frame] = lfo_lanes[frame][lane];
+        }
+
+        for (auto const [lane, voice] : Enumerate(voices))
+            voice->lfo.phase = phase[lane];
+    }
 };
 
+// Groups the active voices into batches that can be processed together. Returns the number of batches.
+static u16 BuildVoiceBatches(VoicePool& pool, Span<VoicePool::VoiceBatch> batches) {
+    u16 num_batches = 0;
+    DynamicArrayBounded<u16, k_num_layers * 2> unfilled_batches {};
+
+    for (auto const& v : pool.voices) {
+        if (!v.is_active) continue;
+
+        Optional<u16> batch_index {};
+        if (pool.allow_voice_batches && v.frames_before_starting == 0) {
+            for (auto const [i, index] : Enumerate(unfilled_batches)) {
+                auto const& first = pool.voices[batches[index].voice_indices[0]];
+                if (!VoiceProcessor::CanShareLanes(first, v)) continue;
+                batch_index = index;
+                if (batches[index].num_voices == k_voice_lanes - 1) dyn::Remove(unfilled_batches, i);
+                break;
+            }
+        }
+
+        if (!batch_index) {
+            batch_index = num_batches++;
+            batches[*batch_index].num_voices = 0;
+            if (pool.allow_voice_batches && v.frames_before_starting == 0 &&
+                unfilled_batches.size != unfilled_batches.Capacity())
+                dyn::Append(unfilled_batches, *batch_index);
+        }
+
+        auto& batch = batches[*batch_index];
+        batch.voice_indices[batch.num_voices++] = v.index;
+    }
+
+    return num_batches;
+}
+
+static void ProcessVoiceBatch(VoicePool& pool,
+                              VoicePool::VoiceBatch const& batch,
+                              AudioProcessingContext const& context,
+                              u32 num_frames) {
+    if (batch.num_voices == 1) {
+        VoiceProcessor::Process(pool.voices[batch.voice_indices[0]], context, num_frames);
+        return;
+    }
+
+    Array<Voice*, k_voice_lanes> voices;
+    for (auto const i : Range(batch.num_voices))
+        voices[i] = &pool.voices[batch.voice_indices[i]];
+    VoiceProcessor::ProcessLanes({voices.data, batch.num_voices}, context, num_frames);
+}
+
 void OnThreadPoolExec(VoicePool& pool, u32 task_index) {
     pool.multithread_processing.fence.Load(LoadMemoryOrder::Acquire);
 
@@ -1480,10 +2049,10 @@ void OnThreadPoolExec(VoicePool& pool, u32 task_index) {
         // we won't crash.
         return;
 
-    auto& voice = pool.voices[pool.multithread_processing.task_index_to_voice_index[task_index]];
-    VoiceProcessor::Process(voice,
-                            *pool.multithread_processing.audio_processing_context,
-                            pool.multithread_processing.num_frames);
+    ProcessVoiceBatch(pool,
+                      pool.multithread_processing.tasks[task_index],
+                      *pool.multithread_processing.audio_processing_context,
+                      pool.multithread_processing.num_frames);
 }
 
 void Reset(VoicePool& pool) {
@@ -1512,26 +2081,26 @@ void ProcessVoices(VoicePool& pool, u32 num_frames, AudioProcessingContext const
 
     if (pool.num_active_voices.Load(LoadMemoryOrder::Relaxed) == 0) return;
 
+    auto& mt = pool.multithread_processing;
+    mt.num_frames = num_frames;
+    mt.audio_processing_context = &context;
+    mt.num_tasks = BuildVoiceBatches(pool, mt.tasks);
+
     if (auto const thread_pool =
             (clap_host_thread_pool const*)context.host.get_extension(&context.host, CLAP_EXT_THREAD_POOL);
         thread_pool && thread_pool->request_exec) {
-        pool.multithread_processing.num_frames = num_frames;
-        pool.multithread_processing.audio_processing_context = &context;
-        pool.multithread_processing.num_tasks = 0;
-        for (auto const& v : pool.voices)
-            if (v.is_active)
-                pool.multithread_processing
-                    .task_index_to_voice_index[pool.multithread_processing.num_tasks++] = v.index;
-        pool.multithread_processing.fence.Store(0, StoreMemoryOrder::Release);
+        mt.fence.Store(0, StoreMemoryOrder::Release);
 
         // NOTE: Bitwig 5.2 misbehaves with this: it doesn't call the on_thread_exec function for as many
         // tasks as we requested. It's fine though because we handle this by checking processed_this_block.
-        thread_pool->request_exec(&context.host, pool.multithread_processing.num_tasks);
+        thread_pool->request_exec(&context.host, mt.num_tasks);
     }
 
-    // Process all voices that haven't already been processed (possibly by the thread pool).
-    for (auto& v : pool.voices)
-        if (v.is_active && !v.processed_this_block) VoiceProcessor::Process(v, context, num_frames);
+    // Process all batches that haven't already been processed (possibly by the thread pool). A batch's
+    // voices are all processed together, so checking its first voice is enough.
+    for (auto const& batch : Span<VoicePool::VoiceBatch const> {mt.tasks.data, mt.num_tasks})
+        if (!pool.voices[batch.voice_indices[0]].processed_this_block)
+            ProcessVoiceBatch(pool, batch, context, num_frames);
 
     for (auto& v : pool.voices) {
         if (v.produced_audio_this_block) {
@@ -1607,19 +2176,6 @@ TEST_CASE(TestEqualPanGains) {
 // ======================================================================================
 // Voice processing tests
 
-static clap_host_t const k_stub_host {
-    .clap_version = CLAP_VERSION,
-    .host_data = nullptr,
-    .name = "Test",
-    .vendor = "Test",
-    .url = "",
-    .version = "1",
-    .get_extension = [](clap_host_t const*, char const*) -> void const* { return nullptr; },
-    .request_restart = [](clap_host_t const*) {},
-    .request_process = [](clap_host_t const*) {},
-    .request_callback = [](clap_host_t const*) {},
-};
-
 struct VoiceTestFixture {
     VoiceTestFixture(tests::Tester&) {
         // VoicePool requires 64-byte alignment (due to AtomicSwapBuffer with cacheline avoidance).
@@ -1938,9 +2494,470 @@ TEST_CASE(TestVoiceProcessingNonTypicalBufferSizes) {
     return k_success;
 }
 
+static void StartTestWaveformVoice(VoicePool& pool,
+                                   VoiceProcessingController& controller,
+                                   AudioProcessingContext const& context,
+                                   u7 note,
+                                   u32 num_frames_before_starting = 0,
+                                   bool disable_vol_env = false) {
+    VoiceStartParams start_params {
+        .initial_pitch = 0,
+        .midi_key_trigger = {.note = note, .channel = 0},
+        .note_num = note,
+        .note_vel = 0.8f,
+        .lfo_start_state = {},
+        .num_frames_before_starting = num_frames_before_starting,
+        .params = VoiceStartParams::WaveformParams {.type = WaveformType::Sine, .amp = 0.5f},
+        .disable_vol_env = disable_vol_env,
+    };
+    StartVoice(pool, controller, start_params, context);
+}
+
+// Switches on everything that voices process in lanes: envelopes, filter, width, pan and an LFO.
+static void SetUpControllerForLanes(VoiceProcessingController& controller, AudioProcessingContext& context) {
+    using Smoother = OnePoleLowPassFilter<f32>;
+    context.one_pole_smoothing_cutoff_0_2ms = Smoother::MsToCutoff(0.2f, context.sample_rate);
+    context.one_pole_smoothing_cutoff_1ms = Smoother::MsToCutoff(1, context.sample_rate);
+    context.one_pole_smoothing_cutoff_10ms = Smoother::MsToCutoff(10, context.sample_rate);
+
+    controller.play_mode = param_values::PlayMode::Standard;
+    controller.pan_pos = 0.2f;
+    controller.stereo_width = 1.4f;
+
+    controller.vol_env_on = true;
+    controller.vol_env.SetSustainAmp(0.6f);
+    controller.vol_env.SetAttackSamples(300, 0.3f);
+    controller.vol_env.SetDecaySamples(2000, 0.0001f);
+    controller.vol_env.SetReleaseSamples(3000, 0.0001f);
+
+    controller.filter_on = true;
+    controller.filter_type = sv_filter::Type::Lowpass;
+    controller.sv_filter_cutoff_linear = 0.5f;
+    controller.sv_filter_resonance = 0.3f;
+    controller.fil_env_amount = 0.4f;
+    controller.fil_env.SetSustainAmp(0.2f);
+    controller.fil_env.SetAttackSamples(100, 0.3f);
+    controller.fil_env.SetDecaySamples(4000, 0.0001f);
+    controller.fil_env.SetReleaseSamples(1000, 0.0001f);
+
+    controller.lfo = {
+        .on = true,
+        .shape = param_values::LfoShape::Sine,
+        .dest = param_values::LfoDestination::Volume,
+        .amount = 0.7f,
+        .time_hz = 3,
+    };
+}
+
+TEST_CASE(TestVoiceProcessingLanes) {
+    // Two pools given the same notes: one processes voices in lanes, the other one voice at a time.
+    Array<VoicePool*, 2> pools;
+    Array<u64, 2> seeds {1, 1};
+    for (auto const i : Range(pools.size)) {
+        pools[i] = PageAllocator::Instance().New<VoicePool>();
+        pools[i]->master_random_seed = &seeds[i];
+        pools[i]->allow_voice_batches = i == 0;
+        pools[i]->PrepareToPlay();
+    }
+    DEFER {
+        for (auto p : pools)
+            PageAllocator::Instance().Delete(p);
+    };
+
+    AudioProcessingContext context {
+        .sample_rate = 44100,
+        .process_block_size_max = k_block_size_max,
+        .host = k_stub_host,
+    };
+    VoiceProcessingController controller {.layer_index = 0};
+    SetUpControllerForLanes(controller, context);
+
+    constexpr u32 k_block_sizes[] = {k_block_size_max, 31, 1, 16, 3};
+
+    auto const check_pools_match = [&](param_values::LfoShape shape,
+                                       param_values::LfoDestination dest,
+                                       sv_filter::Type filter_type,
+                                       bool toggle_filter = false) {
+        CAPTURE(ToInt(shape));
+        CAPTURE(ToInt(dest));
+        CAPTURE(ToInt(filter_type));
+        controller.lfo.shape = shape;
+        controller.lfo.dest = dest;
+        controller.filter_type = filter_type;
+
+        for (auto pool : pools) {
+            // Not a multiple of k_voice_lanes, a mix of envelope settings, and one voice that starts late so
+            // that it's processed on its own.
+            for (auto const i : Range(11u))
+                StartTestWaveformVoice(*pool, controller, context, (u7)(40 + (i * 3)), 0, i % 4 == 3);
+            StartTestWaveformVoice(*pool, controller, context, 70, 10);
+        }
+
+        f32 max_difference = 0;
+        for (auto const block : Range(80u)) {
+            if (block == 20) {
+                for (auto pool : pools)
+                    for (auto const i : Range(11u))
+                        NoteOff(*pool, controller, {.note = (u7)(40 + (i * 3)), .channel = 0});
+            }
+            if (toggle_filter && (block == 10 || block == 30)) controller.filter_on = !controller.filter_on;
+
+            auto const num_frames = k_block_sizes[block % ArraySize(k_block_sizes)];
+            for (auto pool : pools)
+                ProcessVoices(*pool, num_frames, context);
+
+            for (auto const v : Range(k_num_voices)) {
+                auto const& lanes_voice = pools[0]->voices[v];
+                auto const& single_voice = pools[1]->voices[v];
+                REQUIRE_EQ(lanes_voice.is_active, single_voice.is_active);
+                REQUIRE_EQ(lanes_voice.produced_audio_this_block, single_voice.produced_audio_this_block);
+                if (!lanes_voice.produced_audio_this_block) continue;
+                for (auto const frame : Range(num_frames)) {
+                    auto const difference = Abs(lanes_voice.buffer[frame] - single_voice.buffer[frame]);
+                    max_difference = Max(max_difference, Max(difference.x, difference.y));
+                }
+            }
+        }
+
+        CHECK_LT(max_difference, 0.0001f);
+        for (auto pool : pools)
+            pool->EndAllVoicesInstantly();
+    };
+
+    SUBCASE("table LFO") {
+        check_pools_match(param_values::LfoShape::Sine,
+                          param_values::LfoDestination::Volume,
+                          sv_filter::Type::Lowpass);
+        check_pools_match(param_values::LfoShape::Triangle,
+                          param_values::LfoDestination::Pan,
+                          sv_filter::Type::Bandpass);
+        check_pools_match(param_values::LfoShape::Sawtooth,
+                          param_values::LfoDestination::Filter,
+                          sv_filter::Type::Peak);
+    }
+
+    SUBCASE("random LFO") {
+        check_pools_match(param_values::LfoShape::RandomGlide,
+                          param_values::LfoDestination::Filter,
+                          sv_filter::Type::Highpass);
+    }
+
+    SUBCASE("filter switched off and on again") {
+        check_pools_match(param_values::LfoShape::Square,
+                          param_values::LfoDestination::Volume,
+                          sv_filter::Type::Notch,
+                          true);
+    }
+
+    return k_success;
+}
+
+// Renders a single filtered noise voice. Block sizes vary so that control intervals are cut short.
+static void RenderFilteredNoiseVoice(bool interpolate_filter_coeffs,
+                                     VoiceProcessingController& controller,
+                                     AudioProcessingContext const& context,
+                                     Span<f32> out) {
+    auto pool = PageAllocator::Instance().New<VoicePool>();
+    DEFER { PageAllocator::Instance().Delete(pool); };
+    u64 seed = 1;
+    pool->master_random_seed = &seed;
+    pool->interpolate_filter_coeffs = interpolate_filter_coeffs;
+    pool->PrepareToPlay();
+
+    VoiceStartParams start_params {
+        .initial_pitch = 0,
+        .midi_key_trigger = {.note = 60, .channel = 0},
+        .note_num = 60,
+        .note_vel = 0.8f,
+        .lfo_start_state = {},
+        .num_frames_before_starting = 0,
+        .params = VoiceStartParams::WaveformParams {.type = WaveformType::WhiteNoiseMono, .amp = 0.5f},
+        .disable_vol_env = false,
+    };
+    StartVoice(*pool, controller, start_params, context);
+
+    constexpr u32 k_block_sizes[] = {k_block_size_max, 13, k_block_size_max, 5};
+    usize pos = 0;
+    for (u32 block = 0; pos < out.size; ++block) {
+        auto const num_frames =
+            (u32)Min<usize>(k_block_sizes[block % ArraySize(k_block_sizes)], out.size - pos);
+        ProcessVoices(*pool, num_frames, context);
+        auto const& voice = pool->voices[0];
+        for (auto const frame : Range(num_frames))
+            out[pos + frame] = voice.produced_audio_this_block ? voice.buffer[frame].x : 0;
+        pos += num_frames;
+    }
+}
+
+// Hann-windowed magnitude of evenly spaced DFT bins.
+static void MagnitudeSpectrum(ArenaAllocator& arena, Span<f32 const> signal, Span<f64> magnitudes) {
+    HannWindowedDft dft {arena, (u32)signal.size};
+    dft.SetFrame(signal);
+    auto const bin_step = (u32)((signal.size / 2) / magnitudes.size);
+    for (auto const [i, magnitude] : Enumerate<u32>(magnitudes))
+        magnitude = Sqrt(dft.BinPower((i + 1) * bin_step));
+}
+
+TEST_CASE(TestFilterControlRate) {
+    AudioProcessingContext context {
+        .sample_rate = 44100,
+        .process_block_size_max = k_block_size_max,
+        .host = k_stub_host,
+    };
+    VoiceProcessingController controller {.layer_index = 0};
+    SetUpControllerForLanes(controller, context);
+    controller.filter_type = sv_filter::Type::Peak;
+    controller.sv_filter_resonance = 0.6f;
+    controller.lfo.dest = param_values::LfoDestination::Filter;
+
+    // Compares the spectrum of control-rate coefficients against exact coefficients every frame.
+    auto const check_spectra_match = [&]() {
+        constexpr usize k_num_frames = 4096;
+        auto interpolated = tester.scratch_arena.NewMultiple<f32>(k_num_frames);
+        auto exact = tester.scratch_arena.NewMultiple<f32>(k_num_frames);
+        RenderFilteredNoiseVoice(true, controller, context, interpolated);
+        RenderFilteredNoiseVoice(false, controller, context, exact);
+
+        auto interpolated_spectrum = tester.scratch_arena.NewMultiple<f64>(256);
+        auto exact_spectrum = tester.scratch_arena.NewMultiple<f64>(256);
+        MagnitudeSpectrum(tester.scratch_arena, interpolated, interpolated_spectrum);
+        MagnitudeSpectrum(tester.scratch_arena, exact, exact_spectrum);
+
+        f64 peak = 0;
+        for (auto const m : exact_spectrum)
+            peak = Max(peak, m);
+        REQUIRE(peak > 0);
+
+        f64 error_energy = 0;
+        f64 energy = 0;
+        f64 max_bin_difference_db = 0;
+        for (auto const i : Range(exact_spectrum.size)) {
+            auto const a = interpolated_spectrum[i];
+            auto const b = exact_spectrum[i];
+            error_energy += (a - b) * (a - b);
+            energy += b * b;
+            if (b < peak * 0.1) continue; // Only the bins within 20 dB of the peak.
+            max_bin_difference_db = Max(max_bin_difference_db, Fabs(20 * Log10(a / b)));
+        }
+        auto const spectral_error_db = 10 * Log10(Max(error_energy, 1e-30) / energy);
+        CAPTURE(max_bin_difference_db);
+        CAPTURE(spectral_error_db);
+        CHECK(max_bin_difference_db < 0.25);
+        CHECK(spectral_error_db < -40);
+    };
+
+    SUBCASE("slow modulation is interpolated") {
+        controller.lfo.time_hz = 3;
+        check_spectra_match();
+    }
+
+    SUBCASE("fast modulation falls back to exact coefficients") {
+        controller.lfo.time_hz = 800;
+        controller.lfo.amount = 1;
+        controller.fil_env_amount = 1;
+        controller.fil_env.SetAttackSamples(20, 0.3f);
+        controller.fil_env.SetDecaySamples(200, 0.0001f);
+        check_spectra_match();
+    }
+
+    return k_success;
+}
+
+TEST_CASE(TestVoiceStealing) {
+    auto pool = PageAllocator::Instance().New<VoicePool>();
+    DEFER { PageAllocator::Instance().Delete(pool); };
+    u64 seed = 1;
+    pool->master_random_seed = &seed;
+    pool->PrepareToPlay();
+
+    AudioProcessingContext context {
+        .sample_rate = 44100,
+        .process_block_size_max = k_block_size_max,
+        .host = k_stub_host,
+    };
+    VoiceProcessingController controller {.layer_index = 0};
+
+    auto const note_for_index = [](usize i) { return (u7)(20 + (i % 80)); };
+    auto const most_recently_started = [&]() -> Voice& {
+        for (auto& v : pool->voices)
+            if (v.time_started == pool->voice_start_counter - 1) return v;
+        PanicIfReached();
+        return pool->voices[0];
+    };
+
+    SUBCASE("inactive voices are used before any are stolen") {
+        for (auto const i : Range(k_num_voices)) {
+            StartTestWaveformVoice(*pool, controller, context, note_for_index(i));
+            CHECK_EQ(IndexOfVoice(most_recently_started()), i);
+        }
+        CHECK_EQ(pool->num_active_voices.Load(LoadMemoryOrder::Relaxed), k_num_voices);
+
+        EndVoiceInstantly(pool->voices[3]);
+        EndVoiceInstantly(pool->voices[200]);
+        StartTestWaveformVoice(*pool, controller, context, 60);
+        CHECK_EQ(IndexOfVoice(most_recently_started()), 3u);
+        StartTestWaveformVoice(*pool, controller, context, 60);
+        CHECK_EQ(IndexOfVoice(most_recently_started()), 200u);
+        CHECK_EQ(pool->num_active_voices.Load(LoadMemoryOrder::Relaxed), k_num_voices);
+    }
+
+    SUBCASE("stealing order") {
+        for (auto const i : Range(k_num_voices))
+            StartTestWaveformVoice(*pool, controller, context, note_for_index(i));
+
+        // Make every voice a sustaining voice at the same level, then set up some better candidates.
+        for (auto& v : pool->voices) {
+            v.volume_fade.ForceSetFullVolume();
+            v.vol_env.state = adsr::State::Sustain;
+            v.current_gain = 0.5f;
+        }
+        auto const release = [&](usize index, f32 gain) {
+            EndVoice(pool->voices[index]);
+            pool->voices[index].current_gain = gain;
+        };
+        release(100, 0.3f);
+        release(200, 0.01f);
+        pool->voices[150].current_gain = 0.05f;
+
+        // Voices 60, 140 and 220 are playing the note we're about to start. With more than
+        // k_max_num_active_voices active, each note-on also fades out the next candidate, which must agree
+        // with the stealing order.
+        auto const note = note_for_index(60);
+        for (auto const expected_index : Array {200uz, 100, 60, 140, 220, 150, 0, 1}) {
+            StartTestWaveformVoice(*pool, controller, context, note);
+            CHECK_EQ(IndexOfVoice(most_recently_started()), expected_index);
+            CHECK_EQ(pool->num_active_voices.Load(LoadMemoryOrder::Relaxed), k_num_voices);
+        }
+    }
+
+    pool->EndAllVoicesInstantly();
+    return k_success;
+}
+
 TEST_REGISTRATION(RegisterVoiceTests) {
     REGISTER_TEST(TestEqualPanGains);
     REGISTER_TEST(TestVoiceProcessingSampler);
     REGISTER_TEST(TestVoiceProcessingGranular);
     REGISTER_TEST(TestVoiceProcessingNonTypicalBufferSizes);
+    REGISTER_TEST(TestVoiceProcessingLanes);
+    REGISTER_TEST(TestFilterControlRate);
+    REGISTER_TEST(TestVoiceStealing);
+}
+
+// ======================================================================================
+// Benchmarks
+
+BENCHMARK_FN void BenchmarkProcessVoices(bool allow_voice_batches) {
+    // A full pool of sustaining voices on one layer with the envelopes, filter and an LFO all busy.
+    auto pool = PageAllocator::Instance().New<VoicePool>();
+    DEFER { PageAllocator::Instance().Delete(pool); };
+    u64 seed = 1;
+    pool->master_random_seed = &seed;
+    pool->allow_voice_batches = allow_voice_batches;
+    pool->PrepareToPlay();
+
+    AudioProcessingContext context {
+        .sample_rate = 44100,
+        .process_block_size_max = k_block_size_max,
+        .host = k_stub_host,
+    };
+    VoiceProcessingController controller {.layer_index = 0};
+    SetUpControllerForLanes(controller, context);
+
+    constexpr int k_num_iterations = 5;
+    constexpr u32 k_num_blocks = 200;
+
+    for (int iter = 0; iter < k_num_iterations; ++iter) {
+        for (auto const i : Range(k_max_num_active_voices))
+            StartTestWaveformVoice(*pool, controller, context, (u7)(24 + (i % 80)));
+
+        f32x2 sum = 0;
+        for (u32 block = 0; block < k_num_blocks; ++block) {
+            ProcessVoices(*pool, k_block_size_max, context);
+            for (auto const& v : pool->voices)
+                sum += v.buffer[0];
+        }
+        benchmarks::DoNotOptimise(sum);
+
+        pool->EndAllVoicesInstantly();
+    }
+}
+
+BENCHMARK_FN void BenchmarkFilterModulationPerVoice(bool interpolate_filter_coeffs) {
+    // One voice with its filter swept by an LFO: the cost of filter modulation for a single voice.
+    auto pool = PageAllocator::Instance().New<VoicePool>();
+    DEFER { PageAllocator::Instance().Delete(pool); };
+    u64 seed = 1;
+    pool->master_random_seed = &seed;
+    pool->interpolate_filter_coeffs = interpolate_filter_coeffs;
+    pool->PrepareToPlay();
+
+    AudioProcessingContext context {
+        .sample_rate = 44100,
+        .process_block_size_max = k_block_size_max,
+        .host = k_stub_host,
+    };
+    VoiceProcessingController controller {.layer_index = 0};
+    SetUpControllerForLanes(controller, context);
+    controller.lfo.dest = param_values::LfoDestination::Filter;
+
+    StartTestWaveformVoice(*pool, controller, context, 60);
+
+    f32x2 sum = 0;
+    for (u32 block = 0; block < 20000; ++block) {
+        ProcessVoices(*pool, k_block_size_max, context);
+        sum += pool->voices[0].buffer[0];
+    }
+    benchmarks::DoNotOptimise(sum);
+
+    pool->EndAllVoicesInstantly();
+}
+
+BENCHMARK_FN void BenchmarkChordStealing() {
+    // An arpeggiator at a high tempo playing 64-note chords: several chords per block, so once the pool is
+    // full nearly every note-on steals a voice.
+    auto pool = PageAllocator::Instance().New<VoicePool>();
+    DEFER { PageAllocator::Instance().Delete(pool); };
+    u64 seed = 1;
+    pool->master_random_seed = &seed;
+    pool->PrepareToPlay();
+
+    AudioProcessingContext context {
+        .sample_rate = 44100,
+        .process_block_size_max = k_block_size_max,
+        .host = k_stub_host,
+    };
+    VoiceProcessingController controller {.layer_index = 0};
+    SetUpControllerForLanes(controller, context);
+
+    constexpr u32 k_chord_size = 64;
+    constexpr u32 k_chords_per_block = 4;
+    constexpr u32 k_num_blocks = 1000;
+
+    u32 chord = 0;
+    f32x2 sum = 0;
+    for (u32 block = 0; block < k_num_blocks; ++block) {
+        for (u32 i = 0; i < k_chords_per_block; ++i, ++chord) {
+            auto const root = (u7)(24 + ((chord * 5) % 24));
+            for (auto const n : Range(k_chord_size))
+                StartTestWaveformVoice(*pool, controller, context, (u7)(root + n));
+            for (auto const n : Range(k_chord_size))
+                NoteOff(*pool, controller, {.note = (u7)(root + n), .channel = 0});
+        }
+        ProcessVoices(*pool, k_block_size_max, context);
+        sum += pool->voices[0].buffer[0];
+    }
+    benchmarks::DoNotOptimise(sum);
+
+    pool->EndAllVoicesInstantly();
+}
+
+BENCHMARK_REGISTRATION(RegisterVoiceBenchmarks) {
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkProcessVoices(false); }, "ProcessVoices/OneAtATime");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkProcessVoices(true); }, "ProcessVoices/Lanes");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkFilterModulationPerVoice(false); },
+                             "ProcessVoices/FilterLfo/ExactCoeffs");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkFilterModulationPerVoice(true); },
+                             "ProcessVoices/FilterLfo/ControlRateCoeffs");
+    REGISTER_BENCHMARK_NAMED(BenchmarkChordStealing, "ProcessVoices/ChordStealing");
 }
@@ -23,6 +23,14 @@ constexpr u32 k_max_num_active_voices = 256;
 constexpr u32 k_num_voices = 280;
 constexpr f32 k_erroneous_sample_value = 1000.0f;
 
+// Voices of the same layer are processed k_voice_lanes at a time, one voice per vector lane, for the parts of
+// the chain that don't depend on the sound source: LFO, envelopes, gain and filter.
+#if __AVX__
+constexpr u32 k_voice_lanes = 8;
+#else
+constexpr u32 k_voice_lanes = 4; // SSE2 and NEON.
+#endif
+
 struct VoiceProcessingController;
 
 struct VoiceSoundSource {
@@ -213,6 +221,7 @@ struct VoicePool {
     u64 voice_start_counter = 0;
     u16 voice_id_counter = 0;
     Atomic<u32> num_active_voices = 0;
+    Bitset<k_num_voices> active_voice_bits {}; // Mirrors Voice::is_active. Audio thread only.
     Array<Voice, k_num_voices> voices {MakeInitialisedArray<Voice, k_num_voices>(*this)};
 
     AtomicSwapBuffer<Array<VoiceWaveformMarkerForGui, k_num_voices>, true> voice_waveform_markers_for_gui {};
@@ -227,10 +236,21 @@ struct VoicePool {
 
     AtomicQueue<SampleLogItem, 32> sample_log_queue {};
 
+    // Off processes every voice on its own; used to check the batched path against the single-voice path.
+    bool allow_voice_batches = true;
+
+    // Off calculates filter coefficients on every frame rather than interpolating between control points.
+    bool interpolate_filter_coeffs = true;
+
+    struct VoiceBatch {
+        Array<u16, k_voice_lanes> voice_indices;
+        u8 num_voices;
+    };
+
     struct {
         AudioProcessingContext const* audio_processing_context = nullptr;
         u32 num_frames = 0;
-        Array<u16, k_num_voices> task_index_to_voice_index;
+        Array<VoiceBatch, k_num_voices> tasks;
         u16 num_tasks {};
         Atomic<u8> fence;
     } multithread_processing;
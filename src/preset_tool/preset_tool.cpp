@@ -10,6 +10,7 @@
 #include "utils/cli_arg_parse.hpp"
 #include "utils/reader.hpp"
 
+#include "common_infrastructure/autosave.hpp"
 #include "common_infrastructure/common_errors.hpp"
 #include "common_infrastructure/descriptors/effect_descriptors.hpp"
 #include "common_infrastructure/global.hpp"
@@ -24,7 +25,7 @@
 
 // IMPROVE: export a Lua LSP def file for the preset table.
 
-enum class Verb : u8 { Inspect, Run, ApplyJson, DocsShape, DocsParams, Count };
+enum class Verb : u8 { Inspect, Run, ApplyJson, ExportAutosaves, DocsShape, DocsParams, Count };
 
 enum class InspectArg : u8 { Format, Raw, Count };
 constexpr auto k_inspect_arg_defs = MakeCommandLineArgDefs<InspectArg>({
@@ -456,6 +457,7 @@ static ErrorCodeOr<int> Main(ArgsCstr args) {
     Span<String> inspect_positionals {};
     Span<String> run_positionals {};
     Span<String> apply_json_positionals {};
+    Span<String> export_autosaves_positionals {};
 
     auto const subcommands = Array {
         CommandLineSubcommand {
@@ -497,6 +499,19 @@ static ErrorCodeOr<int> Main(ArgsCstr args) {
                             .max_count = 1,
                             .out = &apply_json_positionals},
         },
+        CommandLineSubcommand {
+            .id = (u32)Verb::ExportAutosaves,
+            .name = "export-autosaves"_s,
+            .description = "Write every state in an autosave journal (a .floe-autosave-journal file in "
+                           "Floe's autosave folder) as a preset file, so that any of an instance's history "
+                           "can be loaded."_s,
+            .positionals = {.name = "journal-path"_s,
+                            .description = "Journal file, followed by the folder to write the presets into. "
+                                           "The folder is created if it doesn't exist."_s,
+                            .min_count = 2,
+                            .max_count = 2,
+                            .out = &export_autosaves_positionals},
+        },
         CommandLineSubcommand {
             .id = (u32)Verb::DocsShape,
             .name = "docs-shape"_s,
@@ -658,6 +673,27 @@ static ErrorCodeOr<int> Main(ArgsCstr args) {
             TRY(Rename(out_path, new_preset_path));
             return 0;
         }
+        case Verb::ExportAutosaves: {
+            ASSERT(export_autosaves_positionals.size == 2);
+            auto const journal_path = TRY_OR(AbsolutePath(arena, export_autosaves_positionals[0]), {
+                StdPrintF(StdStream::Err, "Error: failed to resolve journal path\n");
+                return error;
+            });
+            auto const output_folder = TRY_OR(AbsolutePath(arena, export_autosaves_positionals[1]), {
+                StdPrintF(StdStream::Err, "Error: failed to resolve output folder\n");
+                return error;
+            });
+            TRY(CreateDirectory(output_folder,
+                                {.create_intermediate_directories = true, .fail_if_exists = false}));
+
+            auto const preset_paths = TRY_OR(ExportAutosaveJournal(journal_path, output_folder, arena), {
+                StdPrintF(StdStream::Err, "Error: failed to export autosaves: {}\n", error);
+                return error;
+            });
+            for (auto const& p : preset_paths)
+                StdPrintF(StdStream::Out, "{}\n", p);
+            return 0;
+        }
         case Verb::Count: PanicIfReached();
     }
     return 0;
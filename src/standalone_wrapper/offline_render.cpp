@@ -0,0 +1,549 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "offline_render.hpp"
+
+#include <FLAC/stream_encoder.h>
+#include <clap/ext/params.h>
+#include <clap/ext/thread-check.h>
+#include <clap/ext/thread-pool.h>
+#include <clap/factory/plugin-factory.h>
+#include <clap/host.h>
+#include <clap/plugin.h>
+#include <clap/process.h>
+
+#include "os/filesystem.hpp"
+#include "os/misc.hpp"
+#include "os/threading.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/thread_extra/atomic_queue.hpp"
+#include "utils/thread_extra/thread_pool.hpp"
+
+#include "common_infrastructure/audio_utils.hpp"
+#include "common_infrastructure/common_errors.hpp"
+
+#include "plugin/plugin/plugin.hpp"
+#include "plugin/processing_utils/midi_file.hpp"
+
+constexpr f64 k_offline_sample_rate = 44100;
+constexpr u32 k_offline_block_size = 512;
+constexpr f64 k_offline_tail_seconds = 2; // Let releases and reverb tails ring out after the last event.
+constexpr u32 k_max_transport_events_per_block = 16;
+constexpr u32 k_num_writer_blocks = 16;
+constexpr u32 k_max_thread_pool_threads = 64;
+
+struct OfflineHost {
+    clap_host_params const host_params {
+        .rescan = [](clap_host_t const*, clap_param_rescan_flags) {},
+        .clear = [](clap_host_t const*, clap_id, clap_param_clear_flags) {},
+        .request_flush = [](clap_host_t const*) {},
+    };
+
+    clap_host_thread_check const host_thread_check {
+        .is_main_thread =
+            [](clap_host const* h) {
+                auto& offline_host = *(OfflineHost*)h->host_data;
+                return CurrentThreadId() == offline_host.main_thread_id;
+            },
+        .is_audio_thread =
+            [](clap_host const* h) {
+                auto& offline_host = *(OfflineHost*)h->host_data;
+                return CurrentThreadId() == offline_host.render_thread_id.Load(LoadMemoryOrder::Relaxed);
+            },
+    };
+
+    clap_host_thread_pool const host_thread_pool {
+        .request_exec =
+            [](clap_host const* h, u32 num_tasks) {
+                auto& offline_host = *(OfflineHost*)h->host_data;
+                return offline_host.ExecThreadPoolTasks(num_tasks);
+            },
+    };
+
+    // Audio thread. The tasks are shared between the pool's workers and the calling thread; we don't return
+    // until they've all run, as the extension requires.
+    bool ExecThreadPoolTasks(u32 num_tasks) {
+        if (!plugin_thread_pool) return false;
+        if (!num_tasks) return true;
+
+        Atomic<u32> next_task {0};
+        auto const run_tasks = [&]() {
+            for (auto task = next_task.FetchAdd(1, RmwMemoryOrder::Relaxed); task < num_tasks;
+                 task = next_task.FetchAdd(1, RmwMemoryOrder::Relaxed))
+                plugin_thread_pool->exec(plugin, task);
+        };
+
+        // The calling thread takes a share of the tasks too, so we only need help with the rest.
+        auto const num_jobs = Min(num_tasks - 1, num_thread_pool_threads);
+        AtomicCountdown jobs_remaining {num_jobs};
+        auto const job = [&]() {
+            run_tasks();
+            jobs_remaining.CountDown();
+        };
+        if (num_jobs) {
+            DynamicArrayBounded<ThreadPool::FunctionType, k_max_thread_pool_threads> jobs {};
+            for (auto const _ : Range(num_jobs))
+                dyn::Append(jobs, job);
+            thread_pool.AddJobs(jobs, JobPriority::High);
+        }
+
+        run_tasks();
+        jobs_remaining.WaitUntilZero();
+        return true;
+    }
+
+    clap_host_t const host {
+        .clap_version = CLAP_VERSION,
+        .host_data = this,
+        .name = k_floe_standalone_host_name,
+        .vendor = FLOE_VENDOR,
+        .url = FLOE_HOMEPAGE_URL,
+        .version = "1",
+
+        .get_extension = [](clap_host_t const* ch, char const* extension_id) -> void const* {
+            auto& offline_host = *(OfflineHost*)ch->host_data;
+
+            if (NullTermStringsEqual(extension_id, CLAP_EXT_PARAMS))
+                return &offline_host.host_params;
+            else if (NullTermStringsEqual(extension_id, CLAP_EXT_THREAD_CHECK))
+                return &offline_host.host_thread_check;
+            else if (NullTermStringsEqual(extension_id, CLAP_EXT_THREAD_POOL))
+                return offline_host.num_thread_pool_threads ? &offline_host.host_thread_pool : nullptr;
+            else if (NullTermStringsEqual(extension_id, k_floe_clap_extension_id))
+                return &offline_host.floe_host_ext;
+
+            return nullptr;
+        },
+        .request_restart = [](clap_host_t const*) {},
+        .request_process = [](clap_host_t const*) {}, // We're always processing.
+        .request_callback =
+            [](clap_host_t const* h) {
+                auto& offline_host = *(OfflineHost*)h->host_data;
+                offline_host.callback_requested.Store(true, StoreMemoryOrder::Relaxed);
+            },
+    };
+
+    u64 main_thread_id {CurrentThreadId()};
+    Atomic<u64> render_thread_id {};
+    Atomic<bool> callback_requested {false};
+    FloeClapExtensionHost floe_host_ext {};
+    u32 num_thread_pool_threads {};
+    ThreadPool thread_pool {};
+    clap_plugin const* plugin {};
+    clap_plugin_thread_pool const* plugin_thread_pool {};
+};
+
+// Blocks of rendered audio are handed from the render thread to the writer thread through a fixed set of
+// buffers, so that neither thread allocates or waits on the other unless the writer falls behind.
+struct OfflineWriter {
+    struct Block {
+        u32 num_frames;
+        f32 interleaved[k_offline_block_size * 2];
+    };
+
+    Array<Block, k_num_writer_blocks> blocks {};
+    AtomicQueue<u32, k_num_writer_blocks> filled_blocks {}; // Render thread to writer thread.
+    AtomicQueue<u32, k_num_writer_blocks> free_blocks {}; // Writer thread to render thread.
+    WorkSignaller blocks_filled {};
+    WorkSignaller blocks_freed {};
+    Atomic<bool> render_finished {false};
+
+    OfflineRenderFormat format {};
+    FLAC__StreamEncoder* flac_encoder {};
+    Optional<File> wav_file {};
+    u64 frames_written {};
+    Optional<ErrorCode> error {};
+};
+
+constexpr u32 k_wav_header_size = 44;
+
+static ErrorCodeOr<void> WriteWavHeader(File& file, u64 num_frames) {
+    static_assert(k_endianness == Endianness::Little, "Wave file format is little-endian, we don't convert");
+    constexpr u16 k_num_channels = 2;
+    constexpr u32 k_sample_rate = (u32)k_offline_sample_rate;
+    auto const data_size = (u32)(num_frames * k_num_channels * sizeof(s16));
+
+    TRY(file.Seek(0, File::SeekOrigin::Start));
+    TRY(file.Write("RIFF"));
+    TRY(file.WriteBinaryNumber<u32>(k_wav_header_size - 8 + data_size));
+    TRY(file.Write("WAVEfmt "));
+    TRY(file.WriteBinaryNumber<u32>(16)); // fmt chunk size
+    TRY(file.WriteBinaryNumber<u16>(1)); // PCM mode
+    TRY(file.WriteBinaryNumber<u16>(k_num_channels));
+    TRY(file.WriteBinaryNumber<u32>(k_sample_rate));
+    TRY(file.WriteBinaryNumber<u32>(k_sample_rate * k_num_channels * sizeof(s16))); // bytes per second
+    TRY(file.WriteBinaryNumber<u16>((u16)(k_num_channels * sizeof(s16)))); // bytes per frame
+    TRY(file.WriteBinaryNumber<u16>(16)); // bits per sample
+    TRY(file.Write("data"));
+    TRY(file.WriteBinaryNumber<u32>(data_size));
+    return k_success;
+}
+
+static ErrorCodeOr<void> OpenWriterOutput(OfflineWriter& writer, String path, ArenaAllocator& arena) {
+    switch (writer.format) {
+        case OfflineRenderFormat::Flac: {
+            auto* enc = FLAC__stream_encoder_new();
+            if (!enc) return ErrorCode {CommonError::PluginHostError};
+            FLAC__stream_encoder_set_channels(enc, 2);
+            FLAC__stream_encoder_set_bits_per_sample(enc, 16);
+            FLAC__stream_encoder_set_sample_rate(enc, (u32)k_offline_sample_rate);
+            FLAC__stream_encoder_set_compression_level(enc, 5);
+            auto const status =
+                FLAC__stream_encoder_init_file(enc, NullTerminated(path, arena), nullptr, nullptr);
+            if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+                LogError(ModuleName::Standalone, "FLAC encoder init failed ({})", (int)status);
+                FLAC__stream_encoder_delete(enc);
+                return ErrorCode {CommonError::PluginHostError};
+            }
+            writer.flac_encoder = enc;
+            break;
+        }
+        case OfflineRenderFormat::Wav: {
+            writer.wav_file = TRY(OpenFile(path, FileMode::Write()));
+            // Placeholder sizes, rewritten once we know how much audio there is.
+            TRY(WriteWavHeader(*writer.wav_file, 0));
+            break;
+        }
+    }
+    return k_success;
+}
+
+static ErrorCodeOr<void> CloseWriterOutput(OfflineWriter& writer) {
+    if (writer.flac_encoder) {
+        auto const finished = FLAC__stream_encoder_finish(writer.flac_encoder);
+        FLAC__stream_encoder_delete(writer.flac_encoder);
+        writer.flac_encoder = nullptr;
+        if (!finished) return ErrorCode {CommonError::PluginHostError};
+    }
+    if (writer.wav_file) {
+        TRY(WriteWavHeader(*writer.wav_file, writer.frames_written));
+        writer.wav_file.Clear();
+    }
+    return k_success;
+}
+
+static ErrorCodeOr<void> EncodeBlock(OfflineWriter& writer, OfflineWriter::Block const& block) {
+    auto const num_samples = block.num_frames * 2;
+    switch (writer.format) {
+        case OfflineRenderFormat::Flac: {
+            FLAC__int32 buffer[k_offline_block_size * 2];
+            for (auto const i : Range(num_samples))
+                buffer[i] = (FLAC__int32)(Clamp(block.interleaved[i], -1.0f, 1.0f) * 32767.0f);
+            if (!FLAC__stream_encoder_process_interleaved(writer.flac_encoder, buffer, block.num_frames))
+                return ErrorCode {CommonError::PluginHostError};
+            break;
+        }
+        case OfflineRenderFormat::Wav: {
+            s16 buffer[k_offline_block_size * 2];
+            for (auto const i : Range(num_samples))
+                buffer[i] = (s16)(Clamp(block.interleaved[i], -1.0f, 1.0f) * 32767.0f);
+            TRY(writer.wav_file->Write(Span<u8 const> {(u8 const*)buffer, num_samples * sizeof(s16)}));
+            break;
+        }
+    }
+    writer.frames_written += block.num_frames;
+    return k_success;
+}
+
+static void WriterThreadLoop(OfflineWriter& writer) {
+    while (true) {
+        // Read this before draining: the render thread sets it after queuing its last block.
+        auto const render_finished = writer.render_finished.Load(LoadMemoryOrder::Acquire);
+
+        u32 index;
+        while (writer.filled_blocks.Pop(index)) {
+            // After an error we keep taking blocks so that the render thread never stalls.
+            if (!writer.error) {
+                auto const outcome = EncodeBlock(writer, writer.blocks[index]);
+                if (outcome.HasError()) writer.error = outcome.Error();
+            }
+            writer.free_blocks.Push(index);
+            writer.blocks_freed.Signal();
+        }
+
+        if (render_finished) break;
+        writer.blocks_filled.WaitUntilSignalledOrSpurious();
+    }
+}
+
+// Sets transport to the file's position at the given time. Times must not go backwards between calls:
+// tempo_index is the tempo change in effect and only moves forward.
+static void SetTransportForTime(clap_event_transport& transport,
+                                Span<MidiFileTempoChange const> tempo_changes,
+                                usize& tempo_index,
+                                f64 seconds) {
+    while (tempo_index + 1 != tempo_changes.size && tempo_changes[tempo_index + 1].time_seconds <= seconds)
+        ++tempo_index;
+    auto const& tempo = tempo_changes[tempo_index];
+    auto const beats = tempo.beats + ((seconds - tempo.time_seconds) * tempo.beats_per_minute / 60);
+
+    transport.flags = CLAP_TRANSPORT_HAS_TEMPO | CLAP_TRANSPORT_HAS_BEATS_TIMELINE |
+                      CLAP_TRANSPORT_HAS_SECONDS_TIMELINE | CLAP_TRANSPORT_IS_PLAYING;
+    transport.tempo = tempo.beats_per_minute;
+    transport.song_pos_beats = (clap_beattime)Round(beats * (f64)CLAP_BEATTIME_FACTOR);
+    transport.song_pos_seconds = (clap_sectime)Round(seconds * (f64)CLAP_SECTIME_FACTOR);
+}
+
+static void RenderLoop(OfflineHost& offline_host,
+                       MidiFile const& midi_file,
+                       u64 num_frames,
+                       OfflineWriter* writer,
+                       OfflineRenderStats& stats) {
+    auto const plugin = offline_host.plugin;
+    auto const midi_events = midi_file.events;
+    auto const tempo_changes = midi_file.tempo_changes;
+    ASSERT(tempo_changes.size);
+
+    f32 channel_buffers[2][k_offline_block_size];
+    f32* channels[2] = {channel_buffers[0], channel_buffers[1]};
+    clap_audio_buffer_t buffer {};
+    buffer.channel_count = 2;
+    buffer.data32 = channels;
+
+    // The transport is playing from the start so that the plugin sees a transport start, as it would in a
+    // DAW. The file's tempo map is followed: the block's transport and a transport event at the start of each
+    // block give its tempo, and each tempo change within a block gets an event at its frame.
+    clap_event_transport transport {};
+    transport.header = {
+        .size = sizeof(transport),
+        .time = 0,
+        .space_id = CLAP_CORE_EVENT_SPACE_ID,
+        .type = CLAP_EVENT_TRANSPORT,
+        .flags = 0,
+    };
+    usize tempo_index = 0;
+
+    struct EventCtx {
+        Array<clap_event_midi, k_offline_block_size> midi_events;
+        Array<clap_event_transport, k_max_transport_events_per_block> transport_events;
+        Array<clap_event_header_t const*, k_offline_block_size + k_max_transport_events_per_block> events;
+        u32 num_midi_events;
+        u32 num_transport_events;
+        u32 count;
+    };
+    EventCtx event_ctx {};
+    clap_input_events const in_events {
+        .ctx = (void*)&event_ctx,
+        .size = [](clap_input_events const* list) -> u32 { return ((EventCtx const*)list->ctx)->count; },
+        .get = [](clap_input_events const* list, uint32_t index) -> clap_event_header_t const* {
+            return ((EventCtx const*)list->ctx)->events[index];
+        },
+    };
+    clap_output_events const out_events {
+        .ctx = nullptr,
+        .try_push = [](clap_output_events const*, clap_event_header const*) -> bool { return false; },
+    };
+
+    clap_process_t process {};
+    process.transport = &transport;
+    process.audio_outputs = &buffer;
+    process.audio_outputs_count = 1;
+    process.in_events = &in_events;
+    process.out_events = &out_events;
+
+    auto const frame_for_time = [](f64 seconds) { return (u64)(seconds * k_offline_sample_rate + 0.5); };
+
+    usize next_event = 0;
+    auto const start = TimePoint::Now();
+
+    for (u64 block_start = 0; block_start < num_frames; block_start += k_offline_block_size) {
+        auto const block_frames = (u32)Min<u64>(k_offline_block_size, num_frames - block_start);
+        auto const block_end = block_start + block_frames;
+
+        event_ctx.num_midi_events = 0;
+        event_ctx.num_transport_events = 0;
+        event_ctx.count = 0;
+
+        auto const add_transport_event = [&](u64 frame, f64 seconds) {
+            auto& e = event_ctx.transport_events[event_ctx.num_transport_events++];
+            e = transport;
+            SetTransportForTime(e, tempo_changes, tempo_index, seconds);
+            e.header.time = (u32)(Max(frame, block_start) - block_start);
+            event_ctx.events[event_ctx.count++] = &e.header;
+        };
+
+        add_transport_event(block_start, (f64)block_start / k_offline_sample_rate);
+        transport = event_ctx.transport_events[0];
+        transport.header.time = 0;
+
+        // Events are sample-accurate. If a block has more events than we have room for, the rest spill into
+        // the start of the next block. A tempo change goes before MIDI events at the same frame.
+        while (true) {
+            Optional<u64> tempo_frame {};
+            if (tempo_index + 1 != tempo_changes.size &&
+                event_ctx.num_transport_events != event_ctx.transport_events.size) {
+                auto const frame = frame_for_time(tempo_changes[tempo_index + 1].time_seconds);
+                if (frame < block_end) tempo_frame = frame;
+            }
+            Optional<u64> midi_frame {};
+            if (next_event != midi_events.size && event_ctx.num_midi_events != event_ctx.midi_events.size) {
+                auto const frame = frame_for_time(midi_events[next_event].time_seconds);
+                if (frame < block_end) midi_frame = frame;
+            }
+
+            if (tempo_frame && (!midi_frame || *tempo_frame <= *midi_frame)) {
+                add_transport_event(*tempo_frame, tempo_changes[tempo_index + 1].time_seconds);
+            } else if (midi_frame) {
+                auto const& e = midi_events[next_event++];
+                auto& midi = event_ctx.midi_events[event_ctx.num_midi_events++];
+                midi = {
+                    .header =
+                        {
+                            .size = sizeof(clap_event_midi),
+                            .time = (u32)(Max(*midi_frame, block_start) - block_start),
+                            .space_id = CLAP_CORE_EVENT_SPACE_ID,
+                            .type = CLAP_EVENT_MIDI,
+                            .flags = 0,
+                        },
+                    .port_index = 0,
+                    .data = {e.message.status, e.message.data1, e.message.data2},
+                };
+                event_ctx.events[event_ctx.count++] = &midi.header;
+            } else {
+                break;
+            }
+        }
+
+        process.frames_count = block_frames;
+        process.steady_time = (s64)block_start;
+        plugin->process(plugin, &process);
+
+        if (writer) {
+            u32 index;
+            while (!writer->free_blocks.Pop(index))
+                writer->blocks_freed.WaitUntilSignalledOrSpurious();
+            auto& block = writer->blocks[index];
+            block.num_frames = block_frames;
+            CopySeparateChannelsToInterleaved(block.interleaved, channels[0], channels[1], block_frames);
+            writer->filled_blocks.Push(index);
+            writer->blocks_filled.Signal();
+        }
+    }
+
+    stats.render_seconds = TimePoint::Now() - start;
+    stats.num_frames = num_frames;
+    stats.audio_seconds = (f64)num_frames / k_offline_sample_rate;
+
+    if (writer) {
+        writer->render_finished.Store(true, StoreMemoryOrder::Release);
+        writer->blocks_filled.Signal();
+    }
+}
+
+// Main thread. Gives the plugin a chance to finish asynchronous work such as loading sample libraries.
+static bool WaitForPendingStateChange(OfflineHost& offline_host) {
+    auto const plugin = offline_host.plugin;
+    auto const floe_ext = (FloeClapExtension const*)plugin->get_extension(plugin, k_floe_clap_extension_id);
+    if (!floe_ext || !floe_ext->state_change_is_pending) return true;
+
+    constexpr f64 k_timeout_seconds = 120;
+    auto const start = TimePoint::Now();
+    while (true) {
+        if (offline_host.callback_requested.Exchange(false, RmwMemoryOrder::Relaxed))
+            plugin->on_main_thread(plugin);
+        if (!floe_ext->state_change_is_pending(plugin)) return true;
+        if ((TimePoint::Now() - start) > k_timeout_seconds) return false;
+        SleepThisThread(10);
+    }
+}
+
+ErrorCodeOr<OfflineRenderStats> RenderMidiFileOffline(clap_plugin_entry const& entry,
+                                                      OfflineRenderOptions const& options,
+                                                      ArenaAllocator& arena) {
+    auto const midi_file_data = TRY(ReadEntireFile(options.midi_file_path, arena));
+    auto const midi_file = TRY(ParseMidiFile(midi_file_data.ToByteSpan(), arena));
+    LogInfo(ModuleName::Standalone,
+            "MIDI file: {} events, {.1}s",
+            midi_file.events.size,
+            midi_file.length_seconds);
+
+    auto const factory = (clap_plugin_factory const*)entry.get_factory(CLAP_PLUGIN_FACTORY_ID);
+    if (!factory) return ErrorCode {CommonError::PluginHostError};
+
+    OfflineHost offline_host {};
+    offline_host.num_thread_pool_threads = Min(options.num_thread_pool_threads, k_max_thread_pool_threads);
+    if (offline_host.num_thread_pool_threads)
+        offline_host.thread_pool.Init("render", offline_host.num_thread_pool_threads);
+
+    offline_host.plugin = factory->create_plugin(factory, &offline_host.host, g_plugin_info.id);
+    if (!offline_host.plugin) return ErrorCode {CommonError::PluginHostError};
+    auto const plugin = offline_host.plugin;
+    DEFER { plugin->destroy(plugin); };
+    if (!plugin->init(plugin)) return ErrorCode {CommonError::PluginHostError};
+    offline_host.plugin_thread_pool =
+        (clap_plugin_thread_pool const*)plugin->get_extension(plugin, CLAP_EXT_THREAD_POOL);
+
+    if (options.preset_path) {
+        auto const floe_ext =
+            (FloeClapExtension const*)plugin->get_extension(plugin, k_floe_clap_extension_id);
+        if (!floe_ext || !floe_ext->load_preset_file ||
+            !floe_ext->load_preset_file(plugin, *options.preset_path))
+            return ErrorCode {CommonError::PluginHostError};
+    }
+    if (!WaitForPendingStateChange(offline_host)) {
+        LogError(ModuleName::Standalone, "Timed out waiting for the plugin to load its state");
+        return ErrorCode {CommonError::PluginHostError};
+    }
+
+    if (!plugin->activate(plugin, k_offline_sample_rate, 1, k_offline_block_size))
+        return ErrorCode {CommonError::PluginHostError};
+    DEFER { plugin->deactivate(plugin); };
+
+    OfflineWriter* writer = nullptr;
+    if (options.output_path) {
+        writer = arena.New<OfflineWriter>();
+        writer->format = options.format;
+        TRY(OpenWriterOutput(*writer, *options.output_path, arena));
+        for (auto const i : Range(k_num_writer_blocks))
+            writer->free_blocks.Push(i);
+    }
+
+    auto const num_frames =
+        (u64)((midi_file.length_seconds + k_offline_tail_seconds) * k_offline_sample_rate);
+
+    OfflineRenderStats stats {};
+    Atomic<bool> render_done {false};
+
+    Thread writer_thread {};
+    if (writer) writer_thread.Start([writer] { WriterThreadLoop(*writer); }, "render-writer"_s);
+
+    Thread render_thread {};
+    render_thread.Start(
+        [&] {
+            offline_host.render_thread_id.Store(CurrentThreadId(), StoreMemoryOrder::Relaxed);
+            if (plugin->start_processing(plugin)) {
+                RenderLoop(offline_host, midi_file, num_frames, writer, stats);
+                plugin->stop_processing(plugin);
+            } else if (writer) {
+                writer->render_finished.Store(true, StoreMemoryOrder::Release);
+                writer->blocks_filled.Signal();
+            }
+            render_done.Store(true, StoreMemoryOrder::Release);
+        },
+        "render"_s);
+
+    // Like a real host, we keep servicing main-thread requests while the audio thread is busy.
+    while (!render_done.Load(LoadMemoryOrder::Acquire)) {
+        if (offline_host.callback_requested.Exchange(false, RmwMemoryOrder::Relaxed))
+            plugin->on_main_thread(plugin);
+        SleepThisThread(10);
+    }
+    render_thread.Join();
+
+    if (writer) {
+        writer_thread.Join();
+        auto const close_outcome = CloseWriterOutput(*writer);
+        if (writer->error) return *writer->error;
+        TRY(close_outcome);
+    }
+
+    if (!stats.num_frames) return ErrorCode {CommonError::PluginHostError};
+
+    LogInfo(ModuleName::Standalone,
+            "Rendered {.2}s of audio in {.2}s: {.1}x realtime ({} pool threads)",
+            stats.audio_seconds,
+            stats.render_seconds,
+            stats.RealtimeFactor(),
+            offline_host.num_thread_pool_threads);
+    return stats;
+}
@@ -0,0 +1,35 @@
+// Copyright 2026 Sam Windell
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+#include <clap/entry.h>
+
+#include "foundation/foundation.hpp"
+
+// Renders a Standard MIDI File through the plugin without an audio device. The plugin's process() is called
+// in a tight loop on a render thread, so rendering runs as fast as the machine allows. The plugin is offered
+// the CLAP thread-pool extension so that it can spread voices and layers across cores, and the output file
+// is encoded on a separate writer thread.
+
+enum class OfflineRenderFormat : u8 { Flac, Wav };
+
+struct OfflineRenderOptions {
+    String midi_file_path;
+    Optional<String> output_path; // If not given, the audio is discarded: useful for measuring speed alone.
+    OfflineRenderFormat format;
+    Optional<String> preset_path;
+    u32 num_thread_pool_threads; // 0 disables the thread-pool extension.
+};
+
+struct OfflineRenderStats {
+    f64 RealtimeFactor() const { return render_seconds > 0 ? audio_seconds / render_seconds : 0; }
+
+    u64 num_frames;
+    f64 audio_seconds;
+    f64 render_seconds; // Wall-clock time of the process loop.
+};
+
+// Main thread. entry must already be initialised.
+ErrorCodeOr<OfflineRenderStats> RenderMidiFileOffline(clap_plugin_entry const& entry,
+                                                      OfflineRenderOptions const& options,
+                                                      ArenaAllocator& arena);
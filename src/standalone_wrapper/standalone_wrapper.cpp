@@ -30,6 +30,7 @@
 
 #include "plugin/gui_framework/app_window_sizes.hpp"
 #include "plugin/plugin/plugin.hpp"
+#include "offline_render.hpp"
 #include "standalone_device_manager.hpp"
 
 // A very simple 'standalone' host for development purposes.
@@ -1036,6 +1037,21 @@ static ErrorCodeOr<void> Run(RunOptions options, ArenaAllocator& arena) {
     return k_success;
 }
 
+// No devices or GUI: the plugin is driven from a MIDI file as fast as possible.
+static ErrorCodeOr<void>
+RunOfflineRender(Optional<String> dso_path, OfflineRenderOptions const& options, ArenaAllocator& arena) {
+    auto const entry_source = TRY(LoadClapEntry(dso_path, arena));
+    DEFER {
+        if (entry_source.library_handle) UnloadLibrary(*entry_source.library_handle);
+    };
+
+    entry_source.entry->init(nullptr);
+    DEFER { entry_source.entry->deinit(); };
+
+    TRY(RenderMidiFileOffline(*entry_source.entry, options, arena));
+    return k_success;
+}
+
 static int Main(ArgsCstr args) {
     GlobalInit({
         .init_error_reporting = true,
@@ -1058,6 +1074,8 @@ static int Main(ArgsCstr args) {
         Headless,
         MidiStdin,
         Render,
+        RenderMidi,
+        RenderThreads,
         Count,
     };
 
@@ -1143,11 +1161,29 @@ static int Main(ArgsCstr args) {
             .id = (u32)CommandLineArgId::Render,
             .key = "render",
             .description =
-                "Render audio output to a 16-bit 44.1kHz stereo FLAC file at the given path instead of an audio device. Runs realtime-paced; finalises the file on normal exit (window close or stdin EOF).",
+                "Render audio output to a 16-bit 44.1kHz stereo file at the given path instead of an audio device. Without --render-midi, runs realtime-paced, writes FLAC, and finalises the file on normal exit (window close or stdin EOF). With --render-midi, writes WAV if the path ends with .wav, otherwise FLAC.",
+            .value_type = "path",
+            .required = false,
+            .num_values = 1,
+        },
+        {
+            .id = (u32)CommandLineArgId::RenderMidi,
+            .key = "render-midi",
+            .description =
+                "Render a Standard MIDI File offline, as fast as possible, then exit. No audio device or GUI is opened. The output goes to the --render path; without --render the audio is discarded, which is useful for measuring speed. The realtime factor is logged at the end.",
             .value_type = "path",
             .required = false,
             .num_values = 1,
         },
+        {
+            .id = (u32)CommandLineArgId::RenderThreads,
+            .key = "render-threads",
+            .description =
+                "Number of threads offered to the plugin through the CLAP thread-pool extension when using --render-midi. 0 processes everything on the render thread. Defaults to one less than the number of logical CPUs.",
+            .value_type = "count",
+            .required = false,
+            .num_values = 1,
+        },
     });
 
     ArenaAllocator arena {PageAllocator::Instance()};
@@ -1179,6 +1215,40 @@ static int Main(ArgsCstr args) {
         fixed_window_size = SizeWithAspectRatio((u16)pixels, k_gui_aspect_ratio);
     }
 
+    if (auto const midi_path = cli_args[ToInt(CommandLineArgId::RenderMidi)].Value()) {
+        auto const output_path = cli_args[ToInt(CommandLineArgId::Render)].Value();
+
+        auto num_threads = Max(CachedSystemStats().num_logical_cpus, 1u) - 1;
+        if (auto const threads_str = cli_args[ToInt(CommandLineArgId::RenderThreads)].Value()) {
+            auto const parsed = ParseInt(*threads_str, ParseIntBase::Decimal);
+            if (!parsed || *parsed < 0 || *parsed > 64) {
+                LogError(ModuleName::Standalone,
+                         "Invalid --render-threads '{}': must be in [0, 64]",
+                         *threads_str);
+                return 1;
+            }
+            num_threads = (u32)*parsed;
+        }
+
+        auto const o = RunOfflineRender(
+            cli_args[ToInt(CommandLineArgId::ClapPluginPath)].Value(),
+            {
+                .midi_file_path = *midi_path,
+                .output_path = output_path,
+                .format = output_path && EndsWithCaseInsensitiveAscii(*output_path, ".wav")
+                              ? OfflineRenderFormat::Wav
+                              : OfflineRenderFormat::Flac,
+                .preset_path = cli_args[ToInt(CommandLineArgId::Preset)].Value(),
+                .num_thread_pool_threads = num_threads,
+            },
+            arena);
+        if (o.HasError()) {
+            LogError(ModuleName::Standalone, "Offline render error: {}", o.Error());
+            return 1;
+        }
+        return 0;
+    }
+
     auto const o = Run(
         {
             .dso_path = cli_args[ToInt(CommandLineArgId::ClapPluginPath)].Value(),
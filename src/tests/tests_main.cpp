@@ -38,6 +38,7 @@
     X(RegisterFunctionQueueTests)                                                                            \
     X(RegisterFunctionTests)                                                                                 \
     X(RegisterGeometryTests)                                                                                 \
+    X(RegisterGroupedHashTableTests)                                                                         \
     X(RegisterHashTableTests)                                                                                \
     X(RegisterHostingTests)                                                                                  \
     X(RegisterImageTests)                                                                                    \
@@ -53,6 +54,7 @@
     X(RegisterLogRingBufferTests)                                                                            \
     X(RegisterMathsTests)                                                                                    \
     X(RegisterMemoryTests)                                                                                   \
+    X(RegisterMidiFileTests)                                                                                 \
     X(RegisterMiscTests)                                                                                     \
     X(RegisterOptionalTests)                                                                                 \
     X(RegisterPackageFormatTests)                                                                            \
@@ -64,14 +66,20 @@
     X(RegisterPersistentStoreTests)                                                                          \
     X(RegisterPreferencesTests)                                                                              \
     X(RegisterPresetLuaCodecTests)                                                                           \
+    X(RegisterPresetPrefetchTests)                                                                           \
     X(RegisterPresetServerTests)                                                                             \
+    X(RegisterProcessorTests)                                                                                \
     X(RegisterRandomTests)                                                                                   \
     X(RegisterSampleLibraryServerTests)                                                                      \
+    X(RegisterSampleMemoryPoolTests)                                                                         \
+    X(RegisterSampleIoTests)                                                                                 \
     X(RegisterScanFoldersTests)                                                                              \
     X(RegisterSamplePlayheadTests)                                                                           \
+    X(RegisterSearchIndexTests)                                                                              \
     X(RegisterSentryTests)                                                                                   \
     X(RegisterLegacyParamLogicTests)                                                                         \
     X(RegisterStateCodingTests)                                                                              \
+    X(RegisterStateSnapshotTests)                                                                            \
     X(RegisterStringTests)                                                                                   \
     X(RegisterTaggedUnionTests)                                                                              \
     X(RegisterThreadPoolTests)                                                                               \
@@ -3,9 +3,55 @@
 
 #include "json_reader.hpp"
 
+#include "benchmarks/framework.hpp"
 #include "tests/framework.hpp"
 #include "utils/leak_detecting_allocator.hpp"
 
+static void AppendRandomJsonString(DynamicArray<char>& out, u64& seed) {
+    static constexpr String k_pieces[] = {
+        "a"_s, "text"_s, " "_s, "\\\""_s, "\\\\"_s, "\\n"_s, "\\u00e9"_s, "{"_s, "]"_s, ":"_s, ","_s, "\\/"_s,
+    };
+    dyn::Append(out, '"');
+    auto const num_pieces = RandomIntInRange<u32>(seed, 0, 40);
+    for (auto const _ : Range(num_pieces))
+        dyn::AppendSpan(out, k_pieces[RandomIntInRange<usize>(seed, 0, ArraySize(k_pieces) - 1)]);
+    dyn::Append(out, '"');
+}
+
+static void AppendRandomJsonValue(DynamicArray<char>& out, u64& seed, u32 depth) {
+    auto const kind = RandomIntInRange<u32>(seed, 0, depth < 6 ? 7 : 5);
+    switch (kind) {
+        case 0: AppendRandomJsonString(out, seed); break;
+        case 1: fmt::Append(out, "{}", RandomIntInRange<s32>(seed, -100000, 100000)); break;
+        case 2: fmt::Append(out, "{}.{}e-{}", RandomIntInRange<s32>(seed, -99, 99), 5, 2); break;
+        case 3: dyn::AppendSpan(out, "true"_s); break;
+        case 4: dyn::AppendSpan(out, "false"_s); break;
+        case 5: dyn::AppendSpan(out, "null"_s); break;
+        case 6: {
+            dyn::Append(out, '[');
+            auto const size = RandomIntInRange<u32>(seed, 0, 6);
+            for (auto const i : Range(size)) {
+                if (i) dyn::AppendSpan(out, " , "_s);
+                AppendRandomJsonValue(out, seed, depth + 1);
+            }
+            dyn::Append(out, ']');
+            break;
+        }
+        case 7: {
+            dyn::AppendSpan(out, "{\n"_s);
+            auto const size = RandomIntInRange<u32>(seed, 0, 6);
+            for (auto const i : Range(size)) {
+                if (i) dyn::AppendSpan(out, ",\n"_s);
+                AppendRandomJsonString(out, seed);
+                dyn::AppendSpan(out, ": "_s);
+                AppendRandomJsonValue(out, seed, depth + 1);
+            }
+            dyn::AppendSpan(out, "\t}"_s);
+            break;
+        }
+    }
+}
+
 TEST_CASE(TestJsonReader) {
     using namespace json;
 
@@ -39,6 +85,40 @@ TEST_CASE(TestJsonReader) {
         return true;
     };
 
+    // Unless comments are allowed, Parse uses the structural index. Parsing with allow_comments uses the
+    // bytewise tokeniser instead, so we can check that the two produce the same events.
+    auto const record_events = [&](String test, ReaderSettings reader_settings) -> Optional<String> {
+        DynamicArray<char> events {tester.scratch_arena};
+        auto const outcome = Parse(
+            test,
+            [&](EventHandlerStack&, Event const& event) {
+                fmt::Append(events, "{} '{}': ", ToInt(event.type), event.key);
+                switch (event.type) {
+                    case EventType::String: fmt::Append(events, "{}", event.string); break;
+                    case EventType::Double: fmt::Append(events, "{}", event.real); break;
+                    case EventType::Int: fmt::Append(events, "{}", event.integer); break;
+                    case EventType::Bool: fmt::Append(events, "{}", event.boolean); break;
+                    default: break;
+                }
+                dyn::Append(events, '\n');
+                return true;
+            },
+            tester.scratch_arena,
+            reader_settings);
+        if (outcome.HasError()) return k_nullopt;
+        return events.ToConstOwnedSpan();
+    };
+
+    auto const check_conforms = [&](String test) {
+        auto const indexed = record_events(test, settings);
+        auto bytewise_settings = settings;
+        bytewise_settings.allow_comments = true;
+        auto const bytewise = record_events(test, bytewise_settings);
+        REQUIRE(indexed.HasValue());
+        REQUIRE(bytewise.HasValue());
+        CHECK_EQ(*indexed, *bytewise);
+    };
+
     SUBCASE("foo") {
         String const test = "{\"description\":\"Essential data for Floe\",\"name\":\"Core\",\"version\":1}";
 
@@ -102,6 +182,7 @@ TEST_CASE(TestJsonReader) {
         )foo";
 
         REQUIRE(Parse(test, callback, tester.scratch_arena, settings).Succeeded());
+        check_conforms(test);
     }
 
     SUBCASE("test2") {
@@ -169,6 +250,7 @@ TEST_CASE(TestJsonReader) {
         )foo";
 
         REQUIRE(Parse(test, callback, tester.scratch_arena, settings).Succeeded());
+        check_conforms(test);
     }
 
     SUBCASE("nested test") {
@@ -177,6 +259,7 @@ TEST_CASE(TestJsonReader) {
                       tester.scratch_arena,
                       settings)
                     .Succeeded());
+        check_conforms("[[[[[[[[[[[[[[[[[[[[[[[[[\"hello\"]]]]]]]]]]]]]]]]]]]]]]]]]");
     }
 
     SUBCASE("should fail") {
@@ -184,6 +267,10 @@ TEST_CASE(TestJsonReader) {
             auto r = Parse(test, callback, tester.scratch_arena, settings);
             REQUIRE(r.HasError());
             tester.log.Debug("{}", r.Error().message);
+
+            auto bytewise_settings = settings;
+            bytewise_settings.allow_comments = true;
+            REQUIRE(Parse(test, callback, tester.scratch_arena, bytewise_settings).HasError());
         };
 
         should_fail("[\"mismatch\"}");
@@ -200,6 +287,11 @@ TEST_CASE(TestJsonReader) {
         should_fail("[0,]");
         should_fail("{\"key\":\"value\",}");
         should_fail("{no_quotes:\"str\"}");
+        should_fail("[\"unterminated]");
+        should_fail("[\"escaped quote at end\\\"]");
+        should_fail("[tru]");
+        should_fail("[1 2]");
+        should_fail("{\"a\":1}}");
     }
 
     SUBCASE("extra settings") {
@@ -234,6 +326,7 @@ TEST_CASE(TestJsonReader) {
     SUBCASE("newlines") {
         String const test = "{\"foo\":\r\n\"val\"}";
         REQUIRE(Parse(test, callback, tester.scratch_arena, settings).Succeeded());
+        check_conforms(test);
     }
 
     SUBCASE("escape codes") {
@@ -251,7 +344,108 @@ TEST_CASE(TestJsonReader) {
                     settings)
                     .Succeeded());
     }
+
+    SUBCASE("block boundaries") {
+        // The structural index works on 64-byte blocks, so put escapes and quotes either side of the
+        // boundaries.
+        for (auto const padding : Range(130uz)) {
+            for (auto const num_backslashes : Range(5uz)) {
+                DynamicArray<char> test {tester.scratch_arena};
+                dyn::AppendSpan(test, "{\"k\":\""_s);
+                for (auto const _ : Range(padding))
+                    dyn::Append(test, 'x');
+                for (auto const _ : Range(num_backslashes * 2))
+                    dyn::Append(test, '\\');
+                dyn::AppendSpan(test, "\\\"\", \"next\" : [1,{}]}"_s);
+                check_conforms(test);
+            }
+        }
+    }
+
+    SUBCASE("ignored containers are skipped") {
+        String const test = R"foo({
+            "skip": { "a": [1, 2, {"b": "}]"}], "c": "\"{" },
+            "keep": [ "x", { "skip": [ "y" ] } ],
+            "after": 5
+        })foo";
+        DynamicArray<char> seen {tester.scratch_arena};
+        auto const outcome = Parse(
+            test,
+            [&](EventHandlerStack&, Event const& event) {
+                if (event.key == "skip"_s) return false;
+                if (event.key.size) fmt::Append(seen, "{},", event.key);
+                if (event.type == EventType::String) fmt::Append(seen, "{},", event.string);
+                return true;
+            },
+            tester.scratch_arena,
+            settings);
+        REQUIRE(outcome.Succeeded());
+        CHECK_EQ(String(seen), "keep,x,after,"_s);
+    }
+
+    SUBCASE("random documents") {
+        for (auto const _ : Range(200)) {
+            DynamicArray<char> test {tester.scratch_arena};
+            AppendRandomJsonValue(test, tester.random_seed, 0);
+            check_conforms(test);
+        }
+    }
+
     return k_success;
 }
 
+BENCHMARK_FN String GeneratePresetBankJson(ArenaAllocator& arena) {
+    DynamicArray<char> json {arena};
+    u64 seed = 1;
+    dyn::AppendSpan(json, "{\"presets\": [\n"_s);
+    for (auto const i : Range(20'000u)) {
+        if (i) dyn::AppendSpan(json, ",\n"_s);
+        fmt::Append(json,
+                    "  {{\"name\": \"Preset {}\", \"author\": \"Floe\", "
+                    "\"tags\": [\"pad\", \"warm\", \"evolving\"], "
+                    "\"description\": \"A \\\"lush\\\" sound, {} \\u00e9\",\n",
+                    i,
+                    RandomU64(seed));
+        dyn::AppendSpan(json, "   \"params\": {"_s);
+        for (auto const p : Range(40u)) {
+            if (p) dyn::AppendSpan(json, ", "_s);
+            fmt::Append(json, "\"param_{}\": {}", p, RandomFloat01<f64>(seed));
+        }
+        dyn::AppendSpan(json, "}}"_s);
+    }
+    dyn::AppendSpan(json, "\n]}"_s);
+    return json.ToConstOwnedSpan();
+}
+
+BENCHMARK_FN void BenchmarkJsonReader(bool indexed, bool skip_params) {
+    ArenaAllocator arena {PageAllocator::Instance()};
+    auto const json = GeneratePresetBankJson(arena);
+    json::ReaderSettings const settings {.allow_comments = !indexed};
+    for (auto const _ : Range(20)) {
+        ArenaAllocator scratch_arena {PageAllocator::Instance()};
+        usize num_names = 0;
+        auto const outcome = json::Parse(
+            json,
+            [&](json::EventHandlerStack&, json::Event const& event) {
+                if (skip_params && event.key == "params"_s) return false;
+                if (event.key == "name"_s) ++num_names;
+                return true;
+            },
+            scratch_arena,
+            settings);
+        ASSERT(outcome.Succeeded());
+        benchmarks::DoNotOptimise(num_names);
+    }
+}
+
+BENCHMARK_FN void BenchmarkJsonReaderBytewise() { BenchmarkJsonReader(false, false); }
+BENCHMARK_FN void BenchmarkJsonReaderIndexed() { BenchmarkJsonReader(true, false); }
+BENCHMARK_FN void BenchmarkJsonReaderIndexedSkipping() { BenchmarkJsonReader(true, true); }
+
 TEST_REGISTRATION(RegisterJsonReaderTests) { REGISTER_TEST(TestJsonReader); }
+
+BENCHMARK_REGISTRATION(RegisterJsonReaderBenchmarks) {
+    REGISTER_BENCHMARK_NAMED(BenchmarkJsonReaderBytewise, "JsonReader/Bytewise");
+    REGISTER_BENCHMARK_NAMED(BenchmarkJsonReaderIndexed, "JsonReader/Indexed");
+    REGISTER_BENCHMARK_NAMED(BenchmarkJsonReaderIndexedSkipping, "JsonReader/IndexedSkipping");
+}
@@ -3,7 +3,16 @@
 
 #pragma once
 #include "foundation/foundation.hpp"
-
+#include "foundation/utils/simd.hpp"
+
+// Parsing is done in two stages. First, SIMD code finds the position of every bracket, colon, comma, quote
+// and number/literal in the text, 64 bytes at a time (a structural index, like simdjson). Then the events are
+// produced by walking those positions, so the bytes inside strings are only looked at again if the string
+// is needed. Containers that a handler ignores are skipped over entirely using the index.
+//
+// With allow_comments, the index can't be used because comments can contain anything, including quotes and
+// brackets; we tokenise byte by byte instead.
+//
 // WARNING: This API leaves a lot to be desired...
 // - Be careful with lifetime of lambdas that you pass into this API. You might need to keep the functions
 //   alive longer than you's expect.
@@ -94,6 +103,10 @@ class EventHandler {
         }
     }
 
+    // True if the callback returned false for the container that we're in (or one of its parents), so it
+    // won't be called until the container ends.
+    bool IsIgnoring() const { return m_nesting > m_ignore_until_level; }
+
   private:
     int m_nesting = 0;
     int m_ignore_until_level = LargestRepresentableValue<int>();
@@ -157,6 +170,117 @@ static void ConsumeEndOfLine(Tokeniser* tokeniser, char c) {
         tokeniser->at = next;
 }
 
+// Replaces escape sequences. Only allocates if there are any.
+static ValueOrError<String, JsonParseError> DecodeString(String text, ArenaAllocator& scratch_arena) {
+    if (!Contains(text, '\\')) return text;
+
+    auto data = scratch_arena.AllocateExactSizeUninitialised<char>(text.size);
+    auto out = (char*)data.data;
+
+    auto str_end = End(text);
+    for (auto it = Begin(text); it != str_end;) {
+        if (*it == '\\') {
+            ++it;
+            ASSERT(it != str_end);
+
+            constexpr String k_valid_escapes = "\"\\/bfnrtu";
+            if (!Find(k_valid_escapes, *it)) return JsonParseError {"Invalid escape characters"};
+            if (*it != 'u') {
+                switch (*it) {
+                    case 'b': *out++ = '\b'; break;
+                    case 'f': *out++ = '\f'; break;
+                    case 'n': *out++ = '\n'; break;
+                    case 'r': *out++ = '\r'; break;
+                    case 't': *out++ = '\t'; break;
+                    default: *out++ = *it;
+                }
+                ++it;
+            } else {
+                ++it;
+                if (str_end - it < 4) return JsonParseError {"Invalid escape characters"};
+                for (auto const i : Range(4))
+                    if (!IsHexDigit(it[i])) return JsonParseError {"Invalid escape characters"};
+                auto const codepoint = ParseInt({it, 4}, ParseIntBase::Hexadecimal).ValueOr(1);
+
+                if (codepoint < 0x80) {
+                    *out++ = (char)codepoint;
+                } else if (codepoint < 0x800) {
+                    *out++ = (char)((codepoint >> 6) | 0xC0);
+                    *out++ = (char)((codepoint & 0x3F) | 0x80);
+                } else if (codepoint < 0x10000) {
+                    *out++ = (char)((codepoint >> 12) | 0xE0);
+                    *out++ = (char)(((codepoint >> 6) & 0x3F) | 0x80);
+                    *out++ = (char)((codepoint & 0x3F) | 0x80);
+                } else if (codepoint < 0x110000) {
+                    *out++ = (char)((codepoint >> 18) | 0xF0);
+                    *out++ = (char)(((codepoint >> 12) & 0x3F) | 0x80);
+                    *out++ = (char)(((codepoint >> 6) & 0x3F) | 0x80);
+                    *out++ = (char)((codepoint & 0x3F) | 0x80);
+                }
+
+                it += 4;
+            }
+        } else {
+            *out++ = *it;
+            ++it;
+        }
+    }
+
+    return String {(char const*)data.data, (usize)(out - (char*)data.data)};
+}
+
+// A run of characters that isn't a string or punctuation: true, false, null, a number, or (if allowed) a key
+// without quotes.
+static ValueOrError<Token, JsonParseError> ParseAtom(String atom, ReaderSettings const& settings) {
+    ASSERT(atom.size);
+    Token token = {};
+    auto const c = atom[0];
+
+    if (IsAlpha(c)) {
+        if (atom == "true"_s) {
+            token.type = TokenType::True;
+        } else if (atom == "false"_s) {
+            token.type = TokenType::False;
+        } else if (atom == "null"_s) {
+            token.type = TokenType::Null;
+        } else {
+            for (auto const character : atom)
+                if (!IsAlpha(character) && !IsDigit(character) && character != '_')
+                    return JsonParseError {"Unexpected character"};
+            if (!settings.allow_keys_without_quotes) return JsonParseError {"Unknown alphanumeric value"};
+            token.type = TokenType::String;
+            token.text = atom;
+        }
+    } else if (IsDigit(c) || c == '-') {
+        bool is_real = false;
+        for (auto const character : atom) {
+            if (character == '.' || character == 'e' || character == 'E') {
+                usize num_chars_read = 0;
+                auto opt = ParseFloat(atom, &num_chars_read);
+                if (!opt || num_chars_read != atom.size)
+                    return JsonParseError {"The number is not in a correct format"};
+                token.real = opt.Value();
+                token.type = TokenType::Double;
+                is_real = true;
+                break;
+            }
+        }
+
+        if (!is_real) {
+            usize num_chars_read = 0;
+            auto opt = ParseInt(atom, ParseIntBase::Decimal, &num_chars_read);
+            if (!opt || num_chars_read != atom.size)
+                return JsonParseError {"The number is not in a correct format"};
+            token.integer = opt.Value();
+            token.type = TokenType::Integer;
+        }
+    } else {
+        return JsonParseError {"Unexpected character"};
+    }
+
+    return token;
+}
+
 static ValueOrError<Token, JsonParseError> GetToken(Tokeniser* tokeniser) {
     auto& at = tokeniser->at;
     auto end = tokeniser->end;
@@ -217,6 +341,7 @@ static ValueOrError<Token, JsonParseError> GetToken(Tokeniser* tokeniser) {
 
             if (at >= end) return JsonParseError {"Expected quote at end of string"};
 
+            token.text = TRY(DecodeString({start + 1, (usize)(at - start) - 2}, tokeniser->scratch_arena));
             break;
         }
 
@@ -275,18 +400,7 @@ static ValueOrError<Token, JsonParseError> GetToken(Tokeniser* tokeniser) {
                     else
                         break;
                 }
-
-                auto const str = String {start, (usize)(at - start)};
-                if (str == "true"_s)
-                    token.type = TokenType::True;
-                else if (str == "false"_s)
-                    token.type = TokenType::False;
-                else if (str == "null"_s)
-                    token.type = TokenType::Null;
-                else if (!tokeniser->settings->allow_keys_without_quotes)
-                    return JsonParseError {"Unknown alphanumeric value"};
-                else
-                    token.type = TokenType::String;
+                token = TRY(ParseAtom({start, (usize)(at - start)}, *tokeniser->settings));
             } else if (IsDigit(c) || c == '-') {
                 while (at < end) {
                     constexpr String k_allowed_chars = "0123456789.eE-+";
@@ -295,31 +409,7 @@ static ValueOrError<Token, JsonParseError> GetToken(Tokeniser* tokeniser) {
                     else
                         break;
                 }
-
-                auto const number_string = String {start, (usize)(at - start)};
-
-                bool is_real = false;
-                for (auto const character : number_string) {
-                    if (character == '.' || character == 'e' || character == 'E') {
-                        usize num_chars_read = 0;
-                        auto opt = ParseFloat(number_string, &num_chars_read);
-                        if (!opt || num_chars_read != number_string.size)
-                            return JsonParseError {"The number is not in a correct format"};
-                        token.real = opt.Value();
-                        token.type = TokenType::Double;
-                        is_real = true;
-                        break;
-                    }
-                }
-
-                if (!is_real) {
-                    usize num_chars_read = 0;
-                    auto opt = ParseInt(number_string, ParseIntBase::Decimal, &num_chars_read);
-                    if (!opt || num_chars_read != number_string.size)
-                        return JsonParseError {"The number is not in a correct format"};
-                    token.integer = opt.Value();
-                    token.type = TokenType::Integer;
-                }
+                token = TRY(ParseAtom({start, (usize)(at - start)}, *tokeniser->settings));
             } else {
                 return JsonParseError {"Unexpected character"};
             }
@@ -327,104 +417,264 @@ static ValueOrError<Token, JsonParseError> GetToken(Tokeniser* tokeniser) {
         }
     }
 
-    if (token.type == TokenType::String) {
-        ASSERT(at >= start);
-        token.text = {start, (usize)(at - start)};
-        if (token.text[0] == '"') {
-            token.text.RemovePrefix(1); // remove the quotes
-            token.text.RemoveSuffix(1);
+    return token;
+}
+
+static ValueOrError<Token, JsonParseError> GetUsefulToken(Tokeniser* tokeniser) {
+    Token token;
+    do {
+        auto const next_token = TRY(GetToken(tokeniser));
+        token = next_token;
+    } while (token.type == TokenType::Spacing || token.type == TokenType::EndOfLine ||
+             token.type == TokenType::Comment);
+    return token;
+}
+
+// The byte-at-a-time tokeniser can't skip ahead.
+static void SkipToEndOfContainer(Tokeniser*) {}
+
+// Structural index
+// ==========================================================================================================
+// Stage 1 finds the positions of everything the parser needs to look at: brackets, colons and commas, the
+// opening and closing quotes of strings, and the first character of each number/true/false/null. Nothing
+// inside a string is indexed.
+
+constexpr usize k_block_size = 64;
+
+// One bit per byte of a block.
+struct BlockMasks {
+    u64 quote;
+    u64 backslash;
+    u64 structural; // {}[]:,
+    u64 whitespace;
+};
+
+#if defined(__x86_64__)
+static ALWAYS_INLINE u64 MatchMask(__m128i bytes, char c) {
+    return (u64)(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)));
+}
+#elif defined(__aarch64__)
+// NEON has no movemask: weight each lane's bit and add neighbouring lanes together until each byte holds 8
+// lanes.
+static ALWAYS_INLINE u64 ToBitmask(uint8x16_t const (&matches)[4]) {
+    uint8x16_t const bit_weights = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    auto const sum01 = vpaddq_u8(vandq_u8(matches[0], bit_weights), vandq_u8(matches[1], bit_weights));
+    auto const sum23 = vpaddq_u8(vandq_u8(matches[2], bit_weights), vandq_u8(matches[3], bit_weights));
+    auto sum = vpaddq_u8(sum01, sum23);
+    sum = vpaddq_u8(sum, sum);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+}
+#endif
+
+static ALWAYS_INLINE BlockMasks ClassifyBlock(u8 const* block) {
+    BlockMasks masks {};
+#if defined(__x86_64__)
+    for (u32 i = 0; i < k_block_size / 16; ++i) {
+        auto const bytes = _mm_loadu_si128((__m128i const*)(block + (i * 16)));
+        auto const shift = i * 16;
+        masks.quote |= MatchMask(bytes, '"') << shift;
+        masks.backslash |= MatchMask(bytes, '\\') << shift;
+        masks.structural |= (MatchMask(bytes, '{') | MatchMask(bytes, '}') | MatchMask(bytes, '[') |
+                             MatchMask(bytes, ']') | MatchMask(bytes, ':') | MatchMask(bytes, ','))
+                            << shift;
+        masks.whitespace |= (MatchMask(bytes, ' ') | MatchMask(bytes, '\t') | MatchMask(bytes, '\n') |
+                             MatchMask(bytes, '\r'))
+                            << shift;
+    }
+#elif defined(__aarch64__)
+    uint8x16_t quote[4];
+    uint8x16_t backslash[4];
+    uint8x16_t structural[4];
+    uint8x16_t whitespace[4];
+    for (u32 i = 0; i < 4; ++i) {
+        auto const bytes = vld1q_u8(block + (i * 16));
+        auto const match = [&](char c) { return vceqq_u8(bytes, vdupq_n_u8((u8)c)); };
+        quote[i] = match('"');
+        backslash[i] = match('\\');
+        structural[i] = vorrq_u8(vorrq_u8(vorrq_u8(match('{'), match('}')), vorrq_u8(match('['), match(']'))),
+                                 vorrq_u8(match(':'), match(',')));
+        whitespace[i] = vorrq_u8(vorrq_u8(match(' '), match('\t')), vorrq_u8(match('\n'), match('\r')));
+    }
+    masks.quote = ToBitmask(quote);
+    masks.backslash = ToBitmask(backslash);
+    masks.structural = ToBitmask(structural);
+    masks.whitespace = ToBitmask(whitespace);
+#else
+    for (u32 i = 0; i < k_block_size; ++i) {
+        auto const bit = 1ull << i;
+        switch (block[i]) {
+            case '"': masks.quote |= bit; break;
+            case '\\': masks.backslash |= bit; break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',': masks.structural |= bit; break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r': masks.whitespace |= bit; break;
         }
+    }
+#endif
+    return masks;
+}
 
-        bool contains_escape_chars = false;
-        for (auto character : token.text) {
-            if (character == '\\') {
-                contains_escape_chars = true;
-                break;
-            }
+// Bit i is the XOR of bits 0 to i. Applied to the unescaped quotes, it gives the bits that are in a string.
+static ALWAYS_INLINE u64 PrefixXor(u64 bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// The characters that follow an odd-length run of backslashes. prev_escaped carries whether the first
+// character of the next block is escaped.
+static ALWAYS_INLINE u64 EscapedCharacters(u64 backslash, u64& prev_escaped) {
+    constexpr u64 k_even_bits = 0x5555555555555555ull;
+    constexpr u64 k_odd_bits = ~k_even_bits;
+
+    // An escaped backslash doesn't start a run.
+    backslash &= ~prev_escaped;
+    auto const run_starts = backslash & ~(backslash << 1);
+
+    // Adding a run's start bit to the run carries to the bit just past the end of the run. Whether the run's
+    // length is odd is given by whether the start and end positions have different parity.
+    auto const even_starts = run_starts & k_even_bits;
+    auto const odd_starts = run_starts & k_odd_bits;
+    auto const even_start_run_ends = (backslash + even_starts) & ~backslash;
+    u64 odd_start_sums;
+    auto const ends_with_odd_run = __builtin_add_overflow(backslash, odd_starts, &odd_start_sums);
+    auto const odd_start_run_ends = odd_start_sums & ~backslash;
+
+    auto const escaped =
+        (even_start_run_ends & k_odd_bits) | (odd_start_run_ends & k_even_bits) | prev_escaped;
+    prev_escaped = ends_with_odd_run ? 1 : 0;
+    return escaped;
+}
+
+static ValueOrError<Span<u32 const>, JsonParseError> IndexStructurals(String json, ArenaAllocator& arena) {
+    if (json.size > LargestRepresentableValue<u32>()) return JsonParseError {"JSON is too large"};
+
+    DynamicArray<u32> positions {arena};
+    positions.Reserve((json.size / 4) + k_block_size);
+
+    u64 prev_escaped = 0;
+    u64 prev_in_string = 0; // All bits set if the previous block ended inside a string.
+    u64 prev_scalar = 0;
+
+    for (usize block_start = 0; block_start < json.size; block_start += k_block_size) {
+        auto const remaining = json.size - block_start;
+        BlockMasks masks;
+        if (remaining >= k_block_size) {
+            masks = ClassifyBlock((u8 const*)json.data + block_start);
+        } else {
+            // Pad with whitespace: it's never indexed.
+            u8 padded[k_block_size];
+            FillMemory(padded, ' ', k_block_size);
+            CopyMemory(padded, json.data + block_start, remaining);
+            masks = ClassifyBlock(padded);
         }
-        if (contains_escape_chars) {
-            auto data = tokeniser->scratch_arena.AllocateExactSizeUninitialised<char>(token.text.size);
-            auto out = (char*)data.data;
-
-            auto str_end = End(token.text);
-            bool invalid_escape_chars = false;
-            for (auto it = Begin(token.text); it != str_end && !invalid_escape_chars;) {
-                if (*it == '\\') {
-                    ++it;
-                    ASSERT(it != str_end);
-
-                    constexpr String k_valid_escapes = "\"\\/bfnrtu";
-                    if (!Find(k_valid_escapes, *it)) {
-                        invalid_escape_chars = true;
-                        break;
-                    }
-                    if (*it != 'u') {
-                        switch (*it) {
-                            case 'b': *out++ = '\b'; break;
-                            case 'f': *out++ = '\f'; break;
-                            case 'n': *out++ = '\n'; break;
-                            case 'r': *out++ = '\r'; break;
-                            case 't': *out++ = '\t'; break;
-                            default: *out++ = *it;
-                        }
-                        ++it;
-                    } else {
-                        ++it;
-                        auto sub_it = it;
-                        for (auto _ : Range(4)) {
-                            if (sub_it == str_end || !IsHexDigit(*sub_it)) {
-                                invalid_escape_chars = true;
-                                break;
-                            }
-                            ++sub_it;
-                        }
-                        char buffer[4] = {*it, *(it + 1), *(it + 2), *(it + 3)};
-                        auto const codepoint =
-                            ParseInt({buffer, sizeof(buffer)}, ParseIntBase::Hexadecimal).ValueOr(1);
-
-                        if (codepoint < 0x80) {
-                            *out++ = (char)codepoint;
-                        } else if (codepoint < 0x800) {
-                            *out++ = (char)((codepoint >> 6) | 0xC0);
-                            *out++ = (char)((codepoint & 0x3F) | 0x80);
-                        } else if (codepoint < 0x10000) {
-                            *out++ = (char)((codepoint >> 12) | 0xE0);
-                            *out++ = (char)(((codepoint >> 6) & 0x3F) | 0x80);
-                            *out++ = (char)((codepoint & 0x3F) | 0x80);
-                        } else if (codepoint < 0x110000) {
-                            *out++ = (char)((codepoint >> 18) | 0xF0);
-                            *out++ = (char)(((codepoint >> 12) & 0x3F) | 0x80);
-                            *out++ = (char)(((codepoint >> 6) & 0x3F) | 0x80);
-                            *out++ = (char)((codepoint & 0x3F) | 0x80);
-                        }
 
-                        it += 4;
-                    }
-                } else {
-                    *out++ = *it;
-                    ++it;
-                }
-            }
+        auto const quotes = masks.quote & ~EscapedCharacters(masks.backslash, prev_escaped);
 
-            if (invalid_escape_chars) return JsonParseError {"Invalid escape characters"};
+        // From each opening quote up to, but not including, its closing quote.
+        auto const in_string = PrefixXor(quotes) ^ prev_in_string;
+        prev_in_string = (u64)((s64)in_string >> 63);
 
-            token.text = {(char const*)data.data, (usize)(out - (char*)data.data)};
+        auto const outside_strings = ~(in_string | quotes);
+        auto const scalar = ~(masks.structural | masks.whitespace) & outside_strings;
+        auto const scalar_starts = scalar & ~((scalar << 1) | prev_scalar);
+        prev_scalar = scalar >> 63;
+
+        auto bits = (masks.structural & outside_strings) | quotes | scalar_starts;
+
+        auto const num_positions = positions.size;
+        positions.Reserve(num_positions + k_block_size);
+        positions.ResizeWithoutCtorDtor(num_positions + (usize)__builtin_popcountll(bits));
+        auto out = positions.data + num_positions;
+        while (bits) {
+            *out++ = (u32)(block_start + (usize)__builtin_ctzll(bits));
+            bits &= bits - 1;
         }
     }
 
-    return token;
+    if (prev_in_string) return JsonParseError {"Expected quote at end of string"};
+
+    return positions.ToConstOwnedSpan();
 }
 
-static ValueOrError<Token, JsonParseError> GetUsefulToken(Tokeniser* tokeniser) {
-    Token token;
-    do {
-        auto const next_token = TRY(GetToken(tokeniser));
-        token = next_token;
-    } while (token.type == TokenType::Spacing || token.type == TokenType::EndOfLine ||
-             token.type == TokenType::Comment);
+// Stage 2: produces tokens by walking the structural index.
+struct IndexedTokeniser {
+    String json;
+    Span<u32 const> positions;
+    usize cursor;
+    ReaderSettings const* settings;
+    ArenaAllocator& scratch_arena;
+};
+
+static ValueOrError<Token, JsonParseError> GetToken(IndexedTokeniser* tokeniser) {
+    auto& t = *tokeniser;
+    Token token = {};
+    if (t.cursor == t.positions.size) {
+        token.type = TokenType::EndOfStream;
+        return token;
+    }
+
+    auto const pos = (usize)t.positions[t.cursor++];
+    switch (t.json[pos]) {
+        case ':': token.type = TokenType::Colon; break;
+        case ',': token.type = TokenType::Comma; break;
+        case '[': token.type = TokenType::OpenBracket; break;
+        case ']': token.type = TokenType::CloseBracket; break;
+        case '{': token.type = TokenType::OpenBrace; break;
+        case '}': token.type = TokenType::CloseBrace; break;
+        case '"': {
+            // Stage 1 made sure that every opening quote is followed by its closing quote.
+            auto const end = (usize)t.positions[t.cursor++];
+            token.type = TokenType::String;
+            token.text = TRY(DecodeString(t.json.SubSpan(pos + 1, end - pos - 1), t.scratch_arena));
+            break;
+        }
+        default: {
+            // An atom ends at whitespace or at the next thing in the index.
+            auto const limit = (t.cursor != t.positions.size) ? (usize)t.positions[t.cursor] : t.json.size;
+            auto end = pos + 1;
+            while (end != limit && !IsWhitespace(t.json[end]))
+                ++end;
+            token = TRY(ParseAtom(t.json.SubSpan(pos, end - pos), *t.settings));
+            break;
+        }
+    }
     return token;
 }
 
+static ValueOrError<Token, JsonParseError> GetUsefulToken(IndexedTokeniser* tokeniser) {
+    return GetToken(tokeniser);
+}
+
+// Moves to the bracket that closes the container that was just opened, without looking at what's inside.
+static void SkipToEndOfContainer(IndexedTokeniser* tokeniser) {
+    auto& t = *tokeniser;
+    u32 depth = 1;
+    for (; t.cursor != t.positions.size; ++t.cursor) {
+        switch (t.json[t.positions[t.cursor]]) {
+            case '{':
+            case '[': ++depth; break;
+            case '}':
+            case ']':
+                if (--depth == 0) return;
+                break;
+            case '"': ++t.cursor; break; // Skip the closing quote too.
+            default: break;
+        }
+    }
+}
+
 constexpr usize k_initial_stack_size = 10;
 
 class EventHandlerContext {
@@ -451,12 +701,11 @@ class EventHandlerContext {
     EventHandlerStack m_handler_stack;
 };
 
-} // namespace detail
-
-PUBLIC VoidOrError<JsonParseError>
-Parse(String str, EventCallbackRef event_callback, ArenaAllocator& scratch_arena, ReaderSettings settings) {
-    using namespace detail;
-
+template <typename TokeniserType>
+static VoidOrError<JsonParseError> ParseTokens(TokeniserType* tokeniser,
+                                               EventCallbackRef event_callback,
+                                               ArenaAllocator& scratch_arena,
+                                               ReaderSettings const& settings) {
     enum class ContainerType : u8 { Object, Array };
     enum ExpectedType : u8 {
         TypeKeyOrCloseBrace = 1,
@@ -477,10 +726,6 @@ Parse(String str, EventCallbackRef event_callback, ArenaAllocator& scratch_arena
         u8 expected;
     };
 
-    Tokeniser tokeniser {.scratch_arena = scratch_arena};
-    tokeniser.at = str.data;
-    tokeniser.end = str.data + str.size;
-    tokeniser.settings = &settings;
     EventHandlerContext event_handler_context {scratch_arena, Move(event_callback)};
 
     DynamicArray<Frame> stack(scratch_arena);
@@ -490,7 +735,7 @@ Parse(String str, EventCallbackRef event_callback, ArenaAllocator& scratch_arena
     TokenType prev_token_type = {};
 
     while (true) {
-        auto const rhs = TRY(GetUsefulToken(&tokeniser));
+        auto const rhs = TRY(GetUsefulToken(tokeniser));
 
         auto* frame = stack.size ? &Last(stack) : nullptr;
         auto expected = frame ? frame->expected : TypeContainer;
@@ -571,6 +816,8 @@ Parse(String str, EventCallbackRef event_callback, ArenaAllocator& scratch_arena
                 dyn::Append(stack, Frame {ContainerType::Object, TypeKeyOrCloseBrace});
                 event_handler_context.HandleEvent(Event {.key = key, .type = EventType::ObjectStart});
                 key = {};
+                // Nothing inside will reach a callback.
+                if (event_handler_context.CurrentHandler().IsIgnoring()) SkipToEndOfContainer(tokeniser);
                 break;
             }
             case TokenType::CloseBrace: {
@@ -595,6 +842,8 @@ Parse(String str, EventCallbackRef event_callback, ArenaAllocator& scratch_arena
                 dyn::Append(stack, Frame {ContainerType::Array, TypeValueOrCloseBracket});
                 event_handler_context.HandleEvent(Event {.key = key, .type = EventType::ArrayStart});
                 key = {};
+                // Nothing inside will reach a callback.
+                if (event_handler_context.CurrentHandler().IsIgnoring()) SkipToEndOfContainer(tokeniser);
                 break;
             }
             case TokenType::CloseBracket: {
@@ -624,6 +873,30 @@ Parse(String str, EventCallbackRef event_callback, ArenaAllocator& scratch_arena
     return k_success;
 }
 
+} // namespace detail
+
+PUBLIC VoidOrError<JsonParseError>
+Parse(String str, EventCallbackRef event_callback, ArenaAllocator& scratch_arena, ReaderSettings settings) {
+    using namespace detail;
+
+    if (settings.allow_comments) {
+        Tokeniser tokeniser {.scratch_arena = scratch_arena};
+        tokeniser.at = str.data;
+        tokeniser.end = str.data + str.size;
+        tokeniser.settings = &settings;
+        return ParseTokens(&tokeniser, event_callback, scratch_arena, settings);
+    }
+
+    IndexedTokeniser tokeniser {
+        .json = str,
+        .positions = TRY(IndexStructurals(str, scratch_arena)),
+        .cursor = 0,
+        .settings = &settings,
+        .scratch_arena = scratch_arena,
+    };
+    return ParseTokens(&tokeniser, event_callback, scratch_arena, settings);
+}
+
 PUBLIC bool SetIfMatching(Event const& event, String expected_key, bool& result) {
     if (event.type == EventType::Bool && event.key == expected_key) {
         result = event.boolean;
@@ -10,12 +10,37 @@ using PathOrMemory = TaggedUnion<PathOrMemoryType,
                                  TypeAndTag<String, PathOrMemoryType::File>,
                                  TypeAndTag<Span<u8 const>, PathOrMemoryType::Memory>>;
 
+struct FileReaderOptions {
+    // Files at least this size are memory-mapped rather than read with pread. For smaller files, setting up
+    // and tearing down the mapping costs more than the read syscalls it saves.
+    static constexpr u64 k_default_min_size_to_map = Kb(256);
+    static constexpr u64 k_never_map = LargestRepresentableValue<u64>();
+
+    u64 min_size_to_map = k_default_min_size_to_map;
+    FileAccessPattern access_pattern = FileAccessPattern::Sequential;
+};
+
+// Reads from memory, a file, or a callback. File reads are positional (pread, or a memory-mapping) so no
+// OS file position is shared: ReadAt() can be called from multiple threads at once for memory and file
+// readers. Read() uses and advances pos so it's not thread-safe.
 struct Reader {
-    static ErrorCodeOr<Reader> FromFile(String path) {
+    static ErrorCodeOr<Reader> FromFile(String path, FileReaderOptions options = {}) {
         auto f = TRY(OpenFile(path, FileMode::Read()));
         auto const size = TRY(f.FileSize());
+        if (size && size >= options.min_size_to_map) {
+            // If mapping fails for any reason (e.g. a filesystem that doesn't support it) pread still works.
+            if (auto mapping = MapFile(f, size); mapping.HasValue()) {
+                mapping.Value().Advise(options.access_pattern);
+                return Reader {
+                    .size = (usize)size,
+                    .pos = 0,
+                    .file_base_pos = 0,
+                    .mapped_file = Move(mapping.Value()),
+                };
+            }
+        }
         return Reader {
-            .size = size,
+            .size = (usize)size,
             .pos = 0,
             .file_base_pos = 0,
             .file = Move(f),
@@ -61,31 +86,51 @@ struct Reader {
         return {};
     }
 
-    // returns the number read, when the return value is less than the requested its the end
-    ErrorCodeOr<usize> Read(Span<u8> bytes_out) {
-        ASSERT(size >= pos);
-        auto bytes = Min(bytes_out.size, size - pos);
+    // Reads at the given offset without touching pos. Returns the number read, when the return value is less
+    // than the requested its the end.
+    ErrorCodeOr<usize> ReadAt(usize offset, Span<u8> bytes_out) {
+        if (offset >= size) return 0uz;
+        auto bytes = Min(bytes_out.size, size - offset);
         if (!bytes) return bytes;
 
         if (read_callback) {
-            bytes = TRY(read_callback(read_callback_context, pos, bytes_out.data, bytes));
+            bytes = TRY(read_callback(read_callback_context, offset, bytes_out.data, bytes));
         } else if (memory) {
-            CopyMemory(bytes_out.data, memory + pos, bytes);
+            CopyMemory(bytes_out.data, memory + offset, bytes);
+        } else if (mapped_file) {
+            CopyMemory(bytes_out.data, mapped_file->data.data + offset, bytes);
         } else {
-            TRY(file->Seek((s64)(file_base_pos + pos), File::SeekOrigin::Start));
-            bytes = TRY(file->Read(bytes_out.data, bytes));
+            // A short read isn't necessarily the end of the file so we keep going until we get 0.
+            usize total = 0;
+            while (total != bytes) {
+                auto const n =
+                    TRY(file->ReadAt(file_base_pos + offset + total, bytes_out.data + total, bytes - total));
+                if (!n) break;
+                total += n;
+            }
+            bytes = total;
         }
-        pos += bytes;
 
         return bytes;
     }
+
+    // returns the number read, when the return value is less than the requested its the end
+    ErrorCodeOr<usize> Read(Span<u8> bytes_out) {
+        ASSERT(size >= pos);
+        auto const bytes = TRY(ReadAt(pos, bytes_out));
+        pos += bytes;
+        return bytes;
+    }
     ErrorCodeOr<usize> Read(void* out, usize out_size) { return Read(Span {(u8*)out, out_size}); }
 
-    // if it's in-memory the arena isn't used
+    // If it's in-memory or memory-mapped the arena isn't used. In the memory-mapped case, the result is only
+    // valid for the lifetime of this Reader.
     ErrorCodeOr<Span<u8 const>> ReadOrFetchAll(ArenaAllocator& arena) {
         pos = 0;
         if (memory) {
             return Span<u8 const> {memory, size};
+        } else if (mapped_file) {
+            return mapped_file->data;
         } else {
             auto result = arena.AllocateExactSizeUninitialised<u8>(size);
             TRY(Read(result));
@@ -95,9 +140,10 @@ struct Reader {
 
     usize size {};
     usize pos {};
-    u8 const* memory {}; // valid if in-memory
+    u8 const* memory {}; // valid if in-memory, owned by the caller
     usize file_base_pos {};
-    Optional<File> file {}; // valid if its a file
+    Optional<File> file {}; // valid if its a file that isn't mapped
+    Optional<MappedFile> mapped_file {}; // valid if its a memory-mapped file
     ReadAtCallback read_callback {}; // valid if callback-based
     void* read_callback_context {};
 };
@@ -6,6 +6,56 @@
 #include "tests/framework.hpp"
 #include "utils/thread_extra/starting_gun.hpp"
 
+#include "benchmarks/framework.hpp"
+
+void ParallelFor(String thread_name,
+                 u32 count,
+                 u32 max_threads,
+                 FunctionRef<bool(u32 index, u32 thread_index)> function) {
+    auto const num_threads = Min(max_threads, count);
+    if (num_threads <= 1) {
+        for (auto const index : Range(count))
+            if (!function(index, 0)) break;
+        return;
+    }
+
+    Atomic<u32> next_index {0};
+    Atomic<u32> first_failed_index {LargestRepresentableValue<u32>()};
+    Atomic<bool> panicked {false};
+    AtomicCountdown countdown {num_threads};
+
+    ThreadPool pool;
+    pool.Init(thread_name, num_threads);
+    for (auto const thread_index : Range(num_threads)) {
+        pool.AddJob([&, thread_index]() {
+            DEFER { countdown.CountDown(); };
+            try {
+                while (true) {
+                    auto const index = next_index.FetchAdd(1, RmwMemoryOrder::Relaxed);
+                    if (index >= count) break;
+                    if (index > first_failed_index.Load(LoadMemoryOrder::Relaxed)) break;
+                    if (function(index, thread_index)) continue;
+
+                    // Keep the lowest failed index.
+                    auto failed = first_failed_index.Load(LoadMemoryOrder::Relaxed);
+                    while (index < failed)
+                        if (first_failed_index.CompareExchangeWeak(failed,
+                                                                   index,
+                                                                   RmwMemoryOrder::Relaxed,
+                                                                   LoadMemoryOrder::Relaxed))
+                            break;
+                    break;
+                }
+            } catch (PanicException) {
+                panicked.Store(true, StoreMemoryOrder::Relaxed);
+            }
+        });
+    }
+    countdown.WaitUntilZero();
+
+    if (panicked.Load(LoadMemoryOrder::Relaxed)) Panic("panic in ParallelFor job");
+}
+
 TEST_CASE(TestAsync) {
     ThreadPool pool;
     pool.Init("test", 2u);
@@ -225,4 +275,323 @@ TEST_CASE(TestAsync) {
     return k_success;
 }
 
-TEST_REGISTRATION(RegisterThreadPoolTests) { REGISTER_TEST(TestAsync); }
+TEST_CASE(TestThreadPoolJobs) {
+    ThreadPool pool;
+    pool.Init("test", 4u);
+
+    SUBCASE("every job runs exactly once") {
+        constexpr u32 k_num_jobs = 5000;
+        Array<Atomic<u32>, k_num_jobs> run_counts {};
+        AtomicCountdown countdown {k_num_jobs};
+        for (auto const i : Range(k_num_jobs)) {
+            pool.AddJob([&, i]() {
+                run_counts[i].FetchAdd(1, RmwMemoryOrder::Relaxed);
+                countdown.CountDown();
+            });
+        }
+        REQUIRE(countdown.WaitUntilZero(10000u) == WaitResult::WokenOrSpuriousOrNotExpected);
+        for (auto const& c : run_counts)
+            CHECK_EQ(c.Load(LoadMemoryOrder::Relaxed), 1u);
+    }
+
+    SUBCASE("batched submission") {
+        constexpr u32 k_num_jobs = 1000;
+        Atomic<u32> sum {0};
+        AtomicCountdown countdown {k_num_jobs};
+        auto const job = [&]() {
+            sum.FetchAdd(1, RmwMemoryOrder::Relaxed);
+            countdown.CountDown();
+        };
+        DynamicArray<ThreadPool::FunctionType> functions {tester.scratch_arena};
+        for (auto _ : Range(k_num_jobs))
+            dyn::Append(functions, job);
+        pool.AddJobs(functions, JobPriority::Low);
+        REQUIRE(countdown.WaitUntilZero(10000u) == WaitResult::WokenOrSpuriousOrNotExpected);
+        CHECK_EQ(sum.Load(LoadMemoryOrder::Relaxed), k_num_jobs);
+    }
+
+    SUBCASE("jobs added from inside a job are stolen by other workers") {
+        constexpr u32 k_num_children = 64;
+        AtomicCountdown countdown {k_num_children};
+        Atomic<u32> num_children_on_other_threads {0};
+        Atomic<u64> parent_thread_id {0};
+        Atomic<bool> release_parent {false};
+        AtomicCountdown parent_done {1};
+
+        pool.AddJob([&]() {
+            parent_thread_id.Store(CurrentThreadId(), StoreMemoryOrder::Release);
+            for (auto _ : Range(k_num_children)) {
+                pool.AddJob([&]() {
+                    if (CurrentThreadId() != parent_thread_id.Load(LoadMemoryOrder::Acquire))
+                        num_children_on_other_threads.FetchAdd(1, RmwMemoryOrder::Relaxed);
+                    countdown.CountDown();
+                });
+            }
+            // Keep this worker busy so the children can only run if they're stolen.
+            while (!release_parent.Load(LoadMemoryOrder::Acquire) && !countdown.TryWait())
+                YieldThisThread();
+            parent_done.CountDown();
+        });
+
+        auto const result = countdown.WaitUntilZero(10000u);
+        release_parent.Store(true, StoreMemoryOrder::Release);
+        parent_done.WaitUntilZero();
+        REQUIRE(result == WaitResult::WokenOrSpuriousOrNotExpected);
+        CHECK_EQ(num_children_on_other_threads.Load(LoadMemoryOrder::Relaxed), k_num_children);
+    }
+
+    SUBCASE("high priority jobs are picked before low priority ones") {
+        // Use a single worker so the order is deterministic.
+        ThreadPool single;
+        single.Init("single", 1u);
+
+        Atomic<bool> release_blocker {false};
+        Atomic<bool> blocker_started {false};
+        AtomicCountdown countdown {3};
+        single.AddJob([&]() {
+            blocker_started.Store(true, StoreMemoryOrder::Release);
+            while (!release_blocker.Load(LoadMemoryOrder::Acquire))
+                YieldThisThread();
+            countdown.CountDown();
+        });
+        while (!blocker_started.Load(LoadMemoryOrder::Acquire))
+            YieldThisThread();
+
+        Atomic<u32> order {0};
+        Atomic<u32> low_order {0};
+        Atomic<u32> high_order {0};
+        single.AddJob(
+            [&]() {
+                low_order.Store(order.AddFetch(1, RmwMemoryOrder::AcquireRelease), StoreMemoryOrder::Relaxed);
+                countdown.CountDown();
+            },
+            JobPriority::Low);
+        single.AddJob(
+            [&]() {
+                high_order.Store(order.AddFetch(1, RmwMemoryOrder::AcquireRelease), StoreMemoryOrder::Relaxed);
+                countdown.CountDown();
+            },
+            JobPriority::High);
+
+        release_blocker.Store(true, StoreMemoryOrder::Release);
+        REQUIRE(countdown.WaitUntilZero(10000u) == WaitResult::WokenOrSpuriousOrNotExpected);
+        CHECK_EQ(high_order.Load(LoadMemoryOrder::Relaxed), 1u);
+        CHECK_EQ(low_order.Load(LoadMemoryOrder::Relaxed), 2u);
+        single.StopAllThreads();
+    }
+
+    SUBCASE("stopping discards pending jobs") {
+        ThreadPool single;
+        single.Init("single", 1u);
+        Atomic<bool> release_blocker {false};
+        Atomic<bool> blocker_started {false};
+        single.AddJob([&]() {
+            blocker_started.Store(true, StoreMemoryOrder::Release);
+            while (!release_blocker.Load(LoadMemoryOrder::Acquire))
+                YieldThisThread();
+        });
+        while (!blocker_started.Load(LoadMemoryOrder::Acquire))
+            YieldThisThread();
+        for (auto _ : Range(100))
+            single.AddJob([]() {});
+        release_blocker.Store(true, StoreMemoryOrder::Release);
+        single.StopAllThreads();
+    }
+
+    return k_success;
+}
+
+TEST_CASE(TestParallelFor) {
+    // A single thread runs everything on the calling thread, so check both paths.
+    for (auto const max_threads : Array {1u, 4u}) {
+        CAPTURE(max_threads);
+        constexpr u32 k_count = 1000;
+
+        {
+            // Every index runs exactly once.
+            Array<Atomic<u32>, k_count> run_counts {};
+            Atomic<bool> bad_thread_index {false};
+            ParallelFor("test", k_count, max_threads, [&](u32 index, u32 thread_index) {
+                if (thread_index >= max_threads) bad_thread_index.Store(true, StoreMemoryOrder::Relaxed);
+                run_counts[index].FetchAdd(1, RmwMemoryOrder::Relaxed);
+                return true;
+            });
+            for (auto const& c : run_counts)
+                CHECK_EQ(c.Load(LoadMemoryOrder::Relaxed), 1u);
+            CHECK(!bad_thread_index.Load(LoadMemoryOrder::Relaxed));
+        }
+
+        {
+            // Indices before a failure all run and later ones aren't claimed.
+            constexpr u32 k_failing_index = 300;
+            Array<Atomic<u32>, k_count> run_counts {};
+            ParallelFor("test", k_count, max_threads, [&](u32 index, u32) {
+                run_counts[index].FetchAdd(1, RmwMemoryOrder::Relaxed);
+                return index != k_failing_index;
+            });
+            for (auto const i : Range(k_failing_index + 1))
+                CHECK_EQ(run_counts[i].Load(LoadMemoryOrder::Relaxed), 1u);
+            // With several threads, others can get through a few more indices before they see the failure.
+            if (max_threads == 1)
+                CHECK_EQ(run_counts[k_failing_index + 1].Load(LoadMemoryOrder::Relaxed), 0u);
+        }
+
+        {
+            // No indices.
+            bool called = false;
+            ParallelFor("test", 0, max_threads, [&](u32, u32) {
+                called = true;
+                return true;
+            });
+            CHECK(!called);
+        }
+    }
+
+    return k_success;
+}
+
+TEST_REGISTRATION(RegisterThreadPoolTests) {
+    REGISTER_TEST(TestAsync);
+    REGISTER_TEST(TestThreadPoolJobs);
+    REGISTER_TEST(TestParallelFor);
+}
+
+// The previous design of ThreadPool, kept so the benchmarks can compare against it: one mutex and condition
+// variable guarding a queue per priority.
+struct MutexThreadPool {
+    ~MutexThreadPool() {
+        {
+            ScopedMutexLock const lock(mutex);
+            stop_requested.Store(true, StoreMemoryOrder::Release);
+        }
+        cond_var.WakeAll();
+        for (auto& t : workers)
+            if (t.Joinable()) t.Join();
+    }
+
+    void Init(String, Optional<u32> num_threads) {
+        dyn::Resize(workers, *num_threads);
+        for (auto [i, w] : Enumerate(workers))
+            w.Start([this]() { WorkerProc(); }, fmt::FormatInline<k_max_thread_name_size>("bench:{}", i), {});
+    }
+
+    void AddJob(ThreadPool::FunctionType f, JobPriority priority = JobPriority::Normal) {
+        {
+            ScopedMutexLock const lock(mutex);
+            job_queues[ToInt(priority)].Push(f);
+        }
+        cond_var.WakeOne();
+    }
+
+    void AddJobs(Span<ThreadPool::FunctionType const> functions, JobPriority priority = JobPriority::Normal) {
+        for (auto const& f : functions)
+            AddJob(f, priority);
+    }
+
+    void WorkerProc() {
+        ArenaAllocatorWithInlineStorage<4000> scratch_arena {Malloc::Instance()};
+        while (true) {
+            Optional<FunctionQueue<>::Function> f {};
+            {
+                ScopedMutexLock lock(mutex);
+                auto const all_empty = [&]() {
+                    for (auto& q : job_queues)
+                        if (!q.Empty()) return false;
+                    return true;
+                };
+                while (all_empty() && !stop_requested.Load(LoadMemoryOrder::Acquire))
+                    cond_var.Wait(lock);
+                for (auto& queue : job_queues) {
+                    f = queue.TryPop(scratch_arena);
+                    if (f) break;
+                }
+            }
+            if (f) (*f)();
+            if (stop_requested.Load(LoadMemoryOrder::Acquire)) return;
+            scratch_arena.ResetCursorAndConsolidateRegions();
+        }
+    }
+
+    DynamicArray<Thread> workers {Malloc::Instance()};
+    Atomic<bool> stop_requested {};
+    Mutex mutex {};
+    ConditionVariable cond_var {};
+    Array<FunctionQueue<>, 3> job_queues {FunctionQueue<> {.arena = Malloc::Instance()},
+                                          FunctionQueue<> {.arena = Malloc::Instance()},
+                                          FunctionQueue<> {.arena = Malloc::Instance()}};
+};
+
+constexpr u32 k_benchmark_num_threads = 4;
+
+template <typename PoolType>
+BENCHMARK_FN void BenchmarkThreadPoolTinyJobs(bool batched) {
+    PoolType pool;
+    pool.Init("bench", k_benchmark_num_threads);
+
+    constexpr u32 k_num_jobs = 10000;
+    Atomic<u32> counter {0};
+    AtomicCountdown countdown {0};
+    auto const job = [&]() {
+        counter.FetchAdd(1, RmwMemoryOrder::Relaxed);
+        countdown.CountDown();
+    };
+
+    ArenaAllocator arena {PageAllocator::Instance()};
+    DynamicArray<ThreadPool::FunctionType> functions {arena};
+    for (auto _ : Range(k_num_jobs))
+        dyn::Append(functions, job);
+
+    for (auto _ : Range(50)) {
+        countdown.Increase(k_num_jobs);
+        if (batched)
+            pool.AddJobs(functions);
+        else
+            for (auto const& f : functions)
+                pool.AddJob(f);
+        countdown.WaitUntilZero();
+    }
+    benchmarks::DoNotOptimise(counter);
+}
+
+// Roughly the work of decoding a short sample: converting 16-bit frames to float.
+template <typename PoolType>
+BENCHMARK_FN void BenchmarkThreadPoolDecodeSizedJobs() {
+    PoolType pool;
+    pool.Init("bench", k_benchmark_num_threads);
+
+    constexpr u32 k_num_jobs = 1000;
+    constexpr usize k_num_frames = 16 * 1024;
+    AtomicCountdown countdown {k_num_jobs};
+    Atomic<u32> checksum {0};
+
+    auto const job = [&]() {
+        s16 input[k_num_frames];
+        f32 output[k_num_frames];
+        for (auto const i : Range(k_num_frames))
+            input[i] = (s16)(i * 31);
+        benchmarks::DoNotOptimise(input);
+        for (auto const i : Range(k_num_frames))
+            output[i] = (f32)input[i] / 32768.0f;
+        benchmarks::DoNotOptimise(output);
+        checksum.FetchAdd((u32)output[k_num_frames / 2], RmwMemoryOrder::Relaxed);
+        countdown.CountDown();
+    };
+
+    for (auto _ : Range(k_num_jobs))
+        pool.AddJob(job);
+    countdown.WaitUntilZero();
+    benchmarks::DoNotOptimise(checksum);
+}
+
+BENCHMARK_REGISTRATION(RegisterThreadPoolBenchmarks) {
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkThreadPoolTinyJobs<ThreadPool>(false); },
+                             "ThreadPoolTinyJobs/WorkStealing");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkThreadPoolTinyJobs<ThreadPool>(true); },
+                             "ThreadPoolTinyJobs/WorkStealingBatched");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkThreadPoolTinyJobs<MutexThreadPool>(false); },
+                             "ThreadPoolTinyJobs/GlobalMutex");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkThreadPoolDecodeSizedJobs<ThreadPool>(); },
+                             "ThreadPoolDecodeSizedJobs/WorkStealing");
+    REGISTER_BENCHMARK_NAMED([]() { BenchmarkThreadPoolDecodeSizedJobs<MutexThreadPool>(); },
+                             "ThreadPoolDecodeSizedJobs/GlobalMutex");
+}
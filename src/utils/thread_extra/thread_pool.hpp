@@ -10,8 +10,162 @@
 
 enum class JobPriority : u8 { High = 0, Normal = 1, Low = 2 };
 
+namespace detail {
+
+// A job and its captured function object, in a single allocation.
+struct alignas(k_max_alignment) ThreadPoolJob {
+    static ThreadPoolJob* Create(TrivialFunctionRef<void()> const& f) {
+        auto const mem = Malloc::Instance().Allocate({
+            .size = sizeof(ThreadPoolJob) + f.function_object_size,
+            .alignment = alignof(ThreadPoolJob),
+            .allow_oversized_result = false,
+        });
+        auto job = (ThreadPoolJob*)(void*)mem.data;
+        job->invoke_function = f.invoke_function;
+        job->next = nullptr;
+        job->allocation_size = mem.size;
+        if (f.function_object_size) {
+            job->function_object = (void*)(job + 1);
+            __builtin_memcpy(job->function_object, f.function_object, f.function_object_size);
+        } else {
+            job->function_object = f.function_object;
+        }
+        return job;
+    }
+
+    static void Destroy(ThreadPoolJob* job) { Malloc::Instance().Free({(u8*)(void*)job, job->allocation_size}); }
+
+    void (*invoke_function)(void*);
+    void* function_object;
+    ThreadPoolJob* next; // Used by the submission stacks.
+    usize allocation_size;
+};
+
+// Chase-Lev work-stealing deque. The owning worker pushes and pops at the bottom, other workers steal from the
+// top. Memory orderings follow "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al. 2013).
+// The buffer grows as needed; old buffers are kept until the deque is destroyed because a thief might still be
+// reading from one.
+struct WorkStealingDeque {
+    struct Buffer {
+        ThreadPoolJob* Get(s64 index) const {
+            return items[Power2Modulo((usize)index, items.size)].Load(LoadMemoryOrder::Relaxed);
+        }
+        void Put(s64 index, ThreadPoolJob* job) {
+            items[Power2Modulo((usize)index, items.size)].Store(job, StoreMemoryOrder::Relaxed);
+        }
+
+        Span<Atomic<ThreadPoolJob*>> items;
+        Buffer* retired_next;
+    };
+
+    static constexpr usize k_initial_capacity = 256;
+
+    WorkStealingDeque() { buffer.Store(CreateBuffer(k_initial_capacity), StoreMemoryOrder::Relaxed); }
+    ~WorkStealingDeque() {
+        ASSERT(LooksEmpty());
+        DestroyBuffer(buffer.Load(LoadMemoryOrder::Relaxed));
+        while (retired) {
+            auto const next = retired->retired_next;
+            DestroyBuffer(retired);
+            retired = next;
+        }
+    }
+    NON_COPYABLE_AND_MOVEABLE(WorkStealingDeque);
+
+    // Owner only.
+    void Push(ThreadPoolJob* job) {
+        auto const b = bottom.Load(LoadMemoryOrder::Relaxed);
+        auto const t = top.Load(LoadMemoryOrder::Acquire);
+        auto buf = buffer.Load(LoadMemoryOrder::Relaxed);
+        if (b - t > (s64)buf->items.size - 1) buf = Grow(buf, t, b);
+        buf->Put(b, job);
+        AtomicThreadFence(RmwMemoryOrder::Release);
+        bottom.Store(b + 1, StoreMemoryOrder::Relaxed);
+    }
+
+    // Owner only. Takes the most recently pushed job.
+    ThreadPoolJob* Pop() {
+        auto const b = bottom.Load(LoadMemoryOrder::Relaxed) - 1;
+        auto const buf = buffer.Load(LoadMemoryOrder::Relaxed);
+        bottom.Store(b, StoreMemoryOrder::Relaxed);
+        AtomicThreadFence(RmwMemoryOrder::SequentiallyConsistent);
+        auto t = top.Load(LoadMemoryOrder::Relaxed);
+
+        if (t > b) {
+            bottom.Store(b + 1, StoreMemoryOrder::Relaxed);
+            return nullptr;
+        }
+
+        auto job = buf->Get(b);
+        if (t == b) {
+            // Last item: we race against thieves for it.
+            if (!top.CompareExchangeStrong(t,
+                                           t + 1,
+                                           RmwMemoryOrder::SequentiallyConsistent,
+                                           LoadMemoryOrder::Relaxed))
+                job = nullptr;
+            bottom.Store(b + 1, StoreMemoryOrder::Relaxed);
+        }
+        return job;
+    }
+
+    // Any thread. Takes the oldest job. Returns null if empty or if another thief won the race.
+    ThreadPoolJob* Steal() {
+        auto t = top.Load(LoadMemoryOrder::Acquire);
+        AtomicThreadFence(RmwMemoryOrder::SequentiallyConsistent);
+        auto const b = bottom.Load(LoadMemoryOrder::Acquire);
+        if (t >= b) return nullptr;
+
+        auto const job = buffer.Load(LoadMemoryOrder::Acquire)->Get(t);
+        if (!top.CompareExchangeStrong(t, t + 1, RmwMemoryOrder::SequentiallyConsistent, LoadMemoryOrder::Relaxed))
+            return nullptr;
+        return job;
+    }
+
+    bool LooksEmpty() const {
+        return top.Load(LoadMemoryOrder::Acquire) >= bottom.Load(LoadMemoryOrder::Acquire);
+    }
+
+  private:
+    static Buffer* CreateBuffer(usize capacity) {
+        ASSERT(IsPowerOfTwo(capacity));
+        auto const result = Malloc::Instance().New<Buffer>();
+        result->items = Malloc::Instance().NewMultiple<Atomic<ThreadPoolJob*>>(capacity);
+        result->retired_next = nullptr;
+        return result;
+    }
+
+    static void DestroyBuffer(Buffer* buf) {
+        Malloc::Instance().Free(buf->items.ToByteSpan());
+        Malloc::Instance().Free({(u8*)(void*)buf, sizeof(Buffer)});
+    }
+
+    Buffer* Grow(Buffer* old_buf, s64 t, s64 b) {
+        auto const new_buf = CreateBuffer(old_buf->items.size * 2);
+        for (auto i = t; i < b; ++i)
+            new_buf->Put(i, old_buf->Get(i));
+        buffer.Store(new_buf, StoreMemoryOrder::Release);
+        old_buf->retired_next = retired;
+        retired = old_buf;
+        return new_buf;
+    }
+
+    alignas(k_destructive_interference_size) Atomic<s64> top {0};
+    alignas(k_destructive_interference_size) Atomic<s64> bottom {0};
+    Atomic<Buffer*> buffer {};
+    Buffer* retired {}; // Owner only.
+};
+
+} // namespace detail
+
+// General-purpose thread pool. Each worker has a work-stealing deque per priority. Jobs added from a worker
+// thread go on that worker's own deque; jobs added from other threads go on a lock-free submission stack that
+// idle workers take from in one go. Higher priority jobs are always picked before lower ones, but there's no
+// ordering guarantee between jobs of the same priority.
+//
+// Idle workers spin briefly before sleeping on a futex, so bursts of jobs don't pay for a wake-up each.
 struct ThreadPool {
-    using FunctionType = FunctionQueue<>::Function;
+    using FunctionType = TrivialFunctionRef<void()>;
 
     ~ThreadPool() { StopAllThreads(); }
 
@@ -30,23 +184,37 @@ struct ThreadPool {
 
         LogInfo(ModuleName::Main, "Starting thread pool with {} threads", num_threads);
 
-        dyn::Resize(m_workers, *num_threads);
-        for (auto [i, w] : Enumerate(m_workers)) {
+        m_workers = Malloc::Instance().NewMultiple<Worker>(*num_threads);
+        for (auto [i, w] : Enumerate<u32>(m_workers)) {
             auto const name = fmt::FormatInline<k_max_thread_name_size>("{}:{}", pool_name, i);
-            w.Start([this]() { WorkerProc(this); }, name, {});
+            w.thread.Start([this, i]() { WorkerProc(this, i); }, name, {});
         }
     }
 
     void StopAllThreads() {
         ZoneScoped;
-        {
-            ScopedMutexLock const lock(m_mutex);
-            m_thread_stop_requested.Store(true, StoreMemoryOrder::Release);
-        }
-        m_cond_var.WakeAll();
-        for (auto& t : m_workers)
-            if (t.Joinable()) t.Join();
-        dyn::Clear(m_workers);
+        if (!m_workers.size) return;
+
+        m_thread_stop_requested.Store(true, StoreMemoryOrder::SequentiallyConsistent);
+        m_work_epoch.FetchAdd(1, RmwMemoryOrder::SequentiallyConsistent);
+        WakeWaitingThreads(m_work_epoch, NumWaitingThreads::All);
+        for (auto& w : m_workers)
+            if (w.thread.Joinable()) w.thread.Join();
+
+        // Jobs that didn't get to run are discarded.
+        for (auto& w : m_workers)
+            for (auto& deque : w.deques)
+                while (auto job = deque.Pop())
+                    detail::ThreadPoolJob::Destroy(job);
+        for (auto& stack : m_submitted)
+            for (auto job = stack.Exchange(nullptr, RmwMemoryOrder::Acquire); job;) {
+                auto const next = job->next;
+                detail::ThreadPoolJob::Destroy(job);
+                job = next;
+            }
+
+        Malloc::Instance().Delete(m_workers);
+        m_workers = {};
         m_thread_stop_requested.Store(false, StoreMemoryOrder::Release);
     }
 
@@ -54,11 +222,29 @@ struct ThreadPool {
         ZoneScoped;
         ASSERT(f);
         ASSERT(m_workers.size > 0);
-        {
-            ScopedMutexLock const lock(m_mutex);
-            m_job_queues[ToInt(priority)].Push(f);
+        auto const job = detail::ThreadPoolJob::Create(f);
+        Submit(job, job, priority);
+        WakeWorkers(1);
+    }
+
+    // Adds many jobs with a single atomic operation and a single wake-up.
+    void AddJobs(Span<FunctionType const> functions, JobPriority priority = JobPriority::Normal) {
+        ZoneScoped;
+        ASSERT(m_workers.size > 0);
+        if (!functions.size) return;
+
+        // Chain newest-first, the same order as the submission stack.
+        detail::ThreadPoolJob* first = nullptr;
+        detail::ThreadPoolJob* last = nullptr;
+        for (auto const& f : functions) {
+            ASSERT(f);
+            auto const job = detail::ThreadPoolJob::Create(f);
+            job->next = first;
+            first = job;
+            if (!last) last = job;
         }
-        m_cond_var.WakeOne();
+        Submit(first, last, priority);
+        WakeWorkers(functions.size);
     }
 
     // The caller owns the future and is responsible for ensuring it outlives the async task.
@@ -92,41 +278,144 @@ struct ThreadPool {
     }
 
   private:
-    static bool AllQueuesEmpty(Array<FunctionQueue<>, 3>& queues) {
-        for (auto& queue : queues)
-            if (!queue.Empty()) return false;
-        return true;
+    struct Worker {
+        Thread thread {};
+        Array<detail::WorkStealingDeque, 3> deques {}; // Indexed by JobPriority.
+    };
+
+    struct CurrentWorker {
+        ThreadPool* pool;
+        u32 index;
+    };
+
+    static constexpr u32 k_num_spins_before_sleeping = 256;
+
+    // Takes a chain of jobs linked newest-first: first->next...->last.
+    void Submit(detail::ThreadPoolJob* first, detail::ThreadPoolJob* last, JobPriority priority) {
+        if (t_current_worker.pool == this) {
+            // On a worker: push onto our own deque, oldest first, so that others can steal them.
+            auto& deque = m_workers[t_current_worker.index].deques[ToInt(priority)];
+            PushChainOldestFirst(deque, first);
+            return;
+        }
+
+        auto& stack = m_submitted[ToInt(priority)];
+        auto head = stack.Load(LoadMemoryOrder::Relaxed);
+        do
+            last->next = head;
+        while (!stack.CompareExchangeWeak(head, first, RmwMemoryOrder::Release, LoadMemoryOrder::Relaxed));
     }
 
-    static void WorkerProc(ThreadPool* thread_pool) {
+    static void PushChainOldestFirst(detail::WorkStealingDeque& deque, detail::ThreadPoolJob* newest) {
+        detail::ThreadPoolJob* oldest = nullptr;
+        while (newest) {
+            auto const next = newest->next;
+            newest->next = oldest;
+            oldest = newest;
+            newest = next;
+        }
+        while (oldest) {
+            auto const next = oldest->next;
+            oldest->next = nullptr;
+            deque.Push(oldest);
+            oldest = next;
+        }
+    }
+
+    void WakeWorkers(usize num_jobs) {
+        // Paired with the sequence in WorkerProc: either a worker sees the new epoch/job, or we see that it's
+        // sleeping.
+        m_work_epoch.FetchAdd(1, RmwMemoryOrder::SequentiallyConsistent);
+        if (m_num_sleeping.Load(LoadMemoryOrder::SequentiallyConsistent) == 0) return;
+        WakeWaitingThreads(m_work_epoch, num_jobs == 1 ? NumWaitingThreads::One : NumWaitingThreads::All);
+    }
+
+    // Takes the whole submission stack. Returns the oldest job to be run now and pushes the rest onto the
+    // worker's deque.
+    detail::ThreadPoolJob* TakeSubmitted(u32 worker_index, JobPriority priority) {
+        auto& stack = m_submitted[ToInt(priority)];
+        if (!stack.Load(LoadMemoryOrder::Relaxed)) return nullptr;
+        auto job = stack.Exchange(nullptr, RmwMemoryOrder::Acquire);
+        if (!job) return nullptr;
+
+        // Newest-first: pushing in this order leaves the oldest at the bottom of the deque, which is where we
+        // pop from, so we roughly keep submission order.
+        auto& deque = m_workers[worker_index].deques[ToInt(priority)];
+        while (job->next) {
+            auto const next = job->next;
+            job->next = nullptr;
+            deque.Push(job);
+            job = next;
+        }
+        return job;
+    }
+
+    detail::ThreadPoolJob* FindJob(u32 worker_index) {
+        auto const num_workers = (u32)m_workers.size;
+        for (auto const priority : Array {JobPriority::High, JobPriority::Normal, JobPriority::Low}) {
+            if (auto job = m_workers[worker_index].deques[ToInt(priority)].Pop()) return job;
+            if (auto job = TakeSubmitted(worker_index, priority)) return job;
+            for (auto const i : Range(1u, num_workers)) {
+                auto const victim = (worker_index + i) % num_workers;
+                if (auto job = m_workers[victim].deques[ToInt(priority)].Steal()) return job;
+            }
+        }
+        return nullptr;
+    }
+
+    bool AnyWorkAvailable() {
+        for (auto& stack : m_submitted)
+            if (stack.Load(LoadMemoryOrder::SequentiallyConsistent)) return true;
+        for (auto& w : m_workers)
+            for (auto& deque : w.deques)
+                if (!deque.LooksEmpty()) return true;
+        return false;
+    }
+
+    static void WorkerProc(ThreadPool* thread_pool, u32 worker_index) {
         ZoneScoped;
-        ArenaAllocatorWithInlineStorage<4000> scratch_arena {Malloc::Instance()};
-        while (true) {
-            Optional<FunctionQueue<>::Function> f {};
-            {
-                ScopedMutexLock lock(thread_pool->m_mutex);
-                while (AllQueuesEmpty(thread_pool->m_job_queues) &&
-                       !thread_pool->m_thread_stop_requested.Load(LoadMemoryOrder::Acquire))
-                    thread_pool->m_cond_var.Wait(lock);
-
-                // Check queues in priority order: High, Normal, Low
-                for (auto& queue : thread_pool->m_job_queues) {
-                    f = queue.TryPop(scratch_arena);
-                    if (f) break;
-                }
+        t_current_worker = {thread_pool, worker_index};
+        DEFER { t_current_worker = {}; };
+
+        u32 num_spins = 0;
+        while (!thread_pool->m_thread_stop_requested.Load(LoadMemoryOrder::Acquire)) {
+            if (auto job = thread_pool->FindJob(worker_index)) {
+                job->invoke_function(job->function_object);
+                detail::ThreadPoolJob::Destroy(job);
+                num_spins = 0;
+                continue;
             }
-            if (f) (*f)();
 
-            if (thread_pool->m_thread_stop_requested.Load(LoadMemoryOrder::Acquire)) return;
-            scratch_arena.ResetCursorAndConsolidateRegions();
+            if (num_spins++ < k_num_spins_before_sleeping) {
+                SpinLoopPause();
+                continue;
+            }
+            num_spins = 0;
+
+            auto const epoch = thread_pool->m_work_epoch.Load(LoadMemoryOrder::SequentiallyConsistent);
+            thread_pool->m_num_sleeping.FetchAdd(1, RmwMemoryOrder::SequentiallyConsistent);
+            if (!thread_pool->AnyWorkAvailable() &&
+                !thread_pool->m_thread_stop_requested.Load(LoadMemoryOrder::SequentiallyConsistent))
+                WaitIfValueIsExpected(thread_pool->m_work_epoch, epoch);
+            thread_pool->m_num_sleeping.FetchSub(1, RmwMemoryOrder::Relaxed);
         }
     }
 
-    DynamicArray<Thread> m_workers {Malloc::Instance()};
+    static inline thread_local CurrentWorker t_current_worker {};
+
+    Span<Worker> m_workers {};
     Atomic<bool> m_thread_stop_requested {};
-    Mutex m_mutex {};
-    ConditionVariable m_cond_var {};
-    Array<FunctionQueue<>, 3> m_job_queues {FunctionQueue<> {.arena = Malloc::Instance()},
-                                            FunctionQueue<> {.arena = Malloc::Instance()},
-                                            FunctionQueue<> {.arena = Malloc::Instance()}};
+    Array<Atomic<detail::ThreadPoolJob*>, 3> m_submitted {}; // Lock-free stacks, indexed by JobPriority.
+    Atomic<u32> m_work_epoch {};
+    Atomic<u32> m_num_sleeping {};
 };
+
+// Calls function(index, thread_index) for every index in [0, count) using up to max_threads threads, each
+// with its own thread_index below max_threads. Indices are claimed in order, and once function returns false
+// for an index no later indices are claimed - so, as with a serial loop, everything before the lowest failing
+// index has run. If only one thread is needed everything runs on the calling thread. A panic on any thread is
+// re-raised on the calling thread once they have all finished.
+void ParallelFor(String thread_name,
+                 u32 count,
+                 u32 max_threads,
+                 FunctionRef<bool(u32 index, u32 thread_index)> function);